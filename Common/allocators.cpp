@@ -1,49 +1,158 @@
+#include <stdarg.h>
 #include <string.h>
+#include <wchar.h>
 
 #include "defined_macro.h"
 #include "allocators.h"
 #include "container.h"
 #include "mempage.h"
+#include "memtrace.h"
+#include "pageprovider.h"
 
-DECLSPEC_DLL void* memAlloc(size_t size, size_t alignment, size_t alignOffset, const wchar_t* addrspace)
+static bool IsSystemName(const wchar_t* addrspace)
 {
-    if (addrspace == nullptr || 
-        wcscmp(L"", addrspace) == 0 ||
-        wcscmp(SYSTEM_NAME, addrspace) == 0) {
-        return _aligned_offset_malloc(size, alignment, alignOffset);
+    // 대부분의 이름은 첫 글자에서 걸러짐
+    return addrspace == nullptr ||
+        addrspace[0] == L'\0' ||
+        (addrspace[0] == SYSTEM_NAME[0] && wcscmp(SYSTEM_NAME, addrspace) == 0);
+}
+
+static MemSpace MakeSpace(int32 index)
+{
+    MemSpace space;
+    space.id = ((uint64)GetEntryGeneration(index) << 32) | (uint64)(index + 1);
+    return space;
+}
+
+static AllocatorEntry* ResolveSpace(MemSpace space)
+{
+    auto index = (int32)(space.id & 0xFFFFFFFF) - 1;
+
+    if (index < 0 || index >= ALLOCATOR_ENTRY_COUNT ||
+        GetEntryGeneration(index) != (uint32)(space.id >> 32)) {
+        return nullptr;
+    }
+
+    return GetEntry(index);
+}
+
+static MemSpace FindSpace(const wchar_t* addrspace, bool create)
+{
+    if (IsSystemName(addrspace)) {
+        return MEMSPACE_SYSTEM;
+    }
+
+    auto entry = FindEntry(addrspace);
+
+    if (entry != nullptr) {
+        return MakeSpace(GetEntryIndex(entry));
+    }
+    if (!create) {
+        return MEMSPACE_INVALID;
+    }
+
+    auto index = AddEntry(addrspace, ALLOCATOR_MIN_PAGESIZE, false);
+
+    return index < 0? MEMSPACE_INVALID: MakeSpace(index);
+}
+
+DECLSPEC_DLL void* memAllocH(size_t size, size_t alignment, size_t alignOffset, MemSpace space)
+{
+    void* p;
+
+    if (space == MEMSPACE_SYSTEM) {
+        p = SystemAlloc(size, alignment, alignOffset);
     } else {
-        auto entry = FindEntry(addrspace);
+        auto entry = ResolveSpace(space);
 
         if (entry == nullptr) {
-            auto index = AddEntry(addrspace, ALLOCATOR_MIN_PAGESIZE, false);
+            return nullptr;
+        }
 
-            if (index < 0) {
-                return nullptr;
-            } else {
-                entry = GetEntry(index);
-            }
-        } 
+        p = entry->Allocate(size, alignment, alignOffset);
+    }
 
-        return entry->Allocate(size, alignment, alignOffset);
+    if (MemTraceEnabled()) {
+        MemTraceAlloc(space, p, size, alignment, alignOffset);
     }
+    return p;
 }
 
-DECLSPEC_DLL bool memFree(void* ptr, const wchar_t* addrspace)
+DECLSPEC_DLL bool memFreeH(void* ptr, MemSpace space)
 {
-    if (addrspace == nullptr ||
-        wcscmp(L"", addrspace) == 0 ||
-        wcscmp(SYSTEM_NAME, addrspace) == 0) {
-        _aligned_free(ptr);
-        return true;
+    // 해제된 주소를 다른 스레드가 바로 받아갈 수 있으므로 시각은 해제하기 전에 재고, 기록은 해제가 성공했을 때만 남김
+    auto traced = ptr != nullptr && MemTraceEnabled();
+    auto freeTime = traced? MemTraceTime(): 0;
+    bool result;
+
+    if (space == MEMSPACE_SYSTEM) {
+        SystemFree(ptr);
+        result = true;
     } else {
-        auto entry = FindEntry(addrspace);
+        auto entry = ResolveSpace(space);
+
+        result = entry != nullptr && entry->Deallocate(ptr);
+    }
+
+    if (result && traced && MemTraceEnabled()) {
+        MemTraceFree(space, ptr, freeTime);
+    }
+    return result;
+}
+
+DECLSPEC_DLL void* memReallocH(void* ptr, size_t size, size_t alignment, size_t alignOffset, MemSpace space)
+{
+    if (ptr == nullptr) {
+        return memAllocH(size, alignment, alignOffset, space);
+    }
+
+    // 기록에는 해제와 할당으로 남김
+    // 실패하면 ptr 는 그대로 살아 있으므로 해제는 성공한 뒤에만 남기고, 시각은 memFreeH 와 같은 이유로 풀기 전에 잼
+    AllocatorEntry* entry = nullptr;
+
+    if (space != MEMSPACE_SYSTEM) {
+        entry = ResolveSpace(space);
 
         if (entry == nullptr) {
-            return false;
+            return nullptr;
         }
+    }
 
-        return entry->Deallocate(ptr);
+    auto traced = MemTraceEnabled();
+    auto freeTime = traced? MemTraceTime(): 0;
+    void* p;
+
+    if (entry == nullptr) {
+        p = SystemRealloc(ptr, size, alignment, alignOffset);
+    } else {
+        p = entry->Reallocate(ptr, size, alignment, alignOffset);
     }
+
+    if (p != nullptr && traced && MemTraceEnabled()) {
+        MemTraceFree(space, ptr, freeTime);
+        MemTraceAlloc(space, p, size, alignment, alignOffset);
+    }
+    return p;
+}
+
+DECLSPEC_DLL MemSpace memPageFind(const wchar_t* addrspace)
+{
+    return FindSpace(addrspace, false);
+}
+
+DECLSPEC_DLL void* memAlloc(size_t size, size_t alignment, size_t alignOffset, const wchar_t* addrspace)
+{
+    return memAllocH(size, alignment, alignOffset, FindSpace(addrspace, true));
+}
+
+DECLSPEC_DLL bool memFree(void* ptr, const wchar_t* addrspace)
+{
+    return memFreeH(ptr, FindSpace(addrspace, false));
+}
+
+DECLSPEC_DLL void* memRealloc(void* ptr, size_t size, size_t alignment, size_t alignOffset, const wchar_t* addrspace)
+{
+    return memReallocH(ptr, size, alignment, alignOffset, FindSpace(addrspace, ptr == nullptr));
 }
 
 DECLSPEC_DLL size_t memAllocSize(const wchar_t* addrspace)
@@ -54,18 +163,13 @@ DECLSPEC_DLL size_t memAllocSize(const wchar_t* addrspace)
         return 0;
     }
 
-    return entry->allocByteCount;
+    return entry->AllocatedBytes();
 }
 
-DECLSPEC_DLL size_t memPageSize(const wchar_t* addrspace)
+DECLSPEC_DLL size_t memPageSizeH(MemSpace space)
 {
-    if (addrspace == nullptr ||
-        wcscmp(L"", addrspace) == 0 ||
-        wcscmp(SYSTEM_NAME, addrspace) == 0) {
-        return 0;
-    }
-
-    auto entry = FindEntry(addrspace);
+    // system 은 페이지를 따로 잡지 않으므로 ResolveSpace 에서 걸러져 0
+    auto entry = ResolveSpace(space);
 
     if (entry == nullptr) {
         return 0;
@@ -74,28 +178,47 @@ DECLSPEC_DLL size_t memPageSize(const wchar_t* addrspace)
     return entry->totalPageSize;
 }
 
+DECLSPEC_DLL size_t memPageSize(const wchar_t* addrspace)
+{
+    return memPageSizeH(FindSpace(addrspace, false));
+}
+
 DECLSPEC_DLL size_t memPageMinSize(bool pageLocked)
 {
     return pageLocked? ALLOCATOR_MIN_LOCKEDPAGESIZE: ALLOCATOR_MIN_PAGESIZE;
 }
 
-DECLSPEC_DLL bool memPageAdd(const wchar_t* addrspace, size_t pageSize, bool pageLocked)
+DECLSPEC_DLL MemSpace memPageAdd(const wchar_t* addrspace, size_t pageSize, bool pageLocked, int32 kind, uint32 flags)
 {
-    if (addrspace == nullptr ||
-        wcscmp(L"", addrspace) == 0 ||
-        wcscmp(SYSTEM_NAME, addrspace) == 0) {
-        return false;
+    if (IsSystemName(addrspace)) {
+        return MEMSPACE_INVALID;
     }
 
     auto entry = FindEntry(addrspace);
 
     if (entry != nullptr) {
-        return false;
+        return MEMSPACE_INVALID;
     }
 
-    auto index = AddEntry(addrspace, pageSize, pageLocked);
+    if (kind < MEMPAGE_KIND_DEFAULT || kind > MEMPAGE_KIND_BUDDY) {
+        return MEMSPACE_INVALID;
+    }
+
+    if (flags & ~(uint32)(MEMPAGE_FLAG_HUGE | MEMPAGE_FLAG_PREFAULT | MEMPAGE_FLAG_WARM)) {
+        return MEMSPACE_INVALID;
+    }
 
-    return index >= 0 && index < ALLOCATOR_ENTRY_COUNT;
+    auto index = AddEntry(addrspace, pageSize, pageLocked, kind, flags);
+
+    if (index < 0 || index >= ALLOCATOR_ENTRY_COUNT) {
+        return MEMSPACE_INVALID;
+    }
+
+    auto space = MakeSpace(index);
+    if (flags & MEMPAGE_FLAG_WARM) {
+        memPageWarm(space, pageSize);
+    }
+    return space;
 }
 
 DECLSPEC_DLL bool memPageFree(const wchar_t* addrspace)
@@ -106,9 +229,190 @@ DECLSPEC_DLL bool memPageFree(const wchar_t* addrspace)
         return false;
     }
 
+    if (MemTraceEnabled()) {
+        auto space = FindSpace(addrspace, false);
+        if (space != MEMSPACE_INVALID) {
+            MemTraceSpaceFree(space);
+        }
+    }
+
     return RemoveEntry(addrspace);
 }
 
+DECLSPEC_DLL bool memPageSetTrim(MemSpace space, size_t maxRetainedPages, int32 mode)
+{
+    auto entry = ResolveSpace(space);
+
+    if (entry == nullptr || (mode != MEMTRIM_RELEASE && mode != MEMTRIM_DECOMMIT)) {
+        return false;
+    }
+
+    entry->SetTrimPolicy(maxRetainedPages, mode);
+    return true;
+}
+
+DECLSPEC_DLL size_t memTrim(MemSpace space)
+{
+    auto entry = ResolveSpace(space);
+
+    if (entry == nullptr) {
+        return 0;
+    }
+
+    return entry->Trim();
+}
+
+DECLSPEC_DLL bool memPageWarm(MemSpace space, size_t reserveBytes)
+{
+    auto entry = ResolveSpace(space);
+
+    return entry != nullptr && entry->Warm(reserveBytes);
+}
+
+DECLSPEC_DLL int32 memPageWarmState(MemSpace space)
+{
+    auto entry = ResolveSpace(space);
+
+    return entry != nullptr? entry->WarmState(): MEMWARM_COLD;
+}
+
+DECLSPEC_DLL bool memPageStats(MemSpace space, MemPageStats* stats)
+{
+    auto entry = ResolveSpace(space);
+
+    if (entry == nullptr || stats == nullptr) {
+        return false;
+    }
+
+    entry->CollectStats(stats);
+    return true;
+}
+
+DECLSPEC_DLL MemHandle memHandleAlloc(size_t size, size_t alignment, MemSpace space)
+{
+    auto entry = ResolveSpace(space);
+
+    if (entry == nullptr || alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        return MEMHANDLE_NULL;
+    }
+
+    MemHandle handle;
+    handle.space = space;
+    handle.id = entry->AllocateHandle(size, alignment);
+    return handle.id != 0? handle: MEMHANDLE_NULL;
+}
+
+DECLSPEC_DLL bool memHandleFree(MemHandle handle)
+{
+    auto entry = ResolveSpace(handle.space);
+
+    return entry != nullptr && entry->FreeHandle(handle.id);
+}
+
+DECLSPEC_DLL void* memHandlePin(MemHandle handle)
+{
+    auto entry = ResolveSpace(handle.space);
+
+    return entry != nullptr? entry->PinHandle(handle.id): nullptr;
+}
+
+DECLSPEC_DLL bool memHandleUnpin(MemHandle handle)
+{
+    auto entry = ResolveSpace(handle.space);
+
+    return entry != nullptr && entry->UnpinHandle(handle.id);
+}
+
+DECLSPEC_DLL size_t memHandleSize(MemHandle handle)
+{
+    auto entry = ResolveSpace(handle.space);
+
+    return entry != nullptr? entry->HandleSize(handle.id): 0;
+}
+
+DECLSPEC_DLL bool memCompact(MemSpace space, size_t maxMoveBytes, MemCompactStats* stats)
+{
+    auto entry = ResolveSpace(space);
+
+    if (entry == nullptr || stats == nullptr) {
+        return false;
+    }
+
+    entry->Compact(maxMoveBytes, stats);
+    return true;
+}
+
+DECLSPEC_DLL bool memPageSetSampling(MemSpace space, uint32 sampleInterval)
+{
+    auto entry = ResolveSpace(space);
+
+    if (entry == nullptr) {
+        return false;
+    }
+
+    entry->SetSampling(sampleInterval);
+    return true;
+}
+
+// 잘려도 필요한 글자 수는 계속 셈
+static void AppendFormat(wchar_t* buffer, size_t bufferCount, size_t* length, const wchar_t* format, ...)
+{
+    wchar_t line[256];
+    va_list args;
+    va_start(args, format);
+    auto count = vswprintf(line, 256, format, args);
+    va_end(args);
+    if (count < 0) {
+        return;
+    }
+
+    if (*length + 1 < bufferCount) {
+        auto copyCount = bufferCount - *length - 1 < (size_t)count? bufferCount - *length - 1: (size_t)count;
+        wmemcpy(buffer + *length, line, copyCount);
+        buffer[*length + copyCount] = L'\0';
+    }
+    *length += (size_t)count;
+}
+
+DECLSPEC_DLL size_t memPageDump(MemSpace space, wchar_t* buffer, size_t bufferCount)
+{
+    auto entry = ResolveSpace(space);
+    MemPageStats stats;
+
+    if (entry == nullptr || !memPageStats(space, &stats)) {
+        return 0;
+    }
+    if (buffer != nullptr && bufferCount > 0) {
+        buffer[0] = L'\0';
+    }
+    else {
+        bufferCount = 0;
+    }
+
+    size_t length = 0;
+    AppendFormat(buffer, bufferCount, &length, L"[%ls] live %zu bytes in %llu allocs, peak %zu bytes, %llu allocs total\n",
+        entry->name, stats.liveBytes, (unsigned long long)stats.liveCount, stats.peakBytes, (unsigned long long)stats.allocCount);
+    AppendFormat(buffer, bufferCount, &length, L"  pages %zu bytes in %d chunks, free %zu bytes, largest free %zu bytes, fragmentation %.3f\n",
+        stats.pageBytes, stats.chunkCount, stats.freeBytes, stats.largestFreeBytes, stats.fragmentation);
+    if (stats.latencySampleCount > 0) {
+        AppendFormat(buffer, bufferCount, &length, L"  latency p50 %llu ns, p99 %llu ns (%llu samples)\n",
+            (unsigned long long)stats.latencyP50Ns, (unsigned long long)stats.latencyP99Ns, (unsigned long long)stats.latencySampleCount);
+    }
+    for (auto i = 0; i < MEMSTAT_SIZE_BUCKET_COUNT; i++) {
+        if (stats.sizeHistogram[i] == 0) {
+            continue;
+        }
+        if (i == MEMSTAT_SIZE_BUCKET_COUNT - 1) {
+            AppendFormat(buffer, bufferCount, &length, L"  > %zu: %llu\n", (size_t)16 << (i - 1), (unsigned long long)stats.sizeHistogram[i]);
+        }
+        else {
+            AppendFormat(buffer, bufferCount, &length, L"  <= %zu: %llu\n", (size_t)16 << i, (unsigned long long)stats.sizeHistogram[i]);
+        }
+    }
+
+    return length;
+}
+
 DECLSPEC_DLL int32 validPageCount()
 {
     int32 count = 0;
@@ -122,3 +426,50 @@ DECLSPEC_DLL int32 validPageCount()
 
     return count;
 }
+
+static AllocatorEntry* ResolveArena(MemSpace space)
+{
+    auto entry = ResolveSpace(space);
+
+    if (entry == nullptr || entry->kind != MEMPAGE_KIND_ARENA) {
+        return nullptr;
+    }
+
+    return entry;
+}
+
+DECLSPEC_DLL bool memArenaPushH(MemSpace space)
+{
+    auto entry = ResolveArena(space);
+
+    return entry != nullptr && entry->ArenaPush();
+}
+
+DECLSPEC_DLL bool memArenaPopH(MemSpace space)
+{
+    auto entry = ResolveArena(space);
+
+    return entry != nullptr && entry->ArenaPop();
+}
+
+DECLSPEC_DLL bool memArenaResetH(MemSpace space)
+{
+    auto entry = ResolveArena(space);
+
+    return entry != nullptr && entry->ArenaReset();
+}
+
+DECLSPEC_DLL bool memArenaPush(const wchar_t* addrspace)
+{
+    return memArenaPushH(FindSpace(addrspace, false));
+}
+
+DECLSPEC_DLL bool memArenaPop(const wchar_t* addrspace)
+{
+    return memArenaPopH(FindSpace(addrspace, false));
+}
+
+DECLSPEC_DLL bool memArenaReset(const wchar_t* addrspace)
+{
+    return memArenaResetH(FindSpace(addrspace, false));
+}
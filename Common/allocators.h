@@ -4,16 +4,202 @@
 #include "defined_type.h"
 
 #include <string.h>
+#include <wchar.h>
 
 #define SYSTEM_NAME L"system"
 #define PERSISTANT_NAME L"persitant"
 #define TEMPARARY_NAME L"temp"
 
+// 주소 공간 종류
+// MEMPAGE_KIND_SLAB 은 MEMSLAB_MAX_SIZE 이하의 요청을 크기 클래스별 빈 목록에서 O(1) 로 할당
+// 정렬이 16 보다 크거나 offset 이 있는 요청, 더 큰 요청은 기본 경로로 할당
+// MEMPAGE_KIND_ARENA 는 포인터를 밀어서 할당하고 memFree 는 아무것도 하지 않음
+// 아레나 페이지 안의 주소면 블록 중간을 가리키거나 이미 되돌린 주소여도 memFree 는 true, 검증으로 쓰면 안 됨
+// memArenaPush/memArenaPop 으로 저장한 위치로 되돌리거나 memArenaReset 으로 한 번에 비움
+// MEMPAGE_KIND_BUDDY 는 페이지를 2의 거듭제곱 크기로 잡고 BuddyAllocator 로 블록을 나눔
+// 블록은 MEMBUDDY_MIN_BLOCK_SIZE 이상의 2의 거듭제곱, offset 은 MEMBUDDY_MIN_BLOCK_SIZE 보다 작아야 함
+enum MemPageKind
+{
+    MEMPAGE_KIND_DEFAULT = 0,
+    MEMPAGE_KIND_SLAB = 1,
+    MEMPAGE_KIND_ARENA = 2,
+    MEMPAGE_KIND_BUDDY = 3,
+};
+
+// 주소 공간 페이지 옵션
+// MEMPAGE_FLAG_HUGE 는 큰 페이지 (Linux THP, Windows large page) 를 요청, 안 되면 일반 페이지
+// MEMPAGE_FLAG_PREFAULT 는 페이지를 받을 때 미리 채워서 첫 접근 폴트를 없앰
+// MEMPAGE_FLAG_WARM 은 memPageAdd 에서 pageSize 만큼 페이지를 받아두고, 받는 페이지를 백그라운드 스레드에서 채움
+enum MemPageFlag
+{
+    MEMPAGE_FLAG_HUGE = 1 << 1,
+    MEMPAGE_FLAG_PREFAULT = 1 << 2,
+    MEMPAGE_FLAG_WARM = 1 << 3,
+};
+
+// 주소 공간의 페이지가 채워졌는지
+// MEMWARM_COLD 는 받은 페이지가 없거나 첫 접근에서 폴트가 날 페이지가 있음
+enum MemWarmState
+{
+    MEMWARM_COLD = 0,
+    MEMWARM_WARMING = 1,
+    MEMWARM_WARM = 2,
+};
+
+// 빈 페이지를 OS 에 돌려주는 방법
+// MEMTRIM_RELEASE 는 페이지를 해제, MEMTRIM_DECOMMIT 은 주소 범위는 남기고 물리 메모리만 돌려줌
+enum MemTrimMode
+{
+    MEMTRIM_RELEASE = 0,
+    MEMTRIM_DECOMMIT = 1,
+};
+
+// 빈 페이지를 보관할 최대 개수, 기본값은 모두 보관
+constexpr size_t MEMTRIM_RETAIN_ALL = ~(size_t)0;
+
+constexpr int32 MEMSTAT_SIZE_BUCKET_COUNT = 24;
+
+/// <summary>
+/// 주소 공간 통계, memPageStats 로 받음
+/// sizeHistogram[i] 는 요청 크기가 (16 << i) 이하인 할당 수, 마지막 칸은 그보다 큰 할당까지 포함
+/// 빈 공간은 범위/아레나 페이지만 셈, 슬랩 span 안의 빈 블록은 포함하지 않음
+/// 지연 시간은 memPageSetSampling 으로 켰을 때만 채워짐
+/// </summary>
+struct MemPageStats
+{
+    size_t liveBytes;
+    size_t peakBytes;
+    uint64 liveCount;
+    uint64 allocCount;
+    uint64 sizeHistogram[MEMSTAT_SIZE_BUCKET_COUNT];
+
+    size_t pageBytes;
+    int32 chunkCount;
+    size_t freeBytes;
+    size_t largestFreeBytes;
+    // 1 - largestFreeBytes / freeBytes, 빈 공간이 하나로 모여 있으면 0
+    float fragmentation;
+
+    uint64 latencySampleCount;
+    uint64 latencyP50Ns;
+    uint64 latencyP99Ns;
+};
+
+/// <summary>
+/// 주소 공간 핸들, 등록 슬롯과 세대를 묶어서 이름 비교 없이 바로 찾음
+/// 주소 공간이 해제되면 이전 핸들로는 할당/해제가 실패함
+/// </summary>
+struct MemSpace
+{
+    uint64 id;
+
+    explicit operator bool() const { return id != ~(uint64)0; }
+    bool operator==(const MemSpace& o) const { return id == o.id; }
+    bool operator!=(const MemSpace& o) const { return id != o.id; }
+};
+
+constexpr MemSpace MEMSPACE_SYSTEM = { 0 };
+constexpr MemSpace MEMSPACE_INVALID = { ~(uint64)0 };
+
+DECLSPEC_DLL void* memAllocH(size_t size, size_t alignment, size_t alignOffset, MemSpace space);
+// 다른 주소 공간의 블록이나 이미 해제한 블록이면 false, 아레나 주소 공간은 페이지 안의 주소면 항상 true
+DECLSPEC_DLL bool memFreeH(void* ptr, MemSpace space);
+// 뒤쪽 빈 공간으로 늘릴 수 있으면 주소를 유지하고, 안 되면 새로 받아서 옮긴 뒤 ptr 을 해제
+// ptr 이 nullptr 이면 memAllocH 와 같음, 실패하면 nullptr 을 돌려주고 ptr 은 그대로 남음
+DECLSPEC_DLL void* memReallocH(void* ptr, size_t size, size_t alignment, size_t alignOffset, MemSpace space);
+// 이름으로 핸들을 찾음, 시스템 이름은 MEMSPACE_SYSTEM, 없으면 MEMSPACE_INVALID
+DECLSPEC_DLL MemSpace memPageFind(const wchar_t* addrspace);
+
+// 이름을 받는 함수는 핸들을 찾아서 넘기는 호환용
 DECLSPEC_DLL void* memAlloc(size_t size, size_t alignment, size_t alignOffset, const wchar_t* addrspace = SYSTEM_NAME);
 DECLSPEC_DLL bool memFree(void* ptr, const wchar_t* addrspace = SYSTEM_NAME);
+DECLSPEC_DLL void* memRealloc(void* ptr, size_t size, size_t alignment, size_t alignOffset, const wchar_t* addrspace = SYSTEM_NAME);
 DECLSPEC_DLL size_t memAllocSize(const wchar_t* addrspace);
 DECLSPEC_DLL size_t memPageSize(const wchar_t* addrspace);
+// 주소 공간이 받아둔 페이지 크기, system 이나 잘못된 핸들은 0
+DECLSPEC_DLL size_t memPageSizeH(MemSpace space);
 DECLSPEC_DLL size_t memPageMinSize(bool pageLocked);
 DECLSPEC_DLL int32 validPageCount();
-DECLSPEC_DLL bool memPageAdd(const wchar_t* addrspace, size_t pageSize, bool pageLocked);
-DECLSPEC_DLL bool memPageFree(const wchar_t* addrspace);
\ No newline at end of file
+// 같은 이름이 이미 있거나 등록할 수 없으면 MEMSPACE_INVALID
+DECLSPEC_DLL MemSpace memPageAdd(const wchar_t* addrspace, size_t pageSize, bool pageLocked, int32 kind = MEMPAGE_KIND_DEFAULT, uint32 flags = 0);
+DECLSPEC_DLL bool memPageFree(const wchar_t* addrspace);
+// 빈 페이지가 maxRetainedPages 개를 넘으면 넘는 만큼 mode 로 바로 돌려줌
+// 슬랩 span 이 잘린 페이지는 돌려주지 않음
+DECLSPEC_DLL bool memPageSetTrim(MemSpace space, size_t maxRetainedPages, int32 mode = MEMTRIM_RELEASE);
+// 보관 개수와 무관하게 모든 빈 페이지를 돌려주고 돌려준 바이트 수를 반환
+DECLSPEC_DLL size_t memTrim(MemSpace space);
+// 페이지가 reserveBytes 이상이 되도록 받아두고 채우지 않은 페이지를 백그라운드 스레드에서 채움, 바로 돌아옴
+// 채우는 동안에도 할당할 수 있고 이미 쓰고 있는 내용은 바뀌지 않음
+DECLSPEC_DLL bool memPageWarm(MemSpace space, size_t reserveBytes = 0);
+// 프레임 루프에서 불러도 될 만큼 가벼움, 없는 주소 공간은 MEMWARM_COLD
+DECLSPEC_DLL int32 memPageWarmState(MemSpace space);
+
+// system 주소 공간은 통계가 없으므로 false
+DECLSPEC_DLL bool memPageStats(MemSpace space, MemPageStats* stats);
+// sampleInterval 번째 할당마다 걸린 시간을 기록, 0 이면 끔
+DECLSPEC_DLL bool memPageSetSampling(MemSpace space, uint32 sampleInterval);
+// 통계를 읽기 좋은 문자열로 buffer 에 씀, 잘리지 않았을 때의 글자 수를 반환
+DECLSPEC_DLL size_t memPageDump(MemSpace space, wchar_t* buffer, size_t bufferCount);
+
+// 매 프레임 부르는 곳은 핸들을 받는 쪽을 씀, 이름을 받는 쪽은 핸들을 찾아서 넘기는 호환용
+DECLSPEC_DLL bool memArenaPushH(MemSpace space);
+DECLSPEC_DLL bool memArenaPopH(MemSpace space);
+DECLSPEC_DLL bool memArenaResetH(MemSpace space);
+DECLSPEC_DLL bool memArenaPush(const wchar_t* addrspace);
+DECLSPEC_DLL bool memArenaPop(const wchar_t* addrspace);
+DECLSPEC_DLL bool memArenaReset(const wchar_t* addrspace);
+
+// 범위를 벗어날 때 memArenaPop
+struct MemArenaScope
+{
+    MemSpace space;
+    bool pushed;
+
+    MemArenaScope(const wchar_t* addrspace) : space(memPageFind(addrspace)), pushed(memArenaPushH(space)) {}
+    MemArenaScope(MemSpace space) : space(space), pushed(memArenaPushH(space)) {}
+    ~MemArenaScope() { if (pushed) memArenaPopH(space); }
+    MemArenaScope(const MemArenaScope&) = delete;
+    MemArenaScope& operator=(const MemArenaScope&) = delete;
+};
+
+/// <summary>
+/// 옮길 수 있는 할당의 핸들, 기본 종류 주소 공간에서만 만들 수 있음
+/// 주소는 memHandlePin 으로 받아서 memHandleUnpin 할 때까지만 유효
+/// 고정되지 않은 블록은 memCompact 가 다른 위치로 옮김
+/// </summary>
+struct MemHandle
+{
+    MemSpace space;
+    uint64 id;
+
+    explicit operator bool() const { return id != 0; }
+};
+
+constexpr MemHandle MEMHANDLE_NULL = { MEMSPACE_SYSTEM, 0 };
+
+/// <summary>
+/// memCompact 한 번의 결과
+/// </summary>
+struct MemCompactStats
+{
+    size_t movedBytes;
+    uint64 movedCount;
+    // 고정되어 있어서 건너뛴 핸들 수
+    uint64 pinnedCount;
+    // 비워져서 돌려준 페이지 크기
+    size_t releasedBytes;
+    // 주소 공간을 잠근 시간
+    uint64 pauseNs;
+};
+
+// 실패하면 MEMHANDLE_NULL
+DECLSPEC_DLL MemHandle memHandleAlloc(size_t size, size_t alignment, MemSpace space);
+// 고정된 핸들은 해제할 수 없음
+DECLSPEC_DLL bool memHandleFree(MemHandle handle);
+// 고정 횟수를 세고 고정된 동안에는 주소가 바뀌지 않음
+DECLSPEC_DLL void* memHandlePin(MemHandle handle);
+DECLSPEC_DLL bool memHandleUnpin(MemHandle handle);
+DECLSPEC_DLL size_t memHandleSize(MemHandle handle);
+// 고정되지 않은 핸들 블록을 앞쪽 청크의 낮은 주소로 밀어 넣고 비워진 페이지를 돌려줌
+// maxMoveBytes 를 옮기면 멈추므로 백그라운드 스레드에서 조금씩 나눠 불러서 멈춤 시간을 제한할 수 있음
+DECLSPEC_DLL bool memCompact(MemSpace space, size_t maxMoveBytes, MemCompactStats* stats);
@@ -0,0 +1,287 @@
+#include "buddyallocator.h"
+#include "allocators.h"
+
+#include <string.h>
+#include <wchar.h>
+
+constexpr uint8 BUDDY_LEAF_NONE = 0xFF;
+constexpr uint8 BUDDY_LEAF_FREE = 0x80;
+constexpr uint8 BUDDY_LEAF_ORDER_MASK = 0x3F;
+constexpr uint32 BUDDY_LEAF_NULL = 0xFFFFFFFF;
+// 목록 연결을 32비트 인덱스로 하므로 최소 블록 수의 상한
+constexpr uint64 BUDDY_MAX_LEAF_COUNT = (uint64)1 << 31;
+
+static int32 BitScanForward64(uint64 v)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return (int32)index;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+static int32 BitScanReverse64(uint64 v)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return (int32)index;
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+static bool IsPowerOfTwo(uint64 v)
+{
+    return v != 0 && (v & (v - 1)) == 0;
+}
+
+// 빈 블록의 leafData 는 하위 32비트가 다음, 상위 32비트가 이전 블록
+static uint32 NextLeaf(uint64 data) { return (uint32)(data & 0xFFFFFFFF); }
+static uint32 PrevLeaf(uint64 data) { return (uint32)(data >> 32); }
+static uint64 LinkLeaf(uint32 next, uint32 prev) { return (uint64)next | ((uint64)prev << 32); }
+
+DECLSPEC_DLL bool BuddyAllocator::Init(const wchar_t* addrspace, uint64 heapSize, uint64 minBlockSize)
+{
+    this->addrspace = addrspace != nullptr && wcscmp(addrspace, L"") != 0? addrspace: SYSTEM_NAME;
+    this->heapSize = 0;
+    leafStates = nullptr;
+    leafData = nullptr;
+    freeMask = 0;
+    allocCount = 0;
+    usedBytes = 0;
+    requestedBytes = 0;
+    for (auto i = 0; i < BUDDY_MAX_ORDER_COUNT; i++) {
+        freeHeads[i] = BUDDY_LEAF_NULL;
+        freeCounts[i] = 0;
+    }
+
+    if (!IsPowerOfTwo(heapSize) || !IsPowerOfTwo(minBlockSize) || heapSize < minBlockSize ||
+        heapSize / minBlockSize > BUDDY_MAX_LEAF_COUNT) {
+        return false;
+    }
+
+    leafShift = BitScanReverse64(minBlockSize);
+    maxOrder = BitScanReverse64(heapSize) - leafShift;
+    leafCount = (uint32)(heapSize >> leafShift);
+
+    leafStates = (uint8*)memAlloc(leafCount, alignof(uint8), 0, this->addrspace);
+    leafData = (uint64*)memAlloc(sizeof(uint64) * leafCount, alignof(uint64), 0, this->addrspace);
+    if (leafStates == nullptr || leafData == nullptr) {
+        Destroy();
+        return false;
+    }
+    memset(leafStates, BUDDY_LEAF_NONE, leafCount);
+
+    // 힙 전체를 가장 큰 블록 하나로 시작
+    this->heapSize = heapSize;
+    PushFree(0, maxOrder);
+    return true;
+}
+
+DECLSPEC_DLL bool BuddyAllocator::Destroy()
+{
+    auto result = true;
+    if (leafStates) {
+        result &= memFree(leafStates, addrspace);
+        leafStates = nullptr;
+    }
+    if (leafData) {
+        result &= memFree(leafData, addrspace);
+        leafData = nullptr;
+    }
+
+    heapSize = 0;
+    leafCount = 0;
+    freeMask = 0;
+    allocCount = 0;
+    usedBytes = 0;
+    requestedBytes = 0;
+    return result;
+}
+
+int32 BuddyAllocator::OrderOf(uint64 size) const
+{
+    if (size <= ((uint64)1 << leafShift)) {
+        return 0;
+    }
+    return BitScanReverse64(size - 1) + 1 - leafShift;
+}
+
+void BuddyAllocator::PushFree(uint32 leaf, int32 order)
+{
+    auto head = freeHeads[order];
+    if (head != BUDDY_LEAF_NULL) {
+        leafData[head] = LinkLeaf(NextLeaf(leafData[head]), leaf);
+    }
+    leafData[leaf] = LinkLeaf(head, BUDDY_LEAF_NULL);
+    leafStates[leaf] = (uint8)order | BUDDY_LEAF_FREE;
+
+    freeHeads[order] = leaf;
+    freeCounts[order]++;
+    freeMask |= (uint64)1 << order;
+}
+
+void BuddyAllocator::RemoveFree(uint32 leaf, int32 order)
+{
+    auto next = NextLeaf(leafData[leaf]);
+    auto prev = PrevLeaf(leafData[leaf]);
+    if (prev != BUDDY_LEAF_NULL) {
+        leafData[prev] = LinkLeaf(next, PrevLeaf(leafData[prev]));
+    } else {
+        freeHeads[order] = next;
+    }
+    if (next != BUDDY_LEAF_NULL) {
+        leafData[next] = LinkLeaf(NextLeaf(leafData[next]), prev);
+    }
+    leafStates[leaf] = BUDDY_LEAF_NONE;
+
+    if (--freeCounts[order] == 0) {
+        freeMask &= ~((uint64)1 << order);
+    }
+}
+
+DECLSPEC_DLL uint64 BuddyAllocator::Alloc(uint64 size, uint64 alignment)
+{
+    if (heapSize == 0 || size == 0 || size > heapSize || !IsPowerOfTwo(alignment)) {
+        return BUDDY_INVALID_OFFSET;
+    }
+
+    auto order = OrderOf(size > alignment? size: alignment);
+    if (order > maxOrder) {
+        return BUDDY_INVALID_OFFSET;
+    }
+
+    // order 이상에서 가장 작은 빈 블록
+    auto mask = freeMask & (~(uint64)0 << order);
+    if (mask == 0) {
+        return BUDDY_INVALID_OFFSET;
+    }
+    auto found = BitScanForward64(mask);
+    auto leaf = freeHeads[found];
+    RemoveFree(leaf, found);
+
+    // 남는 뒤쪽 절반을 한 단계씩 빈 목록에 넣음
+    while (found > order) {
+        found--;
+        PushFree(leaf + ((uint32)1 << found), found);
+    }
+
+    leafStates[leaf] = (uint8)order;
+    leafData[leaf] = size;
+    allocCount++;
+    usedBytes += (uint64)1 << (order + leafShift);
+    requestedBytes += size;
+    return (uint64)leaf << leafShift;
+}
+
+DECLSPEC_DLL bool BuddyAllocator::Free(uint64 offset)
+{
+    if (offset >= heapSize || (offset & (((uint64)1 << leafShift) - 1)) != 0) {
+        return false;
+    }
+
+    auto leaf = (uint32)(offset >> leafShift);
+    auto state = leafStates[leaf];
+    if (state == BUDDY_LEAF_NONE || (state & BUDDY_LEAF_FREE) != 0) {
+        return false;
+    }
+
+    int32 order = state & BUDDY_LEAF_ORDER_MASK;
+    allocCount--;
+    usedBytes -= (uint64)1 << (order + leafShift);
+    requestedBytes -= leafData[leaf];
+    leafStates[leaf] = BUDDY_LEAF_NONE;
+
+    // 짝 블록이 같은 크기로 비어있는 동안 합침
+    while (order < maxOrder) {
+        auto buddy = leaf ^ ((uint32)1 << order);
+        if (leafStates[buddy] != ((uint8)order | BUDDY_LEAF_FREE)) {
+            break;
+        }
+        RemoveFree(buddy, order);
+        leaf = leaf < buddy? leaf: buddy;
+        order++;
+    }
+
+    PushFree(leaf, order);
+    return true;
+}
+
+DECLSPEC_DLL bool BuddyAllocator::Resize(uint64 offset, uint64 size)
+{
+    uint64 blockSize, requested;
+    if (size == 0 || !Query(offset, &blockSize, &requested) || size > blockSize) {
+        return false;
+    }
+
+    auto leaf = (uint32)(offset >> leafShift);
+    requestedBytes = requestedBytes - requested + size;
+    leafData[leaf] = size;
+    return true;
+}
+
+DECLSPEC_DLL bool BuddyAllocator::Query(uint64 offset, uint64* blockSize, uint64* requested) const
+{
+    if (offset >= heapSize || (offset & (((uint64)1 << leafShift) - 1)) != 0) {
+        return false;
+    }
+
+    auto leaf = (uint32)(offset >> leafShift);
+    auto state = leafStates[leaf];
+    if (state == BUDDY_LEAF_NONE || (state & BUDDY_LEAF_FREE) != 0) {
+        return false;
+    }
+
+    *blockSize = (uint64)1 << ((state & BUDDY_LEAF_ORDER_MASK) + leafShift);
+    *requested = leafData[leaf];
+    return true;
+}
+
+DECLSPEC_DLL void BuddyAllocator::Stats(BuddyStats* stats) const
+{
+    memset(stats, 0, sizeof(BuddyStats));
+    if (heapSize == 0) {
+        return;
+    }
+
+    stats->heapSize = heapSize;
+    stats->minBlockSize = (uint64)1 << leafShift;
+    stats->orderCount = maxOrder + 1;
+    stats->allocCount = allocCount;
+    stats->usedBytes = usedBytes;
+    stats->requestedBytes = requestedBytes;
+    stats->freeBytes = heapSize - usedBytes;
+
+    for (auto i = 0; i <= maxOrder; i++) {
+        stats->freeBlockCounts[i] = freeCounts[i];
+    }
+    if (freeMask != 0) {
+        stats->largestFreeBytes = (uint64)1 << (BitScanReverse64(freeMask) + leafShift);
+    }
+    if (stats->freeBytes > 0) {
+        stats->fragmentation = 1.0f - (float)((double)stats->largestFreeBytes / (double)stats->freeBytes);
+    }
+}
+
+DECLSPEC_DLL uint64 BuddyAllocator::HeapSize() const
+{
+    return heapSize;
+}
+
+DECLSPEC_DLL uint64 BuddyAllocator::MinBlockSize() const
+{
+    return (uint64)1 << leafShift;
+}
+
+DECLSPEC_DLL uint64 BuddyAllocator::UsedBytes() const
+{
+    return usedBytes;
+}
+
+DECLSPEC_DLL uint32 BuddyAllocator::AllocCount() const
+{
+    return allocCount;
+}
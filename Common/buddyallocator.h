@@ -0,0 +1,84 @@
+#pragma once
+
+#include "symbols.h"
+#include "defined_type.h"
+
+constexpr int32 BUDDY_MAX_ORDER_COUNT = 64;
+constexpr uint64 BUDDY_INVALID_OFFSET = ~(uint64)0;
+
+/// <summary>
+/// 버디 힙의 단편화 보고
+/// order 는 블록 크기가 minBlockSize << order 인 단계
+/// </summary>
+struct BuddyStats
+{
+    uint64 heapSize;
+    uint64 minBlockSize;
+    int32 orderCount;
+    uint32 allocCount;
+    // 할당된 블록 크기의 합과 요청 크기의 합, 차이가 2의 거듭제곱으로 올리면서 버린 크기
+    uint64 usedBytes;
+    uint64 requestedBytes;
+    uint64 freeBytes;
+    uint64 largestFreeBytes;
+    uint32 freeBlockCounts[BUDDY_MAX_ORDER_COUNT];
+    // 1 - (가장 큰 빈 블록 / 전체 빈 크기)
+    float fragmentation;
+};
+
+/// <summary>
+/// 2^k 크기의 추상 힙에서 오프셋을 나눠주는 버디 할당기, 메모리에 직접 쓰지 않음
+/// GPU 힙처럼 CPU 에서 접근할 수 없는 메모리를 (힙, 오프셋) 으로 나눌 때 사용
+/// 할당과 해제는 O(log n), 해제할 때 짝 블록이 비어있으면 합침
+/// 관리 정보는 최소 블록마다 9 바이트를 addrspace 에서 받음
+/// C 스타일 컨테이너, ABI 를 위해 템플릿 사용 금지
+/// </summary>
+class DECLSPEC_DLL BuddyAllocator
+{
+public:
+    // heapSize, minBlockSize 는 2의 거듭제곱이고 heapSize >= minBlockSize
+    bool Init(const wchar_t* addrspace, uint64 heapSize, uint64 minBlockSize);
+    bool Destroy();
+
+public:
+    // 블록은 블록 크기로 정렬되므로 alignment 가 size 보다 크면 alignment 크기의 블록을 씀
+    // 실패하면 BUDDY_INVALID_OFFSET
+    uint64 Alloc(uint64 size, uint64 alignment = 1);
+    // Alloc 이 준 오프셋이 아니면 false
+    bool Free(uint64 offset);
+    // 블록 크기 안이면 요청 크기만 바꾸고 true, 아니면 false
+    bool Resize(uint64 offset, uint64 size);
+    bool Query(uint64 offset, uint64* blockSize, uint64* requested) const;
+    void Stats(BuddyStats* stats) const;
+
+public:
+    uint64 HeapSize() const;
+    uint64 MinBlockSize() const;
+    uint64 UsedBytes() const;
+    uint32 AllocCount() const;
+
+private:
+    int32 OrderOf(uint64 size) const;
+    void PushFree(uint32 leaf, int32 order);
+    void RemoveFree(uint32 leaf, int32 order);
+
+private:
+    const wchar_t* addrspace;
+    uint64 heapSize;
+    int32 leafShift;
+    int32 maxOrder;
+    uint32 leafCount;
+
+    // 블록 첫 최소 블록마다 상태 1 바이트, 빈 블록이면 목록 연결, 사용중이면 요청 크기
+    uint8* leafStates;
+    uint64* leafData;
+
+    uint32 freeHeads[BUDDY_MAX_ORDER_COUNT];
+    uint32 freeCounts[BUDDY_MAX_ORDER_COUNT];
+    // 빈 목록이 있는 order 의 비트
+    uint64 freeMask;
+
+    uint32 allocCount;
+    uint64 usedBytes;
+    uint64 requestedBytes;
+};
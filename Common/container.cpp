@@ -32,10 +32,12 @@ DECLSPEC_DLL bool ArrayList::Destroy()
 
 DECLSPEC_DLL bool ArrayList::CopyFrom(const ArrayList* list)
 {
-    ResizeMem(list->capacity);
-
     this->step = list->step;
     this->alignment = list->alignment;
+
+    if (!ResizeMem(list->capacity)) {
+        return false;
+    }
     this->count = list->count;
 
     memcpy(singleChunkPtr, list->singleChunkPtr, this->count * this->step);
@@ -44,31 +46,27 @@ DECLSPEC_DLL bool ArrayList::CopyFrom(const ArrayList* list)
 
 DECLSPEC_DLL bool ArrayList::CopyFrom(const ArrayList& list)
 {
-    ResizeMem(list.capacity);
-
     this->step = list.step;
     this->alignment = list.alignment;
+
+    if (!ResizeMem(list.capacity)) {
+        return false;
+    }
     this->count = list.count;
 
     memcpy(singleChunkPtr, list.singleChunkPtr, this->count * this->step);
     return true;
 }
 
-#define min(a, b) ((a < b)? (a): (b))
-
 DECLSPEC_DLL bool ArrayList::ResizeMem(uint64 capacity)
 {
-    auto newPtr = memAlloc((uint64)step * capacity, alignment, 0, addrspace);
+    // 뒤쪽이 비어 있으면 복사 없이 늘어나고, 옮기면 이전 블록은 memRealloc 에서 해제
+    auto newPtr = memRealloc(singleChunkPtr, (uint64)step * capacity, alignment, 0, addrspace);
 
     if (newPtr == nullptr) {
         return false;
     }
 
-    if (singleChunkPtr != nullptr) {
-        auto minCapacitySize = min((uint64)step * capacity, (uint64)step * this->capacity);
-        memcpy(newPtr, singleChunkPtr, minCapacitySize);
-    }
-
     this->capacity = capacity;
     singleChunkPtr = newPtr;
 
@@ -115,7 +113,7 @@ DECLSPEC_DLL bool ArrayList::Insert(int32 startIndex, int32 count, NOTNULL void*
     }
 
     // 공간 확보 하기, 이거 없으면 Add 랑 동일
-    if (startIndex + 1 < this->count) {
+    if (startIndex < this->count) {
         auto srcArrPtr = (char*)singleChunkPtr + ((startIndex)         * step);
         auto dstArrPtr = (char*)singleChunkPtr + ((startIndex + count) * step);
         auto remainItemCount = this->count - startIndex;
@@ -9,6 +9,9 @@
 #define ARRAYLIST_DEFAULT_CAPACITY  32
 #define ARRAYLIST_DEFAULT_ALIGNMENT 32
 
+template <typename T>
+class TypedArrayList;
+
 /// <summary>
 /// C 스타일 컨테이너, ABI 를 위해 템플릿 사용 금지
 /// </summary>
@@ -49,6 +52,10 @@ public: // list accessor
     int32 Alignment() const;
 
 private:
+    // 헤더 전용 래퍼, 원소 수와 블록을 직접 다룸 (typedarraylist.h)
+    template <typename T>
+    friend class TypedArrayList;
+
     void* singleChunkPtr;
     
     const wchar_t* addrspace;
@@ -0,0 +1,121 @@
+#include "frameallocator.h"
+#include "allocators.h"
+
+#include <thread>
+#include <wchar.h>
+
+static uint64 CounterRetiredFrame(void* userData)
+{
+    return ((MemEpochCounter*)userData)->retired.load(std::memory_order_acquire);
+}
+
+MemEpochCounter::MemEpochCounter() : retired(0) {}
+
+DECLSPEC_DLL void MemEpochCounter::Retire(uint64 frame)
+{
+    auto current = retired.load(std::memory_order_relaxed);
+    while (current < frame && !retired.compare_exchange_weak(current, frame, std::memory_order_release)) {}
+}
+
+DECLSPEC_DLL MemEpochSource MemEpochCounter::Source()
+{
+    MemEpochSource source;
+    source.retiredFrame = CounterRetiredFrame;
+    source.userData = this;
+    return source;
+}
+
+DECLSPEC_DLL bool FrameArena::Init(const wchar_t* name, int32 bufferCount, size_t pageSize, MemEpochSource epochSource)
+{
+    this->bufferCount = 0;
+    this->frame = 0;
+    this->epochSource = epochSource;
+
+    auto length = wcslen(name);
+    if (bufferCount < 1 || bufferCount > FRAMEARENA_MAX_BUFFER ||
+        length == 0 || length + 3 > FRAMEARENA_NAME_MAX ||
+        epochSource.retiredFrame == nullptr) {
+        return false;
+    }
+
+    // 이름#0, 이름#1, ... 주소 공간을 만듦
+    for (auto i = 0; i < bufferCount; i++) {
+        wmemcpy(names[i], name, length);
+        names[i][length] = L'#';
+        names[i][length + 1] = (wchar_t)(L'0' + i);
+        names[i][length + 2] = L'\0';
+
+        spaces[i] = memPageAdd(names[i], pageSize, false, MEMPAGE_KIND_ARENA);
+        if (!spaces[i]) {
+            Destroy();
+            return false;
+        }
+        this->bufferCount = i + 1;
+    }
+
+    return true;
+}
+
+DECLSPEC_DLL bool FrameArena::Destroy()
+{
+    for (auto i = 0; i < bufferCount; i++) {
+        memPageFree(names[i]);
+    }
+
+    this->bufferCount = 0;
+    this->frame = 0;
+    return true;
+}
+
+DECLSPEC_DLL bool FrameArena::IsRetired(uint64 frame) const
+{
+    return frame == 0 || epochSource.retiredFrame(epochSource.userData) >= frame;
+}
+
+DECLSPEC_DLL bool FrameArena::BeginFrame(uint64 frame, bool wait)
+{
+    if (bufferCount == 0 || frame <= this->frame) {
+        return false;
+    }
+
+    // 같은 arena 를 마지막으로 쓴 프레임은 frame - bufferCount 이하
+    auto previous = frame > (uint64)bufferCount? frame - bufferCount: 0;
+    while (!IsRetired(previous)) {
+        if (!wait) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+
+    auto index = (int32)(frame % bufferCount);
+    if (!memArenaResetH(spaces[index])) {
+        return false;
+    }
+
+    this->frame = frame;
+    return true;
+}
+
+DECLSPEC_DLL void* FrameArena::Alloc(size_t size, size_t alignment, size_t offset)
+{
+    if (frame == 0) {
+        return nullptr;
+    }
+
+    return memAllocH(size, alignment, offset, spaces[frame % bufferCount]);
+}
+
+DECLSPEC_DLL const wchar_t* FrameArena::AddrSpace() const
+{
+    return frame == 0? nullptr: names[frame % bufferCount];
+}
+
+DECLSPEC_DLL uint64 FrameArena::Frame() const
+{
+    return frame;
+}
+
+DECLSPEC_DLL int32 FrameArena::BufferCount() const
+{
+    return bufferCount;
+}
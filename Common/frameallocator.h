@@ -0,0 +1,66 @@
+#pragma once
+
+#include "symbols.h"
+#include "defined_type.h"
+#include "allocators.h"
+
+#include <atomic>
+
+constexpr int32 FRAMEARENA_MAX_BUFFER = 4;
+constexpr int32 FRAMEARENA_NAME_MAX = 64;
+
+/// <summary>
+/// 마지막으로 끝난 프레임 번호를 알려주는 곳 (GPU 펜스 등)
+/// 프레임 번호는 1 부터 시작, 끝난 프레임이 없으면 0
+/// </summary>
+struct MemEpochSource
+{
+    uint64 (*retiredFrame)(void* userData);
+    void* userData;
+};
+
+/// <summary>
+/// 직접 올리는 epoch, GPU 없이 테스트하거나 CPU 에서 프레임을 끝낼 때 사용
+/// </summary>
+struct DECLSPEC_DLL MemEpochCounter
+{
+    std::atomic<uint64> retired;
+
+    MemEpochCounter();
+
+    // 이미 끝난 프레임보다 작은 값은 무시
+    void Retire(uint64 frame);
+    MemEpochSource Source();
+};
+
+/// <summary>
+/// 프레임 단위 임시 메모리, bufferCount 개의 arena 주소 공간을 돌려씀
+/// frame 의 arena 는 frame - bufferCount 가 끝난 뒤에만 비우고 다시 씀
+/// 프레임 안에서는 해제 없이 할당만 함
+/// </summary>
+class DECLSPEC_DLL FrameArena
+{
+public:
+    bool Init(const wchar_t* name, int32 bufferCount, size_t pageSize, MemEpochSource epochSource);
+    bool Destroy();
+
+public:
+    // wait 가 false 면 같은 arena 를 쓰던 프레임이 끝나지 않았을 때 바로 false
+    bool BeginFrame(uint64 frame, bool wait = true);
+    bool IsRetired(uint64 frame) const;
+
+    void* Alloc(size_t size, size_t alignment, size_t offset = 0);
+
+public:
+    // 현재 프레임의 주소 공간 이름, memAlloc 이나 ArrayList 에 그대로 넘길 수 있음
+    const wchar_t* AddrSpace() const;
+    uint64 Frame() const;
+    int32 BufferCount() const;
+
+private:
+    wchar_t names[FRAMEARENA_MAX_BUFFER][FRAMEARENA_NAME_MAX];
+    MemSpace spaces[FRAMEARENA_MAX_BUFFER];
+    int32 bufferCount;
+    uint64 frame;
+    MemEpochSource epochSource;
+};
@@ -0,0 +1,425 @@
+#include "hashmap.h"
+#include "allocators.h"
+
+#include <string.h>
+#include <wchar.h>
+
+// 슬롯 해시의 최상위 비트는 사용중 표시, 홈 슬롯은 하위 비트로 정하므로 용량은 2^30 까지
+constexpr uint32 HASHMAP_SLOT_USED = 0x80000000;
+constexpr uint64 HASHMAP_MAX_CAPACITY = (uint64)1 << 30;
+constexpr int32 HASHMAP_BLOCK_ALIGNMENT = 16;
+
+static uint64 RotateLeft(uint64 v, int32 shift)
+{
+    return (v << shift) | (v >> (64 - shift));
+}
+
+static uint64 MixKey(uint64 k)
+{
+    k *= 0x87c37b91114253d5ull;
+    k = RotateLeft(k, 31);
+    return k * 0x4cf5ad432745937full;
+}
+
+static uint64 Finalize(uint64 h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    return h ^ (h >> 33);
+}
+
+// MurmurHash3 의 64비트 한 줄짜리 변형, 8바이트씩 섞음
+DECLSPEC_DLL uint64 hashBytes(const void* p, size_t size, uint64 seed)
+{
+    auto bytes = (const uint8*)p;
+    auto h = seed ^ (size * 0x9E3779B97F4A7C15ull);
+
+    auto blockCount = size / 8;
+    for (size_t i = 0; i < blockCount; i++) {
+        uint64 k;
+        memcpy(&k, bytes + i * 8, 8);
+        h ^= MixKey(k);
+        h = RotateLeft(h, 27) * 5 + 0x52dce729;
+    }
+
+    uint64 tail = 0;
+    auto remain = size & 7;
+    if (remain > 0) {
+        memcpy(&tail, bytes + blockCount * 8, remain);
+        h ^= MixKey(tail);
+    }
+
+    return Finalize(h);
+}
+
+DECLSPEC_DLL uint64 hashString(const char* str, uint64 seed)
+{
+    return hashBytes(str, strlen(str), seed);
+}
+
+DECLSPEC_DLL uint64 hashWString(const wchar_t* str, uint64 seed)
+{
+    return hashBytes(str, wcslen(str) * sizeof(wchar_t), seed);
+}
+
+DECLSPEC_DLL uint64 hashMapStringHash(const void* key, int32 keyStep, void* param)
+{
+    return hashString(*(const char* const*)key);
+}
+
+DECLSPEC_DLL bool hashMapStringEqual(const void* key0, const void* key1, int32 keyStep, void* param)
+{
+    return strcmp(*(const char* const*)key0, *(const char* const*)key1) == 0;
+}
+
+DECLSPEC_DLL uint64 hashMapWStringHash(const void* key, int32 keyStep, void* param)
+{
+    return hashWString(*(const wchar_t* const*)key);
+}
+
+DECLSPEC_DLL bool hashMapWStringEqual(const void* key0, const void* key1, int32 keyStep, void* param)
+{
+    return wcscmp(*(const wchar_t* const*)key0, *(const wchar_t* const*)key1) == 0;
+}
+
+static int32 RoundUp(int32 value, int32 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// 7/8 까지 채움
+static bool Overloaded(uint64 count, uint64 capacity)
+{
+    return count * 8 > capacity * 7;
+}
+
+// 곱셈 해시는 아래쪽 비트가 약하므로 위쪽 32비트를 씀
+static uint32 SlotHash(uint64 h)
+{
+    return (uint32)(h >> 32) | HASHMAP_SLOT_USED;
+}
+
+DECLSPEC_DLL bool HashMap::Init(
+    const wchar_t* addrspace, int32 keyStep, int32 valueStep,
+    NULLABLE HashMapHashFunc hash, NULLABLE HashMapEqualFunc equal, NULLABLE void* param, uint64 capacity
+)
+{
+    this->addrspace = addrspace != nullptr && wcscmp(addrspace, L"") != 0? addrspace: SYSTEM_NAME;
+    this->hash = hash;
+    this->equal = equal;
+    this->param = param;
+    this->keyStep = 0;
+    this->valueStep = 0;
+    entries = nullptr;
+    this->capacity = 0;
+    count = 0;
+
+    if (keyStep <= 0 || valueStep < 0) {
+        return false;
+    }
+
+    // 슬롯 해시 뒤에 키, 작은 키는 해시 옆 4바이트에 넣음
+    this->keyStep = keyStep;
+    this->valueStep = valueStep;
+    keyOffset = keyStep <= 4? 4: 8;
+    valueOffset = RoundUp(keyOffset + keyStep, 8);
+    stride = RoundUp(valueOffset + valueStep, 8);
+
+    if (!Reserve(capacity > 0? capacity: 1)) {
+        this->keyStep = 0;
+        return false;
+    }
+    return true;
+}
+
+DECLSPEC_DLL bool HashMap::Destroy()
+{
+    auto result = true;
+    if (entries != nullptr) {
+        result = memFree(entries, addrspace);
+    }
+
+    entries = nullptr;
+    capacity = 0;
+    count = 0;
+    keyStep = 0;
+    valueStep = 0;
+    return result;
+}
+
+DECLSPEC_DLL bool HashMap::Reserve(uint64 count)
+{
+    if (keyStep == 0) {
+        return false;
+    }
+
+    auto newCapacity = capacity > 0? capacity: HASHMAP_DEFAULT_CAPACITY;
+    while (Overloaded(count, newCapacity)) {
+        newCapacity *= 2;
+    }
+    if (newCapacity == capacity) {
+        return true;
+    }
+    if (newCapacity > HASHMAP_MAX_CAPACITY) {
+        return false;
+    }
+    return Rehash(newCapacity);
+}
+
+uint8* HashMap::Entry(uint64 index) const
+{
+    return entries + (size_t)index * stride;
+}
+
+uint32& HashMap::SlotHashAt(uint64 index) const
+{
+    return *(uint32*)Entry(index);
+}
+
+uint64 HashMap::Hash(const void* key) const
+{
+    if (hash != nullptr) {
+        return hash(key, keyStep, param);
+    }
+    // 정수 키는 곱하기 한 번으로 섞음, 슬롯은 위쪽 32비트로 정함
+    if (keyStep == 8) {
+        uint64 k;
+        memcpy(&k, key, 8);
+        return k * 0x9E3779B97F4A7C15ull;
+    }
+    return hashBytes(key, keyStep);
+}
+
+bool HashMap::Equal(const void* key, const void* other) const
+{
+    if (equal != nullptr) {
+        return equal(key, other, keyStep, param);
+    }
+    if (keyStep == 8) {
+        return *(const uint64*)key == *(const uint64*)other;
+    }
+    return memcmp(key, other, keyStep) == 0;
+}
+
+int64 HashMap::FindSlot(const void* key, uint32 slotHash) const
+{
+    auto mask = capacity - 1;
+    auto pos = slotHash & mask;
+    for (uint64 dist = 0;; dist++) {
+        auto current = SlotHashAt(pos);
+        if (current == slotHash && Equal(key, Entry(pos) + keyOffset)) {
+            return (int64)pos;
+        }
+        // 빈 슬롯이나 홈에서 더 가까운 원소를 만나면 찾는 키는 없음
+        if (current == 0 || ((pos - (current & mask)) & mask) < dist) {
+            return -1;
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+void* HashMap::Place(uint32 slotHash, const void* key, const void* value)
+{
+    // 옮기는 중인 원소는 마지막 임시 entry 에 둠
+    auto carried = Entry(capacity);
+    *(uint32*)carried = slotHash;
+    memcpy(carried + keyOffset, key, keyStep);
+    if (value != nullptr) {
+        memcpy(carried + valueOffset, value, valueStep);
+    } else {
+        memset(carried + valueOffset, 0, valueStep);
+    }
+
+    void* result = nullptr;
+    auto mask = capacity - 1;
+    auto pos = slotHash & mask;
+    uint64 dist = 0;
+    for (;;) {
+        auto current = SlotHashAt(pos);
+        if (current == 0) {
+            memcpy(Entry(pos), carried, stride);
+            count++;
+            return result != nullptr? result: Entry(pos) + valueOffset;
+        }
+
+        // 홈에서 덜 떨어진 원소의 자리를 빼앗고 그 원소를 들고 계속 감
+        auto currentDist = (pos - (current & mask)) & mask;
+        if (currentDist < dist) {
+            auto slot = (uint64*)Entry(pos);
+            auto temp = (uint64*)carried;
+            for (auto i = 0; i < stride / 8; i++) {
+                auto v = slot[i];
+                slot[i] = temp[i];
+                temp[i] = v;
+            }
+            if (result == nullptr) {
+                result = Entry(pos) + valueOffset;
+            }
+            dist = currentDist;
+        }
+
+        pos = (pos + 1) & mask;
+        dist++;
+    }
+}
+
+bool HashMap::Rehash(uint64 newCapacity)
+{
+    auto newEntries = (uint8*)memAlloc((size_t)stride * (newCapacity + 1), HASHMAP_BLOCK_ALIGNMENT, 0, addrspace);
+    if (newEntries == nullptr) {
+        return false;
+    }
+
+    auto oldEntries = entries;
+    auto oldCapacity = capacity;
+
+    entries = newEntries;
+    capacity = newCapacity;
+    count = 0;
+    for (uint64 i = 0; i < newCapacity; i++) {
+        SlotHashAt(i) = 0;
+    }
+
+    for (uint64 i = 0; i < oldCapacity; i++) {
+        auto entry = oldEntries + (size_t)i * stride;
+        auto slotHash = *(uint32*)entry;
+        if (slotHash != 0) {
+            Place(slotHash, entry + keyOffset, entry + valueOffset);
+        }
+    }
+
+    if (oldEntries != nullptr) {
+        memFree(oldEntries, addrspace);
+    }
+    return true;
+}
+
+DECLSPEC_DLL void* HashMap::Find(const void* key) const
+{
+    if (keyStep == 0 || count == 0) {
+        return nullptr;
+    }
+
+    auto h = Hash(key);
+    auto slot = FindSlot(key, SlotHash(h));
+    return slot >= 0? Entry(slot) + valueOffset: nullptr;
+}
+
+DECLSPEC_DLL void* HashMap::Insert(const void* key, NULLABLE const void* value)
+{
+    bool inserted;
+    auto p = FindOrInsert(key, value, &inserted);
+    if (p != nullptr && !inserted && value != nullptr) {
+        memcpy(p, value, valueStep);
+    }
+    return p;
+}
+
+DECLSPEC_DLL void* HashMap::FindOrInsert(const void* key, NULLABLE const void* value, NULLABLE bool* inserted)
+{
+    if (inserted != nullptr) {
+        *inserted = false;
+    }
+    if (keyStep == 0) {
+        return nullptr;
+    }
+
+    auto slotHash = SlotHash(Hash(key));
+    auto slot = FindSlot(key, slotHash);
+    if (slot >= 0) {
+        return Entry(slot) + valueOffset;
+    }
+
+    if (Overloaded(count + 1, capacity) && !Reserve(count + 1)) {
+        return nullptr;
+    }
+    if (inserted != nullptr) {
+        *inserted = true;
+    }
+    return Place(slotHash, key, value);
+}
+
+DECLSPEC_DLL bool HashMap::Remove(const void* key)
+{
+    if (keyStep == 0 || count == 0) {
+        return false;
+    }
+
+    auto slot = FindSlot(key, SlotHash(Hash(key)));
+    if (slot < 0) {
+        return false;
+    }
+
+    // 툼스톤 없이 뒤쪽 원소를 한 칸씩 당김, 홈에 있는 원소를 만나면 멈춤
+    auto mask = capacity - 1;
+    auto pos = (uint64)slot;
+    for (;;) {
+        auto next = (pos + 1) & mask;
+        auto nextHash = SlotHashAt(next);
+        if (nextHash == 0 || (nextHash & mask) == next) {
+            break;
+        }
+        memcpy(Entry(pos), Entry(next), stride);
+        pos = next;
+    }
+    SlotHashAt(pos) = 0;
+    count--;
+    return true;
+}
+
+DECLSPEC_DLL bool HashMap::RemoveAll()
+{
+    for (uint64 i = 0; i < capacity; i++) {
+        SlotHashAt(i) = 0;
+    }
+    count = 0;
+    return true;
+}
+
+DECLSPEC_DLL int32 HashMap::Next(int32 index) const
+{
+    for (auto i = index < 0? 0: (uint64)index; i < capacity; i++) {
+        if (SlotHashAt(i) != 0) {
+            return (int32)i;
+        }
+    }
+    return -1;
+}
+
+DECLSPEC_DLL const void* HashMap::KeyAt(int32 index) const
+{
+    if (index < 0 || (uint64)index >= capacity || SlotHashAt(index) == 0) {
+        return nullptr;
+    }
+    return Entry(index) + keyOffset;
+}
+
+DECLSPEC_DLL void* HashMap::ValueAt(int32 index) const
+{
+    if (index < 0 || (uint64)index >= capacity || SlotHashAt(index) == 0) {
+        return nullptr;
+    }
+    return Entry(index) + valueOffset;
+}
+
+DECLSPEC_DLL uint64 HashMap::Count() const
+{
+    return count;
+}
+
+DECLSPEC_DLL uint64 HashMap::Capacity() const
+{
+    return capacity;
+}
+
+DECLSPEC_DLL int32 HashMap::KeyStep() const
+{
+    return keyStep;
+}
+
+DECLSPEC_DLL int32 HashMap::ValueStep() const
+{
+    return valueStep;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "symbols.h"
+#include "defined_type.h"
+
+#define HASHMAP_DEFAULT_CAPACITY 16
+
+// key 는 keyStep 바이트, 문자열 키는 포인터를 키로 넣고 아래 문자열 함수를 씀
+typedef uint64 (*HashMapHashFunc)(const void* key, int32 keyStep, void* param);
+typedef bool (*HashMapEqualFunc)(const void* key0, const void* key1, int32 keyStep, void* param);
+
+DECLSPEC_DLL uint64 hashBytes(const void* p, size_t size, uint64 seed = 0);
+DECLSPEC_DLL uint64 hashString(const char* str, uint64 seed = 0);
+DECLSPEC_DLL uint64 hashWString(const wchar_t* str, uint64 seed = 0);
+
+// 키가 const char* / const wchar_t* 인 맵, 문자열은 맵에 복사하지 않으므로 맵보다 오래 살아야 함
+DECLSPEC_DLL uint64 hashMapStringHash(const void* key, int32 keyStep, void* param);
+DECLSPEC_DLL bool hashMapStringEqual(const void* key0, const void* key1, int32 keyStep, void* param);
+DECLSPEC_DLL uint64 hashMapWStringHash(const void* key, int32 keyStep, void* param);
+DECLSPEC_DLL bool hashMapWStringEqual(const void* key0, const void* key1, int32 keyStep, void* param);
+
+/// <summary>
+/// Robin Hood 열린 주소 해시 맵, 슬롯마다 32비트 해시를 두고 같은 해시일 때만 키를 비교
+/// 슬롯은 [해시][키][값] 을 이어 붙여서 찾을 때 보통 캐시 라인 하나만 읽음, 값은 8바이트 정렬
+/// hash/equal 이 nullptr 이면 키 바이트 전체를 해시하고 memcmp 로 비교, 8바이트 키는 정수로 다룸
+/// 돌려준 값 포인터는 다음 Insert/Remove 까지만 유효
+/// C 스타일 컨테이너, ABI 를 위해 템플릿 사용 금지
+/// </summary>
+class DECLSPEC_DLL HashMap
+{
+public:
+    bool Init(
+        const wchar_t* addrspace, int32 keyStep, int32 valueStep,
+        NULLABLE HashMapHashFunc hash = nullptr, NULLABLE HashMapEqualFunc equal = nullptr,
+        NULLABLE void* param = nullptr, uint64 capacity = s_DefaultCapacity
+    );
+    bool Destroy();
+    // count 개를 넣어도 다시 만들지 않도록 늘림
+    bool Reserve(uint64 count);
+
+public:
+    // 값 포인터, 없으면 nullptr
+    void* Find(const void* key) const;
+    // 있으면 값을 덮어씀, value 가 nullptr 이면 새 값은 0 으로 채우고 기존 값은 그대로 둠
+    void* Insert(const void* key, NULLABLE const void* value);
+    // 없을 때만 넣음, inserted 에 새로 넣었는지 적음
+    void* FindOrInsert(const void* key, NULLABLE const void* value, NULLABLE bool* inserted);
+    bool Remove(const void* key);
+    bool RemoveAll();
+
+public:
+    // 슬롯 단위로 순회, index 이상인 첫 번째 사용중 슬롯, 없으면 -1
+    // for (auto i = map.Next(0); i >= 0; i = map.Next(i + 1))
+    int32 Next(int32 index) const;
+    const void* KeyAt(int32 index) const;
+    void* ValueAt(int32 index) const;
+
+    uint64 Count() const;
+    uint64 Capacity() const;
+    int32 KeyStep() const;
+    int32 ValueStep() const;
+
+private:
+    uint8* Entry(uint64 index) const;
+    uint32& SlotHashAt(uint64 index) const;
+    uint64 Hash(const void* key) const;
+    bool Equal(const void* key, const void* other) const;
+    int64 FindSlot(const void* key, uint32 slotHash) const;
+    void* Place(uint32 slotHash, const void* key, const void* value);
+    bool Rehash(uint64 capacity);
+
+private:
+    const wchar_t* addrspace;
+    HashMapHashFunc hash;
+    HashMapEqualFunc equal;
+    void* param;
+
+    int32 keyStep;
+    int32 valueStep;
+    int32 keyOffset;
+    int32 valueOffset;
+    int32 stride;
+
+    // 슬롯 capacity 개 뒤에 옮길 때 쓰는 임시 슬롯 하나, 슬롯 해시가 0 이면 빈 슬롯
+    uint8* entries;
+    uint64 capacity;
+    uint64 count;
+
+public:
+    static const uint64 s_DefaultCapacity = HASHMAP_DEFAULT_CAPACITY;
+};
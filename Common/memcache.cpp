@@ -0,0 +1,209 @@
+#include "memcache.h"
+#include "allocators.h"
+
+#include <new>
+
+// 이웃 클래스 간격이 128 이하라서 (클래스 크기 - 요청 크기) 가 항상 MEMCACHE_FREE_BLOCK 보다 작음
+static constexpr uint32 s_ClassSizes[MEMCACHE_CLASS_COUNT] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 320, 384, 448, 512, 640, 768, 896, 1024 };
+
+// 16바이트 단위로 올림한 크기 -> 클래스
+struct MemClassLookup
+{
+    int32 classes[MEMSLAB_MAX_SIZE / 16 + 1];
+
+    constexpr MemClassLookup() : classes{ 0, }
+    {
+        int32 c = 0;
+        for (size_t i = 0; i <= MEMSLAB_MAX_SIZE / 16; i++) {
+            while (s_ClassSizes[c] < i * 16) {
+                c++;
+            }
+            classes[i] = c;
+        }
+    }
+};
+static constexpr MemClassLookup s_ClassLookup;
+
+int32 MemCacheClass(size_t size)
+{
+    return s_ClassLookup.classes[(size + 15) >> 4];
+}
+
+uint32 MemCacheClassSize(int32 classIndex)
+{
+    return s_ClassSizes[classIndex];
+}
+
+uint8* MemSpan::Slack()
+{
+    return (uint8*)(this + 1);
+}
+
+void* MemSpan::Block(uint32 index)
+{
+    return (uint8*)this + headerSize + (size_t)index * blockSize;
+}
+
+int32 MemSpan::IndexOf(void* p)
+{
+    auto offset = (size_t)((uint8*)p - (uint8*)this);
+    if (offset < headerSize) {
+        return -1;
+    }
+
+    offset -= headerSize;
+    auto index = offset / blockSize;
+    if (index >= blockCount || index * blockSize != offset) {
+        return -1;
+    }
+    return (int32)index;
+}
+
+static MemSpan* SpanOf(AllocatorEntry* entry, void* p)
+{
+    return (MemSpan*)((size_t)p & ~(entry->spanSize - 1));
+}
+
+struct MemThreadCacheSet
+{
+    MemThreadCache* caches[ALLOCATOR_ENTRY_COUNT];
+    bool closed;
+
+    ~MemThreadCacheSet();
+};
+
+static thread_local MemThreadCacheSet t_Caches;
+
+MemThreadCacheSet::~MemThreadCacheSet()
+{
+    // 스레드가 끝날 때 남은 블록과 크기 합을 주소 공간에 돌려줌
+    for (auto i = 0; i < ALLOCATOR_ENTRY_COUNT; i++) {
+        auto cache = caches[i];
+        if (cache == nullptr) {
+            continue;
+        }
+        if (cache->generation == GetEntryGeneration(i)) {
+            cache->entry->DetachCache(cache);
+        }
+        cache->~MemThreadCache();
+        memFree(cache);
+        caches[i] = nullptr;
+    }
+    closed = true;
+}
+
+static MemThreadCache* LocalCache(AllocatorEntry* entry)
+{
+    auto index = GetEntryIndex(entry);
+    auto generation = GetEntryGeneration(index);
+    auto cache = t_Caches.caches[index];
+    if (cache != nullptr && cache->generation == generation) {
+        return cache;
+    }
+    if (t_Caches.closed) {
+        return nullptr;
+    }
+
+    if (cache == nullptr) {
+        cache = (MemThreadCache*)memAlloc(sizeof(MemThreadCache), alignof(MemThreadCache), 0);
+        if (cache == nullptr) {
+            return nullptr;
+        }
+        new (cache) MemThreadCache();
+        t_Caches.caches[index] = cache;
+    }
+
+    // 세대가 다르면 이전 주소 공간의 블록이므로 버림
+    cache->entry = entry;
+    cache->generation = generation;
+    cache->byteDelta.store(0, std::memory_order_relaxed);
+    cache->stats.Reset();
+    for (auto i = 0; i < MEMCACHE_CLASS_COUNT; i++) {
+        cache->magazines[i].count = 0;
+    }
+    entry->AttachCache(cache);
+    return cache;
+}
+
+static void AddByteDelta(MemThreadCache* cache, int64 delta)
+{
+    cache->byteDelta.store(cache->byteDelta.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void* MemCacheAllocate(AllocatorEntry* entry, size_t size)
+{
+    auto cache = LocalCache(entry);
+    if (cache == nullptr) {
+        return nullptr;
+    }
+
+    auto classIndex = MemCacheClass(size);
+    auto& magazine = cache->magazines[classIndex];
+    if (magazine.count == 0) {
+        magazine.count = entry->RefillCache(classIndex, magazine.blocks, MEMCACHE_BATCH_SIZE);
+        if (magazine.count == 0) {
+            return nullptr;
+        }
+    }
+
+    auto p = magazine.blocks[--magazine.count];
+    auto span = SpanOf(entry, p);
+    span->Slack()[span->IndexOf(p)] = (uint8)(span->blockSize - size);
+    AddByteDelta(cache, (int64)size);
+    cache->stats.CountAlloc(size);
+    return p;
+}
+
+bool MemCacheDeallocate(AllocatorEntry* entry, void* p)
+{
+    auto span = SpanOf(entry, p);
+    auto index = span->IndexOf(p);
+    if (index < 0 || span->Slack()[index] == MEMCACHE_FREE_BLOCK) {
+        return false;
+    }
+
+    auto size = (int64)(span->blockSize - span->Slack()[index]);
+    span->Slack()[index] = MEMCACHE_FREE_BLOCK;
+
+    auto classIndex = span->classIndex;
+    auto cache = LocalCache(entry);
+    if (cache == nullptr) {
+        entry->FlushCache(classIndex, &p, 1, -size, 1);
+        return true;
+    }
+
+    auto& magazine = cache->magazines[classIndex];
+    if (magazine.count == MEMCACHE_MAGAZINE_SIZE) {
+        magazine.count -= MEMCACHE_BATCH_SIZE;
+        entry->FlushCache(classIndex, magazine.blocks + magazine.count, MEMCACHE_BATCH_SIZE, 0);
+    }
+    magazine.blocks[magazine.count++] = p;
+    AddByteDelta(cache, -size);
+    cache->stats.CountFree();
+    return true;
+}
+
+bool MemCacheResize(AllocatorEntry* entry, void* p, size_t size, size_t alignment, size_t offset, size_t* oldSize, bool* resized)
+{
+    auto span = SpanOf(entry, p);
+    auto index = span->IndexOf(p);
+    if (index < 0 || span->Slack()[index] == MEMCACHE_FREE_BLOCK) {
+        return false;
+    }
+
+    *oldSize = span->blockSize - span->Slack()[index];
+    *resized = false;
+
+    // 같은 블록에 들어가고 자투리를 1바이트로 적을 수 있을 때만 제자리에서 바꿈
+    auto cache = LocalCache(entry);
+    if (cache == nullptr || size > span->blockSize || span->blockSize - size >= MEMCACHE_FREE_BLOCK ||
+        offset != 0 || ((size_t)p & (alignment - 1)) != 0) {
+        return true;
+    }
+
+    span->Slack()[index] = (uint8)(span->blockSize - size);
+    AddByteDelta(cache, (int64)size - (int64)*oldSize);
+    *resized = true;
+    return true;
+}
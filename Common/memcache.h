@@ -0,0 +1,32 @@
+#pragma once
+
+#include "defined_type.h"
+#include "mempage.h"
+
+struct MemMagazine
+{
+    int32 count;
+    void* blocks[MEMCACHE_MAGAZINE_SIZE];
+};
+
+// 스레드 하나가 주소 공간 하나에 대해 가지는 캐시
+// byteDelta 는 이 스레드에서 할당/해제한 요청 크기의 합, 주인 스레드만 쓰고 memAllocSize 가 읽음
+struct MemThreadCache
+{
+    AllocatorEntry* entry;
+    uint32 generation;
+    std::atomic<int64> byteDelta;
+    MemStatCounters stats;
+    MemThreadCache* prev;
+    MemThreadCache* next;
+    MemMagazine magazines[MEMCACHE_CLASS_COUNT];
+};
+
+int32 MemCacheClass(size_t size);
+uint32 MemCacheClassSize(int32 classIndex);
+
+// 캐시를 쓸 수 없으면 nullptr, 호출한 쪽에서 락을 잡고 일반 경로로 할당
+void* MemCacheAllocate(AllocatorEntry* entry, size_t size);
+bool MemCacheDeallocate(AllocatorEntry* entry, void* p);
+// 블록이 아니면 false, 같은 블록 안에서 크기를 바꿀 수 있으면 resized
+bool MemCacheResize(AllocatorEntry* entry, void* p, size_t size, size_t alignment, size_t offset, size_t* oldSize, bool* resized);
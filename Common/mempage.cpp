@@ -1,234 +1,2100 @@
 #include "mempage.h"
-#define NOMINMAX
-#include <windows.h>
+#include "memcache.h"
+#include "memwarm.h"
+#include "allocators.h"
+#include "pageprovider.h"
 
-MemRange::MemRange() : start(0), count(0), flags(0) {}
-MemRange::MemRange(size_t start, size_t count, int flags) : start(start), count(count), flags(flags) {}
+#include <string.h>
+#include <wchar.h>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <new>
+#include <thread>
+
+MemRange::MemRange() : MemRange(0, 0, 0) {}
+MemRange::MemRange(size_t start, size_t count, int flags) :
+    start(start), count(count), flags(flags), requested(0),
+    prevPhys(MEMRANGE_NULL), nextPhys(MEMRANGE_NULL), prevFree(MEMRANGE_NULL), nextFree(MEMRANGE_NULL), isFree(false)
+{}
 size_t MemRange::End() { return start + count; }
 
-MemChunk::MemChunk() : memPtr(nullptr), size(0)
+#pragma region 비트 연산
+
+static int32 BitScanForward32(uint32 v)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, v);
+    return (int32)index;
+#else
+    return __builtin_ctz(v);
+#endif
+}
+
+static int32 BitScanForward64(uint64 v)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return (int32)index;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+static int32 BitScanReverse64(uint64 v)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return (int32)index;
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+int32 MemStatSizeBucket(size_t size)
+{
+    if (size <= 16) {
+        return 0;
+    }
+    auto bucket = BitScanReverse64(size - 1) + 1 - 4;
+    return bucket < MEMSTAT_SIZE_BUCKET_COUNT? bucket: MEMSTAT_SIZE_BUCKET_COUNT - 1;
+}
+
+// 쓰는 스레드가 하나뿐인 카운터, 읽는 쪽과만 원자적이면 됨
+static void AddCounter(std::atomic<uint64>& counter, uint64 value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+MemStatCounters::MemStatCounters()
+{
+    Reset();
+}
+
+void MemStatCounters::Reset()
+{
+    allocCount.store(0, std::memory_order_relaxed);
+    freeCount.store(0, std::memory_order_relaxed);
+    for (auto i = 0; i < MEMSTAT_SIZE_BUCKET_COUNT; i++) {
+        sizeHistogram[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void MemStatCounters::CountAlloc(size_t size)
+{
+    AddCounter(allocCount, 1);
+    AddCounter(sizeHistogram[MemStatSizeBucket(size)], 1);
+}
+
+void MemStatCounters::CountFree(uint64 count)
+{
+    AddCounter(freeCount, count);
+}
+
+void MemStatCounters::AddTo(MemStatCounters& o) const
+{
+    AddCounter(o.allocCount, allocCount.load(std::memory_order_relaxed));
+    AddCounter(o.freeCount, freeCount.load(std::memory_order_relaxed));
+    for (auto i = 0; i < MEMSTAT_SIZE_BUCKET_COUNT; i++) {
+        AddCounter(o.sizeHistogram[i], sizeHistogram[i].load(std::memory_order_relaxed));
+    }
+}
+
+// size 가 속하는 크기 클래스
+static void MappingInsert(size_t size, int32* fl, int32* sl)
+{
+    if (size < MEMCHUNK_SMALL_BLOCK) {
+        *fl = 0;
+        *sl = (int32)(size / (MEMCHUNK_SMALL_BLOCK / MEMCHUNK_SL_COUNT));
+    } else {
+        auto f = BitScanReverse64(size);
+        *sl = (int32)(size >> (f - MEMCHUNK_SL_BITS)) ^ MEMCHUNK_SL_COUNT;
+        *fl = f - (MEMCHUNK_FL_SHIFT - 1);
+    }
+}
+
+// 클래스 안의 모든 범위가 size 이상이 되도록 올림한 크기 클래스
+static void MappingSearch(size_t size, int32* fl, int32* sl)
+{
+    if (size < MEMCHUNK_SMALL_BLOCK) {
+        size = (size + (ALLOCATOR_MIN_ALIGNMENT - 1)) & ~(size_t)(ALLOCATOR_MIN_ALIGNMENT - 1);
+    } else {
+        auto f = BitScanReverse64(size);
+        size += ((size_t)1 << (f - MEMCHUNK_SL_BITS)) - 1;
+    }
+
+    MappingInsert(size, fl, sl);
+}
+
+#pragma endregion
+
+MemChunk::MemChunk() :
+    memPtr(nullptr), size(0), kind(MEMCHUNK_KIND_RANGE), state(MEMCHUNK_STATE_COMMITTED), warmState(MEMWARM_COLD), warmPinned(false), top(0), freeListHeads(nullptr), flBitmap(0), slBitmap{ 0, }, unusedRange(MEMRANGE_NULL),
+    rangeTable(nullptr), rangeTableCapacity(0), usedRangeCount(0)
+{
+    rangeList.Init(nullptr, sizeof(MemRange));
+}
+MemChunk::MemChunk(void* mem_ptr, size_t size, uint32 kind) :
+    memPtr(mem_ptr), size(size), kind(kind), state(MEMCHUNK_STATE_COMMITTED), warmState(MEMWARM_COLD), warmPinned(false), top(0), freeListHeads(nullptr), flBitmap(0), slBitmap{ 0, }, unusedRange(MEMRANGE_NULL),
+    rangeTable(nullptr), rangeTableCapacity(0), usedRangeCount(0)
+{
+    if (kind == MEMCHUNK_KIND_ARENA) {
+        rangeList.Init(nullptr, sizeof(MemRange), ArrayList::s_DefaultAlignment, 1);
+        return;
+    }
+    if (kind == MEMCHUNK_KIND_BUDDY) {
+        auto minBlockSize = size / MEMBUDDY_MAX_BLOCK_COUNT;
+        rangeList.Init(nullptr, sizeof(MemRange), ArrayList::s_DefaultAlignment, 1);
+        buddy.Init(nullptr, size, minBlockSize > MEMBUDDY_MIN_BLOCK_SIZE? minBlockSize: MEMBUDDY_MIN_BLOCK_SIZE);
+        return;
+    }
+
+    rangeList.Init(nullptr, sizeof(MemRange), ArrayList::s_DefaultAlignment, size / 1024 + 1);
+    Init();
+}
+
+bool MemChunk::Init()
+{
+    freeListHeads = (int32*)memAlloc(sizeof(int32) * MEMCHUNK_FL_COUNT * MEMCHUNK_SL_COUNT, alignof(int32), 0);
+    if (freeListHeads == nullptr) {
+        return false;
+    }
+    for (auto i = 0; i < MEMCHUNK_FL_COUNT * MEMCHUNK_SL_COUNT; i++) {
+        freeListHeads[i] = MEMRANGE_NULL;
+    }
+
+    rangeTableCapacity = 64;
+    rangeTable = (int32*)memAlloc(sizeof(int32) * rangeTableCapacity, alignof(int32), 0);
+    if (rangeTable == nullptr) {
+        return false;
+    }
+    for (size_t i = 0; i < rangeTableCapacity; i++) {
+        rangeTable[i] = MEMRANGE_NULL;
+    }
+
+    // 청크 전체를 하나의 빈 범위로 시작
+    auto index = NewRange();
+    if (index == MEMRANGE_NULL) {
+        return false;
+    }
+    auto range = Range(index);
+    range->start = 0;
+    range->count = size;
+    InsertFree(index);
+
+    return true;
+}
+
+void MemChunk::Destroy()
+{
+    rangeList.Destroy();
+    if (kind == MEMCHUNK_KIND_BUDDY) {
+        buddy.Destroy();
+    }
+
+    if (freeListHeads) {
+        memFree(freeListHeads);
+        freeListHeads = nullptr;
+    }
+    if (rangeTable) {
+        memFree(rangeTable);
+        rangeTable = nullptr;
+    }
+
+    rangeTableCapacity = 0;
+    usedRangeCount = 0;
+    unusedRange = MEMRANGE_NULL;
+    flBitmap = 0;
+}
+
+bool MemChunk::GetBuddyBlock(IN size_t req_size, IN size_t alignment, IN size_t aligned_offset, OUT void** ptr)
+{
+    // 블록은 크기로 정렬되어 있으므로 offset 을 더한 크기를 받고 시작에서 offset 만큼 띄움
+    auto offset = buddy.Alloc(req_size + aligned_offset, alignment);
+    if (offset == BUDDY_INVALID_OFFSET) {
+        return false;
+    }
+    *ptr = (uint8*)memPtr + offset + aligned_offset;
+    return true;
+}
+
+bool MemChunk::RemoveBuddyBlock(IN void* p, OUT size_t* count)
+{
+    auto pos = (size_t)((uint8*)p - (uint8*)memPtr);
+    auto start = pos & ~(size_t)(buddy.MinBlockSize() - 1);
+
+    uint64 blockSize, requested;
+    if (!buddy.Query(start, &blockSize, &requested) || !buddy.Free(start)) {
+        return false;
+    }
+    *count = (size_t)requested - (pos - start);
+    return true;
+}
+
+bool MemChunk::ResizeBuddyBlock(IN void* p, IN size_t req_size, IN size_t alignment, IN size_t aligned_offset, OUT size_t* requested, OUT bool* resized)
+{
+    auto pos = (size_t)((uint8*)p - (uint8*)memPtr);
+    auto start = pos & ~(size_t)(buddy.MinBlockSize() - 1);
+
+    uint64 blockSize, blockRequested;
+    if (!buddy.Query(start, &blockSize, &blockRequested)) {
+        return false;
+    }
+    *requested = (size_t)blockRequested - (pos - start);
+
+    // 같은 offset 과 정렬을 유지하면서 블록 안에 들어가면 요청 크기만 바꿈
+    *resized = pos - start == aligned_offset && (start & (alignment - 1)) == 0 &&
+        buddy.Resize(start, req_size + aligned_offset);
+    return true;
+}
+
+MemRange* MemChunk::Range(int32 index) const
+{
+    return (MemRange*)rangeList[index];
+}
+
+void MemChunk::FreeExtent(size_t* freeBytes, size_t* largestFree) const
+{
+    *freeBytes = 0;
+    *largestFree = 0;
+    if (freeListHeads == nullptr) {
+        return;
+    }
+
+    for (auto i = 0; i < MEMCHUNK_FL_COUNT * MEMCHUNK_SL_COUNT; i++) {
+        for (auto index = freeListHeads[i]; index != MEMRANGE_NULL; index = Range(index)->nextFree) {
+            auto count = Range(index)->count;
+            *freeBytes += count;
+            if (count > *largestFree) {
+                *largestFree = count;
+            }
+        }
+    }
+}
+
+bool MemChunk::ReserveRange(int32 count)
+{
+    // 노드 재사용 리스트를 세지 않고 넉넉하게 잡는다, rangeList 가 재할당 되면 MemRange* 가 무효화됨
+    return rangeList.ResizeMore((uint64)rangeList.Count() + count);
+}
+
+int32 MemChunk::NewRange()
+{
+    int32 index;
+    if (unusedRange != MEMRANGE_NULL) {
+        index = unusedRange;
+        unusedRange = Range(index)->nextFree;
+    } else {
+        auto r = MemRange();
+        if (!rangeList.InsertLast(1, &r, nullptr)) {
+            return MEMRANGE_NULL;
+        }
+        index = rangeList.Count() - 1;
+    }
+
+    new (Range(index)) MemRange();
+    return index;
+}
+
+void MemChunk::DeleteRange(int32 index)
+{
+    auto range = Range(index);
+    range->isFree = false;
+    range->nextFree = unusedRange;
+    unusedRange = index;
+}
+
+void MemChunk::InsertFree(int32 index)
+{
+    auto range = Range(index);
+    int32 fl, sl;
+    MappingInsert(range->count, &fl, &sl);
+
+    auto& head = freeListHeads[fl * MEMCHUNK_SL_COUNT + sl];
+    range->isFree = true;
+    range->prevFree = MEMRANGE_NULL;
+    range->nextFree = head;
+    if (head != MEMRANGE_NULL) {
+        Range(head)->prevFree = index;
+    }
+    head = index;
+
+    flBitmap |= (uint64)1 << fl;
+    slBitmap[fl] |= (uint32)1 << sl;
+}
+
+void MemChunk::RemoveFree(int32 index)
+{
+    auto range = Range(index);
+    int32 fl, sl;
+    MappingInsert(range->count, &fl, &sl);
+
+    if (range->prevFree != MEMRANGE_NULL) {
+        Range(range->prevFree)->nextFree = range->nextFree;
+    }
+    if (range->nextFree != MEMRANGE_NULL) {
+        Range(range->nextFree)->prevFree = range->prevFree;
+    }
+
+    auto& head = freeListHeads[fl * MEMCHUNK_SL_COUNT + sl];
+    if (head == index) {
+        head = range->nextFree;
+        if (head == MEMRANGE_NULL) {
+            slBitmap[fl] &= ~((uint32)1 << sl);
+            if (slBitmap[fl] == 0) {
+                flBitmap &= ~((uint64)1 << fl);
+            }
+        }
+    }
+
+    range->isFree = false;
+    range->prevFree = range->nextFree = MEMRANGE_NULL;
+}
+
+#define CEIL_ALIGNED_TO(addr, align, offset) ((((addr) + (align - 1)) & ~(align - 1)) + offset)
+#define FLOOR_ALIGNED_TO(addr, align, offset) (((addr) & ~(align - 1)) + offset)
+
+int32 MemChunk::FindFree(size_t size) const
+{
+    if (size > this->size) {
+        return MEMRANGE_NULL;
+    }
+
+    int32 fl, sl;
+    MappingSearch(size, &fl, &sl);
+
+    if (fl >= MEMCHUNK_FL_COUNT) {
+        return MEMRANGE_NULL;
+    }
+
+    uint32 slMap = sl < MEMCHUNK_SL_COUNT? slBitmap[fl] & (~(uint32)0 << sl): 0;
+    if (slMap == 0) {
+        uint64 flMap = fl + 1 < 64? flBitmap & (~(uint64)0 << (fl + 1)): 0;
+        if (flMap == 0) {
+            return MEMRANGE_NULL;
+        }
+
+        fl = BitScanForward64(flMap);
+        slMap = slBitmap[fl];
+    }
+    sl = BitScanForward32(slMap);
+
+    return freeListHeads[fl * MEMCHUNK_SL_COUNT + sl];
+}
+
+int32 MemChunk::FindFreeFit(size_t size, size_t alignment, size_t aligned_offset) const
+{
+    // 정렬 여유를 포함하면 맞는 클래스가 없을 때, 딱 맞는 범위가 이미 정렬되어 있는지 확인
+    // 같은 클래스 리스트는 일부만 확인해서 상수 시간을 유지
+    const int32 maxCandidate = 16;
+
+    int32 fl, sl;
+    MappingInsert(size, &fl, &sl);
+    if (fl < MEMCHUNK_FL_COUNT) {
+        auto index = freeListHeads[fl * MEMCHUNK_SL_COUNT + sl];
+        for (auto i = 0; i < maxCandidate && index != MEMRANGE_NULL; i++) {
+            auto range = Range(index);
+            if (CEIL_ALIGNED_TO(range->start, alignment, aligned_offset) + size <= range->End()) {
+                return index;
+            }
+            index = range->nextFree;
+        }
+    }
+
+    auto index = FindFree(size);
+    if (index != MEMRANGE_NULL) {
+        auto range = Range(index);
+        if (CEIL_ALIGNED_TO(range->start, alignment, aligned_offset) + size <= range->End()) {
+            return index;
+        }
+    }
+
+    return MEMRANGE_NULL;
+}
+
+int32 MemChunk::FindLowestFree(size_t size, size_t alignment, size_t limit) const
+{
+    // 들어갈 수 있는 클래스의 리스트를 모두 훑어서 시작 주소가 가장 낮은 범위를 고름, 압축에서만 사용
+    int32 fl, sl;
+    MappingInsert(size, &fl, &sl);
+    if (fl >= MEMCHUNK_FL_COUNT) {
+        return MEMRANGE_NULL;
+    }
+
+    int32 found = MEMRANGE_NULL;
+    size_t foundStart = limit;
+    uint64 flMap = flBitmap & (~(uint64)0 << fl);
+    while (flMap != 0) {
+        auto f = BitScanForward64(flMap);
+        flMap &= flMap - 1;
+
+        uint32 slMap = f == fl? slBitmap[f] & (~(uint32)0 << sl): slBitmap[f];
+        while (slMap != 0) {
+            auto s = BitScanForward32(slMap);
+            slMap &= slMap - 1;
+
+            for (auto index = freeListHeads[f * MEMCHUNK_SL_COUNT + s]; index != MEMRANGE_NULL; index = Range(index)->nextFree) {
+                auto range = Range(index);
+                auto alignedStart = CEIL_ALIGNED_TO(range->start, alignment, 0);
+                if (alignedStart < foundStart && alignedStart + size <= range->End()) {
+                    found = index;
+                    foundStart = alignedStart;
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+static size_t HashOffset(size_t start, size_t capacity)
+{
+    return (size_t)(((uint64)start * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+}
+
+bool MemChunk::ReserveTable(size_t count)
+{
+    if ((usedRangeCount + count) * 2 > rangeTableCapacity) {
+        auto newCapacity = rangeTableCapacity * 2;
+        while ((usedRangeCount + count) * 2 > newCapacity) {
+            newCapacity *= 2;
+        }
+        auto newTable = (int32*)memAlloc(sizeof(int32) * newCapacity, alignof(int32), 0);
+        if (newTable == nullptr) {
+            return false;
+        }
+        for (size_t i = 0; i < newCapacity; i++) {
+            newTable[i] = MEMRANGE_NULL;
+        }
+        for (size_t i = 0; i < rangeTableCapacity; i++) {
+            if (rangeTable[i] == MEMRANGE_NULL) {
+                continue;
+            }
+            auto slot = HashOffset(Range(rangeTable[i])->start, newCapacity);
+            while (newTable[slot] != MEMRANGE_NULL) {
+                slot = (slot + 1) & (newCapacity - 1);
+            }
+            newTable[slot] = rangeTable[i];
+        }
+
+        memFree(rangeTable);
+        rangeTable = newTable;
+        rangeTableCapacity = newCapacity;
+    }
+
+    return true;
+}
+
+void MemChunk::InsertTable(int32 index)
+{
+    auto slot = HashOffset(Range(index)->start, rangeTableCapacity);
+    while (rangeTable[slot] != MEMRANGE_NULL) {
+        slot = (slot + 1) & (rangeTableCapacity - 1);
+    }
+    rangeTable[slot] = index;
+    usedRangeCount++;
+}
+
+int32 MemChunk::FindTable(size_t start) const
+{
+    auto slot = HashOffset(start, rangeTableCapacity);
+    while (rangeTable[slot] != MEMRANGE_NULL) {
+        if (Range(rangeTable[slot])->start == start) {
+            return (int32)slot;
+        }
+        slot = (slot + 1) & (rangeTableCapacity - 1);
+    }
+    return MEMRANGE_NULL;
+}
+
+void MemChunk::RemoveTable(size_t slot)
+{
+    // backward shift deletion, 툼스톤 없이 probe 체인을 유지
+    auto mask = rangeTableCapacity - 1;
+    auto hole = slot;
+    auto next = (hole + 1) & mask;
+    while (rangeTable[next] != MEMRANGE_NULL) {
+        auto home = HashOffset(Range(rangeTable[next])->start, rangeTableCapacity);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            rangeTable[hole] = rangeTable[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    rangeTable[hole] = MEMRANGE_NULL;
+    usedRangeCount--;
+}
+
+void MemChunk::SplitBack(int32 index, size_t blockSize)
+{
+    // 뒤쪽 남는 공간을 빈 범위로 분리, 최소 정렬보다 작으면 그냥 포함
+    if (Range(index)->count - blockSize < ALLOCATOR_MIN_ALIGNMENT) {
+        return;
+    }
+
+    auto back = NewRange();
+    auto range = Range(index), backRange = Range(back);
+
+    backRange->start = range->start + blockSize;
+    backRange->count = range->count - blockSize;
+    backRange->prevPhys = index;
+    backRange->nextPhys = range->nextPhys;
+    if (range->nextPhys != MEMRANGE_NULL) {
+        Range(range->nextPhys)->prevPhys = back;
+    }
+
+    range->nextPhys = back;
+    range->count = blockSize;
+    InsertFree(back);
+}
+
+bool MemChunk::GetEmptyMemAndAppend(IN size_t req_size, IN size_t alignment, IN size_t aligned_offset, IN int flags, OUT void** ptr)
+{
+    if (freeListHeads == nullptr || !ReserveRange(2) || !ReserveTable(1)) {
+        return false;
+    }
+
+    // 0 바이트 요청도 고유한 시작 오프셋을 갖도록 함
+    size_t blockSize = req_size > 0? req_size: 1;
+
+    // 정렬 여유까지 포함한 크기면 어떤 범위를 골라도 들어감
+    int32 index = FindFree(blockSize + (alignment - 1) + aligned_offset);
+    if (index == MEMRANGE_NULL) {
+        index = FindFreeFit(blockSize, alignment, aligned_offset);
+        if (index == MEMRANGE_NULL) {
+            return false;
+        }
+    }
+
+    TakeRange(index, blockSize, alignment, aligned_offset, flags, ptr);
+    // 0 바이트 요청은 요청 크기를 0 으로 기록
+    Range(index)->requested = req_size;
+
+    return true;
+}
+
+bool MemChunk::GetLowestMem(IN size_t req_size, IN size_t alignment, IN size_t limit, OUT void** ptr)
+{
+    if (freeListHeads == nullptr || req_size == 0 || !ReserveRange(2) || !ReserveTable(1)) {
+        return false;
+    }
+
+    auto index = FindLowestFree(req_size, alignment, limit);
+    if (index == MEMRANGE_NULL) {
+        return false;
+    }
+
+    TakeRange(index, req_size, alignment, 0, 0, ptr);
+    return true;
+}
+
+void MemChunk::TakeRange(int32 index, size_t req_size, size_t alignment, size_t aligned_offset, int flags, void** ptr)
+{
+    RemoveFree(index);
+
+    auto alignedStart = CEIL_ALIGNED_TO(Range(index)->start, alignment, aligned_offset);
+
+    // 정렬로 생긴 앞쪽 공간은 빈 범위로 분리
+    if (alignedStart > Range(index)->start) {
+        auto front = NewRange();
+        auto range = Range(index), frontRange = Range(front);
+
+        frontRange->start = range->start;
+        frontRange->count = alignedStart - range->start;
+        frontRange->prevPhys = range->prevPhys;
+        frontRange->nextPhys = index;
+        if (range->prevPhys != MEMRANGE_NULL) {
+            Range(range->prevPhys)->nextPhys = front;
+        }
+
+        range->prevPhys = front;
+        range->start = alignedStart;
+        range->count -= frontRange->count;
+        InsertFree(front);
+    }
+
+    SplitBack(index, req_size);
+
+    auto range = Range(index);
+    range->flags = flags;
+    range->requested = req_size;
+
+    InsertTable(index);
+
+    *ptr = static_cast<void*>(((char*)memPtr + range->start));
+}
+
+bool MemChunk::RemoveRange(IN void* p, OUT size_t* count)
+{
+    if (rangeTable == nullptr || !(memPtr <= p && (void*)((char*)memPtr + size) > p)) {
+        return false;
+    }
+
+    auto slot = FindTable((size_t)((char*)p - (char*)memPtr));
+    if (slot == MEMRANGE_NULL) {
+        return false;
+    }
+
+    auto index = rangeTable[slot];
+    RemoveTable(slot);
+
+    if (count) {
+        *count = Range(index)->requested;
+    }
+
+    // 주소상 이웃한 빈 범위와 합침
+    auto range = Range(index);
+    if (range->prevPhys != MEMRANGE_NULL && Range(range->prevPhys)->isFree) {
+        auto prev = range->prevPhys;
+        auto prevRange = Range(prev);
+        RemoveFree(prev);
+
+        range->start = prevRange->start;
+        range->count += prevRange->count;
+        range->prevPhys = prevRange->prevPhys;
+        if (range->prevPhys != MEMRANGE_NULL) {
+            Range(range->prevPhys)->nextPhys = index;
+        }
+        DeleteRange(prev);
+    }
+    if (range->nextPhys != MEMRANGE_NULL && Range(range->nextPhys)->isFree) {
+        auto next = range->nextPhys;
+        auto nextRange = Range(next);
+        RemoveFree(next);
+
+        range->count += nextRange->count;
+        range->nextPhys = nextRange->nextPhys;
+        if (range->nextPhys != MEMRANGE_NULL) {
+            Range(range->nextPhys)->prevPhys = index;
+        }
+        DeleteRange(next);
+    }
+
+    range->requested = 0;
+    range->flags = 0;
+    InsertFree(index);
+
+    return true;
+}
+
+bool MemChunk::ResizeRange(IN void* p, IN size_t req_size, IN size_t alignment, IN size_t aligned_offset, OUT size_t* requested, OUT bool* resized)
+{
+    if (rangeTable == nullptr || !(memPtr <= p && (void*)((char*)memPtr + size) > p)) {
+        return false;
+    }
+
+    auto slot = FindTable((size_t)((char*)p - (char*)memPtr));
+    if (slot == MEMRANGE_NULL) {
+        return false;
+    }
+
+    // 줄일 때 뒤쪽을 나누면 노드가 하나 필요, rangeList 가 커지기 전에 확보
+    auto index = rangeTable[slot];
+    *requested = Range(index)->requested;
+    *resized = false;
+    if (!ReserveRange(1)) {
+        return true;
+    }
+
+    auto range = Range(index);
+    if (range->start < aligned_offset || ((range->start - aligned_offset) & (alignment - 1)) != 0) {
+        return true;
+    }
+
+    // 뒤에 붙은 빈 범위까지 합쳐서 들어가면 시작 위치를 그대로 두고 늘림
+    size_t blockSize = req_size > 0? req_size: 1;
+    auto next = range->nextPhys;
+    auto nextFree = next != MEMRANGE_NULL && Range(next)->isFree;
+    if (blockSize > range->count + (nextFree? Range(next)->count: 0)) {
+        return true;
+    }
+
+    if (nextFree) {
+        auto nextRange = Range(next);
+        RemoveFree(next);
+
+        range->count += nextRange->count;
+        range->nextPhys = nextRange->nextPhys;
+        if (range->nextPhys != MEMRANGE_NULL) {
+            Range(range->nextPhys)->prevPhys = index;
+        }
+        DeleteRange(next);
+    }
+    SplitBack(index, blockSize);
+
+    Range(index)->requested = req_size;
+    *resized = true;
+    return true;
+}
+
+static uint32 PageShift(size_t minPageSize)
+{
+    return minPageSize > 1? (uint32)BitScanReverse64(minPageSize - 1) + 1: 0;
+}
+
+MemChunkSlot* MemChunkTable::Slots()
+{
+    return (MemChunkSlot*)(this + 1);
+}
+
+static MemChunkTable* NewChunkTable(size_t capacity)
+{
+    auto table = (MemChunkTable*)memAlloc(sizeof(MemChunkTable) + sizeof(MemChunkSlot) * capacity, alignof(MemChunkSlot), 0);
+    if (table == nullptr) {
+        return nullptr;
+    }
+
+    table->capacity = capacity;
+    table->count = 0;
+    table->retired = nullptr;
+    auto slots = table->Slots();
+    for (size_t i = 0; i < capacity; i++) {
+        new (slots + i) MemChunkSlot();
+        slots[i].chunkIndex.store(MEMRANGE_NULL, std::memory_order_relaxed);
+    }
+    return table;
+}
+
+static size_t SpanSize(uint32 pageShift)
+{
+    return ((size_t)1 << pageShift) < MEMCACHE_SPAN_SIZE? (size_t)1 << pageShift: MEMCACHE_SPAN_SIZE;
+}
+
+static size_t CacheMaxSize(int32 kind, uint32 pageShift, bool pageLocked)
+{
+    if (kind == MEMPAGE_KIND_ARENA || kind == MEMPAGE_KIND_BUDDY) {
+        return 0;
+    }
+    if (kind == MEMPAGE_KIND_SLAB) {
+        // span 하나에 블록이 여러 개 들어가도록 작은 페이지에서는 줄임
+        auto maxSize = SpanSize(pageShift) / 4;
+        return maxSize < MEMSLAB_MAX_SIZE? maxSize: MEMSLAB_MAX_SIZE;
+    }
+    return !pageLocked && pageShift >= MEMCACHE_MIN_PAGESHIFT? MEMCACHE_MAX_SIZE: 0;
+}
+
+static void CopyName(wchar_t* dst, size_t capacity, const wchar_t* src)
+{
+#ifdef _MSC_VER
+    wcsncpy_s(dst, capacity, src, _TRUNCATE);
+#else
+    wcsncpy(dst, src, capacity - 1);
+    dst[capacity - 1] = L'\0';
+#endif
+}
+
+static void ResetWarmCounts(std::atomic<int32>* counts, std::atomic<int32>* pinCount)
+{
+    for (auto i = 0; i <= MEMWARM_WARM; i++) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+    pinCount->store(0, std::memory_order_relaxed);
+}
+
+static void ResetLatency(std::atomic<uint64>* histogram)
+{
+    for (auto i = 0; i < MEMSTAT_LATENCY_BUCKET_COUNT; i++) {
+        histogram[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+AllocatorEntry::AllocatorEntry() :
+    name(L""), minPageSize(0), lastRefPage(0), debug(0), allocByteCount(0), totalPageSize(0), pageLocked(false), pageFlags(0), warmPages(false),
+    pageShift(0), chunkTable(nullptr), kind(MEMPAGE_KIND_DEFAULT), spanSize(0), cacheMaxSize(0),
+    cacheFreeList{ nullptr, }, threadCacheList(nullptr), arenaChunk(0), freeHandle(MEMRANGE_NULL), trimRetainCount(MEMTRIM_RETAIN_ALL), trimMode(MEMTRIM_RELEASE),
+    peakByteCount(0), sampleInterval(0)
+{
+    ResetLatency(latencyHistogram);
+    ResetWarmCounts(warmChunkCounts, &warmPinCount);
+    memChunkList.Init(nullptr, sizeof(MemChunk));
+    arenaMarkers.Init(nullptr, sizeof(MemArenaMarker));
+    handleList.Init(nullptr, sizeof(MemHandleSlot));
+}
+AllocatorEntry::AllocatorEntry(const wchar_t* name, unsigned debug, size_t minPageSize, bool pageLocked, int32 kind, uint32 flags) :
+    minPageSize(minPageSize), lastRefPage(0), debug(debug), allocByteCount(0), totalPageSize(0), pageLocked(pageLocked),
+    pageFlags((flags & (PAGE_FLAG_HUGE | PAGE_FLAG_PREFAULT)) | (pageLocked? PAGE_FLAG_LOCKED: 0)), warmPages((flags & MEMPAGE_FLAG_WARM) != 0),
+    pageShift(PageShift(minPageSize)), chunkTable(nullptr), kind(kind), spanSize(SpanSize(PageShift(minPageSize))),
+    cacheMaxSize(CacheMaxSize(kind, PageShift(minPageSize), pageLocked)), cacheFreeList{ nullptr, }, threadCacheList(nullptr),
+    arenaChunk(0), freeHandle(MEMRANGE_NULL), trimRetainCount(MEMTRIM_RETAIN_ALL), trimMode(MEMTRIM_RELEASE), peakByteCount(0), sampleInterval(0)
+{
+    ResetLatency(latencyHistogram);
+    ResetWarmCounts(warmChunkCounts, &warmPinCount);
+    CopyName(this->name, name_buffer_max, name);
+    memChunkList.Init(nullptr, sizeof(MemChunk));
+    arenaMarkers.Init(nullptr, sizeof(MemArenaMarker));
+    handleList.Init(nullptr, sizeof(MemHandleSlot));
+}
+AllocatorEntry::AllocatorEntry(const AllocatorEntry& o) :
+    minPageSize(o.minPageSize), lastRefPage(o.lastRefPage), debug(o.debug), allocByteCount(o.allocByteCount),
+    totalPageSize(o.totalPageSize), pageLocked(o.pageLocked), pageFlags(o.pageFlags), warmPages(o.warmPages),
+    pageShift(o.pageShift), chunkTable(nullptr), kind(o.kind), spanSize(o.spanSize), cacheMaxSize(o.cacheMaxSize),
+    cacheFreeList{ nullptr, }, threadCacheList(nullptr), arenaChunk(o.arenaChunk), freeHandle(o.freeHandle), trimRetainCount(o.trimRetainCount), trimMode(o.trimMode),
+    peakByteCount(o.peakByteCount), sampleInterval(o.sampleInterval.load())
+{
+    ResetLatency(latencyHistogram);
+    ResetWarmCounts(warmChunkCounts, &warmPinCount);
+    o.stats.AddTo(stats);
+    CopyName(this->name, name_buffer_max, o.name);
+    memChunkList.Init(nullptr, sizeof(MemChunk));
+    arenaMarkers.Init(nullptr, sizeof(MemArenaMarker));
+    handleList.Init(nullptr, sizeof(MemHandleSlot));
+    arenaMarkers.CopyFrom(o.arenaMarkers);
+    handleList.CopyFrom(o.handleList);
+    memChunkList.CopyFrom(o.memChunkList);
+    for (auto i = 0; i < memChunkList.Count(); i++) {
+        auto memChunk = (MemChunk*)memChunkList[i];
+        memChunk->warmPinned = false;
+        if (memChunk->state != MEMCHUNK_STATE_RELEASED) {
+            InsertChunkTable(i);
+        }
+        if (memChunk->state == MEMCHUNK_STATE_COMMITTED) {
+            warmChunkCounts[memChunk->warmState].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+AllocatorEntry::AllocatorEntry(const AllocatorEntry& o, const wchar_t* name) :
+    minPageSize(o.minPageSize), lastRefPage(o.lastRefPage), debug(o.debug), allocByteCount(o.allocByteCount),
+    totalPageSize(o.totalPageSize), pageLocked(o.pageLocked), pageFlags(o.pageFlags), warmPages(o.warmPages),
+    pageShift(o.pageShift), chunkTable(nullptr), kind(o.kind), spanSize(o.spanSize), cacheMaxSize(o.cacheMaxSize),
+    cacheFreeList{ nullptr, }, threadCacheList(nullptr), arenaChunk(o.arenaChunk), freeHandle(o.freeHandle), trimRetainCount(o.trimRetainCount), trimMode(o.trimMode),
+    peakByteCount(o.peakByteCount), sampleInterval(o.sampleInterval.load())
+{
+    ResetLatency(latencyHistogram);
+    ResetWarmCounts(warmChunkCounts, &warmPinCount);
+    o.stats.AddTo(stats);
+    CopyName(this->name, name_buffer_max, name);
+    memChunkList.Init(nullptr, sizeof(MemChunk));
+    arenaMarkers.Init(nullptr, sizeof(MemArenaMarker));
+    handleList.Init(nullptr, sizeof(MemHandleSlot));
+    arenaMarkers.CopyFrom(o.arenaMarkers);
+    handleList.CopyFrom(o.handleList);
+    memChunkList.CopyFrom(o.memChunkList);
+    for (auto i = 0; i < memChunkList.Count(); i++) {
+        auto memChunk = (MemChunk*)memChunkList[i];
+        memChunk->warmPinned = false;
+        if (memChunk->state != MEMCHUNK_STATE_RELEASED) {
+            InsertChunkTable(i);
+        }
+        if (memChunk->state == MEMCHUNK_STATE_COMMITTED) {
+            warmChunkCounts[memChunk->warmState].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+AllocatorEntry::~AllocatorEntry()
+{
+    for (auto i = 0; i < memChunkList.Count(); i++) {
+        auto memChunk = (MemChunk*)memChunkList[i];
+        if (memChunk->memPtr) {
+            PageFree(memChunk->memPtr, memChunk->size, pageFlags);
+            memChunk->memPtr = nullptr;
+        }
+        memChunk->Destroy();
+    }
+    memChunkList.Destroy();
+    arenaMarkers.Destroy();
+    arenaChunk = 0;
+    handleList.Destroy();
+    freeHandle = MEMRANGE_NULL;
+
+    auto table = chunkTable.exchange(nullptr);
+    while (table) {
+        auto retired = table->retired;
+        memFree(table);
+        table = retired;
+    }
+
+    for (auto i = 0; i < MEMCACHE_CLASS_COUNT; i++) {
+        cacheFreeList[i] = nullptr;
+    }
+    threadCacheList = nullptr;
+
+    this->name[0] = L'\0';
+}
+
+static size_t HashWindow(uint64 window, size_t capacity)
+{
+    return (size_t)((window * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+}
+
+bool AllocatorEntry::InsertChunkTable(int32 chunkIndex)
+{
+    // 페이지는 2^pageShift 로 정렬되어 있으므로 청크가 걸친 모든 윈도우를 등록하면
+    // 포인터를 마스킹하는 것만으로 청크를 찾을 수 있음
+    auto memChunk = (MemChunk*)memChunkList[chunkIndex];
+    uint64 first = (uint64)memChunk->memPtr >> pageShift;
+    uint64 last = ((uint64)memChunk->memPtr + memChunk->size - 1) >> pageShift;
+    size_t windowCount = (size_t)(last - first + 1);
+
+    auto table = chunkTable.load(std::memory_order_relaxed);
+    size_t capacity = table? table->capacity: 0;
+    size_t count = table? table->count: 0;
+
+    if ((count + windowCount) * 2 > capacity) {
+        // 툼스톤은 새 테이블로 옮기지 않으므로 사용중인 슬롯만 세어서 크기를 정함
+        size_t liveCount = 0;
+        for (size_t i = 0; i < capacity; i++) {
+            if (table->Slots()[i].chunkIndex.load(std::memory_order_relaxed) >= 0) {
+                liveCount++;
+            }
+        }
+        auto newCapacity = capacity > 0? capacity: 16;
+        while ((liveCount + windowCount) * 2 > newCapacity) {
+            newCapacity *= 2;
+        }
+
+        auto newTable = NewChunkTable(newCapacity);
+        if (newTable == nullptr) {
+            return false;
+        }
+        auto newSlots = newTable->Slots();
+        for (size_t i = 0; i < capacity; i++) {
+            auto& old = table->Slots()[i];
+            auto index = old.chunkIndex.load(std::memory_order_relaxed);
+            if (index < 0) {
+                continue;
+            }
+            auto window = old.window.load(std::memory_order_relaxed);
+            auto slot = HashWindow(window, newCapacity);
+            while (newSlots[slot].chunkIndex.load(std::memory_order_relaxed) != MEMRANGE_NULL) {
+                slot = (slot + 1) & (newCapacity - 1);
+            }
+            newSlots[slot].window.store(window, std::memory_order_relaxed);
+            newSlots[slot].kind.store(old.kind.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            newSlots[slot].chunkIndex.store(index, std::memory_order_relaxed);
+        }
+        newTable->count = liveCount;
+        count = liveCount;
+
+        // 읽는 중인 스레드가 있을 수 있으므로 이전 테이블은 바로 해제하지 않음
+        newTable->retired = table;
+        chunkTable.store(newTable, std::memory_order_release);
+        table = newTable;
+        capacity = newCapacity;
+    }
+
+    auto slots = table->Slots();
+    for (auto window = first; window <= last; window++) {
+        auto slot = HashWindow(window, capacity);
+        while (slots[slot].chunkIndex.load(std::memory_order_relaxed) != MEMRANGE_NULL) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        slots[slot].window.store(window, std::memory_order_relaxed);
+        slots[slot].kind.store(memChunk->kind, std::memory_order_relaxed);
+        slots[slot].chunkIndex.store(chunkIndex, std::memory_order_release);
+        table->count++;
+    }
+
+    return true;
+}
+
+int32 AllocatorEntry::FindChunk(void* p, uint32* kind) const
+{
+    auto table = chunkTable.load(std::memory_order_acquire);
+    if (table == nullptr) {
+        return MEMRANGE_NULL;
+    }
+
+    auto slots = table->Slots();
+    uint64 window = (uint64)p >> pageShift;
+    auto slot = HashWindow(window, table->capacity);
+    for (;;) {
+        auto index = slots[slot].chunkIndex.load(std::memory_order_acquire);
+        if (index == MEMRANGE_NULL) {
+            return MEMRANGE_NULL;
+        }
+        if (index != MEMCHUNK_TOMBSTONE && slots[slot].window.load(std::memory_order_relaxed) == window) {
+            if (kind) {
+                *kind = slots[slot].kind.load(std::memory_order_relaxed);
+            }
+            return index;
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+}
+
+void AllocatorEntry::RemoveChunkTable(int32 chunkIndex)
+{
+    // 슬롯을 비우면 그 뒤로 이어진 probe 가 끊기므로 툼스톤으로 바꾸고
+    // 다시 쓰지 않다가 테이블을 새로 만들 때 정리
+    auto memChunk = (MemChunk*)memChunkList[chunkIndex];
+    uint64 first = (uint64)memChunk->memPtr >> pageShift;
+    uint64 last = ((uint64)memChunk->memPtr + memChunk->size - 1) >> pageShift;
+
+    auto table = chunkTable.load(std::memory_order_relaxed);
+    auto slots = table->Slots();
+    for (auto window = first; window <= last; window++) {
+        auto slot = HashWindow(window, table->capacity);
+        for (;;) {
+            auto index = slots[slot].chunkIndex.load(std::memory_order_relaxed);
+            if (index == MEMRANGE_NULL) {
+                break;
+            }
+            if (index == chunkIndex && slots[slot].window.load(std::memory_order_relaxed) == window) {
+                slots[slot].chunkIndex.store(MEMCHUNK_TOMBSTONE, std::memory_order_release);
+                break;
+            }
+            slot = (slot + 1) & (table->capacity - 1);
+        }
+    }
+}
+
+int32 AllocatorEntry::AddChunk(size_t numBytes, uint32 kind)
+{
+    size_t allocSize = numBytes < minPageSize ? minPageSize : numBytes;
+    if (kind == MEMCHUNK_KIND_BUDDY) {
+        // 버디 힙은 2의 거듭제곱 크기여야 함
+        allocSize = (size_t)1 << PageShift(allocSize);
+    }
+
+    // 돌려줬던 청크를 먼저 다시 씀
+    int32 releasedIndex = MEMRANGE_NULL;
+    for (auto i = 0; i < memChunkList.Count(); i++) {
+        auto memChunk = (MemChunk*)memChunkList[i];
+        if (memChunk->state == MEMCHUNK_STATE_DECOMMITTED && memChunk->kind == kind && memChunk->size >= allocSize) {
+            return RestoreChunk(i, memChunk->size, kind)? i: MEMRANGE_NULL;
+        }
+        if (memChunk->state == MEMCHUNK_STATE_RELEASED && releasedIndex == MEMRANGE_NULL) {
+            releasedIndex = i;
+        }
+    }
+    if (releasedIndex != MEMRANGE_NULL) {
+        return RestoreChunk(releasedIndex, allocSize, kind)? releasedIndex: MEMRANGE_NULL;
+    }
+
+    void* page = PageAlloc(allocSize, (size_t)1 << pageShift, pageFlags);
+    if (page == nullptr) {
+        return MEMRANGE_NULL;
+    }
+
+    // 목록이나 청크 표에 못 넣으면 RestoreChunk 처럼 페이지를 돌려주고 되돌림
+    auto chunk = MemChunk(page, allocSize, kind);
+    auto memChunk = (MemChunk*)memChunkList.InsertLast(&chunk);
+    if (memChunk == nullptr) {
+        chunk.Destroy();
+        PageFree(page, allocSize, pageFlags);
+        return MEMRANGE_NULL;
+    }
+    if (!InsertChunkTable(memChunkList.Count() - 1)) {
+        memChunk->Destroy();
+        memChunkList.RemoveLast();
+        PageFree(page, allocSize, pageFlags);
+        return MEMRANGE_NULL;
+    }
+
+    totalPageSize += allocSize;
+    ResetChunkWarm(memChunkList.Count() - 1);
+    return memChunkList.Count() - 1;
+}
+
+void* AllocatorEntry::Allocate(size_t numBytes, int flags)
+{
+    return Allocate(numBytes, ALLOCATOR_MIN_ALIGNMENT, 0, flags);
+}
+// 주소 공간과 무관하게 스레드마다 세는 샘플링 간격
+static thread_local int64 t_SampleCountdown = 0;
+
+void* AllocatorEntry::Allocate(size_t numBytes, size_t alignment, size_t offset, int flags)
+{
+    auto interval = sampleInterval.load(std::memory_order_relaxed);
+    if (interval == 0 || --t_SampleCountdown > 0) {
+        return AllocateUnsampled(numBytes, alignment, offset, flags);
+    }
+
+    t_SampleCountdown = interval;
+    auto start = std::chrono::steady_clock::now();
+    auto p = AllocateUnsampled(numBytes, alignment, offset, flags);
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    RecordLatency((uint64)elapsed.count());
+    return p;
+}
+
+void* AllocatorEntry::AllocateUnsampled(size_t numBytes, size_t alignment, size_t offset, int flags)
+{
+    if (numBytes <= cacheMaxSize && alignment <= MEMCACHE_MAX_ALIGNMENT && offset == 0) {
+        auto p = MemCacheAllocate(this, numBytes);
+        if (p) {
+            return p;
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (kind == MEMPAGE_KIND_ARENA) {
+        return ArenaAllocateLocked(numBytes, alignment, offset);
+    }
+    if (kind == MEMPAGE_KIND_BUDDY) {
+        return BuddyAllocateLocked(numBytes, alignment, offset);
+    }
+    return AllocateLocked(numBytes, alignment, offset, flags);
+}
+
+void* AllocatorEntry::AllocateLocked(size_t numBytes, size_t alignment, size_t offset, int flags)
+{
+    void* p = nullptr;
+    if (lastRefPage < (size_t)memChunkList.Count()) {
+        auto lastRefChunk = (MemChunk*)memChunkList[(int32)lastRefPage];
+        if (lastRefChunk->kind == MEMCHUNK_KIND_RANGE && lastRefChunk->state == MEMCHUNK_STATE_COMMITTED &&
+            lastRefChunk->GetEmptyMemAndAppend(numBytes, alignment, offset, flags, &p)) {
+            CountAllocLocked(numBytes);
+            return p;
+        }
+    }
+
+    for (auto i = 0; i < memChunkList.Count(); i++) {
+        auto memChunk = (MemChunk*)memChunkList[i];
+        if (memChunk->kind == MEMCHUNK_KIND_RANGE && memChunk->state == MEMCHUNK_STATE_COMMITTED &&
+            memChunk->GetEmptyMemAndAppend(numBytes, alignment, offset, flags, &p))
+        {
+            CountAllocLocked(numBytes);
+            lastRefPage = i;
+            return p;
+        }
+    }
+
+    auto index = AddChunk(numBytes);
+    if (index == MEMRANGE_NULL) {
+        return nullptr;
+    }
+
+    lastRefPage = index;
+    auto lastRefChunk = (MemChunk*)memChunkList[index];
+
+    if (lastRefChunk->GetEmptyMemAndAppend(numBytes, alignment, offset, flags, &p)) {
+        CountAllocLocked(numBytes);
+        return p;
+    }
+    else {
+        return nullptr;
+    }
+}
+
+bool AllocatorEntry::Deallocate(void* p)
+{
+    uint32 kind;
+    if (FindChunk(p, &kind) == MEMRANGE_NULL) {
+        return false;
+    }
+    if (kind == MEMCHUNK_KIND_SPAN) {
+        return MemCacheDeallocate(this, p);
+    }
+    if (kind == MEMCHUNK_KIND_ARENA) {
+        // 개별 해제는 하지 않음, memArenaPop/memArenaReset 에서 한꺼번에 회수
+        // 블록 경계를 기록하지 않으므로 중간 주소나 두 번 해제도 구별하지 못하고 true, allocators.h 에 적어둠
+        return true;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    return DeallocateLocked(p);
+}
+
+bool AllocatorEntry::DeallocateLocked(void* p)
+{
+    auto index = FindChunk(p);
+    if (index == MEMRANGE_NULL) {
+        return false;
+    }
+
+    auto memChunk = (MemChunk*)memChunkList[index];
+    size_t count;
+    auto removed = memChunk->kind == MEMCHUNK_KIND_BUDDY? memChunk->RemoveBuddyBlock(p, &count): memChunk->RemoveRange(p, &count);
+    if (removed)
+    {
+        if (memChunk->kind == MEMCHUNK_KIND_BUDDY) {
+            // 방금 빈 블록이 생긴 청크부터 찾음
+            lastRefPage = index;
+        }
+        allocByteCount -= count;
+        stats.CountFree();
+        if (IsChunkEmpty(index) && trimRetainCount != MEMTRIM_RETAIN_ALL) {
+            RetainEmptyChunks(trimRetainCount);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void* AllocatorEntry::Reallocate(void* p, size_t numBytes, size_t alignment, size_t offset)
+{
+    uint32 kind;
+    if (FindChunk(p, &kind) == MEMRANGE_NULL) {
+        return nullptr;
+    }
+
+    size_t oldBytes;
+    bool resized;
+    if (kind == MEMCHUNK_KIND_SPAN) {
+        if (!MemCacheResize(this, p, numBytes, alignment, offset, &oldBytes, &resized)) {
+            return nullptr;
+        }
+    } else {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!ResizeLocked(p, numBytes, alignment, offset, &oldBytes, &resized)) {
+            return nullptr;
+        }
+    }
+    if (resized) {
+        return p;
+    }
+
+    // 제자리에서 안 되면 새로 받아서 옮기고 이전 블록을 해제
+    auto newPtr = Allocate(numBytes, alignment, offset);
+    if (newPtr == nullptr) {
+        return nullptr;
+    }
+    memcpy(newPtr, p, oldBytes < numBytes? oldBytes: numBytes);
+    Deallocate(p);
+    return newPtr;
+}
+
+bool AllocatorEntry::ResizeLocked(void* p, size_t numBytes, size_t alignment, size_t offset, size_t* oldBytes, bool* resized)
+{
+    auto index = FindChunk(p);
+    if (index == MEMRANGE_NULL) {
+        return false;
+    }
+
+    auto memChunk = (MemChunk*)memChunkList[index];
+    if (memChunk->kind == MEMCHUNK_KIND_ARENA) {
+        // 아레나는 블록 크기를 기록하지 않으므로 청크에서 쓴 끝까지를 옮김
+        auto start = (size_t)((uint8*)p - (uint8*)memChunk->memPtr);
+        auto end = index == arenaChunk? memChunk->top: memChunk->size;
+        if (start > end) {
+            return false;
+        }
+        *oldBytes = end - start;
+        *resized = false;
+        return true;
+    }
+
+    auto found = memChunk->kind == MEMCHUNK_KIND_BUDDY?
+        memChunk->ResizeBuddyBlock(p, numBytes, alignment, offset, oldBytes, resized):
+        memChunk->ResizeRange(p, numBytes, alignment, offset, oldBytes, resized);
+    if (!found) {
+        return false;
+    }
+    if (*resized) {
+        allocByteCount = allocByteCount - *oldBytes + numBytes;
+        UpdatePeak();
+    }
+    return true;
+}
+
+void* AllocatorEntry::ArenaAllocateLocked(size_t numBytes, size_t alignment, size_t offset)
+{
+    for (;;) {
+        if (arenaChunk < memChunkList.Count()) {
+            auto memChunk = (MemChunk*)memChunkList[arenaChunk];
+            auto start = CEIL_ALIGNED_TO(memChunk->top, alignment, offset);
+            if (start + numBytes <= memChunk->size) {
+                memChunk->top = start + numBytes;
+                CountAllocLocked(numBytes);
+                return (uint8*)memChunk->memPtr + start;
+            }
+
+            // 리셋 이후 다시 쓰는 청크는 처음부터 채움
+            if (arenaChunk + 1 < memChunkList.Count()) {
+                auto nextChunk = (MemChunk*)memChunkList[arenaChunk + 1];
+                if (nextChunk->state != MEMCHUNK_STATE_COMMITTED &&
+                    !RestoreChunk(arenaChunk + 1, nextChunk->size, MEMCHUNK_KIND_ARENA)) {
+                    return nullptr;
+                }
+                arenaChunk++;
+                ((MemChunk*)memChunkList[arenaChunk])->top = 0;
+                continue;
+            }
+        }
+
+        auto index = AddChunk(numBytes + alignment + offset, MEMCHUNK_KIND_ARENA);
+        if (index == MEMRANGE_NULL) {
+            return nullptr;
+        }
+        arenaChunk = index;
+    }
+}
+
+void* AllocatorEntry::BuddyAllocateLocked(size_t numBytes, size_t alignment, size_t offset)
+{
+    // 버디 블록은 청크 시작을 기준으로 정렬되므로 청크 정렬보다 큰 정렬은 맞출 수 없음
+    // 해제할 때 최소 블록으로 내림해서 블록 시작을 찾으므로 offset 은 최소 블록보다 작아야 함
+    if (alignment > ((size_t)1 << pageShift) || offset >= MEMBUDDY_MIN_BLOCK_SIZE || numBytes == 0) {
+        return nullptr;
+    }
+
+    void* p = nullptr;
+    if (lastRefPage < (size_t)memChunkList.Count()) {
+        auto lastRefChunk = (MemChunk*)memChunkList[(int32)lastRefPage];
+        if (lastRefChunk->kind == MEMCHUNK_KIND_BUDDY && lastRefChunk->state == MEMCHUNK_STATE_COMMITTED &&
+            lastRefChunk->GetBuddyBlock(numBytes, alignment, offset, &p)) {
+            CountAllocLocked(numBytes);
+            return p;
+        }
+    }
+
+    for (auto i = 0; i < memChunkList.Count(); i++) {
+        auto memChunk = (MemChunk*)memChunkList[i];
+        if (memChunk->kind == MEMCHUNK_KIND_BUDDY && memChunk->state == MEMCHUNK_STATE_COMMITTED &&
+            memChunk->GetBuddyBlock(numBytes, alignment, offset, &p)) {
+            CountAllocLocked(numBytes);
+            lastRefPage = i;
+            return p;
+        }
+    }
+
+    auto index = AddChunk(numBytes + offset > alignment? numBytes + offset: alignment, MEMCHUNK_KIND_BUDDY);
+    if (index == MEMRANGE_NULL) {
+        return nullptr;
+    }
+
+    lastRefPage = index;
+    auto memChunk = (MemChunk*)memChunkList[index];
+    if (!memChunk->GetBuddyBlock(numBytes, alignment, offset, &p)) {
+        return nullptr;
+    }
+    CountAllocLocked(numBytes);
+    return p;
+}
+
+bool AllocatorEntry::ArenaPush()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    MemArenaMarker marker;
+    marker.chunk = arenaChunk;
+    marker.top = arenaChunk < memChunkList.Count()? ((MemChunk*)memChunkList[arenaChunk])->top: 0;
+    marker.allocByteCount = allocByteCount;
+    marker.liveCount = stats.allocCount.load(std::memory_order_relaxed) - stats.freeCount.load(std::memory_order_relaxed);
+    return arenaMarkers.InsertLast(1, &marker, nullptr);
+}
+
+bool AllocatorEntry::ArenaPop()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (arenaMarkers.Count() == 0) {
+        return false;
+    }
+
+    auto marker = *(MemArenaMarker*)arenaMarkers.Last();
+    arenaMarkers.RemoveLast();
+
+    arenaChunk = marker.chunk;
+    if (arenaChunk < memChunkList.Count()) {
+        ((MemChunk*)memChunkList[arenaChunk])->top = marker.top;
+    }
+    allocByteCount = marker.allocByteCount;
+    stats.freeCount.store(stats.allocCount.load(std::memory_order_relaxed) - marker.liveCount, std::memory_order_relaxed);
+    if (trimRetainCount != MEMTRIM_RETAIN_ALL) {
+        RetainEmptyChunks(trimRetainCount);
+    }
+    return true;
+}
+
+bool AllocatorEntry::ArenaReset()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    // 뒤쪽 청크의 위치는 다시 도달할 때 초기화하므로 청크 수와 무관
+    arenaMarkers.RemoveAll();
+    arenaChunk = 0;
+    if (memChunkList.Count() > 0) {
+        ((MemChunk*)memChunkList[0])->top = 0;
+    }
+    allocByteCount = 0;
+    stats.freeCount.store(stats.allocCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    if (trimRetainCount != MEMTRIM_RETAIN_ALL) {
+        RetainEmptyChunks(trimRetainCount);
+    }
+    return true;
+}
+
+void AllocatorEntry::SetTrimPolicy(size_t retainCount, int32 mode)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    trimRetainCount = retainCount;
+    trimMode = mode;
+    if (trimRetainCount != MEMTRIM_RETAIN_ALL) {
+        RetainEmptyChunks(trimRetainCount);
+    }
+}
+
+size_t AllocatorEntry::Trim()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    return RetainEmptyChunks(0);
+}
+
+MemHandleSlot* AllocatorEntry::FindHandleLocked(uint64 id) const
+{
+    auto index = (int32)(id & 0xFFFFFFFF) - 1;
+    if (index < 0 || index >= handleList.Count()) {
+        return nullptr;
+    }
+
+    auto slot = (MemHandleSlot*)handleList[index];
+    if (slot->ptr == nullptr || slot->generation != (uint32)(id >> 32)) {
+        return nullptr;
+    }
+    return slot;
+}
+
+uint64 AllocatorEntry::AllocateHandle(size_t numBytes, size_t alignment)
+{
+    if (kind != MEMPAGE_KIND_DEFAULT || numBytes == 0) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    // 스레드 캐시를 거치지 않고 범위 청크에서만 할당해서 압축할 때 옮길 수 있게 함
+    auto p = AllocateLocked(numBytes, alignment, 0, 0);
+    if (p == nullptr) {
+        return 0;
+    }
+
+    int32 index = freeHandle;
+    if (index != MEMRANGE_NULL) {
+        freeHandle = ((MemHandleSlot*)handleList[index])->nextFree;
+    } else {
+        MemHandleSlot empty = { nullptr, 0, 0, 1, 0, MEMRANGE_NULL };
+        if (!handleList.InsertLast(1, &empty, nullptr)) {
+            DeallocateLocked(p);
+            return 0;
+        }
+        index = handleList.Count() - 1;
+    }
+
+    auto slot = (MemHandleSlot*)handleList[index];
+    slot->ptr = p;
+    slot->size = numBytes;
+    slot->alignment = alignment;
+    slot->pinCount = 0;
+    slot->nextFree = MEMRANGE_NULL;
+
+    return ((uint64)slot->generation << 32) | (uint64)(index + 1);
+}
+
+bool AllocatorEntry::FreeHandle(uint64 id)
 {
-    rangeList.Init(nullptr, sizeof(MemRange));
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto slot = FindHandleLocked(id);
+    if (slot == nullptr || slot->pinCount > 0 || !DeallocateLocked(slot->ptr)) {
+        return false;
+    }
+
+    slot->ptr = nullptr;
+    slot->size = 0;
+    slot->generation++;
+    slot->nextFree = freeHandle;
+    freeHandle = (int32)(id & 0xFFFFFFFF) - 1;
+    return true;
 }
-MemChunk::MemChunk(void* mem_ptr, size_t size) : memPtr(mem_ptr), size(size)
+
+void* AllocatorEntry::PinHandle(uint64 id)
 {
-    rangeList.Init(nullptr, sizeof(MemRange));
-    rangeList.ResizeMem(size / 1024 + 1);
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto slot = FindHandleLocked(id);
+    if (slot == nullptr) {
+        return nullptr;
+    }
+
+    slot->pinCount++;
+    return slot->ptr;
 }
 
-#define CEIL_ALIGNED_TO(addr, align, offset) ((((addr) + (align - 1)) & ~(align - 1)) + offset)
-#define FLOOR_ALIGNED_TO(addr, align, offset) (((addr) & ~(align - 1)) + offset)
-bool MemChunk::GetEmptyMemAndAppend(IN size_t req_size, IN size_t alignment, IN size_t aligned_offset, IN int flags, OUT void** ptr)
+bool AllocatorEntry::UnpinHandle(uint64 id)
 {
-    size_t start_point = std::numeric_limits<size_t>::max();
+    std::lock_guard<std::mutex> guard(lock);
 
-    if (rangeList.Count() > 0)
-    {
-        size_t aligned_start = 0, aligned_end = 0;
-        int32 insert_index = 0;
+    auto slot = FindHandleLocked(id);
+    if (slot == nullptr || slot->pinCount == 0) {
+        return false;
+    }
 
-        for (auto i = 0; i < rangeList.Count() + 1; i++)
-        {
-            if (i == 0)
-            {
-                aligned_start = 0;
-                auto range = (MemRange*)rangeList.Start();
-                aligned_end = FLOOR_ALIGNED_TO(range->start, alignment, aligned_offset);
-            }
-            else if (i == rangeList.Count())
-            {
-                auto range = (MemRange*)rangeList.Last();
-                aligned_start = CEIL_ALIGNED_TO(range->start + range->count, alignment, aligned_offset);
-                aligned_end = this->size;
-            }
-            else
-            {
-                auto leftRange = (MemRange*)rangeList[i - 1];
-                auto rightRange = (MemRange*)rangeList[i];
-                aligned_start = CEIL_ALIGNED_TO(leftRange->End(), alignment, aligned_offset);
-                aligned_end = FLOOR_ALIGNED_TO(rightRange->start, alignment, aligned_offset);
+    slot->pinCount--;
+    return true;
+}
+
+size_t AllocatorEntry::HandleSize(uint64 id)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto slot = FindHandleLocked(id);
+    return slot != nullptr? slot->size: 0;
+}
+
+struct MemCompactItem
+{
+    int32 chunkIndex;
+    int32 slotIndex;
+    size_t offset;
+};
+
+void AllocatorEntry::Compact(size_t maxMoveBytes, MemCompactStats* compactStats)
+{
+    memset(compactStats, 0, sizeof(MemCompactStats));
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto start = std::chrono::steady_clock::now();
+
+    // 이번에 비워진 청크만 돌려주도록 원래 비어 있지 않던 청크를 기억함
+    ArrayList usedChunks;
+    usedChunks.Init(nullptr, sizeof(int32));
+    for (auto i = 0; i < memChunkList.Count(); i++) {
+        if (!IsChunkEmpty(i)) {
+            usedChunks.InsertLast(1, &i, nullptr);
+        }
+    }
+
+    // 앞쪽 청크의 낮은 주소부터 채우도록 (청크, 오프셋) 순서로 옮김
+    ArrayList items;
+    items.Init(nullptr, sizeof(MemCompactItem));
+    for (auto i = 0; i < handleList.Count(); i++) {
+        auto slot = (MemHandleSlot*)handleList[i];
+        if (slot->ptr == nullptr) {
+            continue;
+        }
+        MemCompactItem item;
+        item.chunkIndex = FindChunk(slot->ptr);
+        item.slotIndex = i;
+        item.offset = (size_t)((char*)slot->ptr - (char*)((MemChunk*)memChunkList[item.chunkIndex])->memPtr);
+        items.InsertLast(1, &item, nullptr);
+    }
+
+    auto first = (MemCompactItem*)items.Start(), last = first + items.Count();
+    std::sort(first, last, [](const MemCompactItem& a, const MemCompactItem& b) {
+        return a.chunkIndex != b.chunkIndex? a.chunkIndex < b.chunkIndex: a.offset < b.offset;
+    });
+
+    for (auto item = first; item != last; item++) {
+        auto slot = (MemHandleSlot*)handleList[item->slotIndex];
+        if (slot->pinCount > 0) {
+            compactStats->pinnedCount++;
+            continue;
+        }
+        if (compactStats->movedBytes >= maxMoveBytes) {
+            break;
+        }
+
+        // 같은 청크에서는 지금 위치보다 앞쪽만 찾음
+        void* p = nullptr;
+        for (auto i = 0; i <= item->chunkIndex && p == nullptr; i++) {
+            auto memChunk = (MemChunk*)memChunkList[i];
+            if (memChunk->kind != MEMCHUNK_KIND_RANGE || memChunk->state != MEMCHUNK_STATE_COMMITTED) {
+                continue;
             }
+            memChunk->GetLowestMem(slot->size, slot->alignment, i == item->chunkIndex? item->offset: memChunk->size, &p);
+        }
+        if (p == nullptr) {
+            continue;
+        }
 
-            if (req_size + aligned_start < aligned_end)
-            {
-                start_point = aligned_start;
-                insert_index = i;
-                break;
+        // 바이트 수와 할당 통계는 그대로 두고 위치만 바꿈
+        memcpy(p, slot->ptr, slot->size);
+        ((MemChunk*)memChunkList[item->chunkIndex])->RemoveRange(slot->ptr, nullptr);
+        slot->ptr = p;
+        compactStats->movedBytes += slot->size;
+        compactStats->movedCount++;
+    }
+    items.Destroy();
+
+    if (trimRetainCount != MEMTRIM_RETAIN_ALL) {
+        compactStats->releasedBytes = RetainEmptyChunks(trimRetainCount);
+    } else {
+        for (auto i = 0; i < usedChunks.Count(); i++) {
+            auto chunkIndex = *(int32*)usedChunks[i];
+            if (IsChunkEmpty(chunkIndex)) {
+                compactStats->releasedBytes += TrimChunk(chunkIndex);
             }
         }
+    }
+    usedChunks.Destroy();
+    compactStats->pauseNs = (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+}
+
+void AllocatorEntry::ResetChunkWarm(int32 chunkIndex)
+{
+    // 잠긴 페이지와 미리 채운 페이지는 받을 때 이미 상주함
+    // 새로 쓰게 된 청크이므로 이전 상태는 세지 않고 더하기만 함
+    auto memChunk = (MemChunk*)memChunkList[chunkIndex];
+    memChunk->warmState = (pageFlags & (PAGE_FLAG_PREFAULT | PAGE_FLAG_LOCKED)) != 0? MEMWARM_WARM: MEMWARM_COLD;
+    warmChunkCounts[memChunk->warmState].fetch_add(1, std::memory_order_relaxed);
+    if (warmPages && memChunk->warmState == MEMWARM_COLD) {
+        QueueWarm(chunkIndex);
+    }
+}
+
+void AllocatorEntry::SetChunkWarm(MemChunk* memChunk, uint32 warmState)
+{
+    // 새 상태를 먼저 더해야 WarmState 가 중간에 읽어도 더 채워진 쪽으로 보이지 않음
+    warmChunkCounts[warmState].fetch_add(1, std::memory_order_relaxed);
+    warmChunkCounts[memChunk->warmState].fetch_sub(1, std::memory_order_relaxed);
+    memChunk->warmState = warmState;
+}
+
+void AllocatorEntry::QueueWarm(int32 chunkIndex)
+{
+    auto memChunk = (MemChunk*)memChunkList[chunkIndex];
+    SetChunkWarm(memChunk, MEMWARM_WARMING);
+
+    MemWarmJob job;
+    job.entryIndex = GetEntryIndex(this);
+    job.generation = GetEntryGeneration(job.entryIndex);
+    job.chunkIndex = chunkIndex;
+    job.memPtr = memChunk->memPtr;
+    job.offset = 0;
+    MemWarmEnqueue(job);
+}
+
+bool AllocatorEntry::Warm(size_t reserveBytes)
+{
+    std::lock_guard<std::mutex> guard(lock);
 
-        if (start_point == std::numeric_limits<size_t>::max())
+    if (totalPageSize < reserveBytes) {
+        auto chunkKind = kind == MEMPAGE_KIND_ARENA? MEMCHUNK_KIND_ARENA: kind == MEMPAGE_KIND_BUDDY? MEMCHUNK_KIND_BUDDY: MEMCHUNK_KIND_RANGE;
+        if (AddChunk(reserveBytes - totalPageSize, chunkKind) == MEMRANGE_NULL) {
             return false;
+        }
+    }
+
+    for (auto i = 0; i < memChunkList.Count(); i++) {
+        auto memChunk = (MemChunk*)memChunkList[i];
+        if (memChunk->state == MEMCHUNK_STATE_COMMITTED && memChunk->warmState == MEMWARM_COLD) {
+            QueueWarm(i);
+        }
+    }
+    return true;
+}
 
-        auto r = MemRange(start_point, req_size, flags);
-        rangeList.Insert(insert_index, 1, &r, nullptr);
+int32 AllocatorEntry::WarmState() const
+{
+    // 가장 덜 채워진 청크의 상태, 락 없이 읽으므로 바뀌는 중이면 한 단계 덜 채워진 쪽으로 보일 수 있음
+    if (warmChunkCounts[MEMWARM_COLD].load() > 0) {
+        return MEMWARM_COLD;
     }
-    else
-    {
-        start_point = 0;
-        auto r = MemRange(start_point, req_size, flags);
-        rangeList.InsertLast(1, &r, nullptr);
+    if (warmChunkCounts[MEMWARM_WARMING].load() > 0) {
+        return MEMWARM_WARMING;
     }
+    return warmChunkCounts[MEMWARM_WARM].load() > 0? MEMWARM_WARM: MEMWARM_COLD;
+}
+
+bool AllocatorEntry::PinWarmChunk(const MemWarmJob* job, size_t sliceBytes, void** p, size_t* size)
+{
+    std::lock_guard<std::mutex> guard(lock);
 
-    *ptr = static_cast<void*>(((char*)memPtr + start_point));
+    // 그 사이 돌려준 청크는 다시 받을 때 새 작업이 들어감
+    if (job->chunkIndex >= memChunkList.Count()) {
+        return false;
+    }
+    auto memChunk = (MemChunk*)memChunkList[job->chunkIndex];
+    if (memChunk->memPtr != job->memPtr || memChunk->state != MEMCHUNK_STATE_COMMITTED || memChunk->warmState != MEMWARM_WARMING) {
+        return false;
+    }
 
+    memChunk->warmPinned = true;
+    warmPinCount.fetch_add(1, std::memory_order_relaxed);
+    *p = (uint8*)memChunk->memPtr + job->offset;
+    *size = memChunk->size - job->offset < sliceBytes? memChunk->size - job->offset: sliceBytes;
     return true;
 }
 
-bool MemChunk::RemoveRange(IN void* p, OUT size_t* count)
+bool AllocatorEntry::UnpinWarmChunk(MemWarmJob* job, size_t size)
 {
-    if (memPtr <= p && (void*)((char*)memPtr + size) > p)
+    bool remaining;
     {
-        auto i = 0;
-        auto rangeCount = rangeList.Count();
-        for (; i < rangeCount; i++) {
-            auto r = (MemRange*)rangeList[i];
-            if ((void*)((char*)memPtr + r->start) == p)
-                break;
+        // 고정한 동안에는 돌려주지 않았으므로 청크는 그대로 MEMWARM_WARMING
+        std::lock_guard<std::mutex> guard(lock);
+
+        auto memChunk = (MemChunk*)memChunkList[job->chunkIndex];
+        memChunk->warmPinned = false;
+        job->offset += size;
+        remaining = job->offset < memChunk->size;
+        if (!remaining) {
+            SetChunkWarm(memChunk, MEMWARM_WARM);
         }
+    }
 
-        if (i < rangeCount) {
-            rangeList.Remove(i, 1);
-            if (count) {
-                auto range = (MemRange*)rangeList[i];
-                *count = range->count;
-            }
-            return true;
+    // 마지막에 내려야 RemoveEntry 가 기다린 뒤 지운 주소 공간을 건드리지 않음
+    warmPinCount.fetch_sub(1, std::memory_order_release);
+    return remaining;
+}
+
+bool AllocatorEntry::IsChunkEmpty(int32 chunkIndex) const
+{
+    auto memChunk = (MemChunk*)memChunkList[chunkIndex];
+    if (memChunk->state != MEMCHUNK_STATE_COMMITTED || memChunk->warmPinned) {
+        return false;
+    }
+
+    // span 은 크기 클래스 목록에 블록이 흩어져 있어서 청크 단위로 회수하지 않음
+    switch (memChunk->kind) {
+    case MEMCHUNK_KIND_RANGE:
+        return memChunk->usedRangeCount == 0;
+    case MEMCHUNK_KIND_ARENA:
+        return chunkIndex > arenaChunk;
+    case MEMCHUNK_KIND_BUDDY:
+        return memChunk->buddy.AllocCount() == 0;
+    default:
+        return false;
+    }
+}
+
+size_t AllocatorEntry::RetainEmptyChunks(size_t retainCount)
+{
+    size_t emptyCount = 0, trimmedBytes = 0;
+    for (auto i = 0; i < memChunkList.Count(); i++) {
+        if (IsChunkEmpty(i) && ++emptyCount > retainCount) {
+            trimmedBytes += TrimChunk(i);
         }
-        else {
+    }
+    return trimmedBytes;
+}
+
+size_t AllocatorEntry::TrimChunk(int32 chunkIndex)
+{
+    auto memChunk = (MemChunk*)memChunkList[chunkIndex];
+    auto size = memChunk->size;
+
+    if (trimMode == MEMTRIM_DECOMMIT) {
+        if (!PageDecommit(memChunk->memPtr, size, pageFlags)) {
+            return 0;
         }
+        warmChunkCounts[memChunk->warmState].fetch_sub(1, std::memory_order_relaxed);
+        memChunk->state = MEMCHUNK_STATE_DECOMMITTED;
+        memChunk->warmState = MEMWARM_COLD;
+        return size;
     }
 
-    return false;
+    warmChunkCounts[memChunk->warmState].fetch_sub(1, std::memory_order_relaxed);
+    RemoveChunkTable(chunkIndex);
+    PageFree(memChunk->memPtr, size, pageFlags);
+    memChunk->Destroy();
+    memChunk->memPtr = nullptr;
+    memChunk->state = MEMCHUNK_STATE_RELEASED;
+    memChunk->warmState = MEMWARM_COLD;
+    totalPageSize -= size;
+    return size;
 }
 
-AllocatorEntry::AllocatorEntry() :
-    name(L""), minPageSize(0), lastRefPage(0), debug(0), allocByteCount(0), totalPageSize(0), pageLocked(false)
+bool AllocatorEntry::RestoreChunk(int32 chunkIndex, size_t numBytes, uint32 kind)
 {
-    memChunkList.Init(nullptr, sizeof(MemChunk));
+    auto memChunk = (MemChunk*)memChunkList[chunkIndex];
+
+    if (memChunk->state == MEMCHUNK_STATE_DECOMMITTED) {
+        if (!PageCommit(memChunk->memPtr, memChunk->size, pageFlags)) {
+            return false;
+        }
+        memChunk->state = MEMCHUNK_STATE_COMMITTED;
+        ResetChunkWarm(chunkIndex);
+        return true;
+    }
+
+    void* page = PageAlloc(numBytes, (size_t)1 << pageShift, pageFlags);
+    if (page == nullptr) {
+        return false;
+    }
+
+    *memChunk = MemChunk(page, numBytes, kind);
+    if (!InsertChunkTable(chunkIndex)) {
+        PageFree(page, numBytes, pageFlags);
+        memChunk->Destroy();
+        memChunk->memPtr = nullptr;
+        memChunk->state = MEMCHUNK_STATE_RELEASED;
+        return false;
+    }
+
+    totalPageSize += numBytes;
+    ResetChunkWarm(chunkIndex);
+    return true;
 }
-AllocatorEntry::AllocatorEntry(const wchar_t* name, unsigned debug, size_t minPageSize, bool pageLocked) :
-    minPageSize(minPageSize), lastRefPage(0), debug(debug), allocByteCount(0), totalPageSize(0), pageLocked(pageLocked)
+
+size_t AllocatorEntry::AllocatedBytes()
 {
-    wcscpy_s(this->name, name);
-    memChunkList.Init(nullptr, sizeof(MemChunk));
+    std::lock_guard<std::mutex> guard(lock);
+
+    return LiveBytesLocked();
 }
-AllocatorEntry::AllocatorEntry(const AllocatorEntry& o) :
-    minPageSize(o.minPageSize), lastRefPage(o.lastRefPage), debug(o.debug), allocByteCount(o.allocByteCount),
-    totalPageSize(o.totalPageSize), pageLocked(o.pageLocked)
+
+size_t AllocatorEntry::LiveBytesLocked() const
 {
-    wcscpy_s(this->name, o.name);
-    memChunkList.CopyFrom(o.memChunkList);
+    auto total = allocByteCount;
+    for (auto cache = threadCacheList; cache; cache = cache->next) {
+        total += (size_t)cache->byteDelta.load(std::memory_order_relaxed);
+    }
+    return total;
 }
-AllocatorEntry::AllocatorEntry(const AllocatorEntry& o, const wchar_t* name) :
-    minPageSize(o.minPageSize), lastRefPage(o.lastRefPage), debug(o.debug), allocByteCount(o.allocByteCount),
-    totalPageSize(o.totalPageSize), pageLocked(o.pageLocked)
+
+void AllocatorEntry::UpdatePeak()
 {
-    wcscpy_s(this->name, name);
-    memChunkList.CopyFrom(o.memChunkList);
+    auto total = LiveBytesLocked();
+    if (total > peakByteCount) {
+        peakByteCount = total;
+    }
 }
-AllocatorEntry::~AllocatorEntry()
+
+void AllocatorEntry::CountAllocLocked(size_t numBytes)
 {
-    for (auto i = 0; i < memChunkList.Count(); i++) {
-        auto memChunk = (MemChunk*)memChunkList[i];
-        if (memChunk->memPtr) {
-            if (pageLocked) {
-                VirtualUnlock(memChunk->memPtr, memChunk->size);
-            }
+    allocByteCount += numBytes;
+    stats.CountAlloc(numBytes);
+    UpdatePeak();
+}
 
-            _aligned_free(memChunk->memPtr);
-            memChunk->memPtr = nullptr;
-        }
+// 2의 지수마다 (1 << MEMSTAT_LATENCY_SUB_BITS) 칸으로 나눈 버킷
+static int32 LatencyBucket(uint64 ns)
+{
+    const uint64 subCount = 1 << MEMSTAT_LATENCY_SUB_BITS;
+    if (ns < subCount) {
+        return (int32)ns;
     }
-    memChunkList.Destroy();
-    this->name[0] = L'\0';
+    auto exponent = BitScanReverse64(ns);
+    auto bucket = (exponent - MEMSTAT_LATENCY_SUB_BITS + 1) * (int32)subCount +
+        (int32)((ns >> (exponent - MEMSTAT_LATENCY_SUB_BITS)) & (subCount - 1));
+    return bucket < MEMSTAT_LATENCY_BUCKET_COUNT? bucket: MEMSTAT_LATENCY_BUCKET_COUNT - 1;
 }
 
-void* AllocatorEntry::Allocate(size_t numBytes, int flags)
+// 버킷의 가운데 값
+static uint64 LatencyBucketValue(int32 bucket)
 {
-    return Allocate(numBytes, ALLOCATOR_MIN_ALIGNMENT, 0, flags);
+    const int32 subCount = 1 << MEMSTAT_LATENCY_SUB_BITS;
+    if (bucket < subCount) {
+        return (uint64)bucket;
+    }
+    auto shift = bucket / subCount - 1;
+    auto low = (uint64)(subCount + bucket % subCount) << shift;
+    return low + ((uint64)1 << shift) / 2;
 }
-void* AllocatorEntry::Allocate(size_t numBytes, size_t alignment, size_t offset, int flags)
+
+static uint64 LatencyPercentile(const uint64* histogram, uint64 total, uint64 percent)
 {
-    if (memChunkList.Count() == 0) {
-        size_t allocSize = numBytes < minPageSize ? minPageSize : numBytes;
-        totalPageSize += allocSize;
-        void* page = _aligned_offset_malloc(allocSize, minPageSize, 0);
-        if (page == nullptr ||
-            (pageLocked && !VirtualLock(page, allocSize))) {
-            return nullptr;
+    auto target = (total * percent + 99) / 100;
+    uint64 sum = 0;
+    for (auto i = 0; i < MEMSTAT_LATENCY_BUCKET_COUNT; i++) {
+        sum += histogram[i];
+        if (sum >= target && sum > 0) {
+            return LatencyBucketValue(i);
         }
-        auto chunk = MemChunk(page, allocSize);
-        memChunkList.InsertLast(1, &chunk, nullptr);
-        lastRefPage = 0;
     }
+    return 0;
+}
 
-    void* p = nullptr;
-    auto lastRefChunk = (MemChunk*)memChunkList[lastRefPage];
-    if (lastRefChunk->GetEmptyMemAndAppend(numBytes, alignment, offset, flags, &p)) {
-        allocByteCount += numBytes;
-        return p;
+void AllocatorEntry::RecordLatency(uint64 ns)
+{
+    latencyHistogram[LatencyBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocatorEntry::SetSampling(uint32 interval)
+{
+    sampleInterval.store(interval, std::memory_order_relaxed);
+}
+
+void AllocatorEntry::CollectStats(MemPageStats* pageStats)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    memset(pageStats, 0, sizeof(MemPageStats));
+
+    UpdatePeak();
+    pageStats->liveBytes = LiveBytesLocked();
+    pageStats->peakBytes = peakByteCount;
+
+    MemStatCounters total;
+    stats.AddTo(total);
+    for (auto cache = threadCacheList; cache; cache = cache->next) {
+        cache->stats.AddTo(total);
+    }
+    pageStats->allocCount = total.allocCount.load(std::memory_order_relaxed);
+    pageStats->liveCount = pageStats->allocCount - total.freeCount.load(std::memory_order_relaxed);
+    for (auto i = 0; i < MEMSTAT_SIZE_BUCKET_COUNT; i++) {
+        pageStats->sizeHistogram[i] = total.sizeHistogram[i].load(std::memory_order_relaxed);
     }
 
+    pageStats->pageBytes = totalPageSize;
     for (auto i = 0; i < memChunkList.Count(); i++) {
         auto memChunk = (MemChunk*)memChunkList[i];
-        if (memChunk->GetEmptyMemAndAppend(numBytes, alignment, offset, flags, &p))
-        {
-            allocByteCount += numBytes;
-            lastRefPage = i;
-            return p;
+        if (memChunk->state == MEMCHUNK_STATE_RELEASED) {
+            continue;
+        }
+        pageStats->chunkCount++;
+        if (memChunk->state != MEMCHUNK_STATE_COMMITTED) {
+            continue;
+        }
+
+        size_t freeBytes = 0, largestFree = 0;
+        if (memChunk->kind == MEMCHUNK_KIND_RANGE) {
+            memChunk->FreeExtent(&freeBytes, &largestFree);
+        }
+        else if (memChunk->kind == MEMCHUNK_KIND_ARENA && i >= arenaChunk) {
+            freeBytes = largestFree = i == arenaChunk? memChunk->size - memChunk->top: memChunk->size;
+        }
+        else if (memChunk->kind == MEMCHUNK_KIND_BUDDY) {
+            BuddyStats buddyStats;
+            memChunk->buddy.Stats(&buddyStats);
+            freeBytes = (size_t)buddyStats.freeBytes;
+            largestFree = (size_t)buddyStats.largestFreeBytes;
         }
+        pageStats->freeBytes += freeBytes;
+        if (largestFree > pageStats->largestFreeBytes) {
+            pageStats->largestFreeBytes = largestFree;
+        }
+    }
+    if (pageStats->freeBytes > 0) {
+        pageStats->fragmentation = 1.0f - (float)((double)pageStats->largestFreeBytes / (double)pageStats->freeBytes);
     }
 
-    size_t allocSize = numBytes < minPageSize ? minPageSize : numBytes;
-    totalPageSize += allocSize;
-    void* page = _aligned_offset_malloc(allocSize, minPageSize, 0);
-    if (page == nullptr ||
-        (pageLocked && !VirtualLock(page, allocSize))) {
-        return nullptr;
+    uint64 latency[MEMSTAT_LATENCY_BUCKET_COUNT];
+    for (auto i = 0; i < MEMSTAT_LATENCY_BUCKET_COUNT; i++) {
+        latency[i] = latencyHistogram[i].load(std::memory_order_relaxed);
+        pageStats->latencySampleCount += latency[i];
+    }
+    pageStats->latencyP50Ns = LatencyPercentile(latency, pageStats->latencySampleCount, 50);
+    pageStats->latencyP99Ns = LatencyPercentile(latency, pageStats->latencySampleCount, 99);
+}
+
+void AllocatorEntry::PushCacheBlock(int32 classIndex, void* block)
+{
+    *(void**)block = cacheFreeList[classIndex];
+    cacheFreeList[classIndex] = block;
+}
+
+bool AllocatorEntry::AddSpan(int32 classIndex)
+{
+    void* p = nullptr;
+    for (auto i = 0; i < memChunkList.Count() && p == nullptr; i++) {
+        auto memChunk = (MemChunk*)memChunkList[i];
+        if (memChunk->kind == MEMCHUNK_KIND_SPAN) {
+            memChunk->GetEmptyMemAndAppend(spanSize, spanSize, 0, 0, &p);
+        }
+    }
+    if (p == nullptr) {
+        auto index = AddChunk(minPageSize, MEMCHUNK_KIND_SPAN);
+        if (index == MEMRANGE_NULL ||
+            !((MemChunk*)memChunkList[index])->GetEmptyMemAndAppend(spanSize, spanSize, 0, 0, &p)) {
+            return false;
+        }
     }
-    auto chunk = MemChunk(page, allocSize);
-    memChunkList.InsertLast(1, &chunk, nullptr);
 
-    lastRefPage = memChunkList.Count() - 1;
-    lastRefChunk = (MemChunk*)memChunkList[lastRefPage];
+    // 헤더 크기와 블록 수가 서로 의존하므로 블록마다 1바이트를 더해 어림한 뒤 다시 계산
+    auto span = (MemSpan*)p;
+    span->classIndex = classIndex;
+    span->blockSize = MemCacheClassSize(classIndex);
+    auto blockCount = (uint32)((spanSize - sizeof(MemSpan)) / (span->blockSize + 1));
+    span->headerSize = (uint32)((sizeof(MemSpan) + blockCount + 63) & ~(size_t)63);
+    auto fitCount = span->headerSize < spanSize? (uint32)((spanSize - span->headerSize) / span->blockSize): 0;
+    span->blockCount = fitCount < blockCount? fitCount: blockCount;
+    if (span->blockCount == 0) {
+        return false;
+    }
 
-    if (lastRefChunk->GetEmptyMemAndAppend(numBytes, alignment, offset, flags, &p)) {
-        allocByteCount += numBytes;
-        return p;
+    memset(span->Slack(), MEMCACHE_FREE_BLOCK, span->blockCount);
+    for (auto i = span->blockCount; i > 0; i--) {
+        PushCacheBlock(classIndex, span->Block(i - 1));
     }
-    else {
-        return nullptr;
+    return true;
+}
+
+int32 AllocatorEntry::RefillCache(int32 classIndex, void** blocks, int32 count)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    int32 n = 0;
+    while (n < count) {
+        if (cacheFreeList[classIndex] == nullptr && !AddSpan(classIndex)) {
+            break;
+        }
+        auto block = cacheFreeList[classIndex];
+        cacheFreeList[classIndex] = *(void**)block;
+        blocks[n++] = block;
     }
+
+    // 스레드 캐시로 할당이 늘어나는 시점이므로 여기서 최대값을 갱신
+    UpdatePeak();
+    return n;
 }
 
-bool AllocatorEntry::Deallocate(void* p)
+void AllocatorEntry::FlushCache(int32 classIndex, void** blocks, int32 count, int64 byteDelta, uint64 freeCount)
 {
-    for (auto i = 0; i < memChunkList.Count(); i++)
-    {
-        auto memChunk = (MemChunk*)memChunkList[i];
-        size_t count;
-        if (memChunk->RemoveRange(p, &count))
-        {
-            allocByteCount -= count;
-            return true;
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (auto i = 0; i < count; i++) {
+        PushCacheBlock(classIndex, blocks[i]);
+    }
+    allocByteCount += (size_t)byteDelta;
+    stats.CountFree(freeCount);
+}
+
+void AllocatorEntry::AttachCache(MemThreadCache* cache)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    cache->prev = nullptr;
+    cache->next = threadCacheList;
+    if (threadCacheList) {
+        threadCacheList->prev = cache;
+    }
+    threadCacheList = cache;
+}
+
+void AllocatorEntry::DetachCache(MemThreadCache* cache)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (auto i = 0; i < MEMCACHE_CLASS_COUNT; i++) {
+        auto& magazine = cache->magazines[i];
+        for (auto j = 0; j < magazine.count; j++) {
+            PushCacheBlock(i, magazine.blocks[j]);
         }
+        magazine.count = 0;
     }
+    allocByteCount += (size_t)cache->byteDelta.exchange(0, std::memory_order_relaxed);
+    cache->stats.AddTo(stats);
+    cache->stats.Reset();
 
-    return false;
+    if (cache->prev) {
+        cache->prev->next = cache->next;
+    } else {
+        threadCacheList = cache->next;
+    }
+    if (cache->next) {
+        cache->next->prev = cache->prev;
+    }
+    cache->prev = cache->next = nullptr;
 }
 
 AllocatorEntry g_Entries[ALLOCATOR_ENTRY_COUNT];
+std::atomic<uint32> g_EntryGenerations[ALLOCATOR_ENTRY_COUNT];
+std::mutex g_EntryLock;
+
+// 위의 전역보다 먼저 사라지면서 채우는 스레드를 멈춤
+static struct MemWarmGuard
+{
+    ~MemWarmGuard() { MemWarmStop(); }
+} g_WarmGuard;
 
-int32 AddEntry(const wchar_t* name, size_t min_page_size, bool pageLocked)
+int32 AddEntry(const wchar_t* name, size_t min_page_size, bool pageLocked, int32 kind, uint32 flags)
 {
     if (name[0] == L'\0') {
         return -1;
     }
 
+    std::lock_guard<std::mutex> guard(g_EntryLock);
+
+    // 다른 스레드가 먼저 같은 이름으로 등록했을 수 있음
+    auto entry = FindEntry(name);
+    if (entry != nullptr) {
+        return GetEntryIndex(entry);
+    }
+
     int32 index = std::numeric_limits<int32>::max();
     for (int32 i = 0; i < ALLOCATOR_ENTRY_COUNT; i++)
-        if (wcscmp(g_Entries[i].name, L"") == 0)
+        if ((g_EntryGenerations[i].load(std::memory_order_relaxed) & 1) == 0)
         {
             index = i;
             break;
@@ -237,14 +2103,15 @@ int32 AddEntry(const wchar_t* name, size_t min_page_size, bool pageLocked)
     if (index == std::numeric_limits<int32>::max()) return -1;
 
     g_Entries[index].~AllocatorEntry();
-    new (g_Entries + index) AllocatorEntry(name, 1, min_page_size, pageLocked);
+    new (g_Entries + index) AllocatorEntry(name, 1, min_page_size, pageLocked, kind, flags);
+    g_EntryGenerations[index].fetch_add(1, std::memory_order_release);
 
     return index;
 }
 AllocatorEntry* FindEntry(const wchar_t* name)
 {
     for (int32 i = 0; i < ALLOCATOR_ENTRY_COUNT; i++)
-        if (!wcscmp(g_Entries[i].name, name))
+        if ((g_EntryGenerations[i].load(std::memory_order_acquire) & 1) && !wcscmp(g_Entries[i].name, name))
             return g_Entries + i;
     return nullptr;
 }
@@ -252,14 +2119,52 @@ AllocatorEntry* GetEntry(int index)
 {
     return g_Entries + index;
 }
+int32 GetEntryIndex(const AllocatorEntry* entry)
+{
+    return (int32)(entry - g_Entries);
+}
+uint32 GetEntryGeneration(int index)
+{
+    return g_EntryGenerations[index].load(std::memory_order_acquire);
+}
+bool WarmChunkSlice(MemWarmJob* job, size_t sliceBytes)
+{
+    AllocatorEntry* entry;
+    void* p;
+    size_t size;
+    {
+        std::lock_guard<std::mutex> guard(g_EntryLock);
+
+        if (GetEntryGeneration(job->entryIndex) != job->generation) {
+            return false;
+        }
+        entry = GetEntry(job->entryIndex);
+        if (!entry->PinWarmChunk(job, sliceBytes, &p, &size)) {
+            return false;
+        }
+    }
+
+    // 고정한 청크는 Trim 이 건너뛰고 RemoveEntry 는 고정이 풀릴 때까지 기다리므로 락 없이 채움
+    PagePopulate(p, size);
+    return entry->UnpinWarmChunk(job, size);
+}
 bool RemoveEntry(const wchar_t* name)
 {
+    std::lock_guard<std::mutex> guard(g_EntryLock);
+
     auto entry = FindEntry(name);
 
     if (entry == nullptr) {
         return false;
     }
 
+    // 세대가 바뀌면 스레드 캐시에 남은 블록은 버려짐
+    g_EntryGenerations[GetEntryIndex(entry)].fetch_add(1, std::memory_order_release);
+    // 세대를 바꾼 뒤에는 새로 고정하지 못하므로 채우는 중인 조각만 기다림
+    while (entry->warmPinCount.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
     entry->~AllocatorEntry();
+    new (entry) AllocatorEntry();
     return true;
 }
@@ -2,11 +2,79 @@
 
 #include "defined_type.h"
 #include "container.h"
+#include "segmentedlist.h"
+#include "allocators.h"
+#include "buddyallocator.h"
+
+#include <atomic>
+#include <mutex>
 
 constexpr int32 ALLOCATOR_MIN_ALIGNMENT = 8;
 constexpr int32 ALLOCATOR_MIN_PAGESIZE = 16 * 1024 * 1024;
 constexpr int32 ALLOCATOR_MIN_LOCKEDPAGESIZE = 4 * 1024;
 
+// 빈 범위 인덱스 (two-level segregated fit)
+// 1단계는 2의 지수, 2단계는 그 구간을 MEMCHUNK_SL_COUNT 로 나눈 크기 클래스
+constexpr int32 MEMCHUNK_SL_BITS = 4;
+constexpr int32 MEMCHUNK_SL_COUNT = 1 << MEMCHUNK_SL_BITS;
+constexpr int32 MEMCHUNK_ALIGN_SHIFT = 3;
+constexpr int32 MEMCHUNK_FL_SHIFT = MEMCHUNK_SL_BITS + MEMCHUNK_ALIGN_SHIFT;
+constexpr int32 MEMCHUNK_FL_COUNT = 64 - MEMCHUNK_FL_SHIFT + 1;
+constexpr size_t MEMCHUNK_SMALL_BLOCK = (size_t)1 << MEMCHUNK_FL_SHIFT;
+constexpr int32 MEMRANGE_NULL = -1;
+
+// 스레드 캐시 (작은 할당 전용)
+// 작은 요청은 크기 클래스별 span 에서 잘라 스레드마다 magazine 에 모아두고
+// magazine 이 비거나 넘칠 때만 주소 공간의 락을 잡고 MEMCACHE_BATCH_SIZE 개씩 주고받음
+// 기본 종류는 MEMCACHE_MAX_SIZE, 슬랩 종류는 MEMSLAB_MAX_SIZE 까지 span 에서 할당
+constexpr int32 MEMCACHE_CLASS_COUNT = 16;
+constexpr size_t MEMCACHE_MAX_SIZE = 256;
+constexpr size_t MEMSLAB_MAX_SIZE = 1024;
+constexpr size_t MEMCACHE_MAX_ALIGNMENT = 16;
+constexpr size_t MEMCACHE_SPAN_SIZE = 64 * 1024;
+constexpr uint32 MEMCACHE_MIN_PAGESHIFT = 20;
+constexpr int32 MEMCACHE_MAGAZINE_SIZE = 64;
+constexpr int32 MEMCACHE_BATCH_SIZE = MEMCACHE_MAGAZINE_SIZE / 2;
+constexpr uint8 MEMCACHE_FREE_BLOCK = 0xFF;
+
+constexpr uint32 MEMCHUNK_KIND_RANGE = 0;
+constexpr uint32 MEMCHUNK_KIND_SPAN = 1;
+constexpr uint32 MEMCHUNK_KIND_ARENA = 2;
+constexpr uint32 MEMCHUNK_KIND_BUDDY = 3;
+
+// 버디 청크의 최소 블록, 큰 청크에서는 최소 블록 수가 MEMBUDDY_MAX_BLOCK_COUNT 를 넘지 않도록 키움
+constexpr size_t MEMBUDDY_MIN_BLOCK_SIZE = 256;
+constexpr size_t MEMBUDDY_MAX_BLOCK_COUNT = (size_t)1 << 20;
+
+// memTrim 으로 돌려준 청크는 memChunkList 에 자리만 남겨서 다른 청크의 인덱스를 유지
+constexpr uint32 MEMCHUNK_STATE_COMMITTED = 0;
+constexpr uint32 MEMCHUNK_STATE_DECOMMITTED = 1;
+constexpr uint32 MEMCHUNK_STATE_RELEASED = 2;
+// 청크 테이블에서 지운 슬롯, 읽는 중인 스레드를 위해 probe 체인을 끊지 않음
+constexpr int32 MEMCHUNK_TOMBSTONE = -2;
+
+// 할당 지연 시간 버킷, 2의 지수마다 4칸
+constexpr int32 MEMSTAT_LATENCY_SUB_BITS = 2;
+constexpr int32 MEMSTAT_LATENCY_BUCKET_COUNT = 128;
+
+// 요청 크기 -> MemPageStats::sizeHistogram 칸
+int32 MemStatSizeBucket(size_t size);
+
+// 주소 공간은 lock 을 잡고, 스레드 캐시는 주인 스레드만 쓰고 memPageStats 가 읽음
+struct MemStatCounters
+{
+    std::atomic<uint64> allocCount;
+    std::atomic<uint64> freeCount;
+    std::atomic<uint64> sizeHistogram[MEMSTAT_SIZE_BUCKET_COUNT];
+
+    MemStatCounters();
+
+    void Reset();
+    void CountAlloc(size_t size);
+    void CountFree(uint64 count = 1);
+    void AddTo(MemStatCounters& o) const;
+};
+
 struct MemRange
 {
     size_t start;
@@ -14,6 +82,15 @@ struct MemRange
     int32 flags;
     size_t End();
 
+    // 요청된 크기, count 는 정렬 후 남은 자투리까지 포함
+    size_t requested;
+    // rangeList 인덱스, 주소 순서 이웃과 같은 크기 클래스의 빈 범위
+    int32 prevPhys;
+    int32 nextPhys;
+    int32 prevFree;
+    int32 nextFree;
+    bool isFree;
+
     MemRange();
     MemRange(size_t start, size_t count, int flags);
 };
@@ -23,17 +100,124 @@ struct MemChunk
 {
     void* memPtr;
     size_t size;
+    uint32 kind;
+    uint32 state;
+    // MemWarmState, 돌려주면 MEMWARM_COLD 로 돌아감
+    uint32 warmState;
+    // 락 없이 채우는 동안 true, 그동안은 비어 있어도 돌려주지 않음
+    bool warmPinned;
+    // MEMCHUNK_KIND_ARENA 에서 다음 할당 위치, 범위 관리는 하지 않음
+    size_t top;
     ArrayList rangeList;
+    // MEMCHUNK_KIND_BUDDY 에서 청크 안의 오프셋 관리, 범위 관리는 하지 않음
+    BuddyAllocator buddy;
+
+    int32* freeListHeads;
+    uint64 flBitmap;
+    uint32 slBitmap[MEMCHUNK_FL_COUNT];
+    int32 unusedRange;
+
+    // 시작 오프셋 -> 사용중인 범위 인덱스, linear probing
+    int32* rangeTable;
+    size_t rangeTableCapacity;
+    size_t usedRangeCount;
 
     MemChunk();
-    MemChunk(void* mem_ptr, size_t size);
+    MemChunk(void* mem_ptr, size_t size, uint32 kind = MEMCHUNK_KIND_RANGE);
     MemChunk(const MemChunk& o) = default;
     MemChunk(MemChunk&& o) = default;
     MemChunk& operator=(const MemChunk&) = default;
     MemChunk& operator=(MemChunk&&) = default;
 
     bool GetEmptyMemAndAppend(IN size_t req_size, IN size_t alignment, IN size_t aligned_offset, IN int flags, OUT void** ptr);
+    // 시작 오프셋이 limit 보다 작은 곳 중 가장 낮은 주소에 할당, 압축할 때 사용
+    bool GetLowestMem(IN size_t req_size, IN size_t alignment, IN size_t limit, OUT void** ptr);
     bool RemoveRange(IN void* p, OUT size_t* count);
+    // 사용중인 범위가 아니면 false, 시작 위치를 유지한 채로 크기를 바꿀 수 있으면 resized
+    bool ResizeRange(IN void* p, IN size_t req_size, IN size_t alignment, IN size_t aligned_offset, OUT size_t* requested, OUT bool* resized);
+    // MEMCHUNK_KIND_BUDDY 전용, 블록 시작에서 aligned_offset 만큼 떨어진 위치를 줌
+    bool GetBuddyBlock(IN size_t req_size, IN size_t alignment, IN size_t aligned_offset, OUT void** ptr);
+    bool RemoveBuddyBlock(IN void* p, OUT size_t* count);
+    bool ResizeBuddyBlock(IN void* p, IN size_t req_size, IN size_t alignment, IN size_t aligned_offset, OUT size_t* requested, OUT bool* resized);
+    void Destroy();
+
+    MemRange* Range(int32 index) const;
+    // 빈 범위 크기의 합과 가장 큰 빈 범위
+    void FreeExtent(size_t* freeBytes, size_t* largestFree) const;
+
+private:
+    bool Init();
+    bool ReserveRange(int32 count);
+    int32 NewRange();
+    void DeleteRange(int32 index);
+    void SplitBack(int32 index, size_t blockSize);
+
+    void InsertFree(int32 index);
+    void RemoveFree(int32 index);
+    int32 FindFree(size_t size) const;
+    int32 FindFreeFit(size_t size, size_t alignment, size_t aligned_offset) const;
+    int32 FindLowestFree(size_t size, size_t alignment, size_t limit) const;
+    void TakeRange(int32 index, size_t req_size, size_t alignment, size_t aligned_offset, int flags, void** ptr);
+
+    bool ReserveTable(size_t count);
+    void InsertTable(int32 index);
+    int32 FindTable(size_t start) const;
+    void RemoveTable(size_t slot);
+};
+
+// 청크 테이블은 락을 잡은 스레드만 쓰고 memFree 는 락 없이 읽음
+// 커질 때는 새 테이블을 만들어 교체하고 이전 테이블은 주소 공간이 해제될 때 같이 해제
+struct MemChunkSlot
+{
+    std::atomic<uint64> window;
+    std::atomic<int32> chunkIndex;
+    std::atomic<uint32> kind;
+};
+
+struct MemChunkTable
+{
+    size_t capacity;
+    size_t count;
+    MemChunkTable* retired;
+
+    MemChunkSlot* Slots();
+};
+
+// span 의 첫 부분, 블록마다 (클래스 크기 - 요청 크기) 를 1바이트로 기록
+struct MemSpan
+{
+    int32 classIndex;
+    uint32 blockSize;
+    uint32 blockCount;
+    uint32 headerSize;
+
+    uint8* Slack();
+    void* Block(uint32 index);
+    // 블록의 시작이 아니면 -1
+    int32 IndexOf(void* p);
+};
+
+struct MemThreadCache;
+struct MemWarmJob;
+
+// memHandleAlloc 으로 받은 블록, 빈 슬롯은 nextFree 로 이음
+// 핸들 id 는 (generation << 32) | (슬롯 + 1), 해제할 때 generation 을 올려서 이전 핸들을 막음
+struct MemHandleSlot
+{
+    void* ptr;
+    size_t size;
+    size_t alignment;
+    uint32 generation;
+    int32 pinCount;
+    int32 nextFree;
+};
+
+struct MemArenaMarker
+{
+    int32 chunk;
+    size_t top;
+    size_t allocByteCount;
+    uint64 liveCount;
 };
 
 struct AllocatorEntry
@@ -44,13 +228,53 @@ struct AllocatorEntry
     size_t minPageSize;
     size_t totalPageSize;
     size_t lastRefPage;
-    ArrayList memChunkList;
+    // 청크를 더해도 기존 MemChunk 주소가 바뀌지 않으므로 AddChunk 전에 받은 포인터를 계속 쓸 수 있음
+    SegmentedList memChunkList;
     bool pageLocked;
+    // PAGE_FLAG_*, 청크를 받고 돌려줄 때 페이지 제공자에 넘김
+    uint32 pageFlags;
+    // MEMPAGE_FLAG_WARM, 새로 받는 청크를 백그라운드 스레드에서 채움
+    bool warmPages;
+    // 사용중인 청크를 MemWarmState 별로 센 값, WarmState 가 락 없이 읽음
+    std::atomic<int32> warmChunkCounts[MEMWARM_WARM + 1];
+    // 락 없이 채우고 있는 청크 수, RemoveEntry 는 0 이 될 때까지 기다린 뒤 지움
+    std::atomic<int32> warmPinCount;
+
+    // (포인터 >> pageShift) -> memChunkList 인덱스
+    uint32 pageShift;
+    std::atomic<MemChunkTable*> chunkTable;
+
+    // 청크와 아래 목록은 lock 으로 보호, 주소 공간마다 따로 잠금
+    std::mutex lock;
+    int32 kind;
+    // span 은 spanSize 로 정렬, cacheMaxSize 이하의 요청만 span 에서 할당 (0 이면 사용 안 함)
+    size_t spanSize;
+    size_t cacheMaxSize;
+    void* cacheFreeList[MEMCACHE_CLASS_COUNT];
+    MemThreadCache* threadCacheList;
+
+    // MEMPAGE_KIND_ARENA: 현재 밀고 있는 청크와 memArenaPush 로 저장한 위치
+    int32 arenaChunk;
+    ArrayList arenaMarkers;
+
+    // 옮길 수 있는 블록, 주소는 lock 을 잡고 바꿈
+    ArrayList handleList;
+    int32 freeHandle;
+
+    // 빈 청크 보관 정책, trimRetainCount 를 넘는 빈 청크는 trimMode 로 바로 돌려줌
+    size_t trimRetainCount;
+    int32 trimMode;
+
+    // 통계, peakByteCount 는 락을 잡는 경로에서만 갱신하므로 스레드 캐시의 변화는 배치 단위로 반영
+    MemStatCounters stats;
+    size_t peakByteCount;
+    std::atomic<uint32> sampleInterval;
+    std::atomic<uint64> latencyHistogram[MEMSTAT_LATENCY_BUCKET_COUNT];
 
     const size_t name_buffer_max = 256;
 
     AllocatorEntry();
-    AllocatorEntry(const wchar_t* name, unsigned debug, size_t minPageSize, bool pageLocked);
+    AllocatorEntry(const wchar_t* name, unsigned debug, size_t minPageSize, bool pageLocked, int32 kind = MEMPAGE_KIND_DEFAULT, uint32 flags = 0);
     AllocatorEntry(const AllocatorEntry& o);
     AllocatorEntry(const AllocatorEntry& o, const wchar_t* name);
     ~AllocatorEntry();
@@ -58,11 +282,81 @@ struct AllocatorEntry
     void* Allocate(size_t numBytes, int flags = 0);
     void* Allocate(size_t numBytes, size_t alignment, size_t offset, int flags = 0);
     bool Deallocate(void* p);
+    // 제자리에서 늘리거나 줄이고, 안 되면 옮긴 뒤 이전 블록을 해제, 실패하면 p 는 그대로 남음
+    void* Reallocate(void* p, size_t numBytes, size_t alignment, size_t offset);
+    size_t AllocatedBytes();
+
+    // 스레드 캐시와 주고받는 경로, 내부에서 lock 을 잡음
+    int32 RefillCache(int32 classIndex, void** blocks, int32 count);
+    void FlushCache(int32 classIndex, void** blocks, int32 count, int64 byteDelta, uint64 freeCount = 0);
+    void AttachCache(MemThreadCache* cache);
+    void DetachCache(MemThreadCache* cache);
+
+    bool ArenaPush();
+    bool ArenaPop();
+    bool ArenaReset();
+
+    void CollectStats(MemPageStats* pageStats);
+    void SetSampling(uint32 interval);
+
+    void SetTrimPolicy(size_t retainCount, int32 mode);
+    size_t Trim();
+
+    // 실패하면 0
+    uint64 AllocateHandle(size_t numBytes, size_t alignment);
+    bool FreeHandle(uint64 id);
+    void* PinHandle(uint64 id);
+    bool UnpinHandle(uint64 id);
+    size_t HandleSize(uint64 id);
+    void Compact(size_t maxMoveBytes, MemCompactStats* compactStats);
+
+    // 페이지를 reserveBytes 까지 받고 채우지 않은 청크를 백그라운드 스레드에 넘김
+    bool Warm(size_t reserveBytes);
+    int32 WarmState() const;
+    // 백그라운드 스레드에서 채울 한 조각을 고르고 청크를 고정, 다 채웠거나 청크가 바뀌었으면 false
+    bool PinWarmChunk(const MemWarmJob* job, size_t sliceBytes, void** p, size_t* size);
+    // 채운 뒤 고정을 풀고 job->offset 을 옮김, 더 채울 것이 없으면 false
+    bool UnpinWarmChunk(MemWarmJob* job, size_t size);
+
+    int32 AddChunk(size_t numBytes, uint32 kind = MEMCHUNK_KIND_RANGE);
+    int32 FindChunk(void* p, uint32* kind = nullptr) const;
+    bool InsertChunkTable(int32 chunkIndex);
+
+private:
+    void* AllocateUnsampled(size_t numBytes, size_t alignment, size_t offset, int flags);
+    void RecordLatency(uint64 ns);
+    size_t LiveBytesLocked() const;
+    void UpdatePeak();
+    void CountAllocLocked(size_t numBytes);
+    void* AllocateLocked(size_t numBytes, size_t alignment, size_t offset, int flags);
+    void* ArenaAllocateLocked(size_t numBytes, size_t alignment, size_t offset);
+    void* BuddyAllocateLocked(size_t numBytes, size_t alignment, size_t offset);
+    bool DeallocateLocked(void* p);
+    bool ResizeLocked(void* p, size_t numBytes, size_t alignment, size_t offset, size_t* oldBytes, bool* resized);
+    bool AddSpan(int32 classIndex);
+    bool IsChunkEmpty(int32 chunkIndex) const;
+    // 앞에서부터 retainCount 개의 빈 청크만 남기고 돌려줌, 돌려준 바이트 수 반환
+    size_t RetainEmptyChunks(size_t retainCount);
+    size_t TrimChunk(int32 chunkIndex);
+    bool RestoreChunk(int32 chunkIndex, size_t numBytes, uint32 kind);
+    void RemoveChunkTable(int32 chunkIndex);
+    void PushCacheBlock(int32 classIndex, void* block);
+    MemHandleSlot* FindHandleLocked(uint64 id) const;
+    void ResetChunkWarm(int32 chunkIndex);
+    void SetChunkWarm(MemChunk* memChunk, uint32 warmState);
+    void QueueWarm(int32 chunkIndex);
 };
 
 constexpr int ALLOCATOR_ENTRY_COUNT = 16;
 
+// 등록/해제는 내부에서 직렬화, FindEntry 는 락 없이 읽음
+// 해제중인 주소 공간을 다른 스레드가 쓰고 있으면 안 됨
 AllocatorEntry* GetEntry(int index);
-int32 AddEntry(const wchar_t* name, size_t min_page_size, bool pageLocked);
+int32 GetEntryIndex(const AllocatorEntry* entry);
+// 홀수면 사용중, 등록/해제마다 증가
+uint32 GetEntryGeneration(int index);
+int32 AddEntry(const wchar_t* name, size_t min_page_size, bool pageLocked, int32 kind = MEMPAGE_KIND_DEFAULT, uint32 flags = 0);
 AllocatorEntry* FindEntry(const wchar_t* name);
-bool RemoveEntry(const wchar_t* name);
\ No newline at end of file
+bool RemoveEntry(const wchar_t* name);
+// 등록 락과 주소 공간의 락은 청크를 고정하고 풀 때만 잡고, 채우는 동안은 둘 다 놓음
+bool WarmChunkSlice(MemWarmJob* job, size_t sliceBytes);
@@ -0,0 +1,364 @@
+#include "memtrace.h"
+#include "mempage.h"
+#include "pageprovider.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <new>
+
+constexpr int32 MEMTRACE_BUFFER_COUNT = 4096;
+
+// 스레드마다 레코드를 모아두는 곳, 주인 스레드와 memTraceEnd 가 lock 으로 나눠 씀
+struct MemTraceBuffer
+{
+    std::mutex lock;
+    uint32 session;
+    uint16 thread;
+    int32 count;
+    MemTraceBuffer* prev;
+    MemTraceBuffer* next;
+    MemTraceRecord records[MEMTRACE_BUFFER_COUNT];
+};
+
+std::atomic<bool> g_MemTraceEnabled(false);
+
+// 파일, 버퍼 목록, 주소 공간 기록 여부는 g_TraceLock 으로 보호
+static std::mutex g_TraceLock;
+static FILE* g_TraceFile = nullptr;
+static MemTraceBuffer* g_TraceBuffers = nullptr;
+static std::atomic<uint32> g_TraceSession(0);
+static std::atomic<uint16> g_TraceThreadCount(0);
+static std::chrono::steady_clock::time_point g_TraceStart;
+// 주소 공간마다 MEMTRACE_OP_SPACE 를 쓴 세대, 세대가 바뀌면 다시 씀
+static std::atomic<uint32> g_TracedGenerations[ALLOCATOR_ENTRY_COUNT];
+
+static FILE* OpenFile(const char* path, const char* mode)
+{
+#ifdef _MSC_VER
+    FILE* file = nullptr;
+    return fopen_s(&file, path, mode) == 0? file: nullptr;
+#else
+    return fopen(path, mode);
+#endif
+}
+
+static uint64 TraceTime()
+{
+    return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_TraceStart).count();
+}
+
+static uint8 AlignShift(size_t alignment)
+{
+    uint8 shift = 0;
+    while (((size_t)1 << shift) < alignment && shift < 63) {
+        shift++;
+    }
+    return shift;
+}
+
+// g_TraceLock 을 잡고 호출
+static void FlushBuffer(MemTraceBuffer* buffer)
+{
+    if (g_TraceFile != nullptr && buffer->session == g_TraceSession.load(std::memory_order_relaxed) && buffer->count > 0) {
+        fwrite(buffer->records, sizeof(MemTraceRecord), buffer->count, g_TraceFile);
+    }
+    buffer->count = 0;
+}
+
+struct MemTraceThread
+{
+    MemTraceBuffer* buffer;
+
+    ~MemTraceThread();
+};
+
+static thread_local MemTraceThread t_Trace;
+
+MemTraceThread::~MemTraceThread()
+{
+    if (buffer == nullptr) {
+        return;
+    }
+
+    // 끝나는 스레드의 레코드를 쓰고 목록에서 뺌
+    std::lock_guard<std::mutex> guard(g_TraceLock);
+    {
+        std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+        FlushBuffer(buffer);
+    }
+    if (buffer->prev) {
+        buffer->prev->next = buffer->next;
+    } else {
+        g_TraceBuffers = buffer->next;
+    }
+    if (buffer->next) {
+        buffer->next->prev = buffer->prev;
+    }
+    buffer->~MemTraceBuffer();
+    SystemFree(buffer);
+    buffer = nullptr;
+}
+
+static MemTraceBuffer* LocalBuffer()
+{
+    if (t_Trace.buffer != nullptr) {
+        return t_Trace.buffer;
+    }
+
+    // memAlloc 을 쓰면 기록이 다시 불리므로 system 힙에서 직접 받음
+    auto buffer = (MemTraceBuffer*)SystemAlloc(sizeof(MemTraceBuffer), alignof(MemTraceBuffer), 0);
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+    new (buffer) MemTraceBuffer();
+    buffer->session = g_TraceSession.load(std::memory_order_relaxed);
+    buffer->thread = g_TraceThreadCount.fetch_add(1, std::memory_order_relaxed);
+    buffer->count = 0;
+
+    std::lock_guard<std::mutex> guard(g_TraceLock);
+    buffer->prev = nullptr;
+    buffer->next = g_TraceBuffers;
+    if (g_TraceBuffers) {
+        g_TraceBuffers->prev = buffer;
+    }
+    g_TraceBuffers = buffer;
+    t_Trace.buffer = buffer;
+    return buffer;
+}
+
+static void Append(const MemTraceRecord& record)
+{
+    auto buffer = LocalBuffer();
+    if (buffer == nullptr) {
+        return;
+    }
+
+    bool full;
+    {
+        std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+        auto session = g_TraceSession.load(std::memory_order_relaxed);
+        if (buffer->session != session) {
+            // 이전 기록의 레코드는 memTraceEnd 에서 이미 썼음
+            buffer->session = session;
+            buffer->count = 0;
+        }
+
+        buffer->records[buffer->count] = record;
+        buffer->records[buffer->count].thread = buffer->thread;
+        buffer->count++;
+        full = buffer->count == MEMTRACE_BUFFER_COUNT;
+    }
+
+    // 락 순서는 항상 g_TraceLock -> buffer->lock
+    if (full) {
+        std::lock_guard<std::mutex> guard(g_TraceLock);
+        std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+        FlushBuffer(buffer);
+    }
+}
+
+static uint16 TraceSpaceId(MemSpace space, int32* index)
+{
+    *index = (int32)(space.id & 0xFFFFFFFF) - 1;
+    return space == MEMSPACE_SYSTEM? MEMTRACE_SYSTEM_SPACE: (uint16)(*index + 1);
+}
+
+// 주소 공간의 이번 세대를 아직 쓰지 않았으면 MEMTRACE_OP_SPACE 를 이름과 같이 씀
+static void DescribeSpace(MemSpace space)
+{
+    int32 index;
+    auto id = TraceSpaceId(space, &index);
+    if (id == MEMTRACE_SYSTEM_SPACE || index < 0 || index >= ALLOCATOR_ENTRY_COUNT) {
+        return;
+    }
+
+    auto generation = (uint32)(space.id >> 32);
+    if (g_TracedGenerations[index].load(std::memory_order_acquire) == generation) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(g_TraceLock);
+    if (g_TraceFile == nullptr || g_TracedGenerations[index].load(std::memory_order_relaxed) == generation) {
+        return;
+    }
+
+    auto entry = GetEntry(index);
+    uint16 name[256];
+    uint16 nameLength = 0;
+    while (nameLength < 255 && entry->name[nameLength] != L'\0') {
+        name[nameLength] = (uint16)entry->name[nameLength];
+        nameLength++;
+    }
+
+    MemTraceRecord record = {};
+    record.time = TraceTime();
+    record.pointer = (uint64)entry->kind | ((uint64)(entry->pageFlags & ~PAGE_FLAG_LOCKED) << 8);
+    record.size = entry->minPageSize;
+    record.space = id;
+    record.op = MEMTRACE_OP_SPACE;
+    record.alignShift = entry->pageLocked? 1: 0;
+    record.alignOffset = nameLength;
+    fwrite(&record, sizeof(record), 1, g_TraceFile);
+    fwrite(name, sizeof(uint16), nameLength, g_TraceFile);
+
+    g_TracedGenerations[index].store(generation, std::memory_order_release);
+}
+
+void MemTraceAlloc(MemSpace space, void* p, size_t size, size_t alignment, size_t alignOffset)
+{
+    if (p == nullptr) {
+        return;
+    }
+    DescribeSpace(space);
+
+    int32 index;
+    MemTraceRecord record = {};
+    record.time = TraceTime();
+    record.pointer = (uint64)p;
+    record.size = size;
+    record.space = TraceSpaceId(space, &index);
+    record.op = MEMTRACE_OP_ALLOC;
+    record.alignShift = AlignShift(alignment);
+    record.alignOffset = alignOffset < 0xFFFF? (uint16)alignOffset: 0xFFFF;
+    Append(record);
+}
+
+void MemTraceFree(MemSpace space, void* p)
+{
+    MemTraceFree(space, p, TraceTime());
+}
+
+uint64 MemTraceTime()
+{
+    return TraceTime();
+}
+
+void MemTraceFree(MemSpace space, void* p, uint64 time)
+{
+    int32 index;
+    MemTraceRecord record = {};
+    record.time = time;
+    record.pointer = (uint64)p;
+    record.space = TraceSpaceId(space, &index);
+    record.op = MEMTRACE_OP_FREE;
+    Append(record);
+}
+
+void MemTraceSpaceFree(MemSpace space)
+{
+    int32 index;
+    MemTraceRecord record = {};
+    record.time = TraceTime();
+    record.space = TraceSpaceId(space, &index);
+    record.op = MEMTRACE_OP_SPACE_FREE;
+    Append(record);
+}
+
+DECLSPEC_DLL bool memTraceBegin(const char* path)
+{
+    std::lock_guard<std::mutex> guard(g_TraceLock);
+
+    if (g_TraceFile != nullptr || path == nullptr) {
+        return false;
+    }
+
+    auto file = OpenFile(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    MemTraceHeader header = { MEMTRACE_MAGIC, MEMTRACE_VERSION };
+    fwrite(&header, sizeof(header), 1, file);
+
+    g_TraceFile = file;
+    g_TraceStart = std::chrono::steady_clock::now();
+    g_TraceSession.fetch_add(1, std::memory_order_relaxed);
+    for (auto i = 0; i < ALLOCATOR_ENTRY_COUNT; i++) {
+        g_TracedGenerations[i].store(0, std::memory_order_relaxed);
+    }
+    g_MemTraceEnabled.store(true, std::memory_order_release);
+    return true;
+}
+
+DECLSPEC_DLL bool memTraceEnd()
+{
+    g_MemTraceEnabled.store(false, std::memory_order_release);
+
+    std::lock_guard<std::mutex> guard(g_TraceLock);
+
+    if (g_TraceFile == nullptr) {
+        return false;
+    }
+
+    // 아직 기록중인 스레드가 넣는 레코드는 세대가 맞지 않아서 버려짐
+    for (auto buffer = g_TraceBuffers; buffer; buffer = buffer->next) {
+        std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+        FlushBuffer(buffer);
+    }
+    g_TraceSession.fetch_add(1, std::memory_order_relaxed);
+
+    auto result = fclose(g_TraceFile) == 0;
+    g_TraceFile = nullptr;
+    return result;
+}
+
+DECLSPEC_DLL bool memTraceLoad(const char* path, ArrayList* records, ArrayList* names)
+{
+    auto file = OpenFile(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    MemTraceHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != MEMTRACE_MAGIC || header.version != MEMTRACE_VERSION) {
+        fclose(file);
+        return false;
+    }
+
+    // 레코드 수의 상한을 알 수 있으므로 한 번에 잡아둠
+    fseek(file, 0, SEEK_END);
+    auto fileSize = (uint64)ftell(file);
+    fseek(file, sizeof(header), SEEK_SET);
+    if (!records->Init(nullptr, sizeof(MemTraceRecord), alignof(MemTraceRecord), fileSize / sizeof(MemTraceRecord) + 1) ||
+        !names->Init(nullptr, sizeof(MemTraceName))) {
+        fclose(file);
+        return false;
+    }
+
+    MemTraceRecord record;
+    bool result = true;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        if (record.op == MEMTRACE_OP_SPACE) {
+            uint16 name[256];
+            auto nameLength = (size_t)(record.alignOffset < 255? record.alignOffset: 255);
+            if (fread(name, sizeof(uint16), nameLength, file) != nameLength) {
+                result = false;
+                break;
+            }
+
+            MemTraceName traceName;
+            traceName.time = record.time;
+            traceName.space = record.space;
+            for (size_t i = 0; i < nameLength; i++) {
+                traceName.name[i] = (wchar_t)name[i];
+            }
+            traceName.name[nameLength] = L'\0';
+            names->InsertLast(1, &traceName, nullptr);
+        }
+        if (!records->InsertLast(1, &record, nullptr)) {
+            result = false;
+            break;
+        }
+    }
+    fclose(file);
+
+    // 같은 시간이면 파일 순서 (같은 스레드 안의 순서) 를 유지
+    auto first = (MemTraceRecord*)records->Start();
+    std::stable_sort(first, first + records->Count(), [](const MemTraceRecord& a, const MemTraceRecord& b) {
+        return a.time < b.time;
+    });
+    return result;
+}
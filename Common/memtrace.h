@@ -0,0 +1,80 @@
+#pragma once
+
+#include "symbols.h"
+#include "defined_type.h"
+#include "allocators.h"
+#include "container.h"
+
+#include <atomic>
+
+// 할당 기록 파일 형식
+// MemTraceHeader 뒤에 MemTraceRecord 가 이어짐, 스레드마다 모아서 쓰므로 파일 안에서는 시간 순서가 아님
+// MEMTRACE_OP_SPACE 레코드 바로 뒤에는 alignOffset 개의 uint16 이름 글자가 따라옴
+// Framework 의 EASTL 할당자도 같은 형식으로 씀 (Framework/source/allocators.cpp)
+constexpr uint32 MEMTRACE_MAGIC = 0x4352544D;
+constexpr uint32 MEMTRACE_VERSION = 1;
+constexpr uint16 MEMTRACE_SYSTEM_SPACE = 0;
+
+enum MemTraceOp
+{
+    MEMTRACE_OP_ALLOC = 0,
+    MEMTRACE_OP_FREE = 1,
+    // 주소 공간이 처음 쓰일 때 한 번, pointer 는 (kind | flags << 8), size 는 최소 페이지 크기
+    // alignShift 는 pageLocked, alignOffset 은 이름 길이
+    MEMTRACE_OP_SPACE = 2,
+    MEMTRACE_OP_SPACE_FREE = 3,
+};
+
+struct MemTraceHeader
+{
+    uint32 magic;
+    uint32 version;
+};
+
+struct MemTraceRecord
+{
+    // 기록을 시작한 뒤 지난 나노초
+    uint64 time;
+    // 할당된 주소, 재생할 때 같은 주소의 할당/해제를 한 블록으로 묶음
+    uint64 pointer;
+    uint64 size;
+    // 0 은 system, 나머지는 기록하는 쪽에서 붙인 번호
+    uint16 space;
+    uint8 op;
+    uint8 alignShift;
+    uint16 thread;
+    uint16 alignOffset;
+};
+static_assert(sizeof(MemTraceRecord) == 32, "MemTraceRecord must stay 32 bytes");
+
+struct MemTraceName
+{
+    uint64 time;
+    uint16 space;
+    wchar_t name[256];
+};
+
+// 기록중인 파일이 있으면 false
+DECLSPEC_DLL bool memTraceBegin(const char* path);
+DECLSPEC_DLL bool memTraceEnd();
+
+/// <summary>
+/// 기록 파일을 읽어서 시간 순으로 정렬
+/// records 는 MemTraceRecord, names 는 MemTraceName 을 담도록 여기서 Init 함
+/// </summary>
+DECLSPEC_DLL bool memTraceLoad(const char* path, ArrayList* records, ArrayList* names);
+
+// allocators.cpp 에서 부르는 기록 함수, 꺼져 있으면 g_MemTraceEnabled 만 확인하고 넘어감
+extern std::atomic<bool> g_MemTraceEnabled;
+
+void MemTraceAlloc(MemSpace space, void* p, size_t size, size_t alignment, size_t alignOffset);
+void MemTraceFree(MemSpace space, void* p);
+// 해제가 성공한 뒤에 기록할 때는 풀기 전에 잰 시각을 넘겨서 같은 주소를 받아간 다른 스레드의 할당보다 앞에 둠
+uint64 MemTraceTime();
+void MemTraceFree(MemSpace space, void* p, uint64 time);
+void MemTraceSpaceFree(MemSpace space);
+
+inline bool MemTraceEnabled()
+{
+    return g_MemTraceEnabled.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,82 @@
+#include "memwarm.h"
+#include "mempage.h"
+#include "container.h"
+
+#include <mutex>
+#include <thread>
+
+struct MemWarmQueue
+{
+    std::mutex lock;
+    ArrayList jobs;
+    std::thread worker;
+    bool running;
+    bool stopped;
+};
+
+// 프로세스가 끝날 때 다른 전역보다 먼저 사라지지 않도록 해제하지 않음
+static MemWarmQueue* WarmQueue()
+{
+    static MemWarmQueue* queue = []() {
+        auto queue = new MemWarmQueue();
+        queue->jobs.Init(nullptr, sizeof(MemWarmJob));
+        queue->running = false;
+        queue->stopped = false;
+        return queue;
+    }();
+    return queue;
+}
+
+// 작업이 없으면 끝나고 다음 작업이 들어올 때 다시 만듦
+static void WarmWorker(MemWarmQueue* queue)
+{
+    for (;;) {
+        MemWarmJob job;
+        {
+            std::lock_guard<std::mutex> guard(queue->lock);
+            if (queue->stopped || queue->jobs.Count() == 0) {
+                queue->running = false;
+                return;
+            }
+            job = *(MemWarmJob*)queue->jobs.Start();
+            queue->jobs.RemoveFirst();
+        }
+
+        while (WarmChunkSlice(&job, MEMWARM_SLICE_SIZE)) {
+            std::lock_guard<std::mutex> guard(queue->lock);
+            if (queue->stopped) {
+                queue->running = false;
+                return;
+            }
+        }
+    }
+}
+
+void MemWarmEnqueue(const MemWarmJob& job)
+{
+    auto queue = WarmQueue();
+    std::lock_guard<std::mutex> guard(queue->lock);
+    if (queue->stopped || !queue->jobs.InsertLast(1, (void*)&job, nullptr) || queue->running) {
+        return;
+    }
+
+    // 끝난 스레드는 락을 다시 잡지 않으므로 여기서 기다려도 됨
+    if (queue->worker.joinable()) {
+        queue->worker.join();
+    }
+    queue->worker = std::thread(WarmWorker, queue);
+    queue->running = true;
+}
+
+void MemWarmStop()
+{
+    auto queue = WarmQueue();
+    {
+        std::lock_guard<std::mutex> guard(queue->lock);
+        queue->stopped = true;
+        queue->jobs.RemoveAll();
+    }
+    if (queue->worker.joinable()) {
+        queue->worker.join();
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "defined_type.h"
+
+// 청크를 백그라운드 스레드에서 채우는 작업
+// 스레드는 작업이 들어올 때 만들고 큐가 비면 끝남
+// 한 번에 MEMWARM_SLICE_SIZE 씩 청크를 고정하고 락을 놓은 채로 채우므로 그동안 할당과 해제는 막히지 않음
+constexpr size_t MEMWARM_SLICE_SIZE = 256 * 1024;
+
+struct MemWarmJob
+{
+    int32 entryIndex;
+    uint32 generation;
+    int32 chunkIndex;
+    void* memPtr;
+    size_t offset;
+};
+
+void MemWarmEnqueue(const MemWarmJob& job);
+// 남은 작업을 버리고 스레드가 끝날 때까지 기다림
+void MemWarmStop();
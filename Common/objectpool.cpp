@@ -0,0 +1,461 @@
+#include "objectpool.h"
+#include "allocators.h"
+
+#include <wchar.h>
+#include <mutex>
+#include <new>
+#include <thread>
+
+constexpr uint64 OBJECTPOOL_INDEX_MASK = 0xFFFFFFFF;
+// 블록 인덱스는 32비트 안에서 + 1 로 적으므로 블록 수의 상한
+constexpr uint64 OBJECTPOOL_MAX_BLOCK_COUNT = (uint64)1 << 31;
+
+// 스레드 하나가 풀 하나에 대해 가지는 캐시
+struct ObjectPoolCache
+{
+    uint32 generation;
+    int32 count;
+    void* blocks[OBJECTPOOL_MAGAZINE_SIZE];
+};
+
+struct ObjectPoolCacheSet
+{
+    ObjectPoolCache* caches[OBJECTPOOL_MAX_COUNT];
+    bool closed;
+
+    ~ObjectPoolCacheSet();
+};
+
+// 풀 등록과 해제, 스레드가 끝날 때 캐시를 돌려주는 것은 g_PoolLock 으로 보호
+static std::mutex g_PoolLock;
+static ObjectPool* g_Pools[OBJECTPOOL_MAX_COUNT];
+static uint32 g_PoolGenerations[OBJECTPOOL_MAX_COUNT];
+static thread_local ObjectPoolCacheSet t_PoolCaches;
+
+ObjectPoolCacheSet::~ObjectPoolCacheSet()
+{
+    // 닫고 목록에서 뺀 캐시는 FreeBulk 가 거치지 않고 빈 목록에 바로 넣음
+    closed = true;
+
+    std::lock_guard<std::mutex> guard(g_PoolLock);
+    for (auto i = 0; i < OBJECTPOOL_MAX_COUNT; i++) {
+        auto cache = caches[i];
+        if (cache == nullptr) {
+            continue;
+        }
+        caches[i] = nullptr;
+        if (g_Pools[i] != nullptr && cache->generation == g_PoolGenerations[i] && cache->count > 0) {
+            g_Pools[i]->FreeBulk(cache->blocks, cache->count);
+        }
+        memFree(cache);
+    }
+}
+
+static ObjectPoolCache* LocalCache(int32 slot, uint32 generation)
+{
+    auto cache = t_PoolCaches.caches[slot];
+    if (cache != nullptr && cache->generation == generation) {
+        return cache;
+    }
+    if (t_PoolCaches.closed) {
+        return nullptr;
+    }
+
+    if (cache == nullptr) {
+        cache = (ObjectPoolCache*)memAlloc(sizeof(ObjectPoolCache), alignof(ObjectPoolCache), 0);
+        if (cache == nullptr) {
+            return nullptr;
+        }
+        t_PoolCaches.caches[slot] = cache;
+    }
+
+    // 세대가 다르면 이전 풀의 블록이므로 버림
+    cache->generation = generation;
+    cache->count = 0;
+    return cache;
+}
+
+// 빈 블록의 첫 4바이트에 다음 빈 블록의 인덱스 + 1 을 적음
+// 다른 스레드가 이미 가져가서 쓰는 블록을 읽을 수 있으므로 원자적으로 읽고 씀
+static uint32 LoadLink(void* block)
+{
+    return ((std::atomic<uint32>*)block)->load(std::memory_order_relaxed);
+}
+
+static void StoreLink(void* block, uint32 link)
+{
+    ((std::atomic<uint32>*)block)->store(link, std::memory_order_relaxed);
+}
+
+static uint64 MakeHead(uint64 oldHead, uint32 link)
+{
+    return (((oldHead >> 32) + 1) << 32) | link;
+}
+
+static int32 RoundUp(int32 value, int32 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// 페이지는 pageBytes 로 정렬되므로 그 아래 비트는 버리고 섞음
+static uint32 PageHash(size_t page, size_t pageBytes)
+{
+    return (uint32)(((uint64)(page / pageBytes) * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+DECLSPEC_DLL bool ObjectPool::Init(const wchar_t* addrspace, int32 step, int32 alignment, int32 blocksPerPage, uint64 maxCount)
+{
+    this->addrspace = addrspace != nullptr && wcscmp(addrspace, L"") != 0? addrspace: SYSTEM_NAME;
+    this->step = 0;
+    pages = nullptr;
+    maxPageCount = 0;
+    pageTable = nullptr;
+    pageTableMask = 0;
+    pageCount.store(0, std::memory_order_relaxed);
+    growing.store(false, std::memory_order_relaxed);
+    freeHead.store(0, std::memory_order_relaxed);
+    freeCount.store(0, std::memory_order_relaxed);
+    slot = -1;
+    generation = 0;
+
+    if (step <= 0 || alignment <= 0 || (alignment & (alignment - 1)) != 0 ||
+        blocksPerPage <= 0 || maxCount == 0 || maxCount > OBJECTPOOL_MAX_BLOCK_COUNT) {
+        return false;
+    }
+
+    pageShift = 0;
+    while ((1 << pageShift) < blocksPerPage) {
+        pageShift++;
+    }
+
+    this->alignment = alignment;
+    stride = RoundUp(step < (int32)sizeof(uint32)? (int32)sizeof(uint32): step, alignment);
+
+    // 페이지를 페이지 크기로 정렬해서 블록 포인터를 내림하면 페이지 시작이 나오게 함
+    pageBytes = 1;
+    while (pageBytes < ((size_t)stride << pageShift)) {
+        pageBytes <<= 1;
+    }
+
+    maxPageCount = (uint32)((maxCount + ((uint64)1 << pageShift) - 1) >> pageShift);
+    pages = (void**)memAlloc(sizeof(void*) * maxPageCount, alignof(void*), 0, this->addrspace);
+    if (pages == nullptr) {
+        return false;
+    }
+
+    // 절반 이하로 채워서 찾는 길이를 짧게 유지
+    uint32 tableSize = 1;
+    while (tableSize < maxPageCount * 2) {
+        tableSize <<= 1;
+    }
+    pageTable = (std::atomic<uint32>*)memAlloc(sizeof(std::atomic<uint32>) * tableSize, alignof(std::atomic<uint32>), 0, this->addrspace);
+    if (pageTable == nullptr) {
+        memFree(pages, this->addrspace);
+        pages = nullptr;
+        return false;
+    }
+    for (uint32 i = 0; i < tableSize; i++) {
+        new (pageTable + i) std::atomic<uint32>(0);
+    }
+    pageTableMask = tableSize - 1;
+
+    {
+        std::lock_guard<std::mutex> guard(g_PoolLock);
+        for (auto i = 0; i < OBJECTPOOL_MAX_COUNT; i++) {
+            if (g_Pools[i] == nullptr) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot >= 0) {
+            g_Pools[slot] = this;
+            generation = ++g_PoolGenerations[slot];
+        }
+    }
+    if (slot < 0) {
+        memFree(pageTable, this->addrspace);
+        memFree(pages, this->addrspace);
+        pageTable = nullptr;
+        pages = nullptr;
+        return false;
+    }
+
+    this->step = step;
+    return true;
+}
+
+DECLSPEC_DLL bool ObjectPool::Destroy()
+{
+    if (pages == nullptr) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(g_PoolLock);
+        g_Pools[slot] = nullptr;
+        g_PoolGenerations[slot]++;
+    }
+
+    auto result = true;
+    auto count = pageCount.load(std::memory_order_acquire);
+    for (uint32 i = 0; i < count; i++) {
+        result &= memFree(pages[i], addrspace);
+    }
+    result &= memFree(pageTable, addrspace);
+    result &= memFree(pages, addrspace);
+
+    pages = nullptr;
+    pageTable = nullptr;
+    pageCount.store(0, std::memory_order_relaxed);
+    freeHead.store(0, std::memory_order_relaxed);
+    freeCount.store(0, std::memory_order_relaxed);
+    step = 0;
+    slot = -1;
+    return result;
+}
+
+void* ObjectPool::Block(uint32 index) const
+{
+    return (uint8*)pages[index >> pageShift] + (size_t)(index & ((1u << pageShift) - 1)) * stride;
+}
+
+bool ObjectPool::IndexOf(void* p, uint32* index) const
+{
+    if (p == nullptr || pages == nullptr) {
+        return false;
+    }
+
+    // 이 풀의 페이지인지 표에서 확인하기 전에는 p 가 가리키는 곳을 읽지 않음
+    auto page = (size_t)p & ~(pageBytes - 1);
+    uint32 pageIndex;
+    for (auto i = PageHash(page, pageBytes);; i++) {
+        auto value = pageTable[i & pageTableMask].load(std::memory_order_acquire);
+        if (value == 0) {
+            return false;
+        }
+        if ((size_t)pages[value - 1] == page) {
+            pageIndex = value - 1;
+            break;
+        }
+    }
+
+    auto offset = (size_t)p - page;
+    if (offset % stride != 0 || offset / stride >= ((size_t)1 << pageShift)) {
+        return false;
+    }
+    *index = (pageIndex << pageShift) | (uint32)(offset / stride);
+    return true;
+}
+
+bool ObjectPool::Grow()
+{
+    // 다른 스레드가 늘리는 중이면 기다렸다가 빈 목록을 다시 봄
+    if (growing.exchange(true, std::memory_order_acquire)) {
+        std::this_thread::yield();
+        return true;
+    }
+
+    auto index = pageCount.load(std::memory_order_relaxed);
+    if (freeHead.load(std::memory_order_acquire) & OBJECTPOOL_INDEX_MASK) {
+        growing.store(false, std::memory_order_release);
+        return true;
+    }
+    if (index == maxPageCount) {
+        growing.store(false, std::memory_order_release);
+        return false;
+    }
+
+    auto page = memAlloc(pageBytes, pageBytes, 0, addrspace);
+    if (page == nullptr) {
+        growing.store(false, std::memory_order_release);
+        return false;
+    }
+    pages[index] = page;
+
+    // 빈 칸에 넣고 release 로 적어서 표에서 찾은 쪽이 pages[index] 를 보게 함
+    auto slotIndex = PageHash((size_t)page, pageBytes);
+    while (pageTable[slotIndex & pageTableMask].load(std::memory_order_relaxed) != 0) {
+        slotIndex++;
+    }
+    pageTable[slotIndex & pageTableMask].store(index + 1, std::memory_order_release);
+    pageCount.store(index + 1, std::memory_order_release);
+
+    // 페이지의 블록을 순서대로 이어서 한 번에 넣음
+    auto blockCount = (uint32)1 << pageShift;
+    auto first = index << pageShift;
+    for (uint32 i = 0; i + 1 < blockCount; i++) {
+        StoreLink(Block(first + i), first + i + 2);
+    }
+
+    auto last = Block(first + blockCount - 1);
+    auto head = freeHead.load(std::memory_order_relaxed);
+    do {
+        StoreLink(last, (uint32)(head & OBJECTPOOL_INDEX_MASK));
+    } while (!freeHead.compare_exchange_weak(head, MakeHead(head, first + 1), std::memory_order_release, std::memory_order_relaxed));
+    freeCount.fetch_add(blockCount, std::memory_order_relaxed);
+
+    growing.store(false, std::memory_order_release);
+    return true;
+}
+
+int32 ObjectPool::PopChain(void** blocks, int32 count)
+{
+    for (;;) {
+        auto head = freeHead.load(std::memory_order_acquire);
+        auto link = (uint32)(head & OBJECTPOOL_INDEX_MASK);
+        if (link == 0) {
+            if (!Grow()) {
+                return 0;
+            }
+            continue;
+        }
+
+        // 읽는 사이에 목록이 바뀌었으면 태그가 달라져서 CAS 가 실패하므로 중간에 읽은 값은 버려짐
+        auto blockCount = pageCount.load(std::memory_order_acquire) << pageShift;
+        int32 popped = 0;
+        while (popped < count && link != 0 && link <= blockCount) {
+            auto block = Block(link - 1);
+            blocks[popped++] = block;
+            link = LoadLink(block);
+        }
+        if (link > blockCount) {
+            continue;
+        }
+
+        if (freeHead.compare_exchange_weak(head, MakeHead(head, link), std::memory_order_acquire, std::memory_order_relaxed)) {
+            freeCount.fetch_sub(popped, std::memory_order_relaxed);
+            return popped;
+        }
+    }
+}
+
+void ObjectPool::PushChain(void* const* blocks, int32 count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    uint32 index;
+    for (auto i = 0; i + 1 < count; i++) {
+        IndexOf(blocks[i + 1], &index);
+        StoreLink(blocks[i], index + 1);
+    }
+    IndexOf(blocks[0], &index);
+
+    auto last = blocks[count - 1];
+    auto head = freeHead.load(std::memory_order_relaxed);
+    do {
+        StoreLink(last, (uint32)(head & OBJECTPOOL_INDEX_MASK));
+    } while (!freeHead.compare_exchange_weak(head, MakeHead(head, index + 1), std::memory_order_release, std::memory_order_relaxed));
+    freeCount.fetch_add(count, std::memory_order_relaxed);
+}
+
+DECLSPEC_DLL void* ObjectPool::Alloc()
+{
+    if (pages == nullptr) {
+        return nullptr;
+    }
+
+    auto cache = LocalCache(slot, generation);
+    if (cache == nullptr) {
+        void* p;
+        return PopChain(&p, 1) == 1? p: nullptr;
+    }
+
+    if (cache->count == 0) {
+        cache->count = PopChain(cache->blocks, OBJECTPOOL_BATCH_SIZE);
+        if (cache->count == 0) {
+            return nullptr;
+        }
+    }
+    return cache->blocks[--cache->count];
+}
+
+DECLSPEC_DLL bool ObjectPool::Free(void* p)
+{
+    uint32 index;
+    if (!IndexOf(p, &index)) {
+        return false;
+    }
+
+    auto cache = LocalCache(slot, generation);
+    if (cache == nullptr) {
+        PushChain(&p, 1);
+        return true;
+    }
+
+    if (cache->count == OBJECTPOOL_MAGAZINE_SIZE) {
+        cache->count -= OBJECTPOOL_BATCH_SIZE;
+        PushChain(cache->blocks + cache->count, OBJECTPOOL_BATCH_SIZE);
+    }
+    cache->blocks[cache->count++] = p;
+    return true;
+}
+
+DECLSPEC_DLL int32 ObjectPool::AllocBulk(void** blocks, int32 count)
+{
+    if (pages == nullptr || count <= 0) {
+        return 0;
+    }
+
+    int32 allocated = 0;
+    auto cache = LocalCache(slot, generation);
+    if (cache != nullptr) {
+        while (allocated < count && cache->count > 0) {
+            blocks[allocated++] = cache->blocks[--cache->count];
+        }
+    }
+
+    // 나머지는 빈 목록에서 CAS 한 번에 여러 개씩 가져옴
+    while (allocated < count) {
+        auto popped = PopChain(blocks + allocated, count - allocated);
+        if (popped == 0) {
+            break;
+        }
+        allocated += popped;
+    }
+    return allocated;
+}
+
+DECLSPEC_DLL bool ObjectPool::FreeBulk(void* const* blocks, int32 count)
+{
+    uint32 index;
+    for (auto i = 0; i < count; i++) {
+        if (!IndexOf(blocks[i], &index)) {
+            return false;
+        }
+    }
+
+    auto cache = LocalCache(slot, generation);
+    auto cached = 0;
+    if (cache != nullptr) {
+        while (cached < count && cache->count < OBJECTPOOL_MAGAZINE_SIZE) {
+            cache->blocks[cache->count++] = blocks[cached++];
+        }
+    }
+    PushChain(blocks + cached, count - cached);
+    return true;
+}
+
+DECLSPEC_DLL int32 ObjectPool::Step() const
+{
+    return step;
+}
+
+DECLSPEC_DLL int32 ObjectPool::Alignment() const
+{
+    return alignment;
+}
+
+DECLSPEC_DLL uint64 ObjectPool::Capacity() const
+{
+    return (uint64)pageCount.load(std::memory_order_acquire) << pageShift;
+}
+
+DECLSPEC_DLL uint64 ObjectPool::LiveCount() const
+{
+    // 다른 스레드가 넣기 전에 꺼내 가면 잠깐 빈 블록 수가 음수일 수 있음
+    auto freeBlocks = freeCount.load(std::memory_order_relaxed);
+    auto capacity = Capacity();
+    return freeBlocks <= 0? capacity: freeBlocks >= (int64)capacity? 0: capacity - (uint64)freeBlocks;
+}
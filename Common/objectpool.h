@@ -0,0 +1,86 @@
+#pragma once
+
+#include "symbols.h"
+#include "defined_type.h"
+
+#include <atomic>
+
+#define OBJECTPOOL_DEFAULT_ALIGNMENT 16
+#define OBJECTPOOL_DEFAULT_PAGECOUNT 256
+
+constexpr int32 OBJECTPOOL_MAX_COUNT = 64;
+constexpr int32 OBJECTPOOL_MAGAZINE_SIZE = 64;
+constexpr int32 OBJECTPOOL_BATCH_SIZE = OBJECTPOOL_MAGAZINE_SIZE / 2;
+
+/// <summary>
+/// 고정 크기 블록 풀, 여러 스레드가 락 없이 할당/해제
+/// 빈 목록 머리는 (태그, 블록 인덱스) 를 64비트로 묶어서 CAS 할 때마다 태그를 올려 ABA 를 막음
+/// 스레드마다 OBJECTPOOL_MAGAZINE_SIZE 개의 캐시를 두고 OBJECTPOOL_BATCH_SIZE 개씩 빈 목록과 주고받음
+/// 페이지는 addrspace 에서 받아서 Destroy 할 때까지 돌려주지 않음
+/// 해제할 때는 포인터를 페이지 크기로 내려서 페이지 표에 있는지 먼저 보므로 다른 메모리는 읽지 않음
+/// 동시에 OBJECTPOOL_MAX_COUNT 개까지 만들 수 있음
+/// C 스타일 컨테이너, ABI 를 위해 템플릿 사용 금지
+/// </summary>
+class DECLSPEC_DLL ObjectPool
+{
+public:
+    // blocksPerPage 는 2의 거듭제곱으로 올림, 블록 수가 maxCount 를 넘으면 할당 실패
+    bool Init(
+        const wchar_t* addrspace, int32 step, int32 alignment = s_DefaultAlignment,
+        int32 blocksPerPage = s_DefaultPageCount, uint64 maxCount = s_DefaultMaxCount
+    );
+    // 다른 스레드가 쓰는 중이면 안 됨, 스레드 캐시에 남은 블록은 버려짐
+    bool Destroy();
+
+public:
+    void* Alloc();
+    // 이 풀의 블록이 아니면 false
+    bool Free(void* p);
+    // 받은 개수를 돌려줌, count 보다 작으면 풀이 가득 찬 것
+    int32 AllocBulk(void** blocks, int32 count);
+    bool FreeBulk(void* const* blocks, int32 count);
+
+public:
+    int32 Step() const;
+    int32 Alignment() const;
+    // 지금까지 만든 블록 수
+    uint64 Capacity() const;
+    // 스레드 캐시에 있는 블록도 사용중으로 셈
+    uint64 LiveCount() const;
+
+private:
+    void* Block(uint32 index) const;
+    bool IndexOf(void* p, uint32* index) const;
+    bool Grow();
+    int32 PopChain(void** blocks, int32 count);
+    void PushChain(void* const* blocks, int32 count);
+
+private:
+    const wchar_t* addrspace;
+    int32 step;
+    int32 alignment;
+    int32 stride;
+    int32 pageShift;
+    size_t pageBytes;
+
+    void** pages;
+    uint32 maxPageCount;
+    // 페이지 주소로 찾는 열린 주소 해시, 값은 페이지 인덱스 + 1 (0 이면 빈 칸)
+    // 페이지는 Destroy 까지 빠지지 않으므로 넣기만 하고, 넣는 쪽은 growing 으로 하나뿐
+    std::atomic<uint32>* pageTable;
+    uint32 pageTableMask;
+    std::atomic<uint32> pageCount;
+    std::atomic<bool> growing;
+
+    // 상위 32비트는 태그, 하위 32비트는 블록 인덱스 + 1 (0 이면 빈 목록)
+    std::atomic<uint64> freeHead;
+    std::atomic<int64> freeCount;
+
+    int32 slot;
+    uint32 generation;
+
+public:
+    static const int32 s_DefaultAlignment = OBJECTPOOL_DEFAULT_ALIGNMENT;
+    static const int32 s_DefaultPageCount = OBJECTPOOL_DEFAULT_PAGECOUNT;
+    static const uint64 s_DefaultMaxCount = (uint64)1 << 24;
+};
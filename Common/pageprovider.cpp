@@ -0,0 +1,352 @@
+#include "pageprovider.h"
+
+#include <string.h>
+
+#include <atomic>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static size_t AlignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// 페이지마다 한 번씩 써서 첫 접근 폴트를 미리 처리
+static void TouchPages(void* p, size_t size, size_t step)
+{
+    auto bytes = (volatile uint8*)p;
+    for (size_t i = 0; i < size; i += step) {
+        bytes[i] = 0;
+    }
+}
+
+// 0 을 더하는 원자적 쓰기라서 다른 스레드가 같은 바이트에 쓴 값을 덮지 않음
+static void TouchPagesShared(void* p, size_t size, size_t step)
+{
+    auto bytes = (uint8*)p;
+    for (size_t i = 0; i < size; i += step) {
+        reinterpret_cast<std::atomic<uint8>*>(bytes + i)->fetch_add(0, std::memory_order_relaxed);
+    }
+}
+
+#ifdef _WIN32
+
+size_t PageSystemSize()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+size_t PageHugeSize()
+{
+    return GetLargePageMinimum();
+}
+
+static void* ReserveAligned(size_t size, size_t alignment, DWORD type)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    if (alignment <= info.dwAllocationGranularity) {
+        return VirtualAlloc(nullptr, size, type, PAGE_READWRITE);
+    }
+
+    // 넉넉히 예약해서 정렬된 주소를 찾은 뒤 해제하고 그 자리에 다시 할당
+    // 그 사이 다른 스레드가 가져갈 수 있으므로 몇 번 재시도
+    for (auto i = 0; i < 8; i++) {
+        auto base = VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+        if (base == nullptr) {
+            return nullptr;
+        }
+        VirtualFree(base, 0, MEM_RELEASE);
+
+        auto p = VirtualAlloc((void*)AlignUp((size_t)base, alignment), size, type, PAGE_READWRITE);
+        if (p != nullptr) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+void* PageAlloc(size_t size, size_t alignment, uint32 flags)
+{
+    void* p = nullptr;
+
+    // 큰 페이지는 SeLockMemoryPrivilege 가 있어야 하고 항상 상주함
+    auto hugeSize = PageHugeSize();
+    if ((flags & PAGE_FLAG_HUGE) && hugeSize > 0 && size % hugeSize == 0) {
+        p = ReserveAligned(size, alignment > hugeSize? alignment: hugeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES);
+        if (p != nullptr) {
+            return p;
+        }
+    }
+
+    p = ReserveAligned(size, alignment, MEM_RESERVE | MEM_COMMIT);
+    if (p == nullptr) {
+        return nullptr;
+    }
+    if (flags & PAGE_FLAG_PREFAULT) {
+        TouchPages(p, size, PageSystemSize());
+    }
+    if ((flags & PAGE_FLAG_LOCKED) && !VirtualLock(p, size)) {
+        VirtualFree(p, 0, MEM_RELEASE);
+        return nullptr;
+    }
+    return p;
+}
+
+void PageFree(void* p, size_t size, uint32 flags)
+{
+    if (flags & PAGE_FLAG_LOCKED) {
+        VirtualUnlock(p, size);
+    }
+    VirtualFree(p, 0, MEM_RELEASE);
+}
+
+bool PageDecommit(void* p, size_t size, uint32 flags)
+{
+    if (flags & PAGE_FLAG_LOCKED) {
+        VirtualUnlock(p, size);
+    }
+    return VirtualFree(p, size, MEM_DECOMMIT) != FALSE;
+}
+
+bool PageCommit(void* p, size_t size, uint32 flags)
+{
+    if (VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+        return false;
+    }
+    if (flags & PAGE_FLAG_PREFAULT) {
+        TouchPages(p, size, PageSystemSize());
+    }
+    if ((flags & PAGE_FLAG_LOCKED) && !VirtualLock(p, size)) {
+        VirtualFree(p, size, MEM_DECOMMIT);
+        return false;
+    }
+    return true;
+}
+
+void PagePopulate(void* p, size_t size)
+{
+    TouchPagesShared(p, size, PageSystemSize());
+}
+
+void* SystemAlloc(size_t size, size_t alignment, size_t alignOffset)
+{
+    return _aligned_offset_malloc(size, alignment, alignOffset);
+}
+
+void* SystemRealloc(void* p, size_t size, size_t alignment, size_t alignOffset)
+{
+    return _aligned_offset_realloc(p, size, alignment, alignOffset);
+}
+
+void SystemFree(void* p)
+{
+    _aligned_free(p);
+}
+
+#else
+
+size_t PageSystemSize()
+{
+    static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    return pageSize;
+}
+
+size_t PageHugeSize()
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    return 2 * 1024 * 1024;
+#else
+    return 0;
+#endif
+}
+
+static void* MapAligned(size_t size, size_t alignment, int extraFlags)
+{
+    if (alignment <= PageSystemSize()) {
+        auto p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0);
+        return p == MAP_FAILED? nullptr: p;
+    }
+
+    // 넉넉히 매핑한 뒤 정렬된 구간만 남기고 앞뒤를 잘라냄
+    auto mapSize = size + alignment;
+    auto base = (uint8*)mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == (uint8*)MAP_FAILED) {
+        return nullptr;
+    }
+
+    auto aligned = (uint8*)AlignUp((size_t)base, alignment);
+    if (aligned > base) {
+        munmap(base, aligned - base);
+    }
+    if (base + mapSize > aligned + size) {
+        munmap(aligned + size, base + mapSize - (aligned + size));
+    }
+    return aligned;
+}
+
+static void PopulatePages(void* p, size_t size)
+{
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(p, size, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+    TouchPages(p, size, PageSystemSize());
+}
+
+void* PageAlloc(size_t size, size_t alignment, uint32 flags)
+{
+    size = AlignUp(size, PageSystemSize());
+
+    auto hugeSize = PageHugeSize();
+    bool huge = (flags & PAGE_FLAG_HUGE) && hugeSize > 0 && size >= hugeSize;
+    if (huge && alignment < hugeSize) {
+        alignment = hugeSize;
+    }
+
+    // 정렬이 필요 없고 큰 페이지도 아니면 매핑하면서 바로 채움
+    bool populated = false;
+    int extraFlags = 0;
+#ifdef MAP_POPULATE
+    if ((flags & PAGE_FLAG_PREFAULT) && !huge && alignment <= PageSystemSize()) {
+        extraFlags |= MAP_POPULATE;
+        populated = true;
+    }
+#endif
+
+    auto p = MapAligned(size, alignment, extraFlags);
+    if (p == nullptr) {
+        return nullptr;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (huge) {
+        madvise(p, size, MADV_HUGEPAGE);
+    }
+#endif
+
+    // 큰 페이지 지정 뒤에 채워야 폴트가 큰 페이지 단위로 일어남
+    if ((flags & PAGE_FLAG_PREFAULT) && !populated) {
+        PopulatePages(p, size);
+    }
+
+    if ((flags & PAGE_FLAG_LOCKED) && mlock(p, size) != 0) {
+        munmap(p, size);
+        return nullptr;
+    }
+    return p;
+}
+
+void PageFree(void* p, size_t size, uint32 flags)
+{
+    size = AlignUp(size, PageSystemSize());
+
+    if (flags & PAGE_FLAG_LOCKED) {
+        munlock(p, size);
+    }
+    munmap(p, size);
+}
+
+bool PageDecommit(void* p, size_t size, uint32 flags)
+{
+    size = AlignUp(size, PageSystemSize());
+
+    // 잠긴 페이지는 MADV_DONTNEED 가 실패하므로 먼저 풀어줌
+    if (flags & PAGE_FLAG_LOCKED) {
+        munlock(p, size);
+    }
+    return madvise(p, size, MADV_DONTNEED) == 0;
+}
+
+bool PageCommit(void* p, size_t size, uint32 flags)
+{
+    size = AlignUp(size, PageSystemSize());
+
+    // 매핑은 그대로 남아 있으므로 다음 접근에서 0 으로 채워진 페이지를 받음
+    if (flags & PAGE_FLAG_PREFAULT) {
+        PopulatePages(p, size);
+    }
+    return !(flags & PAGE_FLAG_LOCKED) || mlock(p, size) == 0;
+}
+
+void PagePopulate(void* p, size_t size)
+{
+    size = AlignUp(size, PageSystemSize());
+
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(p, size, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+    TouchPagesShared(p, size, PageSystemSize());
+}
+
+// 정렬된 포인터 바로 앞에 malloc 이 돌려준 원래 포인터를 저장
+void* SystemAlloc(size_t size, size_t alignment, size_t alignOffset)
+{
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+
+    auto raw = (uint8*)malloc(size + alignment + sizeof(void*));
+    if (raw == nullptr) {
+        return nullptr;
+    }
+
+    auto p = (uint8*)AlignUp((size_t)raw + sizeof(void*) + alignOffset, alignment) - alignOffset;
+    memcpy(p - sizeof(void*), &raw, sizeof(void*));
+    return p;
+}
+
+void* SystemRealloc(void* p, size_t size, size_t alignment, size_t alignOffset)
+{
+    if (p == nullptr) {
+        return SystemAlloc(size, alignment, alignOffset);
+    }
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+
+    void* raw;
+    memcpy(&raw, (uint8*)p - sizeof(void*), sizeof(void*));
+    auto shift = (size_t)((uint8*)p - (uint8*)raw);
+
+    // 큰 블록은 realloc 이 페이지를 다시 매핑하므로 복사하지 않고 늘어남
+    auto rawSize = size + alignment + sizeof(void*);
+    auto newRaw = (uint8*)realloc(raw, rawSize);
+    if (newRaw == nullptr) {
+        return nullptr;
+    }
+
+    // 주소가 바뀌어서 정렬 위치가 달라지면 내용을 옮김
+    auto newP = (uint8*)AlignUp((size_t)newRaw + sizeof(void*) + alignOffset, alignment) - alignOffset;
+    if ((size_t)(newP - newRaw) != shift) {
+        auto copySize = shift < rawSize? rawSize - shift: 0;
+        copySize = copySize < size? copySize: size;
+        memmove(newP, newRaw + shift, copySize);
+    }
+    memcpy(newP - sizeof(void*), &newRaw, sizeof(void*));
+    return newP;
+}
+
+void SystemFree(void* p)
+{
+    if (p == nullptr) {
+        return;
+    }
+
+    void* raw;
+    memcpy(&raw, (uint8*)p - sizeof(void*), sizeof(void*));
+    free(raw);
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "defined_type.h"
+#include "allocators.h"
+
+// 주소 공간 페이지를 OS 에서 받아오는 곳, Windows 는 VirtualAlloc, 그 외는 mmap
+// HUGE/PREFAULT 는 allocators.h 의 MEMPAGE_FLAG_* 와 같은 값
+constexpr uint32 PAGE_FLAG_LOCKED = 1 << 0;
+constexpr uint32 PAGE_FLAG_HUGE = MEMPAGE_FLAG_HUGE;
+constexpr uint32 PAGE_FLAG_PREFAULT = MEMPAGE_FLAG_PREFAULT;
+
+// alignment 로 정렬된 size 바이트, 실패하면 nullptr
+// HUGE 는 가능할 때만 적용하고 안 되면 일반 페이지로 받음, LOCKED 가 실패하면 nullptr
+void* PageAlloc(size_t size, size_t alignment, uint32 flags);
+void PageFree(void* p, size_t size, uint32 flags);
+// 주소 범위는 남기고 물리 페이지만 돌려줌, 다시 쓰기 전에 PageCommit 필요
+// 큰 페이지처럼 돌려줄 수 없는 경우 false
+bool PageDecommit(void* p, size_t size, uint32 flags);
+bool PageCommit(void* p, size_t size, uint32 flags);
+// 내용을 바꾸지 않고 물리 페이지를 붙임, 다른 스레드가 쓰고 있는 페이지에도 쓸 수 있음
+void PagePopulate(void* p, size_t size);
+size_t PageSystemSize();
+// 큰 페이지를 쓸 수 없으면 0
+size_t PageHugeSize();
+
+// system 주소 공간, _aligned_offset_malloc 과 같이 (p + alignOffset) 이 alignment 로 정렬됨
+void* SystemAlloc(size_t size, size_t alignment, size_t alignOffset);
+// 실패하면 nullptr, p 는 그대로 남음
+void* SystemRealloc(void* p, size_t size, size_t alignment, size_t alignOffset);
+void SystemFree(void* p);
@@ -0,0 +1,420 @@
+#include "ringbuffer.h"
+#include "allocators.h"
+
+#include <string.h>
+#include <wchar.h>
+#include <new>
+#include <thread>
+
+constexpr int32 RINGBUFFER_MAX_CAPACITY = 1 << 30;
+
+static uint64 RoundCapacity(int32 capacity)
+{
+    uint64 rounded = 1;
+    while (rounded < (uint64)capacity) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+static void ResetSignal(RingBufferSignal& signal)
+{
+    signal.sequence.store(0, std::memory_order_relaxed);
+    signal.sleeping.store(false, std::memory_order_relaxed);
+}
+
+// 원소를 내보인 쪽에서 부름, 기다리는 스레드가 없으면 시스템 호출 없이 끝남
+static void Notify(RingBufferSignal& signal)
+{
+    // 기다리는 쪽의 sleeping 설정 → 다시 확인 과 짝을 이뤄서 깨우기를 놓치지 않음
+    // 지운 sleeping 을 설정했던 스레드는 모두 그 전에 sequence 를 읽었으므로 아래 증가로 깨어남
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (signal.sleeping.load(std::memory_order_relaxed) && signal.sleeping.exchange(false, std::memory_order_acq_rel)) {
+        signal.sequence.fetch_add(1, std::memory_order_release);
+        signal.sequence.notify_all();
+    }
+}
+
+static void Wake(RingBufferSignal& signal)
+{
+    signal.sequence.fetch_add(1, std::memory_order_release);
+    signal.sequence.notify_all();
+}
+
+// tryOnce 가 성공하거나 닫힐 때까지 기다림, drain 이면 닫힌 뒤에도 한 번 더 시도
+template <typename TryFunc>
+static bool WaitFor(RingBufferSignal& signal, const std::atomic<bool>& closed, bool waitable, bool drain, TryFunc tryOnce)
+{
+    for (;;) {
+        if (tryOnce()) {
+            return true;
+        }
+        if (closed.load(std::memory_order_acquire)) {
+            return drain && tryOnce();
+        }
+        if (!waitable) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        auto sequence = signal.sequence.load(std::memory_order_acquire);
+        signal.sleeping.store(true, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (tryOnce()) {
+            return true;
+        }
+        if (!closed.load(std::memory_order_acquire)) {
+            signal.sequence.wait(sequence, std::memory_order_acquire);
+        }
+    }
+}
+
+DECLSPEC_DLL bool SPSCRingBuffer::Init(const wchar_t* addrspace, int32 step, int32 capacity, bool waitable)
+{
+    this->addrspace = addrspace != nullptr && wcscmp(addrspace, L"") != 0? addrspace: SYSTEM_NAME;
+    this->step = 0;
+    mask = 0;
+    data = nullptr;
+    this->waitable = waitable;
+    closed.store(false, std::memory_order_relaxed);
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    cachedHead = 0;
+    cachedTail = 0;
+    ResetSignal(pushed);
+    ResetSignal(popped);
+
+    if (step <= 0 || capacity <= 0 || capacity > RINGBUFFER_MAX_CAPACITY) {
+        return false;
+    }
+
+    auto rounded = RoundCapacity(capacity);
+    data = (uint8*)memAlloc((size_t)step * rounded, RINGBUFFER_CACHELINE_SIZE, 0, this->addrspace);
+    if (data == nullptr) {
+        return false;
+    }
+
+    this->step = step;
+    mask = rounded - 1;
+    return true;
+}
+
+DECLSPEC_DLL bool SPSCRingBuffer::Destroy()
+{
+    auto result = true;
+    if (data != nullptr) {
+        result = memFree(data, addrspace);
+    }
+    data = nullptr;
+    step = 0;
+    mask = 0;
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    cachedHead = 0;
+    cachedTail = 0;
+    return result;
+}
+
+DECLSPEC_DLL bool SPSCRingBuffer::Push(const void* ptr)
+{
+    return PushBulk(ptr, 1) == 1;
+}
+
+DECLSPEC_DLL int32 SPSCRingBuffer::PushBulk(const void* ptrs, int32 count)
+{
+    if (step == 0 || count <= 0 || closed.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+
+    auto capacity = mask + 1;
+    auto t = tail.load(std::memory_order_relaxed);
+    if (capacity - (t - cachedHead) < (uint64)count) {
+        cachedHead = head.load(std::memory_order_acquire);
+    }
+    auto free = capacity - (t - cachedHead);
+    auto n = free < (uint64)count? free: (uint64)count;
+    if (n == 0) {
+        return 0;
+    }
+
+    // 끝에서 잘리면 두 번에 나눠 복사
+    auto start = t & mask;
+    auto first = capacity - start < n? capacity - start: n;
+    memcpy(data + start * step, ptrs, (size_t)first * step);
+    if (first < n) {
+        memcpy(data, (const uint8*)ptrs + first * step, (size_t)(n - first) * step);
+    }
+
+    tail.store(t + n, std::memory_order_release);
+    if (waitable) {
+        Notify(pushed);
+    }
+    return (int32)n;
+}
+
+DECLSPEC_DLL bool SPSCRingBuffer::PushWait(const void* ptr)
+{
+    return WaitFor(popped, closed, waitable, false, [this, ptr]() { return Push(ptr); });
+}
+
+DECLSPEC_DLL bool SPSCRingBuffer::Pop(NULLABLE void* ptr)
+{
+    return PopBulk(ptr, 1) == 1;
+}
+
+DECLSPEC_DLL int32 SPSCRingBuffer::PopBulk(NULLABLE void* ptrs, int32 count)
+{
+    if (step == 0 || count <= 0) {
+        return 0;
+    }
+
+    auto h = head.load(std::memory_order_relaxed);
+    if (cachedTail - h < (uint64)count) {
+        cachedTail = tail.load(std::memory_order_acquire);
+    }
+    auto available = cachedTail - h;
+    auto n = available < (uint64)count? available: (uint64)count;
+    if (n == 0) {
+        return 0;
+    }
+
+    if (ptrs != nullptr) {
+        auto capacity = mask + 1;
+        auto start = h & mask;
+        auto first = capacity - start < n? capacity - start: n;
+        memcpy(ptrs, data + start * step, (size_t)first * step);
+        if (first < n) {
+            memcpy((uint8*)ptrs + first * step, data, (size_t)(n - first) * step);
+        }
+    }
+
+    head.store(h + n, std::memory_order_release);
+    if (waitable) {
+        Notify(popped);
+    }
+    return (int32)n;
+}
+
+DECLSPEC_DLL bool SPSCRingBuffer::PopWait(NULLABLE void* ptr)
+{
+    return WaitFor(pushed, closed, waitable, true, [this, ptr]() { return Pop(ptr); });
+}
+
+DECLSPEC_DLL void SPSCRingBuffer::Close()
+{
+    closed.store(true, std::memory_order_seq_cst);
+    Wake(pushed);
+    Wake(popped);
+}
+
+DECLSPEC_DLL bool SPSCRingBuffer::IsClosed() const
+{
+    return closed.load(std::memory_order_acquire);
+}
+
+DECLSPEC_DLL int32 SPSCRingBuffer::Count() const
+{
+    auto h = head.load(std::memory_order_acquire);
+    auto t = tail.load(std::memory_order_acquire);
+    return t > h? (int32)(t - h): 0;
+}
+
+DECLSPEC_DLL int32 SPSCRingBuffer::Capacity() const
+{
+    return step > 0? (int32)(mask + 1): 0;
+}
+
+DECLSPEC_DLL int32 SPSCRingBuffer::Step() const
+{
+    return step;
+}
+
+DECLSPEC_DLL bool MPMCRingBuffer::Init(const wchar_t* addrspace, int32 step, int32 capacity, bool waitable)
+{
+    this->addrspace = addrspace != nullptr && wcscmp(addrspace, L"") != 0? addrspace: SYSTEM_NAME;
+    this->step = 0;
+    stride = 0;
+    mask = 0;
+    slots = nullptr;
+    this->waitable = waitable;
+    closed.store(false, std::memory_order_relaxed);
+    enqueuePos.store(0, std::memory_order_relaxed);
+    dequeuePos.store(0, std::memory_order_relaxed);
+    ResetSignal(pushed);
+    ResetSignal(popped);
+
+    if (step <= 0 || capacity <= 0 || capacity > RINGBUFFER_MAX_CAPACITY) {
+        return false;
+    }
+
+    auto rounded = RoundCapacity(capacity);
+    auto slotStride = (int32)((sizeof(std::atomic<uint64>) + step + 7) & ~(size_t)7);
+    slots = (uint8*)memAlloc((size_t)slotStride * rounded, RINGBUFFER_CACHELINE_SIZE, 0, this->addrspace);
+    if (slots == nullptr) {
+        return false;
+    }
+
+    // 자리 i 는 순번이 i 일 때 넣을 수 있고, i + 1 일 때 꺼낼 수 있음
+    for (uint64 i = 0; i < rounded; i++) {
+        new (slots + i * slotStride) std::atomic<uint64>(i);
+    }
+
+    this->step = step;
+    stride = slotStride;
+    mask = rounded - 1;
+    return true;
+}
+
+DECLSPEC_DLL bool MPMCRingBuffer::Destroy()
+{
+    auto result = true;
+    if (slots != nullptr) {
+        result = memFree(slots, addrspace);
+    }
+    slots = nullptr;
+    step = 0;
+    stride = 0;
+    mask = 0;
+    enqueuePos.store(0, std::memory_order_relaxed);
+    dequeuePos.store(0, std::memory_order_relaxed);
+    return result;
+}
+
+std::atomic<uint64>& MPMCRingBuffer::Sequence(uint64 index) const
+{
+    return *(std::atomic<uint64>*)(slots + (index & mask) * stride);
+}
+
+DECLSPEC_DLL bool MPMCRingBuffer::Push(const void* ptr)
+{
+    return PushBulk(ptr, 1) == 1;
+}
+
+DECLSPEC_DLL int32 MPMCRingBuffer::PushBulk(const void* ptrs, int32 count)
+{
+    if (step == 0 || count <= 0 || closed.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+
+    uint64 n;
+    auto pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        // 잡기 전에 이어진 자리가 모두 비었는지 봄, 그 자리는 pos 를 넘겨야만 바뀌므로 CAS 가 성공하면 그대로임
+        n = 0;
+        while (n < (uint64)count && Sequence(pos + n).load(std::memory_order_acquire) == pos + n) {
+            n++;
+        }
+
+        if (n == 0) {
+            auto diff = (int64)(Sequence(pos).load(std::memory_order_acquire) - pos);
+            if (diff < 0) {
+                return 0;
+            }
+            pos = enqueuePos.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (enqueuePos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    for (uint64 i = 0; i < n; i++) {
+        auto& sequence = Sequence(pos + i);
+        memcpy((uint8*)&sequence + sizeof(std::atomic<uint64>), (const uint8*)ptrs + i * step, step);
+        sequence.store(pos + i + 1, std::memory_order_release);
+    }
+
+    if (waitable) {
+        Notify(pushed);
+    }
+    return (int32)n;
+}
+
+DECLSPEC_DLL bool MPMCRingBuffer::PushWait(const void* ptr)
+{
+    return WaitFor(popped, closed, waitable, false, [this, ptr]() { return Push(ptr); });
+}
+
+DECLSPEC_DLL bool MPMCRingBuffer::Pop(NULLABLE void* ptr)
+{
+    return PopBulk(ptr, 1) == 1;
+}
+
+DECLSPEC_DLL int32 MPMCRingBuffer::PopBulk(NULLABLE void* ptrs, int32 count)
+{
+    if (step == 0 || count <= 0) {
+        return 0;
+    }
+
+    uint64 n;
+    auto pos = dequeuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        n = 0;
+        while (n < (uint64)count && Sequence(pos + n).load(std::memory_order_acquire) == pos + n + 1) {
+            n++;
+        }
+
+        if (n == 0) {
+            auto diff = (int64)(Sequence(pos).load(std::memory_order_acquire) - (pos + 1));
+            if (diff < 0) {
+                return 0;
+            }
+            pos = dequeuePos.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (dequeuePos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    for (uint64 i = 0; i < n; i++) {
+        auto& sequence = Sequence(pos + i);
+        if (ptrs != nullptr) {
+            memcpy((uint8*)ptrs + i * step, (uint8*)&sequence + sizeof(std::atomic<uint64>), step);
+        }
+        // 한 바퀴 뒤의 자리 번호로 돌려놓음
+        sequence.store(pos + i + mask + 1, std::memory_order_release);
+    }
+
+    if (waitable) {
+        Notify(popped);
+    }
+    return (int32)n;
+}
+
+DECLSPEC_DLL bool MPMCRingBuffer::PopWait(NULLABLE void* ptr)
+{
+    return WaitFor(pushed, closed, waitable, true, [this, ptr]() { return Pop(ptr); });
+}
+
+DECLSPEC_DLL void MPMCRingBuffer::Close()
+{
+    closed.store(true, std::memory_order_seq_cst);
+    Wake(pushed);
+    Wake(popped);
+}
+
+DECLSPEC_DLL bool MPMCRingBuffer::IsClosed() const
+{
+    return closed.load(std::memory_order_acquire);
+}
+
+DECLSPEC_DLL int32 MPMCRingBuffer::Count() const
+{
+    auto dequeue = dequeuePos.load(std::memory_order_acquire);
+    auto enqueue = enqueuePos.load(std::memory_order_acquire);
+    if (enqueue <= dequeue) {
+        return 0;
+    }
+    return enqueue - dequeue > mask + 1? (int32)(mask + 1): (int32)(enqueue - dequeue);
+}
+
+DECLSPEC_DLL int32 MPMCRingBuffer::Capacity() const
+{
+    return step > 0? (int32)(mask + 1): 0;
+}
+
+DECLSPEC_DLL int32 MPMCRingBuffer::Step() const
+{
+    return step;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "symbols.h"
+#include "defined_type.h"
+
+#include <atomic>
+
+#define RINGBUFFER_CACHELINE_SIZE 64
+
+// 기다리는 스레드가 있을 때만 깨우는 신호, std::atomic::wait (futex / WaitOnAddress) 를 씀
+// sleeping 은 깨우는 쪽이 지우므로 잠든 스레드가 깨어나기 전까지 이어지는 Push/Pop 은 다시 깨우지 않음
+struct RingBufferSignal
+{
+    std::atomic<uint32> sequence;
+    std::atomic<bool> sleeping;
+};
+
+/// <summary>
+/// 생산자 하나, 소비자 하나인 고정 크기 링 버퍼, 원소는 step 바이트로 복사
+/// head 와 tail 은 다른 캐시 라인에 두고, 반대쪽 인덱스는 캐시해 두었다가 가득 차거나 비었을 때만 다시 읽음
+/// Wait 가 붙은 함수는 가득 차거나 비었을 때 기다리고, Close 하면 깨어나서 false 를 돌려줌
+/// waitable 로 만들어야 잠들고 깨움, 아니면 yield 하면서 다시 확인하고 Push/Pop 에서 깨우는 비용이 없음
+/// C 스타일 컨테이너, ABI 를 위해 템플릿 사용 금지
+/// </summary>
+class DECLSPEC_DLL SPSCRingBuffer
+{
+public:
+    // capacity 는 2의 거듭제곱으로 올림
+    bool Init(const wchar_t* addrspace, int32 step, int32 capacity, bool waitable = false);
+    // 다른 스레드가 쓰는 중이면 안 됨
+    bool Destroy();
+
+public:
+    // 생산자 스레드만, 가득 차면 false
+    bool Push(const void* ptr);
+    // ptrs 에서 step 간격으로 최대 count 개를 넣고 넣은 개수를 돌려줌
+    int32 PushBulk(const void* ptrs, int32 count);
+    bool PushWait(const void* ptr);
+
+    // 소비자 스레드만, 비었으면 false, ptr 가 nullptr 이면 버림
+    bool Pop(NULLABLE void* ptr);
+    int32 PopBulk(NULLABLE void* ptrs, int32 count);
+    // 닫힌 뒤에도 남은 원소는 꺼냄
+    bool PopWait(NULLABLE void* ptr);
+
+    // 기다리는 스레드를 모두 깨움, 이후 Push 는 실패
+    void Close();
+    bool IsClosed() const;
+
+public:
+    // 다른 스레드가 쓰는 중이면 근사값
+    int32 Count() const;
+    int32 Capacity() const;
+    int32 Step() const;
+
+private:
+    const wchar_t* addrspace;
+    int32 step;
+    uint64 mask;
+    uint8* data;
+    bool waitable;
+    std::atomic<bool> closed;
+
+    // 소비자가 쓰는 줄
+    alignas(RINGBUFFER_CACHELINE_SIZE) std::atomic<uint64> head;
+    uint64 cachedTail;
+
+    // 생산자가 쓰는 줄
+    alignas(RINGBUFFER_CACHELINE_SIZE) std::atomic<uint64> tail;
+    uint64 cachedHead;
+
+    alignas(RINGBUFFER_CACHELINE_SIZE) RingBufferSignal pushed;
+    RingBufferSignal popped;
+};
+
+/// <summary>
+/// 여러 생산자, 여러 소비자가 락 없이 쓰는 고정 크기 링 버퍼 (Vyukov bounded MPMC)
+/// 슬롯마다 순번을 두고 인덱스 CAS 로 자리를 잡음, 순번이 자리 번호와 맞을 때만 쓰고 읽음
+/// Bulk 는 이어진 자리가 모두 준비되었을 때 CAS 한 번으로 여러 자리를 잡음
+/// Wait 와 Close 는 SPSCRingBuffer 와 같음
+/// C 스타일 컨테이너, ABI 를 위해 템플릿 사용 금지
+/// </summary>
+class DECLSPEC_DLL MPMCRingBuffer
+{
+public:
+    // capacity 는 2의 거듭제곱으로 올림
+    bool Init(const wchar_t* addrspace, int32 step, int32 capacity, bool waitable = false);
+    bool Destroy();
+
+public:
+    bool Push(const void* ptr);
+    int32 PushBulk(const void* ptrs, int32 count);
+    bool PushWait(const void* ptr);
+
+    bool Pop(NULLABLE void* ptr);
+    int32 PopBulk(NULLABLE void* ptrs, int32 count);
+    bool PopWait(NULLABLE void* ptr);
+
+    void Close();
+    bool IsClosed() const;
+
+public:
+    int32 Count() const;
+    int32 Capacity() const;
+    int32 Step() const;
+
+private:
+    std::atomic<uint64>& Sequence(uint64 index) const;
+
+private:
+    const wchar_t* addrspace;
+    int32 step;
+    int32 stride;
+    uint64 mask;
+    // 슬롯은 [순번][원소]
+    uint8* slots;
+    bool waitable;
+    std::atomic<bool> closed;
+
+    alignas(RINGBUFFER_CACHELINE_SIZE) std::atomic<uint64> enqueuePos;
+    alignas(RINGBUFFER_CACHELINE_SIZE) std::atomic<uint64> dequeuePos;
+
+    alignas(RINGBUFFER_CACHELINE_SIZE) RingBufferSignal pushed;
+    RingBufferSignal popped;
+};
@@ -0,0 +1,372 @@
+#include "segmentedlist.h"
+#include "allocators.h"
+
+#include <string.h>
+#include <wchar.h>
+
+// 인덱스가 int32 이므로 전체 자리 수의 상한
+constexpr int64 SEGMENTEDLIST_MAX_SLOT_COUNT = (int64)1 << 31;
+constexpr int32 SEGMENTEDLIST_MAX_BLOCKCAPACITY = 1 << 24;
+
+static int32 BitScanForward64(uint64 v)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return (int32)index;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+DECLSPEC_DLL bool SegmentedList::Init(const wchar_t* addrspace, int32 step, int32 alignment, int32 blockCapacity, bool freeSlots)
+{
+    this->addrspace = addrspace != nullptr && wcscmp(addrspace, L"") != 0? addrspace: SYSTEM_NAME;
+    this->step = 0;
+    this->alignment = 0;
+    blocks = nullptr;
+    blockCount = 0;
+    blockTableCapacity = 0;
+    count = 0;
+    end = 0;
+    freeHint = 0;
+
+    if (step <= 0 || alignment <= 0 || (alignment & (alignment - 1)) != 0 ||
+        blockCapacity <= 0 || blockCapacity > SEGMENTEDLIST_MAX_BLOCKCAPACITY) {
+        return false;
+    }
+
+    // 비트맵은 64비트 단위로 읽으므로 freeSlots 면 블록당 64자리 이상
+    blockShift = freeSlots? 6: 0;
+    while ((1 << blockShift) < blockCapacity) {
+        blockShift++;
+    }
+
+    bitmapOffset = freeSlots? (((size_t)step << blockShift) + 7) & ~(size_t)7: 0;
+
+    this->step = step;
+    this->alignment = alignment;
+    return true;
+}
+
+DECLSPEC_DLL bool SegmentedList::Destroy()
+{
+    auto result = true;
+    for (auto i = 0; i < blockCount; i++) {
+        result &= memFree(blocks[i], addrspace);
+    }
+    if (blocks != nullptr) {
+        result &= memFree(blocks, addrspace);
+    }
+
+    blocks = nullptr;
+    blockCount = 0;
+    blockTableCapacity = 0;
+    count = 0;
+    end = 0;
+    freeHint = 0;
+    step = 0;
+    alignment = 0;
+    return result;
+}
+
+DECLSPEC_DLL bool SegmentedList::CopyFrom(const SegmentedList& list)
+{
+    if (this == &list) {
+        return true;
+    }
+
+    auto space = addrspace;
+    Destroy();
+    if (!Init(space, list.step, list.alignment, 1 << list.blockShift, list.bitmapOffset != 0)) {
+        return false;
+    }
+
+    auto blockBytes = bitmapOffset != 0? bitmapOffset + ((size_t)1 << blockShift) / 8: (size_t)step << blockShift;
+    auto usedBlocks = (list.end + (1 << blockShift) - 1) >> blockShift;
+    for (auto i = 0; i < usedBlocks; i++) {
+        if (!AddBlock()) {
+            return false;
+        }
+        memcpy(blocks[i], list.blocks[i], blockBytes);
+    }
+
+    count = list.count;
+    end = list.end;
+    freeHint = list.freeHint;
+    return true;
+}
+
+uint64* SegmentedList::Bitmap(int32 blockIndex) const
+{
+    return (uint64*)((uint8*)blocks[blockIndex] + bitmapOffset);
+}
+
+bool SegmentedList::AddBlock()
+{
+    if (((int64)blockCount + 1) << blockShift >= SEGMENTEDLIST_MAX_SLOT_COUNT) {
+        return false;
+    }
+
+    // 블록 표만 옮기고 블록은 그대로 둠
+    if (blockCount == blockTableCapacity) {
+        auto capacity = blockTableCapacity > 0? blockTableCapacity * 2: 4;
+        auto table = (void**)memRealloc(blocks, sizeof(void*) * capacity, alignof(void*), 0, addrspace);
+        if (table == nullptr) {
+            return false;
+        }
+        blocks = table;
+        blockTableCapacity = capacity;
+    }
+
+    auto bitmapBytes = bitmapOffset != 0? ((size_t)1 << blockShift) / 8: 0;
+    auto blockBytes = bitmapOffset != 0? bitmapOffset + bitmapBytes: (size_t)step << blockShift;
+    auto block = memAlloc(blockBytes, alignment, 0, addrspace);
+    if (block == nullptr) {
+        return false;
+    }
+    if (bitmapBytes > 0) {
+        memset((uint8*)block + bitmapOffset, 0, bitmapBytes);
+    }
+
+    blocks[blockCount++] = block;
+    return true;
+}
+
+void* SegmentedList::Append(const void* ptr)
+{
+    if (end == (blockCount << blockShift) && !AddBlock()) {
+        return nullptr;
+    }
+
+    auto blockIndex = end >> blockShift;
+    auto slot = end & ((1 << blockShift) - 1);
+    auto p = (uint8*)blocks[blockIndex] + (size_t)slot * step;
+    if (ptr != nullptr) {
+        memcpy(p, ptr, step);
+    } else {
+        memset(p, 0, step);
+    }
+    if (bitmapOffset != 0) {
+        Bitmap(blockIndex)[slot >> 6] |= (uint64)1 << (slot & 63);
+    }
+
+    end++;
+    count++;
+    return p;
+}
+
+DECLSPEC_DLL void* SegmentedList::InsertLast(NULLABLE const void* ptr)
+{
+    if (step == 0) {
+        return nullptr;
+    }
+
+    return Append(ptr);
+}
+
+DECLSPEC_DLL void* SegmentedList::Add(NULLABLE const void* ptr, NULLABLE int32* index)
+{
+    if (step == 0) {
+        return nullptr;
+    }
+
+    if (bitmapOffset == 0 || count == end) {
+        auto p = Append(ptr);
+        if (p != nullptr && index != nullptr) {
+            *index = end - 1;
+        }
+        return p;
+    }
+
+    // 빈 자리가 있으면 freeHint 블록부터 비트맵에서 찾음
+    auto wordCount = (1 << blockShift) >> 6;
+    for (auto b = freeHint; b < blockCount; b++) {
+        auto bitmap = Bitmap(b);
+        for (auto w = 0; w < wordCount; w++) {
+            auto first = (b << blockShift) + (w << 6);
+            if (first >= end) {
+                break;
+            }
+
+            auto empty = ~bitmap[w];
+            if (end - first < 64) {
+                empty &= ((uint64)1 << (end - first)) - 1;
+            }
+            if (empty == 0) {
+                continue;
+            }
+
+            auto slot = (w << 6) + BitScanForward64(empty);
+            auto p = (uint8*)blocks[b] + (size_t)slot * step;
+            if (ptr != nullptr) {
+                memcpy(p, ptr, step);
+            } else {
+                memset(p, 0, step);
+            }
+            bitmap[w] |= (uint64)1 << (slot & 63);
+            count++;
+            freeHint = b;
+            if (index != nullptr) {
+                *index = (b << blockShift) + slot;
+            }
+            return p;
+        }
+    }
+
+    return nullptr;
+}
+
+DECLSPEC_DLL bool SegmentedList::Remove(int32 index)
+{
+    if (bitmapOffset == 0 || !IsAlive(index)) {
+        return false;
+    }
+
+    auto blockIndex = index >> blockShift;
+    auto slot = index & ((1 << blockShift) - 1);
+    Bitmap(blockIndex)[slot >> 6] &= ~((uint64)1 << (slot & 63));
+    count--;
+    if (blockIndex < freeHint) {
+        freeHint = blockIndex;
+    }
+
+    // 맨 뒤가 비면 End() 를 당겨서 순회와 Add 가 빈 꼬리를 보지 않게 함
+    while (end > 0 && !IsAlive(end - 1)) {
+        end--;
+    }
+    return true;
+}
+
+DECLSPEC_DLL bool SegmentedList::RemoveLast()
+{
+    if (end == 0) {
+        return false;
+    }
+
+    if (bitmapOffset != 0) {
+        return Remove(end - 1);
+    }
+
+    end--;
+    count--;
+    return true;
+}
+
+DECLSPEC_DLL bool SegmentedList::RemoveAll()
+{
+    if (bitmapOffset != 0) {
+        auto bitmapBytes = ((size_t)1 << blockShift) / 8;
+        for (auto i = 0; i < blockCount; i++) {
+            memset(Bitmap(i), 0, bitmapBytes);
+        }
+    }
+
+    count = 0;
+    end = 0;
+    freeHint = 0;
+    return true;
+}
+
+DECLSPEC_DLL void* SegmentedList::operator[](int32 index) const
+{
+    if (index < 0 || index >= end) {
+        return nullptr;
+    }
+
+    return (uint8*)blocks[index >> blockShift] + (size_t)(index & ((1 << blockShift) - 1)) * step;
+}
+
+DECLSPEC_DLL bool SegmentedList::IsAlive(int32 index) const
+{
+    if (index < 0 || index >= end) {
+        return false;
+    }
+    if (bitmapOffset == 0) {
+        return true;
+    }
+
+    auto slot = index & ((1 << blockShift) - 1);
+    return (Bitmap(index >> blockShift)[slot >> 6] >> (slot & 63)) & 1;
+}
+
+DECLSPEC_DLL int32 SegmentedList::Next(int32 index) const
+{
+    if (index < 0) {
+        index = 0;
+    }
+    if (bitmapOffset == 0 || index >= end) {
+        return index < end? index: -1;
+    }
+
+    // 64자리씩 건너뜀
+    while (index < end) {
+        auto slot = index & ((1 << blockShift) - 1);
+        auto alive = Bitmap(index >> blockShift)[slot >> 6] >> (slot & 63);
+        if (alive != 0) {
+            auto found = index + BitScanForward64(alive);
+            return found < end? found: -1;
+        }
+        index += 64 - (slot & 63);
+    }
+    return -1;
+}
+
+DECLSPEC_DLL int32 SegmentedList::IndexOf(const void* p) const
+{
+    auto blockBytes = (size_t)step << blockShift;
+    for (auto i = 0; i < blockCount; i++) {
+        auto offset = (size_t)((const uint8*)p - (const uint8*)blocks[i]);
+        if ((const uint8*)p < (const uint8*)blocks[i] || offset >= blockBytes || offset % step != 0) {
+            continue;
+        }
+
+        auto index = (i << blockShift) + (int32)(offset / step);
+        return index < end? index: -1;
+    }
+    return -1;
+}
+
+DECLSPEC_DLL int32 SegmentedList::BlockCount() const
+{
+    return blockCount;
+}
+
+DECLSPEC_DLL void* SegmentedList::Block(int32 blockIndex, NULLABLE int32* slotCount) const
+{
+    if (blockIndex < 0 || blockIndex >= blockCount) {
+        return nullptr;
+    }
+
+    if (slotCount != nullptr) {
+        auto remain = end - (blockIndex << blockShift);
+        auto capacity = 1 << blockShift;
+        *slotCount = remain < 0? 0: (remain < capacity? remain: capacity);
+    }
+    return blocks[blockIndex];
+}
+
+DECLSPEC_DLL int32 SegmentedList::Count() const
+{
+    return count;
+}
+
+DECLSPEC_DLL int32 SegmentedList::End() const
+{
+    return end;
+}
+
+DECLSPEC_DLL int32 SegmentedList::Step() const
+{
+    return step;
+}
+
+DECLSPEC_DLL int32 SegmentedList::Alignment() const
+{
+    return alignment;
+}
+
+DECLSPEC_DLL int32 SegmentedList::BlockCapacity() const
+{
+    return step > 0? 1 << blockShift: 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "symbols.h"
+#include "defined_type.h"
+
+#define SEGMENTEDLIST_DEFAULT_ALIGNMENT 32
+#define SEGMENTEDLIST_DEFAULT_BLOCKCAPACITY 64
+
+/// <summary>
+/// 고정 크기 블록을 이어 붙인 목록, 블록은 addrspace 에서 받고 옮기지 않으므로 원소 주소가 바뀌지 않음
+/// 블록 표만 늘어날 때 다시 할당하고, 뒤에 붙이는 것은 O(1)
+/// freeSlots 를 켜면 블록마다 사용중 비트맵을 두어서 가운데 원소를 O(1) 로 지우고 Add 에서 빈 자리를 다시 씀
+/// 인덱스는 [0, End()) 이고, 지운 자리가 있으면 Count() 보다 End() 가 큼
+/// C 스타일 컨테이너, ABI 를 위해 템플릿 사용 금지
+/// </summary>
+class DECLSPEC_DLL SegmentedList
+{
+public:
+    // blockCapacity 는 2의 거듭제곱으로 올림, freeSlots 를 켜면 64 이상
+    bool Init(
+        const wchar_t* addrspace, int32 step, int32 alignment = s_DefaultAlignment,
+        int32 blockCapacity = s_DefaultBlockCapacity, bool freeSlots = false
+    );
+    bool Destroy();
+    // list 와 같은 설정으로 다시 만들고 원소를 복사, 빈 자리도 그대로 둠
+    bool CopyFrom(const SegmentedList& list);
+
+public:
+    // 맨 뒤에 붙이고 원소 주소를 돌려줌, ptr 가 nullptr 이면 0 으로 채움, 실패하면 nullptr
+    void* InsertLast(NULLABLE const void* ptr);
+    // 빈 자리가 있으면 가장 앞의 빈 자리를 쓰고, 없으면 InsertLast 와 같음
+    void* Add(NULLABLE const void* ptr, NULLABLE int32* index);
+    // freeSlots 를 켠 목록만 가능, 자리를 비우고 뒤쪽 원소는 그대로 둠
+    bool Remove(int32 index);
+    bool RemoveLast();
+    // 블록은 남겨두고 다시 씀
+    bool RemoveAll();
+
+public:
+    // 빈 자리도 주소는 돌려줌, 범위 밖이면 nullptr
+    void* operator[](int32 index) const;
+    bool IsAlive(int32 index) const;
+    // index 이상인 첫 번째 사용중 인덱스, 없으면 -1
+    // for (auto i = list.Next(0); i >= 0; i = list.Next(i + 1))
+    int32 Next(int32 index) const;
+    // 이 목록의 원소가 아니면 -1, 블록 수에 비례
+    int32 IndexOf(const void* p) const;
+
+    // 블록 단위로 순회, slotCount 에 그 블록에서 쓰는 자리 수 (빈 자리 포함) 를 적음
+    int32 BlockCount() const;
+    void* Block(int32 blockIndex, NULLABLE int32* slotCount) const;
+
+    int32 Count() const;
+    int32 End() const;
+    int32 Step() const;
+    int32 Alignment() const;
+    int32 BlockCapacity() const;
+
+private:
+    uint64* Bitmap(int32 blockIndex) const;
+    bool AddBlock();
+    void* Append(const void* ptr);
+
+private:
+    const wchar_t* addrspace;
+    int32 step;
+    int32 alignment;
+    int32 blockShift;
+    // 블록 안에서 비트맵이 시작하는 위치, freeSlots 를 끄면 0
+    size_t bitmapOffset;
+
+    void** blocks;
+    int32 blockCount;
+    int32 blockTableCapacity;
+
+    int32 count;
+    int32 end;
+    // 이 블록 앞에는 빈 자리가 없음
+    int32 freeHint;
+
+public:
+    static const int32 s_DefaultAlignment = SEGMENTEDLIST_DEFAULT_ALIGNMENT;
+    static const int32 s_DefaultBlockCapacity = SEGMENTEDLIST_DEFAULT_BLOCKCAPACITY;
+};
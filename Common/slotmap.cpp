@@ -0,0 +1,238 @@
+#include "slotmap.h"
+#include "allocators.h"
+
+#include <string.h>
+#include <wchar.h>
+
+// 빈 슬롯은 indexOrNext 에 이 비트를 켜고 하위 비트에 다음 빈 슬롯을 적음
+constexpr uint32 SLOTMAP_FREE_BIT = 0x80000000;
+constexpr uint32 SLOTMAP_FREE_END = 0x7FFFFFFF;
+constexpr uint32 SLOTMAP_NO_SLOT = 0xFFFFFFFF;
+constexpr int32 SLOTMAP_MAX_CAPACITY = 0x7FFFFFFE;
+
+static SlotHandle MakeHandle(uint32 index, uint32 generation)
+{
+    return ((uint64)generation << 32) | index;
+}
+
+static uint32 NextGeneration(uint32 generation)
+{
+    // 한 바퀴 돌아도 0 은 건너뜀
+    return generation + 1 != 0? generation + 1: 1;
+}
+
+DECLSPEC_DLL bool SlotMap::Init(const wchar_t* addrspace, int32 step, int32 alignment, int32 capacity)
+{
+    this->addrspace = addrspace != nullptr && wcscmp(addrspace, L"") != 0? addrspace: SYSTEM_NAME;
+    this->step = 0;
+    this->alignment = 0;
+    dense = nullptr;
+    denseToSlot = nullptr;
+    slots = nullptr;
+    count = 0;
+    this->capacity = 0;
+    slotCount = 0;
+    freeHead = SLOTMAP_NO_SLOT;
+
+    if (step <= 0 || alignment <= 0 || (alignment & (alignment - 1)) != 0 || capacity < 0) {
+        return false;
+    }
+
+    this->step = step;
+    this->alignment = alignment;
+    if (capacity > 0 && !Reserve(capacity)) {
+        Destroy();
+        return false;
+    }
+    return true;
+}
+
+DECLSPEC_DLL bool SlotMap::Destroy()
+{
+    auto result = true;
+    if (dense != nullptr) {
+        result &= memFree(dense, addrspace);
+    }
+    if (denseToSlot != nullptr) {
+        result &= memFree(denseToSlot, addrspace);
+    }
+    if (slots != nullptr) {
+        result &= memFree(slots, addrspace);
+    }
+
+    dense = nullptr;
+    denseToSlot = nullptr;
+    slots = nullptr;
+    count = 0;
+    capacity = 0;
+    slotCount = 0;
+    freeHead = SLOTMAP_NO_SLOT;
+    step = 0;
+    alignment = 0;
+    return result;
+}
+
+DECLSPEC_DLL bool SlotMap::Reserve(int32 capacity)
+{
+    if (step == 0 || capacity < 0 || capacity > SLOTMAP_MAX_CAPACITY) {
+        return false;
+    }
+    if (capacity <= this->capacity) {
+        return true;
+    }
+
+    // 슬롯은 살아 있는 원소 수보다 많아지지 않으므로 세 배열 모두 같은 용량
+    auto newDense = (uint8*)memRealloc(dense, (size_t)step * capacity, alignment, 0, addrspace);
+    if (newDense == nullptr) {
+        return false;
+    }
+    dense = newDense;
+
+    auto newDenseToSlot = (uint32*)memRealloc(denseToSlot, sizeof(uint32) * capacity, alignof(uint32), 0, addrspace);
+    if (newDenseToSlot == nullptr) {
+        return false;
+    }
+    denseToSlot = newDenseToSlot;
+
+    auto newSlots = (Slot*)memRealloc(slots, sizeof(Slot) * capacity, alignof(Slot), 0, addrspace);
+    if (newSlots == nullptr) {
+        return false;
+    }
+    slots = newSlots;
+
+    this->capacity = capacity;
+    return true;
+}
+
+DECLSPEC_DLL SlotHandle SlotMap::Insert(NULLABLE const void* ptr)
+{
+    if (step == 0) {
+        return SLOTMAP_INVALID_HANDLE;
+    }
+    if (count == capacity) {
+        auto newCapacity = capacity < SLOTMAP_DEFAULT_CAPACITY? SLOTMAP_DEFAULT_CAPACITY:
+            capacity > SLOTMAP_MAX_CAPACITY / 2? SLOTMAP_MAX_CAPACITY: capacity * 2;
+        if (newCapacity == capacity || !Reserve(newCapacity)) {
+            return SLOTMAP_INVALID_HANDLE;
+        }
+    }
+
+    uint32 slotIndex;
+    if (freeHead != SLOTMAP_NO_SLOT) {
+        slotIndex = freeHead;
+        auto next = slots[slotIndex].indexOrNext & ~SLOTMAP_FREE_BIT;
+        freeHead = next != SLOTMAP_FREE_END? next: SLOTMAP_NO_SLOT;
+    } else {
+        slotIndex = (uint32)slotCount++;
+        slots[slotIndex].generation = 1;
+    }
+
+    auto denseIndex = count++;
+    auto p = dense + (size_t)step * denseIndex;
+    if (ptr != nullptr) {
+        memcpy(p, ptr, step);
+    } else {
+        memset(p, 0, step);
+    }
+    denseToSlot[denseIndex] = slotIndex;
+    slots[slotIndex].indexOrNext = (uint32)denseIndex;
+    return MakeHandle(slotIndex, slots[slotIndex].generation);
+}
+
+DECLSPEC_DLL bool SlotMap::Erase(SlotHandle handle)
+{
+    if (!IsAlive(handle)) {
+        return false;
+    }
+
+    auto slotIndex = (uint32)handle;
+    auto& slot = slots[slotIndex];
+    auto denseIndex = slot.indexOrNext;
+    auto last = (uint32)(count - 1);
+
+    // 마지막 원소를 빈 자리로 옮겨서 dense 배열에 빈틈을 남기지 않음
+    if (denseIndex != last) {
+        memcpy(dense + (size_t)step * denseIndex, dense + (size_t)step * last, step);
+        denseToSlot[denseIndex] = denseToSlot[last];
+        slots[denseToSlot[denseIndex]].indexOrNext = denseIndex;
+    }
+    count--;
+
+    slot.generation = NextGeneration(slot.generation);
+    slot.indexOrNext = SLOTMAP_FREE_BIT | (freeHead != SLOTMAP_NO_SLOT? freeHead: SLOTMAP_FREE_END);
+    freeHead = slotIndex;
+    return true;
+}
+
+DECLSPEC_DLL bool SlotMap::RemoveAll()
+{
+    for (auto i = 0; i < count; i++) {
+        auto slotIndex = denseToSlot[i];
+        auto& slot = slots[slotIndex];
+        slot.generation = NextGeneration(slot.generation);
+        slot.indexOrNext = SLOTMAP_FREE_BIT | (freeHead != SLOTMAP_NO_SLOT? freeHead: SLOTMAP_FREE_END);
+        freeHead = slotIndex;
+    }
+    count = 0;
+    return true;
+}
+
+DECLSPEC_DLL void* SlotMap::Find(SlotHandle handle) const
+{
+    if (!IsAlive(handle)) {
+        return nullptr;
+    }
+    return dense + (size_t)step * slots[(uint32)handle].indexOrNext;
+}
+
+DECLSPEC_DLL bool SlotMap::IsAlive(SlotHandle handle) const
+{
+    auto slotIndex = (uint32)handle;
+    if (slotIndex >= (uint32)slotCount) {
+        return false;
+    }
+    auto& slot = slots[slotIndex];
+    return slot.generation == (uint32)(handle >> 32) && (slot.indexOrNext & SLOTMAP_FREE_BIT) == 0;
+}
+
+DECLSPEC_DLL void* SlotMap::operator[](int32 denseIndex) const
+{
+    if (denseIndex < 0 || denseIndex >= count) {
+        return nullptr;
+    }
+    return dense + (size_t)step * denseIndex;
+}
+
+DECLSPEC_DLL SlotHandle SlotMap::HandleAt(int32 denseIndex) const
+{
+    if (denseIndex < 0 || denseIndex >= count) {
+        return SLOTMAP_INVALID_HANDLE;
+    }
+    auto slotIndex = denseToSlot[denseIndex];
+    return MakeHandle(slotIndex, slots[slotIndex].generation);
+}
+
+DECLSPEC_DLL void* SlotMap::Data() const
+{
+    return dense;
+}
+
+DECLSPEC_DLL int32 SlotMap::Count() const
+{
+    return count;
+}
+
+DECLSPEC_DLL int32 SlotMap::Capacity() const
+{
+    return capacity;
+}
+
+DECLSPEC_DLL int32 SlotMap::Step() const
+{
+    return step;
+}
+
+DECLSPEC_DLL int32 SlotMap::Alignment() const
+{
+    return alignment;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "symbols.h"
+#include "defined_type.h"
+
+#define SLOTMAP_DEFAULT_ALIGNMENT 16
+#define SLOTMAP_DEFAULT_CAPACITY 16
+#define SLOTMAP_INVALID_HANDLE 0
+
+// 상위 32비트는 세대, 하위 32비트는 슬롯 인덱스, 세대는 1 부터 시작하므로 0 은 항상 잘못된 핸들
+typedef uint64 SlotHandle;
+
+/// <summary>
+/// 세대 번호가 붙은 핸들로 원소를 찾는 슬롯 맵
+/// 원소는 빈틈 없는 배열 (dense) 에 모여 있고, 핸들은 슬롯 배열 (sparse) 을 거쳐서 dense 위치를 찾음
+/// 지우면 마지막 원소를 빈 자리로 옮기고 슬롯 세대를 올리므로, 넣기/지우기/찾기가 O(1) 이고 지운 핸들은 다시 찾을 수 없음
+/// 원소 주소와 dense 순서는 Insert/Erase 에서 바뀔 수 있으므로 오래 들고 있을 것은 핸들
+/// C 스타일 컨테이너, ABI 를 위해 템플릿 사용 금지
+/// </summary>
+class DECLSPEC_DLL SlotMap
+{
+public:
+    bool Init(
+        const wchar_t* addrspace, int32 step,
+        int32 alignment = s_DefaultAlignment, int32 capacity = s_DefaultCapacity
+    );
+    bool Destroy();
+    bool Reserve(int32 capacity);
+
+public:
+    // ptr 가 nullptr 이면 0 으로 채움, 실패하면 SLOTMAP_INVALID_HANDLE
+    SlotHandle Insert(NULLABLE const void* ptr);
+    bool Erase(SlotHandle handle);
+    // 모든 핸들을 무효로 만들고 슬롯은 다시 씀
+    bool RemoveAll();
+
+    // 지웠거나 다른 맵의 핸들이면 nullptr
+    void* Find(SlotHandle handle) const;
+    bool IsAlive(SlotHandle handle) const;
+
+public:
+    // dense 배열로 순회, for (auto i = 0; i < map.Count(); i++) map[i]
+    void* operator[](int32 denseIndex) const;
+    SlotHandle HandleAt(int32 denseIndex) const;
+    // dense 배열 시작, Count() 개가 step 간격으로 이어져 있음
+    void* Data() const;
+
+    int32 Count() const;
+    int32 Capacity() const;
+    int32 Step() const;
+    int32 Alignment() const;
+
+private:
+    struct Slot
+    {
+        // 살아 있으면 dense 위치, 비어 있으면 다음 빈 슬롯
+        uint32 indexOrNext;
+        uint32 generation;
+    };
+
+private:
+    const wchar_t* addrspace;
+    int32 step;
+    int32 alignment;
+
+    uint8* dense;
+    // dense 위치마다 슬롯 인덱스, 지울 때 옮겨온 원소의 슬롯을 고침
+    uint32* denseToSlot;
+    Slot* slots;
+
+    int32 count;
+    int32 capacity;
+    // 한 번이라도 쓴 슬롯 수
+    int32 slotCount;
+    uint32 freeHead;
+
+public:
+    static const int32 s_DefaultAlignment = SLOTMAP_DEFAULT_ALIGNMENT;
+    static const int32 s_DefaultCapacity = SLOTMAP_DEFAULT_CAPACITY;
+};
@@ -0,0 +1,226 @@
+#include "soalist.h"
+#include "allocators.h"
+
+#include <string.h>
+#include <wchar.h>
+
+// 인덱스가 int32 이므로 행 수의 상한
+constexpr int32 SOALIST_MAX_CAPACITY = 0x7fffffff;
+constexpr int32 SOALIST_MIN_GROW_CAPACITY = 16;
+
+DECLSPEC_DLL bool SoAList::Init(const wchar_t* addrspace, int32 columnCount, const int32* steps, int32 capacity)
+{
+    this->addrspace = addrspace != nullptr && wcscmp(addrspace, L"") != 0? addrspace: SYSTEM_NAME;
+    this->columnCount = 0;
+    data = nullptr;
+    count = 0;
+    this->capacity = 0;
+
+    if (columnCount <= 0 || columnCount > SOALIST_MAX_COLUMN_COUNT || steps == nullptr || capacity < 0) {
+        return false;
+    }
+    for (auto i = 0; i < columnCount; i++) {
+        if (steps[i] <= 0) {
+            return false;
+        }
+    }
+
+    for (auto i = 0; i < columnCount; i++) {
+        this->steps[i] = steps[i];
+        offsets[i] = 0;
+    }
+    this->columnCount = columnCount;
+
+    if (capacity > 0 && !ResizeMem(capacity)) {
+        this->columnCount = 0;
+        return false;
+    }
+    return true;
+}
+
+DECLSPEC_DLL bool SoAList::Destroy()
+{
+    auto result = true;
+    if (data != nullptr) {
+        result = memFree(data, addrspace);
+    }
+
+    data = nullptr;
+    count = 0;
+    capacity = 0;
+    columnCount = 0;
+    return result;
+}
+
+DECLSPEC_DLL bool SoAList::CopyFrom(const SoAList& list)
+{
+    if (this == &list) {
+        return true;
+    }
+
+    auto space = addrspace;
+    Destroy();
+    if (!Init(space, list.columnCount, list.steps, list.count)) {
+        return false;
+    }
+
+    for (auto i = 0; i < columnCount && list.count > 0; i++) {
+        memcpy(data + offsets[i], list.data + list.offsets[i], (size_t)steps[i] * list.count);
+    }
+    count = list.count;
+    return true;
+}
+
+size_t SoAList::Layout(int32 capacity, size_t* offsets) const
+{
+    size_t size = 0;
+    for (auto i = 0; i < columnCount; i++) {
+        offsets[i] = size;
+        size += ((size_t)steps[i] * capacity + SOALIST_COLUMN_ALIGNMENT - 1) & ~(size_t)(SOALIST_COLUMN_ALIGNMENT - 1);
+    }
+    return size;
+}
+
+DECLSPEC_DLL bool SoAList::ResizeMem(int32 capacity)
+{
+    if (columnCount == 0 || capacity < count) {
+        return false;
+    }
+    if (capacity == this->capacity) {
+        return true;
+    }
+
+    size_t newOffsets[SOALIST_MAX_COLUMN_COUNT];
+    auto size = Layout(capacity, newOffsets);
+    uint8* newData = nullptr;
+    if (size > 0) {
+        newData = (uint8*)memAlloc(size, SOALIST_COLUMN_ALIGNMENT, 0, addrspace);
+        if (newData == nullptr) {
+            return false;
+        }
+    }
+
+    // 열마다 시작 위치가 바뀌므로 realloc 대신 열 단위로 옮김
+    for (auto i = 0; i < columnCount; i++) {
+        if (count > 0) {
+            memcpy(newData + newOffsets[i], data + offsets[i], (size_t)steps[i] * count);
+        }
+        offsets[i] = newOffsets[i];
+    }
+
+    if (data != nullptr) {
+        memFree(data, addrspace);
+    }
+    data = newData;
+    this->capacity = capacity;
+    return true;
+}
+
+DECLSPEC_DLL bool SoAList::Resize(int32 count)
+{
+    if (columnCount == 0 || count < 0) {
+        return false;
+    }
+    if (count > capacity && !ResizeMem(count)) {
+        return false;
+    }
+
+    for (auto i = 0; i < columnCount && count > this->count; i++) {
+        memset(data + offsets[i] + (size_t)steps[i] * this->count, 0, (size_t)steps[i] * (count - this->count));
+    }
+    this->count = count;
+    return true;
+}
+
+DECLSPEC_DLL int32 SoAList::InsertLast(NULLABLE const void* const* values)
+{
+    if (columnCount == 0) {
+        return -1;
+    }
+    if (count == capacity) {
+        if (capacity == SOALIST_MAX_CAPACITY) {
+            return -1;
+        }
+        auto newCapacity = capacity < SOALIST_MIN_GROW_CAPACITY? SOALIST_MIN_GROW_CAPACITY:
+            capacity > SOALIST_MAX_CAPACITY / 2? SOALIST_MAX_CAPACITY: capacity * 2;
+        if (!ResizeMem(newCapacity)) {
+            return -1;
+        }
+    }
+
+    for (auto i = 0; i < columnCount; i++) {
+        auto dst = data + offsets[i] + (size_t)steps[i] * count;
+        if (values != nullptr && values[i] != nullptr) {
+            memcpy(dst, values[i], steps[i]);
+        } else {
+            memset(dst, 0, steps[i]);
+        }
+    }
+    return count++;
+}
+
+DECLSPEC_DLL bool SoAList::RemoveLast()
+{
+    if (count == 0) {
+        return false;
+    }
+    count--;
+    return true;
+}
+
+DECLSPEC_DLL bool SoAList::RemoveSwap(int32 index)
+{
+    if (index < 0 || index >= count) {
+        return false;
+    }
+
+    count--;
+    if (index != count) {
+        for (auto i = 0; i < columnCount; i++) {
+            memcpy(data + offsets[i] + (size_t)steps[i] * index, data + offsets[i] + (size_t)steps[i] * count, steps[i]);
+        }
+    }
+    return true;
+}
+
+DECLSPEC_DLL bool SoAList::RemoveAll()
+{
+    count = 0;
+    return true;
+}
+
+DECLSPEC_DLL void* SoAList::Column(int32 column) const
+{
+    if (column < 0 || column >= columnCount || data == nullptr) {
+        return nullptr;
+    }
+    return data + offsets[column];
+}
+
+DECLSPEC_DLL void* SoAList::At(int32 column, int32 index) const
+{
+    if (column < 0 || column >= columnCount || index < 0 || index >= count) {
+        return nullptr;
+    }
+    return data + offsets[column] + (size_t)steps[column] * index;
+}
+
+DECLSPEC_DLL int32 SoAList::ColumnCount() const
+{
+    return columnCount;
+}
+
+DECLSPEC_DLL int32 SoAList::ColumnStep(int32 column) const
+{
+    return column >= 0 && column < columnCount? steps[column]: 0;
+}
+
+DECLSPEC_DLL int32 SoAList::Count() const
+{
+    return count;
+}
+
+DECLSPEC_DLL int32 SoAList::Capacity() const
+{
+    return capacity;
+}
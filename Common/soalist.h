@@ -0,0 +1,66 @@
+#pragma once
+
+#include "symbols.h"
+#include "defined_type.h"
+
+#define SOALIST_MAX_COLUMN_COUNT 16
+#define SOALIST_COLUMN_ALIGNMENT 64
+
+/// <summary>
+/// 열마다 원소 크기가 다른 배열 여러 개를 한 할당에 이어 붙인 목록, 모든 열이 원소 수와 용량을 공유
+/// 열은 64바이트로 정렬되어 있어서 Column() 포인터를 그대로 SIMD 커널이나 GPU 버퍼 복사에 넘길 수 있음
+/// 용량이 바뀌면 모든 열을 한 번에 다시 할당하므로 열 포인터는 다음 ResizeMem 전까지만 유효
+/// C 스타일 컨테이너, ABI 를 위해 템플릿 사용 금지
+/// </summary>
+class DECLSPEC_DLL SoAList
+{
+public:
+    // steps 는 열마다 원소 크기, columnCount 는 1 ~ SOALIST_MAX_COLUMN_COUNT
+    bool Init(const wchar_t* addrspace, int32 columnCount, const int32* steps, int32 capacity = 0);
+    bool Destroy();
+    // list 와 같은 열로 다시 만들고 원소를 복사
+    bool CopyFrom(const SoAList& list);
+
+    // 모든 열의 용량을 함께 바꿈, count 보다 작게 줄일 수 없음
+    bool ResizeMem(int32 capacity);
+    // 원소 수를 바꿈, 늘어난 행은 모든 열을 0 으로 채움
+    bool Resize(int32 count);
+
+public:
+    // 한 행을 맨 뒤에 붙이고 행 인덱스를 돌려줌, 실패하면 -1
+    // values 는 열마다 원소 포인터, values 나 그 원소가 nullptr 이면 그 열은 0 으로 채움
+    int32 InsertLast(NULLABLE const void* const* values);
+    bool RemoveLast();
+    // 마지막 행을 index 로 옮기고 지움, 순서가 바뀜
+    bool RemoveSwap(int32 index);
+    bool RemoveAll();
+
+public:
+    // 열의 시작 주소, 64바이트 정렬
+    void* Column(int32 column) const;
+    // 범위 밖이면 nullptr
+    void* At(int32 column, int32 index) const;
+
+    int32 ColumnCount() const;
+    int32 ColumnStep(int32 column) const;
+    int32 Count() const;
+    int32 Capacity() const;
+
+private:
+    // capacity 개를 담을 때 열의 시작 위치를 offsets 에 적고 전체 크기를 돌려줌
+    size_t Layout(int32 capacity, size_t* offsets) const;
+
+private:
+    const wchar_t* addrspace;
+    int32 columnCount;
+    int32 steps[SOALIST_MAX_COLUMN_COUNT];
+    size_t offsets[SOALIST_MAX_COLUMN_COUNT];
+
+    uint8* data;
+    int32 count;
+    int32 capacity;
+
+public:
+    static const int32 s_MaxColumnCount = SOALIST_MAX_COLUMN_COUNT;
+    static const int32 s_ColumnAlignment = SOALIST_COLUMN_ALIGNMENT;
+};
@@ -1,7 +1,11 @@
 #pragma once
 
+#if defined(_WIN32)
 #ifdef EXPORT_COMMON_DLL
 #define DECLSPEC_DLL __declspec(dllexport)
 #else
 #define DECLSPEC_DLL __declspec(dllimport)
-#endif
\ No newline at end of file
+#endif
+#else
+#define DECLSPEC_DLL __attribute__((visibility("default")))
+#endif
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "container.h"
+#include "allocators.h"
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/// <summary>
+/// ArrayList 위에 올린 타입 있는 헤더 전용 컨테이너, 메모리 배치는 ArrayList 와 같음
+/// DLL 경계를 넘기지 않고 쓰는 곳에서만 템플릿을 만듦, 넘길 때는 Raw() 로 ArrayList 를 넘김
+/// 복사만으로 옮길 수 있는 T 는 memmove/memRealloc 으로, 아니면 이동 생성자로 옮김
+/// ArrayList 처럼 Init/Destroy 를 직접 불러야 하고, Destroy 에서 남은 원소의 소멸자를 부름
+/// </summary>
+template <typename T>
+class TypedArrayList
+{
+public:
+    bool Init(const wchar_t* addrspace, uint64 capacity = ArrayList::s_DefaultCapacity)
+    {
+        return list.Init(addrspace, (int32)sizeof(T), s_Alignment, capacity > 0? capacity: 1);
+    }
+    bool Destroy()
+    {
+        DestroyRange(0, list.count);
+        return list.Destroy();
+    }
+
+public:
+    bool Reserve(uint64 capacity)
+    {
+        if (capacity <= list.capacity) {
+            return true;
+        }
+        return Relocate(capacity);
+    }
+    // 원소 수에 맞춰 줄임, 빈 목록도 원소 하나 자리는 남김
+    bool ShrinkToFit()
+    {
+        auto capacity = list.count > 0? (uint64)list.count: 1;
+        return capacity == list.capacity || Relocate(capacity);
+    }
+
+public:
+    // value 와 args 는 이 목록의 원소를 가리켜도 됨
+    bool InsertLast(const T& value)
+    {
+        return ConstructLast(value) != nullptr;
+    }
+    bool InsertLast(T&& value)
+    {
+        return ConstructLast(std::move(value)) != nullptr;
+    }
+    // 실패하면 nullptr
+    template <typename... Args>
+    T* EmplaceLast(Args&&... args)
+    {
+        return ConstructLast(std::forward<Args>(args)...);
+    }
+    bool Insert(int32 index, const T& value)
+    {
+        return InsertRange(index, &value, 1);
+    }
+    // 뒤쪽 원소는 한 번에 count 칸씩 밀림, values 는 이 목록 안을 가리켜도 됨
+    bool InsertRange(int32 index, const T* values, int32 count)
+    {
+        if (index < 0 || index > list.count || count < 0) {
+            return false;
+        }
+        if (count == 0) {
+            return true;
+        }
+
+        // 늘리거나 밀면 values 가 옮겨지거나 풀리므로 따로 복사해 둔 것을 넣음
+        if (Overlaps(values, count)) {
+            TypedArrayList<T> copy;
+            if (!copy.Init(list.addrspace, (uint64)count)) {
+                return false;
+            }
+            auto result = copy.InsertRange(0, values, count) && InsertRange(index, copy.Data(), count);
+            copy.Destroy();
+            return result;
+        }
+
+        if (!Grow(count)) {
+            return false;
+        }
+
+        if (s_Trivial) {
+            return list.Insert(index, count, (void*)values, nullptr);
+        }
+
+        // 뒤에 붙인 뒤 제자리로 돌림
+        auto oldCount = list.count;
+        for (auto i = 0; i < count; i++) {
+            new (Data() + oldCount + i) T(values[i]);
+        }
+        list.count += count;
+        std::rotate(Data() + index, Data() + oldCount, Data() + list.count);
+        return true;
+    }
+
+    bool Remove(int32 index, int32 count = 1)
+    {
+        if (index < 0 || count < 0 || index + count > list.count) {
+            return false;
+        }
+
+        if (s_Trivial) {
+            return list.Remove(index, count);
+        }
+
+        std::move(Data() + index + count, Data() + list.count, Data() + index);
+        DestroyRange(list.count - count, list.count);
+        list.count -= count;
+        return true;
+    }
+    bool RemoveLast()
+    {
+        return Remove(list.count - 1, 1);
+    }
+    // 순서를 지키지 않고 마지막 원소를 옮겨와서 O(1) 로 지움
+    bool RemoveSwap(int32 index)
+    {
+        if (index < 0 || index >= list.count) {
+            return false;
+        }
+
+        auto last = list.count - 1;
+        if (index != last) {
+            Data()[index] = std::move(Data()[last]);
+        }
+        DestroyRange(last, list.count);
+        list.count--;
+        return true;
+    }
+    // pred 가 true 인 원소를 지우고 남은 원소의 순서는 유지, 지운 개수를 돌려줌
+    // 남는 원소가 이어진 구간마다 한 번씩만 옮김
+    template <typename Pred>
+    int32 EraseIf(Pred pred)
+    {
+        auto data = Data();
+        int32 write = 0, read = 0;
+        while (read < list.count) {
+            if (pred(data[read])) {
+                read++;
+                continue;
+            }
+
+            auto runStart = read;
+            while (read < list.count && !pred(data[read])) {
+                read++;
+            }
+            if (runStart != write) {
+                if (s_Trivial) {
+                    memmove((void*)(data + write), data + runStart, sizeof(T) * (read - runStart));
+                } else {
+                    std::move(data + runStart, data + read, data + write);
+                }
+            }
+            write += read - runStart;
+        }
+
+        auto removed = list.count - write;
+        DestroyRange(write, list.count);
+        list.count = write;
+        return removed;
+    }
+    void RemoveAll()
+    {
+        DestroyRange(0, list.count);
+        list.count = 0;
+    }
+
+public:
+    T& operator[](int32 index) { return Data()[index]; }
+    const T& operator[](int32 index) const { return Data()[index]; }
+    T* Data() { return (T*)list.singleChunkPtr; }
+    const T* Data() const { return (const T*)list.singleChunkPtr; }
+    T* begin() { return Data(); }
+    T* end() { return Data() + list.count; }
+    const T* begin() const { return Data(); }
+    const T* end() const { return Data() + list.count; }
+    T& Last() { return Data()[list.count - 1]; }
+
+    int32 Count() const { return list.count; }
+    uint64 Capacity() const { return list.capacity; }
+    bool Empty() const { return list.count == 0; }
+
+    ArrayList& Raw() { return list; }
+    const ArrayList& Raw() const { return list; }
+
+private:
+    void DestroyRange(int32 start, int32 end)
+    {
+        if (!std::is_trivially_destructible<T>::value) {
+            for (auto i = start; i < end; i++) {
+                Data()[i].~T();
+            }
+        }
+    }
+
+    bool Overlaps(const T* values, int32 count) const
+    {
+        auto begin = (size_t)list.singleChunkPtr;
+        auto end = begin + (size_t)(sizeof(T) * list.capacity);
+        return (size_t)values < end && (size_t)(values + count) > begin;
+    }
+
+    // 모자라면 두 배씩 늘림
+    uint64 GrowCapacity(int32 count) const
+    {
+        return std::max((uint64)list.count + (uint64)count, list.capacity * 2);
+    }
+    bool Grow(int32 count)
+    {
+        if ((uint64)list.count + (uint64)count <= list.capacity) {
+            return true;
+        }
+        return Relocate(GrowCapacity(count));
+    }
+
+    // 늘릴 때 이전 블록은 새 원소를 만든 뒤에 풀어서 args 가 원소를 가리켜도 읽을 수 있게 함
+    template <typename... Args>
+    T* ConstructLast(Args&&... args)
+    {
+        if ((uint64)list.count < list.capacity) {
+            auto p = new (Data() + list.count) T(std::forward<Args>(args)...);
+            list.count++;
+            return p;
+        }
+
+        if (s_Trivial) {
+            // memRealloc 이 이전 블록을 풀 수 있으므로 먼저 복사해 둠
+            T value(std::forward<Args>(args)...);
+            if (!list.ResizeMem(GrowCapacity(1))) {
+                return nullptr;
+            }
+            auto p = new (Data() + list.count) T(value);
+            list.count++;
+            return p;
+        }
+
+        auto capacity = GrowCapacity(1);
+        auto block = (T*)memAlloc(sizeof(T) * capacity, s_Alignment, 0, list.addrspace);
+        if (block == nullptr) {
+            return nullptr;
+        }
+        auto p = new (block + list.count) T(std::forward<Args>(args)...);
+        MoveTo(block, capacity);
+        list.count++;
+        return p;
+    }
+
+    bool Relocate(uint64 capacity)
+    {
+        if (s_Trivial) {
+            return list.ResizeMem(capacity);
+        }
+
+        auto block = (T*)memAlloc(sizeof(T) * capacity, s_Alignment, 0, list.addrspace);
+        if (block == nullptr) {
+            return false;
+        }
+        MoveTo(block, capacity);
+        return true;
+    }
+
+    // memRealloc 은 바이트 복사로 옮기므로 새 블록에 이동 생성하고 이전 블록을 풂
+    void MoveTo(T* block, uint64 capacity)
+    {
+        for (auto i = 0; i < list.count; i++) {
+            new (block + i) T(std::move(Data()[i]));
+            Data()[i].~T();
+        }
+        memFree(list.singleChunkPtr, list.addrspace);
+        list.singleChunkPtr = block;
+        list.capacity = capacity;
+    }
+
+private:
+    ArrayList list;
+
+    static constexpr bool s_Trivial = std::is_trivially_copyable<T>::value;
+    static constexpr int32 s_Alignment =
+        alignof(T) > ArrayList::s_DefaultAlignment? (int32)alignof(T): (int32)ArrayList::s_DefaultAlignment;
+};
@@ -11,6 +11,10 @@ void* SystemAlignedAlloc(size_t size, size_t alignment, size_t alignmentOffset,
 void SystemDealloc(void* p, unsigned debugFlags, const char* file, int line);
 void SystemAlignedDealloc(void* p, unsigned debugFlags, const char* file, int line);
 
+// EASTL 할당 기록, 파일 형식은 Common/memtrace.h 와 같음
+bool AllocTraceBegin(const char* path);
+bool AllocTraceEnd();
+
 #define EASTL_SYSTEM_NAME ""
 #define EASTL_PERSISTANT_NAME "persitant"
 #define EASTL_BIG_PERSISTANT_NAME "persitant"
@@ -1,4 +1,8 @@
 #include <string.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 
 #include "defined_macro.h"
 #include "defined_alloc_macro.h"
@@ -266,6 +270,162 @@ AllocatorEntry* FindEntry(const char* name)
 
 const size_t MinPageSize = 16 * 1024 * 1024;
 
+// Common/memtrace.h 의 MemTraceRecord 와 같은 배치, Framework 는 Common 을 링크하지 않아서 따로 씀
+struct AllocTraceRecord
+{
+	unsigned long long time;
+	unsigned long long pointer;
+	unsigned long long size;
+	unsigned short space;
+	unsigned char op;
+	unsigned char alignShift;
+	unsigned short thread;
+	unsigned short alignOffset;
+};
+static_assert(sizeof(AllocTraceRecord) == 32, "AllocTraceRecord must match MemTraceRecord");
+
+const unsigned AllocTraceMagic = 0x4352544D;
+const unsigned AllocTraceVersion = 1;
+const unsigned char AllocTraceOpAlloc = 0;
+const unsigned char AllocTraceOpFree = 1;
+const unsigned char AllocTraceOpSpace = 2;
+const size_t AllocTraceBufferCount = 4096;
+
+// g_TraceFile 은 g_TraceLock 을 잡고만 읽고 씀, 락 밖에서는 g_TraceEnabled 만 봄
+std::mutex g_TraceLock;
+std::atomic<bool> g_TraceEnabled(false);
+FILE* g_TraceFile = nullptr;
+std::chrono::steady_clock::time_point g_TraceStart;
+AllocTraceRecord g_TraceRecords[AllocTraceBufferCount];
+size_t g_TraceCount = 0;
+bool g_TraceSpaces[AllocEntryCount];
+// 레코드의 thread, 스레드가 처음 기록할 때 번호를 받음
+std::atomic<unsigned short> g_TraceThreadCount(0);
+thread_local int t_TraceThread = -1;
+
+unsigned short TraceThread()
+{
+	if (t_TraceThread < 0)
+		t_TraceThread = g_TraceThreadCount.fetch_add(1, std::memory_order_relaxed);
+	return (unsigned short)t_TraceThread;
+}
+
+AllocTraceRecord MakeTraceRecord(unsigned char op, unsigned short space, void* p, size_t size, size_t alignment, size_t alignmentOffset)
+{
+	AllocTraceRecord record;
+	record.time = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_TraceStart).count();
+	record.pointer = (unsigned long long)p;
+	record.size = size;
+	record.space = space;
+	record.op = op;
+	record.alignShift = 0;
+	while (((size_t)1 << record.alignShift) < alignment && record.alignShift < 63)
+		record.alignShift++;
+	record.thread = TraceThread();
+	record.alignOffset = alignmentOffset < 0xFFFF ? (unsigned short)alignmentOffset : 0xFFFF;
+	return record;
+}
+// g_TraceLock 을 잡고 호출
+void FlushTrace()
+{
+	fwrite(g_TraceRecords, sizeof(AllocTraceRecord), g_TraceCount, g_TraceFile);
+	g_TraceCount = 0;
+}
+void AppendTrace(const AllocTraceRecord& record)
+{
+	g_TraceRecords[g_TraceCount++] = record;
+	if (g_TraceCount == AllocTraceBufferCount)
+		FlushTrace();
+}
+
+bool AllocTraceBegin(const char* path)
+{
+	std::lock_guard<std::mutex> guard(g_TraceLock);
+
+	if (g_TraceFile != nullptr || path == nullptr)
+		return false;
+	if (fopen_s(&g_TraceFile, path, "wb") != 0)
+	{
+		g_TraceFile = nullptr;
+		return false;
+	}
+
+	unsigned header[2] = { AllocTraceMagic, AllocTraceVersion };
+	fwrite(header, sizeof(header), 1, g_TraceFile);
+
+	g_TraceStart = std::chrono::steady_clock::now();
+	g_TraceCount = 0;
+	memset(g_TraceSpaces, 0, sizeof(g_TraceSpaces));
+	g_TraceEnabled.store(true, std::memory_order_release);
+	return true;
+}
+bool AllocTraceEnd()
+{
+	g_TraceEnabled.store(false, std::memory_order_release);
+
+	std::lock_guard<std::mutex> guard(g_TraceLock);
+
+	if (g_TraceFile == nullptr)
+		return false;
+
+	FlushTrace();
+
+	bool result = fclose(g_TraceFile) == 0;
+	g_TraceFile = nullptr;
+	return result;
+}
+
+void TraceAlloc(AllocatorEntry* entry, void* p, size_t size, size_t alignment, size_t alignmentOffset)
+{
+	if (!g_TraceEnabled.load(std::memory_order_acquire) || p == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> guard(g_TraceLock);
+
+	if (g_TraceFile == nullptr)
+		return;
+
+	unsigned short space = 0;
+	if (entry != nullptr)
+	{
+		space = (unsigned short)(entry - g_Entries + 1);
+
+		// 처음 쓰는 주소 공간이면 이름을 같이 남김
+		if (!g_TraceSpaces[space - 1])
+		{
+			g_TraceSpaces[space - 1] = true;
+
+			unsigned short name[256];
+			unsigned short nameLength = 0;
+			while (nameLength < 255 && entry->name[nameLength] != '\0')
+			{
+				name[nameLength] = (unsigned char)entry->name[nameLength];
+				nameLength++;
+			}
+
+			// 이름이 레코드 바로 뒤에 와야 하므로 모아둔 레코드를 먼저 씀
+			FlushTrace();
+			AllocTraceRecord record = MakeTraceRecord(AllocTraceOpSpace, space, nullptr, entry->min_page_size, 0, nameLength);
+			fwrite(&record, sizeof(record), 1, g_TraceFile);
+			fwrite(name, sizeof(unsigned short), nameLength, g_TraceFile);
+		}
+	}
+
+	AppendTrace(MakeTraceRecord(AllocTraceOpAlloc, space, p, size, alignment, alignmentOffset));
+}
+void TraceFree(AllocatorEntry* entry, void* p)
+{
+	if (!g_TraceEnabled.load(std::memory_order_acquire) || p == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> guard(g_TraceLock);
+
+	if (g_TraceFile == nullptr)
+		return;
+
+	AppendTrace(MakeTraceRecord(AllocTraceOpFree, entry != nullptr ? (unsigned short)(entry - g_Entries + 1) : 0, p, 0, 0, 0));
+}
+
 void* operator new[](size_t size, const char* pName, int flags, unsigned debugFlags, const char* file, int line)
 {
 	return ::new (EASTL_ALLOCATOR_MIN_ALIGNMENT, 0, pName, flags, debugFlags, file, line) char[size];
@@ -285,7 +445,11 @@ void* operator new[](size_t size, const char* pName, const char* file, int line)
 void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, const char* pName, int flags, unsigned debugFlags, const char* file, int line)
 {
 	if (pName == nullptr || pName[0] == '\0')
-		return SystemAlignedAlloc(size, alignment, alignmentOffset, debugFlags, file, line);
+	{
+		void* p = SystemAlignedAlloc(size, alignment, alignmentOffset, debugFlags, file, line);
+		TraceAlloc(nullptr, p, size, alignment, alignmentOffset);
+		return p;
+	}
 
 	AllocatorEntry* entry = FindEntry(pName);
 
@@ -302,7 +466,9 @@ void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, cons
 		entry = g_Entries + index;
 	}
 
-	return entry->allocate(size, alignment, alignmentOffset, flags);
+	void* p = entry->allocate(size, alignment, alignmentOffset, flags);
+	TraceAlloc(entry, p, size, alignment, alignmentOffset);
+	return p;
 }
 
 void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, const char* pName, const char* file, int line)
@@ -322,6 +488,7 @@ void operator delete[](void* p, const char* pName, int flags, unsigned debugFlag
 {
 	if (pName == nullptr || pName[0] == '\0')
 	{
+		TraceFree(nullptr, p);
 		SystemAlignedDealloc(p, debugFlags, file, line);
 		return;
 	}
@@ -341,6 +508,7 @@ void operator delete[](void* p, const char* pName, int flags, unsigned debugFlag
 		entry = g_Entries + index;
 	}
 
+	TraceFree(entry, p);
 	entry->deallocate(p, 0);
 }
 
@@ -360,6 +528,7 @@ void operator delete[](void* p, unsigned align, const char* pName, int flags, un
 {
 	if (pName == nullptr || pName[0] == '\0')
 	{
+		TraceFree(nullptr, p);
 		SystemDealloc(p, debugFlags, file, line);
 		return;
 	}
@@ -379,6 +548,7 @@ void operator delete[](void* p, unsigned align, const char* pName, int flags, un
 		entry = g_Entries + index;
 	}
 
+	TraceFree(entry, p);
 	entry->deallocate(p, 0);
 }
 void operator delete[](void* p, unsigned align, const char* pName, const char* file, int line)
@@ -1 +1,945 @@
 #include "bvh.h"
+
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+
+#define BVH_MAX_BIN_COUNT 64
+#define BVH_MAX_LEAF_SIZE 255
+// below this depth splits fall back to the median so the traversal stack can not overflow
+#define BVH_MEDIAN_SPLIT_DEPTH (BVH_MAX_DEPTH / 2)
+
+#define BVH_TRIANGLE_STRIDE 9
+#define BVH_BOUNDS_STRIDE 6
+
+// MSVC takes AVX intrinsics anywhere and the CPU is checked at run time, other compilers need -mavx2
+#if defined(_MSC_VER) || defined(__AVX2__)
+#define BVH_PACKET_AVX2
+#endif
+
+struct BVHBuildContext
+{
+    // min xyz, max xyz per primitive
+    const float* bounds;
+    const float* centroids;
+    uint32* indices;
+    // every subtree of n primitives owns 2n - 1 nodes right after its root, compacted after the build
+    BVHNode* nodes;
+    uint32 binCount;
+    uint32 maxLeafSize;
+    uint32 parallelThreshold;
+    float traversalCost;
+    float intersectCost;
+
+    std::atomic<int32> idleThreads;
+    std::atomic<uint32> depth;
+};
+
+struct BVHBin
+{
+    float min[3];
+    float max[3];
+    uint32 count;
+};
+
+static void ResetBox(float* min, float* max)
+{
+    for (auto i = 0; i < 3; i++) {
+        min[i] = FLT_MAX;
+        max[i] = -FLT_MAX;
+    }
+}
+
+static void GrowBox(float* min, float* max, const float* otherMin, const float* otherMax)
+{
+    for (auto i = 0; i < 3; i++) {
+        min[i] = std::min(min[i], otherMin[i]);
+        max[i] = std::max(max[i], otherMax[i]);
+    }
+}
+
+static float HalfArea(const float* min, const float* max)
+{
+    auto dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+    return dx < 0? 0: dx * dy + dy * dz + dz * dx;
+}
+
+static void MakeLeaf(BVHNode& node, uint32 begin, uint32 count)
+{
+    node.offset = begin;
+    node.primitiveCount = (uint16)count;
+    node.axis = 0;
+}
+
+// returns the first index of the right half, or begin if the SAH prefers a leaf
+static uint32 SplitSAH(BVHBuildContext* ctx, uint32 begin, uint32 end, const float* nodeMin, const float* nodeMax,
+    const float* centroidMin, const float* centroidMax, uint32* splitAxis)
+{
+    auto count = end - begin;
+    auto binCount = ctx->binCount;
+    BVHBin bins[3][BVH_MAX_BIN_COUNT];
+    float scale[3];
+    for (auto axis = 0; axis < 3; axis++) {
+        auto extent = centroidMax[axis] - centroidMin[axis];
+        scale[axis] = extent > 0? binCount * (1 - 1e-5f) / extent: 0;
+        for (uint32 b = 0; b < binCount; b++) {
+            ResetBox(bins[axis][b].min, bins[axis][b].max);
+            bins[axis][b].count = 0;
+        }
+    }
+
+    for (auto i = begin; i < end; i++) {
+        auto primitive = ctx->indices[i];
+        auto centroid = ctx->centroids + primitive * 3;
+        auto box = ctx->bounds + primitive * 6;
+        for (auto axis = 0; axis < 3; axis++) {
+            auto b = (uint32)((centroid[axis] - centroidMin[axis]) * scale[axis]);
+            b = std::min(b, binCount - 1);
+            GrowBox(bins[axis][b].min, bins[axis][b].max, box, box + 3);
+            bins[axis][b].count++;
+        }
+    }
+
+    // sweep from the right to get the cost of every right half, then from the left
+    auto bestCost = FLT_MAX;
+    uint32 bestAxis = 0, bestBin = 0;
+    for (auto axis = 0; axis < 3; axis++) {
+        if (scale[axis] == 0) {
+            continue;
+        }
+
+        float rightArea[BVH_MAX_BIN_COUNT];
+        uint32 rightCount[BVH_MAX_BIN_COUNT];
+        float min[3], max[3];
+        ResetBox(min, max);
+        uint32 n = 0;
+        for (auto b = binCount - 1; b > 0; b--) {
+            GrowBox(min, max, bins[axis][b].min, bins[axis][b].max);
+            n += bins[axis][b].count;
+            rightArea[b] = HalfArea(min, max);
+            rightCount[b] = n;
+        }
+
+        ResetBox(min, max);
+        n = 0;
+        for (uint32 b = 0; b + 1 < binCount; b++) {
+            GrowBox(min, max, bins[axis][b].min, bins[axis][b].max);
+            n += bins[axis][b].count;
+            if (n == 0 || rightCount[b + 1] == 0) {
+                continue;
+            }
+            auto cost = HalfArea(min, max) * n + rightArea[b + 1] * rightCount[b + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+
+    if (bestCost == FLT_MAX) {
+        return begin;
+    }
+
+    auto area = HalfArea(nodeMin, nodeMax);
+    auto splitCost = ctx->traversalCost + ctx->intersectCost * (area > 0? bestCost / area: (float)count);
+    auto leafCost = ctx->intersectCost * count;
+    if (count <= ctx->maxLeafSize && leafCost <= splitCost) {
+        return begin;
+    }
+
+    auto axisMin = centroidMin[bestAxis], axisScale = scale[bestAxis];
+    auto centroids = ctx->centroids;
+    auto middle = std::partition(ctx->indices + begin, ctx->indices + end, [=](uint32 primitive) {
+        auto b = std::min((uint32)((centroids[primitive * 3 + bestAxis] - axisMin) * axisScale), binCount - 1);
+        return b <= bestBin;
+    });
+    *splitAxis = bestAxis;
+    return (uint32)(middle - ctx->indices);
+}
+
+static uint32 SplitMedian(BVHBuildContext* ctx, uint32 begin, uint32 end, const float* centroidMin, const float* centroidMax, uint32* splitAxis)
+{
+    uint32 axis = 0;
+    for (uint32 i = 1; i < 3; i++) {
+        if (centroidMax[i] - centroidMin[i] > centroidMax[axis] - centroidMin[axis]) {
+            axis = i;
+        }
+    }
+
+    auto middle = begin + (end - begin) / 2;
+    auto centroids = ctx->centroids;
+    std::nth_element(ctx->indices + begin, ctx->indices + middle, ctx->indices + end, [=](uint32 a, uint32 b) {
+        return centroids[a * 3 + axis] < centroids[b * 3 + axis];
+    });
+    *splitAxis = axis;
+    return middle;
+}
+
+static void BuildRange(BVHBuildContext* ctx, uint32 nodeIndex, uint32 begin, uint32 end, uint32 depth)
+{
+    auto& node = ctx->nodes[nodeIndex];
+    auto count = end - begin;
+
+    float centroidMin[3], centroidMax[3];
+    ResetBox(node.min, node.max);
+    ResetBox(centroidMin, centroidMax);
+    for (auto i = begin; i < end; i++) {
+        auto primitive = ctx->indices[i];
+        auto box = ctx->bounds + primitive * 6;
+        auto centroid = ctx->centroids + primitive * 3;
+        GrowBox(node.min, node.max, box, box + 3);
+        GrowBox(centroidMin, centroidMax, centroid, centroid);
+    }
+    node.padding = 0;
+
+    auto previousDepth = ctx->depth.load(std::memory_order_relaxed);
+    while (previousDepth < depth + 1 && !ctx->depth.compare_exchange_weak(previousDepth, depth + 1, std::memory_order_relaxed)) {
+    }
+
+    if (count == 1) {
+        MakeLeaf(node, begin, count);
+        return;
+    }
+
+    uint32 axis = 0;
+    auto middle = begin;
+    if (depth < BVH_MEDIAN_SPLIT_DEPTH) {
+        middle = SplitSAH(ctx, begin, end, node.min, node.max, centroidMin, centroidMax, &axis);
+        if (middle == begin && count <= ctx->maxLeafSize) {
+            MakeLeaf(node, begin, count);
+            return;
+        }
+    } else if (count <= ctx->maxLeafSize) {
+        MakeLeaf(node, begin, count);
+        return;
+    }
+    // every centroid fell in one bin, or too deep for SAH
+    if (middle == begin || middle == end) {
+        middle = SplitMedian(ctx, begin, end, centroidMin, centroidMax, &axis);
+    }
+
+    auto leftCount = middle - begin, rightCount = end - middle;
+    auto left = nodeIndex + 1, right = nodeIndex + 2 * leftCount;
+    node.offset = right;
+    node.primitiveCount = 0;
+    node.axis = (uint8)axis;
+
+    // hand the left subtree to another thread while this one builds the right
+    auto threshold = ctx->parallelThreshold;
+    if (leftCount >= threshold && rightCount >= threshold && ctx->idleThreads.fetch_sub(1, std::memory_order_acq_rel) > 0) {
+        std::thread worker(BuildRange, ctx, left, begin, middle, depth + 1);
+        BuildRange(ctx, right, middle, end, depth + 1);
+        worker.join();
+        ctx->idleThreads.fetch_add(1, std::memory_order_acq_rel);
+        return;
+    }
+    if (leftCount >= threshold && rightCount >= threshold) {
+        ctx->idleThreads.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    BuildRange(ctx, left, begin, middle, depth + 1);
+    BuildRange(ctx, right, middle, end, depth + 1);
+}
+
+// copies the subtree in depth-first order without the unused nodes and returns its new index
+static uint32 Flatten(const BVHNode* scratch, uint32 scratchIndex, BVHNode* nodes, uint32* nodeCount)
+{
+    auto index = (*nodeCount)++;
+    nodes[index] = scratch[scratchIndex];
+    if (scratch[scratchIndex].primitiveCount == 0) {
+        Flatten(scratch, scratchIndex + 1, nodes, nodeCount);
+        nodes[index].offset = Flatten(scratch, scratch[scratchIndex].offset, nodes, nodeCount);
+    }
+    return index;
+}
+
+static uint32 CountNodes(const BVHNode* scratch, uint32 scratchIndex)
+{
+    if (scratch[scratchIndex].primitiveCount > 0) {
+        return 1;
+    }
+    return 1 + CountNodes(scratch, scratchIndex + 1) + CountNodes(scratch, scratch[scratchIndex].offset);
+}
+
+BVHBuildOption::BVHBuildOption() :
+    binCount(16), maxLeafSize(4), threadCount(0), parallelThreshold(4096), traversalCost(1.f), intersectCost(1.f)
+{ }
+
+BVH::BVH() :
+    type(BVHPrimitiveType::None), nodes(nullptr), nodeCount(0), depth(0),
+    primitiveIndices(nullptr), primitiveCount(0), primitives(nullptr)
+{ }
+
+BVH::~BVH()
+{
+    Clear();
+}
+
+void BVH::Clear()
+{
+    delete[] nodes;
+    delete[] primitiveIndices;
+    delete[] primitives;
+    nodes = nullptr;
+    primitiveIndices = nullptr;
+    primitives = nullptr;
+    nodeCount = 0;
+    primitiveCount = 0;
+    depth = 0;
+    type = BVHPrimitiveType::None;
+}
+
+bool BVH::Build(const Vector3f* positions, uint32 vertexCount, const uint32* indices, uint32 indexCount, const BVHBuildOption* option)
+{
+    Clear();
+
+    auto count = indexCount / 3;
+    if (positions == nullptr || count == 0 || (indices == nullptr && indexCount > vertexCount)) {
+        return false;
+    }
+
+    std::vector<float> triangles((size_t)count * BVH_TRIANGLE_STRIDE);
+    std::vector<float> bounds((size_t)count * 6);
+    for (uint32 i = 0; i < count; i++) {
+        uint32 v[3] = { i * 3, i * 3 + 1, i * 3 + 2 };
+        if (indices != nullptr) {
+            for (auto k = 0; k < 3; k++) {
+                v[k] = indices[i * 3 + k];
+                if (v[k] >= vertexCount) {
+                    return false;
+                }
+            }
+        }
+
+        const Vector3f& p0 = positions[v[0]];
+        const Vector3f& p1 = positions[v[1]];
+        const Vector3f& p2 = positions[v[2]];
+        auto triangle = triangles.data() + (size_t)i * BVH_TRIANGLE_STRIDE;
+        auto box = bounds.data() + (size_t)i * 6;
+        for (auto k = 0; k < 3; k++) {
+            triangle[k] = p0[k];
+            triangle[3 + k] = p1[k] - p0[k];
+            triangle[6 + k] = p2[k] - p0[k];
+            box[k] = std::min(std::min(p0[k], p1[k]), p2[k]);
+            box[3 + k] = std::max(std::max(p0[k], p1[k]), p2[k]);
+        }
+    }
+
+    if (!BuildTree(bounds.data(), count, option)) {
+        return false;
+    }
+
+    primitives = new float[(size_t)count * BVH_TRIANGLE_STRIDE];
+    for (uint32 i = 0; i < count; i++) {
+        memcpy(primitives + (size_t)i * BVH_TRIANGLE_STRIDE, triangles.data() + (size_t)primitiveIndices[i] * BVH_TRIANGLE_STRIDE,
+            sizeof(float) * BVH_TRIANGLE_STRIDE);
+    }
+    type = BVHPrimitiveType::Triangle;
+    return true;
+}
+
+bool BVH::Build(const Bounds* boundsList, uint32 count, const BVHBuildOption* option)
+{
+    Clear();
+
+    if (boundsList == nullptr || count == 0) {
+        return false;
+    }
+
+    std::vector<float> bounds((size_t)count * 6);
+    for (uint32 i = 0; i < count; i++) {
+        auto box = bounds.data() + (size_t)i * 6;
+        for (auto k = 0; k < 3; k++) {
+            box[k] = boundsList[i].center[k] - boundsList[i].extents[k];
+            box[3 + k] = boundsList[i].center[k] + boundsList[i].extents[k];
+        }
+    }
+
+    if (!BuildTree(bounds.data(), count, option)) {
+        return false;
+    }
+
+    primitives = new float[(size_t)count * BVH_BOUNDS_STRIDE];
+    for (uint32 i = 0; i < count; i++) {
+        memcpy(primitives + (size_t)i * BVH_BOUNDS_STRIDE, bounds.data() + (size_t)primitiveIndices[i] * 6, sizeof(float) * 6);
+    }
+    type = BVHPrimitiveType::Bounds;
+    return true;
+}
+
+bool BVH::BuildTree(const float* bounds, uint32 count, const BVHBuildOption* option)
+{
+    BVHBuildOption defaultOption;
+    if (option == nullptr) {
+        option = &defaultOption;
+    }
+    if (option->binCount < 2 || option->binCount > BVH_MAX_BIN_COUNT ||
+        option->maxLeafSize == 0 || option->maxLeafSize > BVH_MAX_LEAF_SIZE) {
+        return false;
+    }
+
+    std::vector<float> centroids((size_t)count * 3);
+    for (uint32 i = 0; i < count; i++) {
+        for (auto k = 0; k < 3; k++) {
+            centroids[(size_t)i * 3 + k] = (bounds[(size_t)i * 6 + k] + bounds[(size_t)i * 6 + 3 + k]) * 0.5f;
+        }
+    }
+
+    primitiveIndices = new uint32[count];
+    for (uint32 i = 0; i < count; i++) {
+        primitiveIndices[i] = i;
+    }
+    std::vector<BVHNode> scratch((size_t)count * 2 - 1);
+
+    auto threadCount = option->threadCount > 0? option->threadCount: std::max(std::thread::hardware_concurrency(), 1u);
+    BVHBuildContext ctx;
+    ctx.bounds = bounds;
+    ctx.centroids = centroids.data();
+    ctx.indices = primitiveIndices;
+    ctx.nodes = scratch.data();
+    ctx.binCount = option->binCount;
+    ctx.maxLeafSize = option->maxLeafSize;
+    ctx.parallelThreshold = std::max(option->parallelThreshold, 2u);
+    ctx.traversalCost = option->traversalCost;
+    ctx.intersectCost = option->intersectCost;
+    ctx.idleThreads.store((int32)threadCount - 1);
+    ctx.depth.store(0);
+    BuildRange(&ctx, 0, 0, count, 0);
+
+    nodeCount = CountNodes(scratch.data(), 0);
+    nodes = new BVHNode[nodeCount];
+    uint32 written = 0;
+    Flatten(scratch.data(), 0, nodes, &written);
+
+    primitiveCount = count;
+    depth = ctx.depth.load();
+    return true;
+}
+
+// slab test against the node box, entry distance in tNear
+static bool IntersectBox(const float* min, const float* max, const float* origin, const float* invDir, float tMax, float* tNear)
+{
+    auto t0 = 0.f, t1 = tMax;
+    for (auto k = 0; k < 3; k++) {
+        auto ta = (min[k] - origin[k]) * invDir[k];
+        auto tb = (max[k] - origin[k]) * invDir[k];
+        // min/max in this order drop the NaN of a ray lying on the slab plane
+        t0 = std::max(t0, std::min(ta, tb));
+        t1 = std::min(t1, std::max(ta, tb));
+    }
+    *tNear = t0;
+    return t0 <= t1;
+}
+
+// Moller-Trumbore against v0, e1, e2
+static bool IntersectTriangle(const float* triangle, const float* origin, const float* dir, float tMax, float* t, float* u, float* v)
+{
+    auto e1 = triangle + 3, e2 = triangle + 6;
+    float p[3] = {
+        dir[1] * e2[2] - dir[2] * e2[1],
+        dir[2] * e2[0] - dir[0] * e2[2],
+        dir[0] * e2[1] - dir[1] * e2[0],
+    };
+    auto det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if (det > -1e-12f && det < 1e-12f) {
+        return false;
+    }
+
+    auto invDet = 1.f / det;
+    float s[3] = { origin[0] - triangle[0], origin[1] - triangle[1], origin[2] - triangle[2] };
+    auto bu = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+    if (bu < 0.f || bu > 1.f) {
+        return false;
+    }
+
+    float q[3] = {
+        s[1] * e1[2] - s[2] * e1[1],
+        s[2] * e1[0] - s[0] * e1[2],
+        s[0] * e1[1] - s[1] * e1[0],
+    };
+    auto bv = (dir[0] * q[0] + dir[1] * q[1] + dir[2] * q[2]) * invDet;
+    if (bv < 0.f || bu + bv > 1.f) {
+        return false;
+    }
+
+    auto tHit = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invDet;
+    if (tHit < 0.f || tHit > tMax) {
+        return false;
+    }
+    *t = tHit;
+    *u = bu;
+    *v = bv;
+    return true;
+}
+
+bool BVH::Intersect(const Ray& ray, float tMax, BVHHit& hit) const
+{
+    if (nodeCount == 0) {
+        return false;
+    }
+
+    float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+    float dir[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+    float invDir[3] = { 1.f / dir[0], 1.f / dir[1], 1.f / dir[2] };
+    bool negative[3] = { dir[0] < 0, dir[1] < 0, dir[2] < 0 };
+
+    auto found = false;
+    auto closest = tMax;
+    uint32 stack[BVH_MAX_DEPTH];
+    uint32 stackSize = 0, index = 0;
+    for (;;) {
+        auto& node = nodes[index];
+        float tNear;
+        if (IntersectBox(node.min, node.max, origin, invDir, closest, &tNear)) {
+            if (node.primitiveCount == 0) {
+                // near child first, the far one waits on the stack
+                if (negative[node.axis]) {
+                    stack[stackSize++] = index + 1;
+                    index = node.offset;
+                } else {
+                    stack[stackSize++] = node.offset;
+                    index = index + 1;
+                }
+                continue;
+            }
+
+            for (uint32 i = node.offset; i < node.offset + node.primitiveCount; i++) {
+                float t, u = 0.f, v = 0.f;
+                bool intersected;
+                if (type == BVHPrimitiveType::Triangle) {
+                    intersected = IntersectTriangle(primitives + (size_t)i * BVH_TRIANGLE_STRIDE, origin, dir, closest, &t, &u, &v);
+                } else {
+                    auto box = primitives + (size_t)i * BVH_BOUNDS_STRIDE;
+                    intersected = IntersectBox(box, box + 3, origin, invDir, closest, &t);
+                }
+                if (intersected) {
+                    found = true;
+                    closest = t;
+                    hit.t = t;
+                    hit.u = u;
+                    hit.v = v;
+                    hit.primitive = primitiveIndices[i];
+                }
+            }
+        }
+
+        if (stackSize == 0) {
+            break;
+        }
+        index = stack[--stackSize];
+    }
+    return found;
+}
+
+bool BVH::IntersectAny(const Ray& ray, float tMax) const
+{
+    if (nodeCount == 0) {
+        return false;
+    }
+
+    float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+    float dir[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+    float invDir[3] = { 1.f / dir[0], 1.f / dir[1], 1.f / dir[2] };
+
+    uint32 stack[BVH_MAX_DEPTH];
+    uint32 stackSize = 0, index = 0;
+    for (;;) {
+        auto& node = nodes[index];
+        float tNear;
+        if (IntersectBox(node.min, node.max, origin, invDir, tMax, &tNear)) {
+            if (node.primitiveCount == 0) {
+                stack[stackSize++] = node.offset;
+                index = index + 1;
+                continue;
+            }
+
+            for (uint32 i = node.offset; i < node.offset + node.primitiveCount; i++) {
+                float t, u, v;
+                if (type == BVHPrimitiveType::Triangle) {
+                    if (IntersectTriangle(primitives + (size_t)i * BVH_TRIANGLE_STRIDE, origin, dir, tMax, &t, &u, &v)) {
+                        return true;
+                    }
+                } else {
+                    auto box = primitives + (size_t)i * BVH_BOUNDS_STRIDE;
+                    if (IntersectBox(box, box + 3, origin, invDir, tMax, &t)) {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        if (stackSize == 0) {
+            return false;
+        }
+        index = stack[--stackSize];
+    }
+}
+
+static bool Overlaps(const float* min, const float* max, const float* otherMin, const float* otherMax)
+{
+    return min[0] <= otherMax[0] && max[0] >= otherMin[0] &&
+        min[1] <= otherMax[1] && max[1] >= otherMin[1] &&
+        min[2] <= otherMax[2] && max[2] >= otherMin[2];
+}
+
+uint32 BVH::Overlap(const Bounds& bounds, uint32* result, uint32 capacity) const
+{
+    if (nodeCount == 0) {
+        return 0;
+    }
+
+    float queryMin[3], queryMax[3];
+    for (auto k = 0; k < 3; k++) {
+        queryMin[k] = bounds.center[k] - bounds.extents[k];
+        queryMax[k] = bounds.center[k] + bounds.extents[k];
+    }
+
+    uint32 found = 0;
+    uint32 stack[BVH_MAX_DEPTH];
+    uint32 stackSize = 0, index = 0;
+    for (;;) {
+        auto& node = nodes[index];
+        if (Overlaps(node.min, node.max, queryMin, queryMax)) {
+            if (node.primitiveCount == 0) {
+                stack[stackSize++] = node.offset;
+                index = index + 1;
+                continue;
+            }
+
+            for (uint32 i = node.offset; i < node.offset + node.primitiveCount; i++) {
+                float min[3], max[3];
+                if (type == BVHPrimitiveType::Triangle) {
+                    auto triangle = primitives + (size_t)i * BVH_TRIANGLE_STRIDE;
+                    for (auto k = 0; k < 3; k++) {
+                        auto p1 = triangle[k] + triangle[3 + k], p2 = triangle[k] + triangle[6 + k];
+                        min[k] = std::min(std::min(triangle[k], p1), p2);
+                        max[k] = std::max(std::max(triangle[k], p1), p2);
+                    }
+                } else {
+                    memcpy(min, primitives + (size_t)i * BVH_BOUNDS_STRIDE, sizeof(min));
+                    memcpy(max, primitives + (size_t)i * BVH_BOUNDS_STRIDE + 3, sizeof(max));
+                }
+                if (Overlaps(min, max, queryMin, queryMax)) {
+                    if (found < capacity && result != nullptr) {
+                        result[found] = primitiveIndices[i];
+                    }
+                    found++;
+                }
+            }
+        }
+
+        if (stackSize == 0) {
+            return found;
+        }
+        index = stack[--stackSize];
+    }
+}
+
+// packet traversal, one node stack shared by 4 (SSE) or 8 (AVX2) rays stored as structure of arrays
+// the same kernel is instantiated for both widths through these wrappers
+
+struct BVHPacketSSE
+{
+    typedef __m128 Float;
+    static const uint32 s_Width = 4;
+
+    static Float Set1(float f) { return _mm_set1_ps(f); }
+    static Float Bits(uint32 u) { return _mm_castsi128_ps(_mm_set1_epi32((int)u)); }
+    static Float Load(const float* p) { return _mm_load_ps(p); }
+    static void Store(float* p, Float a) { _mm_store_ps(p, a); }
+    static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+    static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+    static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+    static Float Div(Float a, Float b) { return _mm_div_ps(a, b); }
+    static Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+    static Float Max(Float a, Float b) { return _mm_max_ps(a, b); }
+    static Float LessEqual(Float a, Float b) { return _mm_cmple_ps(a, b); }
+    static Float GreaterEqual(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+    static Float And(Float a, Float b) { return _mm_and_ps(a, b); }
+    static Float Abs(Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+    // mask ? b : a, SSE2 has no blendv
+    static Float Select(Float a, Float b, Float mask) { return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(mask, b)); }
+    static int32 Mask(Float mask) { return _mm_movemask_ps(mask); }
+};
+
+#ifdef BVH_PACKET_AVX2
+struct BVHPacketAVX2
+{
+    typedef __m256 Float;
+    static const uint32 s_Width = 8;
+
+    static Float Set1(float f) { return _mm256_set1_ps(f); }
+    static Float Bits(uint32 u) { return _mm256_castsi256_ps(_mm256_set1_epi32((int)u)); }
+    static Float Load(const float* p) { return _mm256_load_ps(p); }
+    static void Store(float* p, Float a) { _mm256_store_ps(p, a); }
+    static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+    static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    static Float Div(Float a, Float b) { return _mm256_div_ps(a, b); }
+    static Float Min(Float a, Float b) { return _mm256_min_ps(a, b); }
+    static Float Max(Float a, Float b) { return _mm256_max_ps(a, b); }
+    static Float LessEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static Float GreaterEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static Float And(Float a, Float b) { return _mm256_and_ps(a, b); }
+    static Float Abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+    static Float Select(Float a, Float b, Float mask) { return _mm256_blendv_ps(a, b, mask); }
+    static int32 Mask(Float mask) { return _mm256_movemask_ps(mask); }
+};
+#endif
+
+static bool SupportsAVX2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // the OS has to save the ymm registers too
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(BVH_PACKET_AVX2)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+// slab test for every lane, the NaN of a lane lying on a slab plane is dropped by putting it first in min/max
+template <typename Ops>
+static typename Ops::Float IntersectBoxPacket(
+    const float* min, const float* max, const typename Ops::Float* origin, const typename Ops::Float* invDir,
+    typename Ops::Float tMax, typename Ops::Float* tNear)
+{
+    auto t0 = Ops::Set1(0.f), t1 = tMax;
+    for (auto k = 0; k < 3; k++) {
+        auto ta = Ops::Mul(Ops::Sub(Ops::Set1(min[k]), origin[k]), invDir[k]);
+        auto tb = Ops::Mul(Ops::Sub(Ops::Set1(max[k]), origin[k]), invDir[k]);
+        t0 = Ops::Max(Ops::Min(ta, tb), t0);
+        t1 = Ops::Min(Ops::Max(ta, tb), t1);
+    }
+    *tNear = t0;
+    return Ops::LessEqual(t0, t1);
+}
+
+template <typename Ops>
+static uint32 IntersectPacket(
+    const BVHNode* nodes, const float* primitives, const uint32* primitiveIndices, BVHPrimitiveType type,
+    const Ray* rays, uint32 count, float tMax, BVHHit* hits)
+{
+    typedef typename Ops::Float Float;
+    const auto width = Ops::s_Width;
+
+    // lanes past count copy the first ray with an empty [0, -1] range so they never hit
+    alignas(32) float lanes[7][8];
+    for (uint32 i = 0; i < width; i++) {
+        auto& ray = rays[i < count? i: 0];
+        lanes[0][i] = ray.origin.x;
+        lanes[1][i] = ray.origin.y;
+        lanes[2][i] = ray.origin.z;
+        lanes[3][i] = ray.direction.x;
+        lanes[4][i] = ray.direction.y;
+        lanes[5][i] = ray.direction.z;
+        lanes[6][i] = i < count? tMax: -1.f;
+    }
+    Float origin[3], dir[3], invDir[3];
+    for (auto k = 0; k < 3; k++) {
+        origin[k] = Ops::Load(lanes[k]);
+        dir[k] = Ops::Load(lanes[3 + k]);
+        invDir[k] = Ops::Div(Ops::Set1(1.f), dir[k]);
+    }
+    auto closest = Ops::Load(lanes[6]);
+    auto u = Ops::Set1(0.f), v = Ops::Set1(0.f);
+    auto primitive = Ops::Bits(BVH_INVALID_PRIMITIVE);
+
+    // children are ordered by the first ray, the packet is assumed to point roughly the same way
+    bool negative[3] = { lanes[3][0] < 0, lanes[4][0] < 0, lanes[5][0] < 0 };
+
+    uint32 stack[BVH_MAX_DEPTH];
+    uint32 stackSize = 0, index = 0;
+    for (;;) {
+        auto& node = nodes[index];
+        Float tNear;
+        auto active = IntersectBoxPacket<Ops>(node.min, node.max, origin, invDir, closest, &tNear);
+        // early out once every lane misses the node
+        if (Ops::Mask(active) != 0) {
+            if (node.primitiveCount == 0) {
+                if (negative[node.axis]) {
+                    stack[stackSize++] = index + 1;
+                    index = node.offset;
+                } else {
+                    stack[stackSize++] = node.offset;
+                    index = index + 1;
+                }
+                continue;
+            }
+
+            for (uint32 i = node.offset; i < node.offset + node.primitiveCount; i++) {
+                Float hit, t, hitU, hitV;
+                if (type == BVHPrimitiveType::Triangle) {
+                    // Moller-Trumbore with the triangle broadcast to every lane
+                    auto triangle = primitives + (size_t)i * BVH_TRIANGLE_STRIDE;
+                    Float v0[3], e1[3], e2[3];
+                    for (auto k = 0; k < 3; k++) {
+                        v0[k] = Ops::Set1(triangle[k]);
+                        e1[k] = Ops::Set1(triangle[3 + k]);
+                        e2[k] = Ops::Set1(triangle[6 + k]);
+                    }
+                    Float p[3] = {
+                        Ops::Sub(Ops::Mul(dir[1], e2[2]), Ops::Mul(dir[2], e2[1])),
+                        Ops::Sub(Ops::Mul(dir[2], e2[0]), Ops::Mul(dir[0], e2[2])),
+                        Ops::Sub(Ops::Mul(dir[0], e2[1]), Ops::Mul(dir[1], e2[0])),
+                    };
+                    auto det = Ops::Add(Ops::Add(Ops::Mul(e1[0], p[0]), Ops::Mul(e1[1], p[1])), Ops::Mul(e1[2], p[2]));
+                    auto invDet = Ops::Div(Ops::Set1(1.f), det);
+                    Float s[3] = { Ops::Sub(origin[0], v0[0]), Ops::Sub(origin[1], v0[1]), Ops::Sub(origin[2], v0[2]) };
+                    hitU = Ops::Mul(Ops::Add(Ops::Add(Ops::Mul(s[0], p[0]), Ops::Mul(s[1], p[1])), Ops::Mul(s[2], p[2])), invDet);
+                    Float q[3] = {
+                        Ops::Sub(Ops::Mul(s[1], e1[2]), Ops::Mul(s[2], e1[1])),
+                        Ops::Sub(Ops::Mul(s[2], e1[0]), Ops::Mul(s[0], e1[2])),
+                        Ops::Sub(Ops::Mul(s[0], e1[1]), Ops::Mul(s[1], e1[0])),
+                    };
+                    hitV = Ops::Mul(Ops::Add(Ops::Add(Ops::Mul(dir[0], q[0]), Ops::Mul(dir[1], q[1])), Ops::Mul(dir[2], q[2])), invDet);
+                    t = Ops::Mul(Ops::Add(Ops::Add(Ops::Mul(e2[0], q[0]), Ops::Mul(e2[1], q[1])), Ops::Mul(e2[2], q[2])), invDet);
+
+                    auto zero = Ops::Set1(0.f);
+                    hit = Ops::GreaterEqual(Ops::Abs(det), Ops::Set1(1e-12f));
+                    hit = Ops::And(hit, Ops::GreaterEqual(hitU, zero));
+                    hit = Ops::And(hit, Ops::GreaterEqual(hitV, zero));
+                    hit = Ops::And(hit, Ops::LessEqual(Ops::Add(hitU, hitV), Ops::Set1(1.f)));
+                    hit = Ops::And(hit, Ops::GreaterEqual(t, zero));
+                    hit = Ops::And(hit, Ops::LessEqual(t, closest));
+                } else {
+                    auto box = primitives + (size_t)i * BVH_BOUNDS_STRIDE;
+                    hit = IntersectBoxPacket<Ops>(box, box + 3, origin, invDir, closest, &t);
+                    hitU = hitV = Ops::Set1(0.f);
+                }
+
+                if (Ops::Mask(hit) != 0) {
+                    closest = Ops::Select(closest, t, hit);
+                    u = Ops::Select(u, hitU, hit);
+                    v = Ops::Select(v, hitV, hit);
+                    primitive = Ops::Select(primitive, Ops::Bits(primitiveIndices[i]), hit);
+                }
+            }
+        }
+
+        if (stackSize == 0) {
+            break;
+        }
+        index = stack[--stackSize];
+    }
+
+    alignas(32) float result[4][8];
+    Ops::Store(result[0], closest);
+    Ops::Store(result[1], u);
+    Ops::Store(result[2], v);
+    Ops::Store(result[3], primitive);
+    uint32 found = 0;
+    for (uint32 i = 0; i < count; i++) {
+        hits[i].t = result[0][i];
+        hits[i].u = result[1][i];
+        hits[i].v = result[2][i];
+        memcpy(&hits[i].primitive, &result[3][i], sizeof(uint32));
+        found += hits[i].primitive != BVH_INVALID_PRIMITIVE;
+    }
+    return found;
+}
+
+uint32 BVH::IntersectRays(const Ray* rays, uint32 count, float tMax, BVHHit* hits, uint32 packetWidth) const
+{
+    if (rays == nullptr || hits == nullptr) {
+        return 0;
+    }
+    if (nodeCount == 0) {
+        for (uint32 i = 0; i < count; i++) {
+            hits[i] = { tMax, 0.f, 0.f, BVH_INVALID_PRIMITIVE };
+        }
+        return 0;
+    }
+
+    auto width = packetWidth == 0? MaxPacketWidth(): std::min(packetWidth, MaxPacketWidth());
+    uint32 found = 0;
+    if (width >= 8) {
+#ifdef BVH_PACKET_AVX2
+        for (uint32 i = 0; i < count; i += 8) {
+            found += IntersectPacket<BVHPacketAVX2>(nodes, primitives, primitiveIndices, type, rays + i, std::min(count - i, 8u), tMax, hits + i);
+        }
+        return found;
+#endif
+    }
+    if (width >= 4) {
+        for (uint32 i = 0; i < count; i += 4) {
+            found += IntersectPacket<BVHPacketSSE>(nodes, primitives, primitiveIndices, type, rays + i, std::min(count - i, 4u), tMax, hits + i);
+        }
+        return found;
+    }
+
+    for (uint32 i = 0; i < count; i++) {
+        if (Intersect(rays[i], tMax, hits[i])) {
+            found++;
+        } else {
+            hits[i] = { tMax, 0.f, 0.f, BVH_INVALID_PRIMITIVE };
+        }
+    }
+    return found;
+}
+
+uint32 BVH::MaxPacketWidth()
+{
+    static const auto s_AVX2 = SupportsAVX2();
+    return s_AVX2? 8: 4;
+}
+
+Bounds BVH::GetBounds() const
+{
+    if (nodeCount == 0) {
+        return Bounds();
+    }
+    auto& root = nodes[0];
+    Vector3f min(root.min[0], root.min[1], root.min[2]), max(root.max[0], root.max[1], root.max[2]);
+    return Bounds((min + max) / 2.f, (max - min) / 2.f);
+}
+
+BVHPrimitiveType BVH::PrimitiveType() const
+{
+    return type;
+}
+
+uint32 BVH::PrimitiveCount() const
+{
+    return primitiveCount;
+}
+
+uint32 BVH::NodeCount() const
+{
+    return nodeCount;
+}
+
+uint32 BVH::Depth() const
+{
+    return depth;
+}
+
+const BVHNode* BVH::Nodes() const
+{
+    return nodes;
+}
+
+const uint32* BVH::PrimitiveIndices() const
+{
+    return primitiveIndices;
+}
@@ -1,8 +1,118 @@
 #pragma once
 
+#include "defined_type.h"
 #include "symbols.h"
+#include "primtives.h"
 
-class DECLSPEC_DLL BVH
+#define BVH_MAX_DEPTH 64
+#define BVH_INVALID_PRIMITIVE 0xFFFFFFFF
+
+// flattened depth-first node, the left child is always the next node
+struct DECLSPEC_DLL BVHNode
+{
+    float min[3];
+    // leaf : first primitive in BVH order, interior : index of the right child
+    uint32 offset;
+    float max[3];
+    // 0 for interior nodes
+    uint16 primitiveCount;
+    // split axis, visit the right child first when the ray goes negative along it
+    uint8 axis;
+    uint8 padding;
+};
+
+struct DECLSPEC_DLL BVHBuildOption
+{
+    // SAH bins per axis
+    uint32 binCount;
+    // leaves are split until they hold at most this many primitives, or SAH says a leaf is cheaper
+    uint32 maxLeafSize;
+    // 0 uses every hardware thread, 1 builds on the calling thread
+    uint32 threadCount;
+    // subtrees with fewer primitives are built on the thread that split them
+    uint32 parallelThreshold;
+    float traversalCost;
+    float intersectCost;
+
+    BVHBuildOption();
+};
+
+struct DECLSPEC_DLL BVHHit
+{
+    float t;
+    // barycentric coordinates of the hit, 0 for bounds primitives
+    float u;
+    float v;
+    // index of the triangle or bounds given to Build
+    uint32 primitive;
+};
+
+enum class BVHPrimitiveType : int
 {
+    None,
+    Triangle,
+    Bounds,
 };
 
+/// <summary>
+/// bounding volume hierarchy over triangles or Bounds, built with binned SAH
+/// subtrees are split across threads, then the tree is flattened to 32-byte nodes in depth-first order
+/// primitive data is copied in BVH order so leaves read it contiguously
+/// </summary>
+class DECLSPEC_DLL BVH
+{
+public:
+    BVH();
+    ~BVH();
+
+    BVH(const BVH&) = delete;
+    BVH& operator=(const BVH&) = delete;
+
+    // indexCount / 3 triangles, indices nullptr means the positions are already a triangle list
+    bool Build(
+        const Vector3f* positions, uint32 vertexCount, const uint32* indices, uint32 indexCount,
+        const BVHBuildOption* option = nullptr
+    );
+    bool Build(const Bounds* bounds, uint32 count, const BVHBuildOption* option = nullptr);
+    void Clear();
+
+public:
+    // closest hit in [0, tMax], for bounds primitives t is where the ray enters the box
+    bool Intersect(const Ray& ray, float tMax, BVHHit& hit) const;
+    // any hit in [0, tMax], stops at the first one
+    bool IntersectAny(const Ray& ray, float tMax) const;
+    // primitives whose bounds overlap, writes up to capacity indices and returns the total count
+    uint32 Overlap(const Bounds& bounds, uint32* primitives, uint32 capacity) const;
+    // closest hit for every ray, consecutive rays are traced together as one packet of packetWidth lanes
+    // 0 picks the widest the CPU supports (8 with AVX2, else 4 with SSE), 1 traces one ray at a time
+    // packets share one traversal, so order the rays coherently (screen tiles, probe grids)
+    // a miss gets t = tMax and primitive = BVH_INVALID_PRIMITIVE, returns the number of hits
+    uint32 IntersectRays(const Ray* rays, uint32 count, float tMax, BVHHit* hits, uint32 packetWidth = 0) const;
+
+public:
+    Bounds GetBounds() const;
+    BVHPrimitiveType PrimitiveType() const;
+    uint32 PrimitiveCount() const;
+    uint32 NodeCount() const;
+    uint32 Depth() const;
+    const BVHNode* Nodes() const;
+    // Build index of the primitive at each BVH position
+    const uint32* PrimitiveIndices() const;
+
+    // widest packet IntersectRays can use on this CPU
+    static uint32 MaxPacketWidth();
+
+private:
+    bool BuildTree(const float* primitiveBounds, uint32 count, const BVHBuildOption* option);
+
+private:
+    BVHPrimitiveType type;
+    BVHNode* nodes;
+    uint32 nodeCount;
+    uint32 depth;
+
+    uint32* primitiveIndices;
+    uint32 primitiveCount;
+    // triangle : v0, v1 - v0, v2 - v0 (9 floats), bounds : min, max (6 floats)
+    float* primitives;
+};
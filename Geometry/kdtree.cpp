@@ -1 +1,335 @@
 #include "kdtree.h"
+
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// node indices are doubled on the way down, so the count has to leave room for 2i + 2
+#define KDTREE_MAX_COUNT 0x7FFFFFFF
+// smaller subtrees and query batches stay on the thread that reached them
+#define KDTREE_PARALLEL_THRESHOLD 8192
+#define KDTREE_BATCH_THRESHOLD 256
+
+struct KDTreeItem
+{
+    float p[3];
+    uint32 index;
+};
+
+struct KDTreeBuildContext
+{
+    // partitioned in place, nodes copy their median out of it
+    KDTreeItem* items;
+    Vector3f* points;
+    uint32* indices;
+    uint8* axes;
+    uint32 count;
+
+    std::atomic<int32> idleThreads;
+};
+
+struct KDTreeStackEntry
+{
+    uint32 node;
+    // lower bound of the squared distance from the query to anything in the subtree
+    float sqrDistance;
+};
+
+// size of the left subtree of a left-balanced tree with n nodes
+static uint32 LeftSubtreeSize(uint32 n)
+{
+    if (n <= 1) {
+        return 0;
+    }
+
+    uint32 levels = 0;
+    while ((2u << levels) - 1 <= n && levels < 31) {
+        levels++;
+    }
+    // levels full levels hold (1 << levels) - 1 nodes, the rest fill the last level from the left
+    auto lastLevel = n - ((1u << levels) - 1);
+    auto halfLastLevel = 1u << (levels - 1);
+    return halfLastLevel - 1 + std::min(lastLevel, halfLastLevel);
+}
+
+// min and max bound the cell of the subtree, they are narrowed at each split instead of rescanning the points
+static void BuildRange(KDTreeBuildContext* ctx, uint32 node, uint32 begin, uint32 end, const float* cellMin, const float* cellMax)
+{
+    float min[3] = { cellMin[0], cellMin[1], cellMin[2] }, max[3] = { cellMax[0], cellMax[1], cellMax[2] };
+    while (begin < end) {
+        // split the widest side of the cell
+        uint32 axis = 0;
+        for (uint32 k = 1; k < 3; k++) {
+            if (max[k] - min[k] > max[axis] - min[axis]) {
+                axis = k;
+            }
+        }
+
+        auto middle = begin + LeftSubtreeSize(end - begin);
+        std::nth_element(ctx->items + begin, ctx->items + middle, ctx->items + end, [=](const KDTreeItem& a, const KDTreeItem& b) {
+            return a.p[axis] < b.p[axis];
+        });
+
+        auto& item = ctx->items[middle];
+        ctx->points[node].x = item.p[0];
+        ctx->points[node].y = item.p[1];
+        ctx->points[node].z = item.p[2];
+        ctx->indices[node] = item.index;
+        ctx->axes[node] = (uint8)axis;
+
+        // the worker reads its cell while this thread narrows min for the right side, so the left cell is a copy
+        float leftMin[3] = { min[0], min[1], min[2] }, leftMax[3] = { max[0], max[1], max[2] };
+        leftMax[axis] = item.p[axis];
+        auto left = node * 2 + 1, right = node * 2 + 2;
+        if (middle - begin >= KDTREE_PARALLEL_THRESHOLD && ctx->idleThreads.fetch_sub(1, std::memory_order_acq_rel) > 0) {
+            std::thread worker(BuildRange, ctx, left, begin, middle, leftMin, leftMax);
+            min[axis] = item.p[axis];
+            BuildRange(ctx, right, middle + 1, end, min, max);
+            worker.join();
+            ctx->idleThreads.fetch_add(1, std::memory_order_acq_rel);
+            return;
+        }
+        if (middle - begin >= KDTREE_PARALLEL_THRESHOLD) {
+            ctx->idleThreads.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        BuildRange(ctx, left, begin, middle, leftMin, leftMax);
+        min[axis] = item.p[axis];
+        node = right;
+        begin = middle + 1;
+    }
+}
+
+// runs query(begin, end) over [0, count) in contiguous chunks, one per thread
+template <typename Query>
+static void RunBatch(uint32 count, uint32 threadCount, const Query& query)
+{
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threadCount = std::min(threadCount, std::max(count / KDTREE_BATCH_THRESHOLD, 1u));
+    if (threadCount <= 1) {
+        query(0, count);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    auto chunk = (count + threadCount - 1) / threadCount;
+    for (uint32 begin = chunk; begin < count; begin += chunk) {
+        workers.emplace_back(query, begin, std::min(begin + chunk, count));
+    }
+    query(0, chunk);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+static bool CompareNeighbor(const KDTreeNeighbor& a, const KDTreeNeighbor& b)
+{
+    return a.sqrDistance < b.sqrDistance;
+}
+
+KDTree::KDTree() :
+    points(nullptr), indices(nullptr), axes(nullptr), count(0)
+{ }
+
+KDTree::~KDTree()
+{
+    Clear();
+}
+
+void KDTree::Clear()
+{
+    delete[] points;
+    delete[] indices;
+    delete[] axes;
+    points = nullptr;
+    indices = nullptr;
+    axes = nullptr;
+    count = 0;
+}
+
+bool KDTree::Build(const Vector3f* source, uint32 sourceCount, uint32 threadCount)
+{
+    Clear();
+
+    if (source == nullptr || sourceCount == 0 || sourceCount > KDTREE_MAX_COUNT) {
+        return false;
+    }
+
+    // sort copies instead of indices so nth_element does not chase pointers into the source
+    std::vector<KDTreeItem> items(sourceCount);
+    float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (uint32 i = 0; i < sourceCount; i++) {
+        items[i].p[0] = source[i].x;
+        items[i].p[1] = source[i].y;
+        items[i].p[2] = source[i].z;
+        items[i].index = i;
+        for (auto k = 0; k < 3; k++) {
+            min[k] = std::min(min[k], items[i].p[k]);
+            max[k] = std::max(max[k], items[i].p[k]);
+        }
+    }
+
+    points = new Vector3f[sourceCount];
+    indices = new uint32[sourceCount];
+    axes = new uint8[sourceCount];
+    count = sourceCount;
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    KDTreeBuildContext ctx;
+    ctx.items = items.data();
+    ctx.points = points;
+    ctx.indices = indices;
+    ctx.axes = axes;
+    ctx.count = count;
+    ctx.idleThreads.store((int32)threadCount - 1);
+    BuildRange(&ctx, 0, 0, count, min, max);
+    return true;
+}
+
+uint32 KDTree::Nearest(const Vector3f& point, uint32 k, KDTreeNeighbor* neighbors, float maxDistance) const
+{
+    if (count == 0 || k == 0 || neighbors == nullptr) {
+        return 0;
+    }
+
+    float query[3] = { point.x, point.y, point.z };
+    // neighbors is a max-heap on the distance until it is sorted at the end
+    auto maxSqrDistance = maxDistance * maxDistance;
+    auto bound = maxSqrDistance;
+    uint32 found = 0;
+
+    KDTreeStackEntry stack[KDTREE_MAX_DEPTH];
+    uint32 stackSize = 0;
+    stack[stackSize++] = { 0, 0.f };
+    while (stackSize > 0) {
+        auto entry = stack[--stackSize];
+        if (entry.sqrDistance > bound) {
+            continue;
+        }
+
+        auto node = entry.node;
+        auto& p = points[node];
+        float diff[3] = { query[0] - p.x, query[1] - p.y, query[2] - p.z };
+        auto sqrDistance = diff[0] * diff[0] + diff[1] * diff[1] + diff[2] * diff[2];
+        if (sqrDistance <= bound) {
+            if (found < k) {
+                neighbors[found++] = { indices[node], sqrDistance };
+                std::push_heap(neighbors, neighbors + found, CompareNeighbor);
+            } else if (sqrDistance < neighbors[0].sqrDistance) {
+                std::pop_heap(neighbors, neighbors + found, CompareNeighbor);
+                neighbors[found - 1] = { indices[node], sqrDistance };
+                std::push_heap(neighbors, neighbors + found, CompareNeighbor);
+            }
+            if (found == k) {
+                bound = std::min(maxSqrDistance, neighbors[0].sqrDistance);
+            }
+        }
+
+        // the far side waits on the stack behind the near side
+        auto planeDistance = diff[axes[node]];
+        auto nearChild = node * 2 + (planeDistance < 0? 1: 2);
+        auto farChild = node * 2 + (planeDistance < 0? 2: 1);
+        if (farChild < count) {
+            stack[stackSize++] = { farChild, std::max(entry.sqrDistance, planeDistance * planeDistance) };
+        }
+        if (nearChild < count) {
+            stack[stackSize++] = { nearChild, entry.sqrDistance };
+        }
+    }
+
+    std::sort_heap(neighbors, neighbors + found, CompareNeighbor);
+    return found;
+}
+
+uint32 KDTree::Radius(const Vector3f& point, float radius, KDTreeNeighbor* neighbors, uint32 capacity) const
+{
+    if (count == 0 || radius < 0) {
+        return 0;
+    }
+
+    float query[3] = { point.x, point.y, point.z };
+    auto bound = radius * radius;
+    uint32 found = 0;
+
+    uint32 stack[KDTREE_MAX_DEPTH];
+    uint32 stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        auto node = stack[--stackSize];
+        auto& p = points[node];
+        float diff[3] = { query[0] - p.x, query[1] - p.y, query[2] - p.z };
+        auto sqrDistance = diff[0] * diff[0] + diff[1] * diff[1] + diff[2] * diff[2];
+        if (sqrDistance <= bound) {
+            if (found < capacity && neighbors != nullptr) {
+                neighbors[found] = { indices[node], sqrDistance };
+            }
+            found++;
+        }
+
+        // a child is skipped only when the whole half-space is beyond the radius
+        auto planeDistance = diff[axes[node]];
+        auto left = node * 2 + 1, right = node * 2 + 2;
+        if (right < count && (planeDistance >= 0 || planeDistance * planeDistance <= bound)) {
+            stack[stackSize++] = right;
+        }
+        if (left < count && (planeDistance < 0 || planeDistance * planeDistance <= bound)) {
+            stack[stackSize++] = left;
+        }
+    }
+    return found;
+}
+
+bool KDTree::NearestBatch(
+    const Vector3f* queries, uint32 queryCount, uint32 k, KDTreeNeighbor* neighbors, uint32* found,
+    float maxDistance, uint32 threadCount
+) const
+{
+    if (queries == nullptr || neighbors == nullptr || found == nullptr) {
+        return false;
+    }
+
+    RunBatch(queryCount, threadCount, [&](uint32 begin, uint32 end) {
+        for (auto i = begin; i < end; i++) {
+            found[i] = Nearest(queries[i], k, neighbors + (size_t)i * k, maxDistance);
+        }
+    });
+    return true;
+}
+
+bool KDTree::RadiusBatch(
+    const Vector3f* queries, uint32 queryCount, float radius, KDTreeNeighbor* neighbors, uint32 capacity, uint32* found,
+    uint32 threadCount
+) const
+{
+    if (queries == nullptr || found == nullptr || (neighbors == nullptr && capacity > 0)) {
+        return false;
+    }
+
+    RunBatch(queryCount, threadCount, [&](uint32 begin, uint32 end) {
+        for (auto i = begin; i < end; i++) {
+            found[i] = Radius(queries[i], radius, neighbors + (size_t)i * capacity, capacity);
+        }
+    });
+    return true;
+}
+
+uint32 KDTree::Count() const
+{
+    return count;
+}
+
+const Vector3f* KDTree::Points() const
+{
+    return points;
+}
+
+const uint32* KDTree::Indices() const
+{
+    return indices;
+}
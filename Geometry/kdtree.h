@@ -1,6 +1,66 @@
 #pragma once
 
-class __declspec(dllimport) KDTree
+#include <float.h>
+
+#include "defined_type.h"
+#include "symbols.h"
+#include "units.h"
+
+#define KDTREE_MAX_DEPTH 64
+
+struct DECLSPEC_DLL KDTreeNeighbor
 {
+    // index of the point given to Build
+    uint32 index;
+    float sqrDistance;
 };
 
+/// <summary>
+/// implicit left-balanced kd-tree over points, node i has children 2i + 1 and 2i + 2
+/// every level but the last is full and the last one is filled from the left, so the tree needs no child links
+/// points, original indices and split axes live in three flat arrays in node order
+/// </summary>
+class DECLSPEC_DLL KDTree
+{
+public:
+    KDTree();
+    ~KDTree();
+
+    KDTree(const KDTree&) = delete;
+    KDTree& operator=(const KDTree&) = delete;
+
+    // threadCount 0 uses every hardware thread, 1 builds on the calling thread
+    bool Build(const Vector3f* points, uint32 count, uint32 threadCount = 0);
+    void Clear();
+
+public:
+    // up to k neighbors within maxDistance, sorted from the closest, returns how many were written
+    uint32 Nearest(const Vector3f& point, uint32 k, KDTreeNeighbor* neighbors, float maxDistance = FLT_MAX) const;
+    // every point within radius in tree order, writes up to capacity and returns the total count
+    uint32 Radius(const Vector3f& point, float radius, KDTreeNeighbor* neighbors, uint32 capacity) const;
+
+    // query i writes to neighbors[i * k], found[i] is the count Nearest returned, queries are split across threads
+    bool NearestBatch(
+        const Vector3f* points, uint32 count, uint32 k, KDTreeNeighbor* neighbors, uint32* found,
+        float maxDistance = FLT_MAX, uint32 threadCount = 0
+    ) const;
+    // query i writes to neighbors[i * capacity], found[i] is the total count Radius returned
+    bool RadiusBatch(
+        const Vector3f* points, uint32 count, float radius, KDTreeNeighbor* neighbors, uint32 capacity, uint32* found,
+        uint32 threadCount = 0
+    ) const;
+
+public:
+    uint32 Count() const;
+    // points in node order
+    const Vector3f* Points() const;
+    // Build index of the point at each node
+    const uint32* Indices() const;
+
+private:
+    Vector3f* points;
+    uint32* indices;
+    // 0, 1, 2 for the split axis of each node
+    uint8* axes;
+    uint32 count;
+};
@@ -1,5 +1,7 @@
 #include "primtives.h"
 
+#include <cmath>
+
 
 #pragma region Ray
 
@@ -65,8 +67,8 @@ bool Bounds::Intersect(const Ray& r) const
     float    t5 = (smp.z - r.origin.z) * dir_frac.z;
     float    t6 = (bgp.z - r.origin.z) * dir_frac.z;
 
-    float tmin = fmax(fmax(fmin(t1, t2), fmin(t3, t4)), fmin(t5, t6));
-    float tmax = fmin(fmin(fmax(t1, t2), fmax(t3, t4)), fmax(t5, t6));
+    float tmin = std::fmax(std::fmax(std::fmin(t1, t2), std::fmin(t3, t4)), std::fmin(t5, t6));
+    float tmax = std::fmin(std::fmin(std::fmax(t1, t2), std::fmax(t3, t4)), std::fmax(t5, t6));
 
     // if tmax < 0, ray (line) is intersecting AABB, but the whole AABB is behind us
     // if tmin > tmax, ray doesn't intersect AABB
@@ -89,8 +91,8 @@ bool Bounds::Intersect(const Ray& r, float& t) const
     float    t5 = (smp.z - r.origin.z) * dir_frac.z;
     float    t6 = (bgp.z - r.origin.z) * dir_frac.z;
 
-    float tmin = fmax(fmax(fmin(t1, t2), fmin(t3, t4)), fmin(t5, t6));
-    float tmax = fmin(fmin(fmax(t1, t2), fmax(t3, t4)), fmax(t5, t6));
+    float tmin = std::fmax(std::fmax(std::fmin(t1, t2), std::fmin(t3, t4)), std::fmin(t5, t6));
+    float tmax = std::fmin(std::fmin(std::fmax(t1, t2), std::fmax(t3, t4)), std::fmax(t5, t6));
 
     // if tmax < 0, ray (line) is intersecting AABB, but the whole AABB is behind us
     if (tmax < 0) {
@@ -6,15 +6,8 @@
 
 struct DECLSPEC_DLL Ray
 {
-    union
-    {
-        struct
-        {
-            Vector3f origin;
-            Vector3f direction;
-        };
-        uint8 data[24];
-    };
+    Vector3f origin;
+    Vector3f direction;
 
     Ray();
     Ray(const Ray& r);
@@ -27,15 +20,8 @@ struct DECLSPEC_DLL Ray
 
 struct DECLSPEC_DLL Bounds
 {
-    union
-    {
-        struct
-        {
-            Vector3f center;
-            Vector3f extents;
-        };
-        uint8 data[24];
-    };
+    Vector3f center;
+    Vector3f extents;
 
     Bounds();
     Bounds(const Bounds& b);
@@ -40,9 +40,9 @@ void TranslateTo(const Vector3f& t, Matrix4x4& mat)
         ?    ?    ?    ?
     */
 
-    mat.c3.x = t.x;
-    mat.c3.y = t.y;
-    mat.c3.z = t.z;
+    mat.columns[3].x = t.x;
+    mat.columns[3].y = t.y;
+    mat.columns[3].z = t.z;
 }
 
 void RotateTo(const Vector3f& forwardUM, const Vector3f& upUM, Matrix4x4& mat)
@@ -58,17 +58,17 @@ void RotateTo(const Vector3f& forwardUM, const Vector3f& upUM, Matrix4x4& mat)
         ?    ?    ?    ?
     */
 
-    mat.c0.x = rn.x;
-    mat.c1.x = rn.y;
-    mat.c2.x = rn.z;
+    mat.columns[0].x = rn.x;
+    mat.columns[1].x = rn.y;
+    mat.columns[2].x = rn.z;
 
-    mat.c0.y = un.x;
-    mat.c1.y = un.y;
-    mat.c2.y = un.z;
+    mat.columns[0].y = un.x;
+    mat.columns[1].y = un.y;
+    mat.columns[2].y = un.z;
 
-    mat.c0.z = fn.x;
-    mat.c1.z = fn.y;
-    mat.c2.z = fn.z;
+    mat.columns[0].z = fn.x;
+    mat.columns[1].z = fn.y;
+    mat.columns[2].z = fn.z;
 }
 
 // https://stackoverflow.com/questions/52413464/look-at-quaternion-using-up-vector/52551983#52551983
@@ -226,7 +226,7 @@ Vector2f Sqrtv(const Vector2f& v)
 
 bool Vector2f::IsNan() const
 {
-    return isnan(x) || isnan(y);
+    return std::isnan(x) || std::isnan(y);
 }
 
 Vector2f::operator Vector3f() const
@@ -372,7 +372,7 @@ Vector3f Vector3f::One()
 
 bool Vector3f::IsNan() const
 {
-    return isnan(x) || isnan(y) || isnan(z);
+    return std::isnan(x) || std::isnan(y) || std::isnan(z);
 }
 
 float Vector3f::MaxComponent()
@@ -719,7 +719,7 @@ Vector4f Vector4f::Permute(int x, int y, int z, int w)
 
 bool Vector4f::IsNan() const
 {
-    return isnan(x) || isnan(y) || isnan(z) || isnan(w);
+    return std::isnan(x) || std::isnan(y) || std::isnan(z) || std::isnan(w);
 }
 
 float Vector4f::MaxComponent()
@@ -942,7 +942,7 @@ Vector3f& operator*(const Quaternion& q1, Vector3f& v1)
 Matrix4x4::Matrix4x4()
 {
     m00 = m10 = m20 = m30 =
-        m01 = m11 = m12 = m13 =
+        m01 = m11 = m21 = m31 =
         m02 = m12 = m22 = m32 =
         m03 = m13 = m23 = m33 = 0;
 }
@@ -956,10 +956,10 @@ Matrix4x4::Matrix4x4(const Matrix4x4& mat) :
 
 Matrix4x4::Matrix4x4(const Vector4f& c0, const Vector4f& c1, const Vector4f& c2, const Vector4f& c3)
 {
-    this->c0 = c0;
-    this->c1 = c1;
-    this->c2 = c2;
-    this->c3 = c3;
+    this->columns[0] = c0;
+    this->columns[1] = c1;
+    this->columns[2] = c2;
+    this->columns[3] = c3;
 }
 
 Matrix4x4 Matrix4x4::Transpose() const
@@ -321,13 +321,7 @@ struct DECLSPEC_DLL Matrix4x4
             float m23;
             float m33;
         };
-        struct
-        {
-            Vector4f c0;
-            Vector4f c1;
-            Vector4f c2;
-            Vector4f c3;
-        };
+        // gcc/clang do not allow members with constructors in an anonymous struct, columns[i] is the portable column view
         Vector4f columns[4];
         char     data[64];
         float    dataf[16];
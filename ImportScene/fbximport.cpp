@@ -5,6 +5,7 @@
 
 #include "fbximport.h"
 #include "datatypes.h"
+#include "hashmap.h"
 
 using namespace fbxsdk;
 
@@ -674,6 +675,26 @@ bool MeshToChunk(FbxNode* node, FBXChunk& chunk, const FBXLoadOptionChunk* opt,
 
 const char* g_ClusterModes[] = { "Normalize", "Additive", "Total1" };
 
+// map each cluster to the hierarchy node of the same name(-1 if not found), hashing names instead of strcmp per cluster
+void ClusterToHierarchy(FbxSkin* skin, const FBXChunk& chunk, int* clusterToHierarchy)
+{
+	HashMap nameToHierarchy;
+	nameToHierarchy.Init(nullptr, sizeof(const char*), sizeof(int), hashMapStringHash, hashMapStringEqual, nullptr, chunk.hierarchyCount);
+	// keep the first node on duplicated names, same as the linear search
+	for (int i = 0; i < chunk.hierarchyCount; i++)
+		nameToHierarchy.FindOrInsert(&chunk.hierarchyNodes[i].name, &i, nullptr);
+
+	int clusterCount = skin->GetClusterCount();
+	for (int cidx = 0; cidx < clusterCount; cidx++)
+	{
+		const char* boneName = skin->GetCluster(cidx)->GetLink()->GetName();
+		int* hierarchyIndex = (int*)nameToHierarchy.Find(&boneName);
+		clusterToHierarchy[cidx] = hierarchyIndex ? *hierarchyIndex : -1;
+	}
+
+	nameToHierarchy.Destroy();
+}
+
 bool LinkToChunk(FbxNode* node, FBXChunk& wholeChunk, FBXMeshChunk& meshChunk, const FBXLoadOptionChunk* opt, const Allocaters* allocs)
 {
 	const char* name = node->GetName();
@@ -699,6 +720,9 @@ bool LinkToChunk(FbxNode* node, FBXChunk& wholeChunk, FBXMeshChunk& meshChunk, c
 			new (countPerVertices + cvvi) std::vector<Bone>();
 
 		int clusterCount = skin->GetClusterCount();
+		int* clusterToHierarchy = (int*)alloca(sizeof(int) * clusterCount);
+		ClusterToHierarchy(skin, wholeChunk, clusterToHierarchy);
+
 		for (int clusterIdx = 0; clusterIdx < clusterCount; clusterIdx++)
 		{
 			fbxsdk::FbxCluster* cluster = skin->GetCluster(clusterIdx);
@@ -712,13 +736,7 @@ bool LinkToChunk(FbxNode* node, FBXChunk& wholeChunk, FBXMeshChunk& meshChunk, c
 			int* vertexIndices = cluster->GetControlPointIndices();
 			double* boneWeights = cluster->GetControlPointWeights();
 
-			int hierarchyIndex = -1;
-			for (int i = 0; i < wholeChunk.hierarchyCount; i++)
-				if (strcmp(wholeChunk.hierarchyNodes[i].name, cluster->GetLink()->GetName()) == 0)
-				{
-					hierarchyIndex = i;
-					break;
-				}
+			int hierarchyIndex = clusterToHierarchy[clusterIdx];
 			FALSE_ERROR_MESSAGE_CONTINUE_ARGS(
 				hierarchyIndex >= 0, 
 				L"fail to find same hierarchy names..(%s)",
@@ -813,21 +831,7 @@ bool AnimationToChunk(FbxNode* node, FBXChunk& chunk, const Allocaters* allocs)
 		);
 
 	int* clusterToHierarchy = (int*)alloca(sizeof(int) * clusterCnt);
-	for (uint cidx = 0; cidx < clusterCnt; cidx++)
-	{
-		FbxCluster* cluster = skin->GetCluster(cidx);
-		const char* boneName = cluster->GetLink()->GetName();
-		bool find = false;
-		for (int i = 0; i < chunk.hierarchyCount; i++)
-			if (strcmp(chunk.hierarchyNodes[i].name, boneName) == 0)
-			{
-				find = true;
-				clusterToHierarchy[cidx] = i;
-				break;
-			}
-
-		if (!find) clusterToHierarchy[cidx] = -1;
-	}
+	ClusterToHierarchy(skin, chunk, clusterToHierarchy);
 
 	for (int ai = 0; ai < newAnimCount; ai++)
 	{
@@ -0,0 +1,335 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <chrono>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "allocators.h"
+#include "container.h"
+#include "memtrace.h"
+
+// 기록 파일을 여러 할당 방식으로 다시 돌려서 처리량, RSS, 단편화를 비교
+// 사용법: MemReplay trace.bin [default|slab|arena|buddy|system ...]
+
+constexpr int32 REPLAY_SPACE_COUNT = 17;
+constexpr size_t REPLAY_DEFAULT_PAGESIZE = 16 * 1024 * 1024;
+constexpr int32 REPLAY_SAMPLE_INTERVAL = 4096;
+constexpr size_t REPLAY_TOUCH_STRIDE = 4096;
+
+struct ReplaySpace
+{
+    bool used;
+    wchar_t name[64];
+    MemSpace handle;
+    size_t pageSize;
+    uint32 flags;
+    int64 liveCount;
+};
+
+struct ReplayStrategy
+{
+    const char* name;
+    int32 kind;
+    // false 면 주소 공간을 만들지 않고 system 힙으로 할당
+    bool paged;
+    // true 면 해제를 무시하고 주소 공간이 비었을 때 한 번에 되돌림
+    bool arena;
+};
+
+static const ReplayStrategy g_Strategies[] = {
+    { "default", MEMPAGE_KIND_DEFAULT, true, false },
+    { "slab", MEMPAGE_KIND_SLAB, true, false },
+    { "arena", MEMPAGE_KIND_ARENA, true, true },
+    { "buddy", MEMPAGE_KIND_BUDDY, true, false },
+    { "system", MEMPAGE_KIND_DEFAULT, false, false },
+};
+
+struct ReplayBlock
+{
+    void* p;
+    uint16 space;
+};
+
+struct ReplayResult
+{
+    uint64 opCount;
+    uint64 failCount;
+    double seconds;
+    size_t peakResidentBytes;
+    size_t peakPageBytes;
+    float fragmentation;
+};
+
+static size_t ResidentBytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))? counters.WorkingSetSize: 0;
+#else
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    unsigned long size = 0, resident = 0;
+    auto count = fscanf(file, "%lu %lu", &size, &resident);
+    fclose(file);
+    return count == 2? (size_t)resident * (size_t)sysconf(_SC_PAGESIZE): 0;
+#endif
+}
+
+static uint16 ReplaySpaceId(uint16 space)
+{
+    return space < REPLAY_SPACE_COUNT? space: MEMTRACE_SYSTEM_SPACE;
+}
+
+static bool AddSpace(const ReplayStrategy& strategy, ReplaySpace* spaces, uint16 id, size_t pageSize, uint32 flags)
+{
+    auto space = spaces + id;
+    space->used = true;
+    space->pageSize = pageSize;
+    space->flags = flags;
+    space->liveCount = 0;
+    space->handle = MEMSPACE_SYSTEM;
+
+    if (!strategy.paged) {
+        return true;
+    }
+
+    // 잠금 페이지는 권한이 필요하고 할당 방식과 상관 없으므로 재생할 때는 쓰지 않음
+    swprintf(space->name, 64, L"replay_%d", (int)id);
+    space->handle = memPageAdd(space->name, pageSize, false, strategy.kind, flags);
+    if (!space->handle) {
+        space->used = false;
+        return false;
+    }
+    return true;
+}
+
+static void FreeSpace(const ReplayStrategy& strategy, ReplaySpace* space)
+{
+    if (space->used && strategy.paged) {
+        memPageFree(space->name);
+    }
+    space->used = false;
+}
+
+static void FreeBlock(const ReplayStrategy& strategy, ReplaySpace* spaces, const ReplayBlock& block)
+{
+    auto space = spaces + block.space;
+    space->liveCount--;
+
+    if (!strategy.arena) {
+        memFreeH(block.p, space->handle);
+    } else if (space->liveCount == 0) {
+        memArenaReset(space->name);
+    }
+}
+
+// 모든 재생 주소 공간의 페이지 통계를 더함
+static void SampleSpaces(const ReplaySpace* spaces, size_t* pageBytes, float* fragmentation)
+{
+    size_t freeBytes = 0, largestFreeBytes = 0;
+    *pageBytes = 0;
+
+    for (auto i = 0; i < REPLAY_SPACE_COUNT; i++) {
+        MemPageStats stats;
+        if (!spaces[i].used || !memPageStats(spaces[i].handle, &stats)) {
+            continue;
+        }
+        *pageBytes += stats.pageBytes;
+        freeBytes += stats.freeBytes;
+        largestFreeBytes = largestFreeBytes < stats.largestFreeBytes? stats.largestFreeBytes: largestFreeBytes;
+    }
+    *fragmentation = freeBytes > 0? 1.0f - (float)largestFreeBytes / (float)freeBytes: 0.0f;
+}
+
+/// <summary>
+/// 기록을 처음부터 끝까지 한 번 재생
+/// sample 이 false 면 시간만 재고, true 면 REPLAY_SAMPLE_INTERVAL 마다 RSS 와 페이지 통계를 봄
+/// </summary>
+static void Replay(const ReplayStrategy& strategy, const ArrayList& records, bool sample, ReplayResult* result)
+{
+    ReplaySpace spaces[REPLAY_SPACE_COUNT] = {};
+    std::unordered_map<uint64, ReplayBlock> blocks;
+    blocks.reserve((size_t)records.Count());
+
+    memset(result, 0, sizeof(ReplayResult));
+    auto baseResidentBytes = ResidentBytes();
+    auto first = (const MemTraceRecord*)records.Start();
+    auto start = std::chrono::steady_clock::now();
+
+    for (auto i = 0; i < records.Count(); i++) {
+        auto& record = first[i];
+        auto id = ReplaySpaceId(record.space);
+
+        switch (record.op) {
+        case MEMTRACE_OP_SPACE:
+            FreeSpace(strategy, spaces + id);
+            if (!AddSpace(strategy, spaces, id, (size_t)record.size, (uint32)(record.pointer >> 8))) {
+                result->failCount++;
+            }
+            break;
+
+        case MEMTRACE_OP_SPACE_FREE:
+            // 주소 공간과 같이 사라진 블록은 해제하지 않고 목록에서만 뺌
+            for (auto it = blocks.begin(); it != blocks.end();) {
+                it = it->second.space == id? blocks.erase(it): ++it;
+            }
+            FreeSpace(strategy, spaces + id);
+            break;
+
+        case MEMTRACE_OP_ALLOC:
+        {
+            if (!spaces[id].used && !AddSpace(strategy, spaces, id, REPLAY_DEFAULT_PAGESIZE, 0)) {
+                result->failCount++;
+                break;
+            }
+
+            // 아레나를 되돌려서 해제 기록 없이 같은 주소가 다시 나온 경우
+            auto found = blocks.find(record.pointer);
+            if (found != blocks.end()) {
+                FreeBlock(strategy, spaces, found->second);
+                blocks.erase(found);
+            }
+
+            auto p = (uint8*)memAllocH((size_t)record.size, (size_t)1 << record.alignShift, record.alignOffset, spaces[id].handle);
+            if (p == nullptr) {
+                result->failCount++;
+                break;
+            }
+
+            // 실제 프로그램처럼 페이지를 건드려야 RSS 가 잡힘
+            for (size_t offset = 0; offset < record.size; offset += REPLAY_TOUCH_STRIDE) {
+                p[offset] = (uint8)i;
+            }
+
+            spaces[id].liveCount++;
+            blocks[record.pointer] = ReplayBlock { p, id };
+            break;
+        }
+
+        case MEMTRACE_OP_FREE:
+        {
+            // 기록을 시작하기 전에 할당된 주소는 건너뜀
+            auto found = blocks.find(record.pointer);
+            if (found != blocks.end()) {
+                FreeBlock(strategy, spaces, found->second);
+                blocks.erase(found);
+            }
+            break;
+        }
+        }
+        result->opCount++;
+
+        if (sample && (i % REPLAY_SAMPLE_INTERVAL) == 0) {
+            auto residentBytes = ResidentBytes();
+            if (residentBytes > baseResidentBytes && residentBytes - baseResidentBytes > result->peakResidentBytes) {
+                result->peakResidentBytes = residentBytes - baseResidentBytes;
+            }
+
+            size_t pageBytes;
+            float fragmentation;
+            SampleSpaces(spaces, &pageBytes, &fragmentation);
+            if (pageBytes > result->peakPageBytes) {
+                result->peakPageBytes = pageBytes;
+                result->fragmentation = fragmentation;
+            }
+        }
+    }
+
+    result->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto& block : blocks) {
+        FreeBlock(strategy, spaces, block.second);
+    }
+    for (auto i = 0; i < REPLAY_SPACE_COUNT; i++) {
+        FreeSpace(strategy, spaces + i);
+    }
+}
+
+static void PrintSummary(const ArrayList& records, const ArrayList& names)
+{
+    std::unordered_map<uint64, uint64> sizes;
+    uint64 allocCount = 0, freeCount = 0, liveBytes = 0, peakBytes = 0, duration = 0;
+    auto first = (const MemTraceRecord*)records.Start();
+
+    for (auto i = 0; i < records.Count(); i++) {
+        auto& record = first[i];
+        if (record.op == MEMTRACE_OP_ALLOC) {
+            allocCount++;
+            liveBytes += record.size;
+            peakBytes = peakBytes < liveBytes? liveBytes: peakBytes;
+            sizes[record.pointer] = record.size;
+        } else if (record.op == MEMTRACE_OP_FREE) {
+            freeCount++;
+            auto found = sizes.find(record.pointer);
+            if (found != sizes.end()) {
+                liveBytes -= found->second;
+                sizes.erase(found);
+            }
+        }
+        duration = record.time;
+    }
+
+    printf("records %d, alloc %llu, free %llu, peak live %.2f MB, %.3f s\n",
+        records.Count(), (unsigned long long)allocCount, (unsigned long long)freeCount, peakBytes / (1024.0 * 1024.0), duration / 1e9);
+    for (auto i = 0; i < names.Count(); i++) {
+        auto name = (const MemTraceName*)names[i];
+        printf("  space %d: %ls\n", (int)name->space, name->name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("usage: %s trace.bin [default|slab|arena|buddy|system ...]\n", argv[0]);
+        return 1;
+    }
+
+    ArrayList records, names;
+    if (!memTraceLoad(argv[1], &records, &names)) {
+        printf("fail to load %s\n", argv[1]);
+        return 1;
+    }
+    PrintSummary(records, names);
+
+    printf("%-8s %14s %12s %12s %8s %6s\n", "strategy", "ops/s", "peak rss MB", "pages MB", "frag", "fail");
+    auto strategyCount = (int32)(sizeof(g_Strategies) / sizeof(g_Strategies[0]));
+    for (auto s = 0; s < strategyCount; s++) {
+        auto& strategy = g_Strategies[s];
+
+        auto selected = argc == 2;
+        for (auto a = 2; a < argc; a++) {
+            selected |= strcmp(argv[a], strategy.name) == 0;
+        }
+        if (!selected) {
+            continue;
+        }
+
+        // 시간과 메모리는 따로 재생해서 통계를 보는 비용이 처리량에 섞이지 않게 함
+        // 힙이 해제된 메모리를 들고 있으면 RSS 가 덜 잡히므로 메모리를 먼저 잼
+        ReplayResult sampled, timed;
+        Replay(strategy, records, true, &sampled);
+        Replay(strategy, records, false, &timed);
+
+        printf("%-8s %14.0f %12.2f ", strategy.name, timed.opCount / timed.seconds, sampled.peakResidentBytes / (1024.0 * 1024.0));
+        if (strategy.paged) {
+            printf("%12.2f %8.3f", sampled.peakPageBytes / (1024.0 * 1024.0), sampled.fragmentation);
+        } else {
+            printf("%12s %8s", "-", "-");
+        }
+        printf(" %6llu\n", (unsigned long long)timed.failCount);
+    }
+
+    records.Destroy();
+    names.Destroy();
+    return 0;
+}
@@ -0,0 +1,673 @@
+#include "allocators.h"
+#include "buddyallocator.h"
+#include "container.h"
+#include "mempage.h"
+#include "objectpool.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+
+static long MinorFaults()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+#endif
+
+TEST_CASE("bench memory allocate by live allocation count", "[Allocator][!benchmark]") {
+    auto addrspace0 = L"bench";
+    const uint32 liveCounts[] = { 10, 100, 1000, 10000, 100000 };
+
+    for (auto liveCount : liveCounts) {
+        char** live = (char**)memAlloc(sizeof(char*) * liveCount, alignof(char*), 0);
+
+        // 살아있는 할당 사이에 빈 범위가 흩어지도록 하나 걸러 해제
+        uint32 seed = 12345;
+        for (uint32 i = 0; i < liveCount * 2; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            auto p = (char*)memAlloc(16 + (seed >> 8) % 240, 8, 0, addrspace0);
+            if (i % 2) {
+                memFree(p, addrspace0);
+            } else {
+                live[i / 2] = p;
+            }
+        }
+
+        BENCHMARK(std::to_string(liveCount) + " live, alloc/free 64 bytes") {
+            auto p = memAlloc(64, 8, 0, addrspace0);
+            memFree(p, addrspace0);
+            return p;
+        };
+
+        BENCHMARK(std::to_string(liveCount) + " live, alloc/free 64 bytes aligned 256") {
+            auto p = memAlloc(64, 256, 0, addrspace0);
+            memFree(p, addrspace0);
+            return p;
+        };
+
+        for (uint32 i = 0; i < liveCount; i++) {
+            memFree(live[i], addrspace0);
+        }
+        memFree(live);
+        memPageFree(addrspace0);
+    }
+}
+
+TEST_CASE("bench memory free by chunk count", "[Allocator][!benchmark]") {
+    auto addrspace0 = L"bench";
+    const uint32 liveCounts[] = { 1000, 10000, 100000 };
+
+    for (auto liveCount : liveCounts) {
+        // 작은 페이지로 청크를 많이 만들어 둔 상태에서 해제 비용 측정
+        REQUIRE(memPageAdd(addrspace0, memPageMinSize(true), false));
+
+        std::vector<void*> live(liveCount);
+        for (uint32 i = 0; i < liveCount; i++) {
+            live[i] = memAlloc(512, 8, 0, addrspace0);
+        }
+
+        BENCHMARK_ADVANCED(std::to_string(liveCount) + " live, free 512 bytes")(Catch::Benchmark::Chronometer meter) {
+            std::vector<void*> ps(meter.runs());
+            for (auto& p : ps) {
+                p = memAlloc(512, 8, 0, addrspace0);
+            }
+
+            uint32 seed = 12345;
+            for (size_t i = ps.size(); i > 1; i--) {
+                seed = seed * 1664525u + 1013904223u;
+                std::swap(ps[i - 1], ps[(seed >> 8) % i]);
+            }
+
+            meter.measure([&](int i) { return memFree(ps[i], addrspace0); });
+        };
+
+        for (auto p : live) {
+            memFree(p, addrspace0);
+        }
+        memPageFree(addrspace0);
+    }
+}
+
+TEST_CASE("bench memory allocate by thread count", "[Allocator][!benchmark]") {
+    const uint32 threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    const uint32 opCount = 20000;
+    const uint32 liveCount = 64;
+
+    // 스레드마다 작은 블록을 살려둔 채로 할당/해제를 반복
+    auto run = [&](uint32 threadCount, const wchar_t* addrspace) {
+        std::vector<std::thread> threads;
+        for (uint32 t = 0; t < threadCount; t++) {
+            threads.emplace_back([=]() {
+                void* live[liveCount] = { 0, };
+                uint32 seed = 12345 + t;
+                for (uint32 i = 0; i < opCount; i++) {
+                    seed = seed * 1664525u + 1013904223u;
+                    auto& p = live[(seed >> 8) % liveCount];
+                    if (p) {
+                        memFree(p, addrspace);
+                    }
+                    p = memAlloc(16 + (seed >> 16) % 240, 8, 0, addrspace);
+                }
+                for (auto p : live) {
+                    memFree(p, addrspace);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    };
+
+    for (auto threadCount : threadCounts) {
+        BENCHMARK(std::to_string(threadCount) + " threads, " + std::to_string(opCount) + " alloc/free each") {
+            run(threadCount, L"bench");
+        };
+
+        BENCHMARK(std::to_string(threadCount) + " threads, " + std::to_string(opCount) + " alloc/free each (system)") {
+            run(threadCount, SYSTEM_NAME);
+        };
+    }
+    memPageFree(L"bench");
+}
+
+TEST_CASE("bench memory allocate by space kind", "[Allocator][!benchmark]") {
+    struct Kind { const wchar_t* name; int32 kind; const char* label; };
+    const Kind kinds[] = {
+        { L"benchdefault", MEMPAGE_KIND_DEFAULT, "default" },
+        { L"benchslab", MEMPAGE_KIND_SLAB, "slab" },
+        { L"benchbuddy", MEMPAGE_KIND_BUDDY, "buddy" },
+    };
+    const uint32 liveCount = 10000;
+
+    for (auto& kind : kinds) {
+        // 스레드 캐시가 꺼지는 크기의 페이지라 기본 종류는 일반 범위 할당 경로를 탐
+        REQUIRE(memPageAdd(kind.name, 64 * 1024, false, kind.kind));
+        auto kindName = std::string(kind.label);
+
+        std::vector<void*> live(liveCount);
+        uint32 seed = 12345;
+        for (auto& p : live) {
+            seed = seed * 1664525u + 1013904223u;
+            p = memAlloc(16 + (seed >> 8) % 1000, 8, 0, kind.name);
+        }
+
+        BENCHMARK(kindName + ", alloc/free 48 bytes") {
+            auto p = memAlloc(48, 8, 0, kind.name);
+            memFree(p, kind.name);
+            return p;
+        };
+
+        BENCHMARK_ADVANCED(kindName + ", replace random live 16~1016 bytes")(Catch::Benchmark::Chronometer meter) {
+            meter.measure([&](int i) {
+                seed = seed * 1664525u + 1013904223u;
+                auto& p = live[(seed >> 8) % liveCount];
+                memFree(p, kind.name);
+                p = memAlloc(16 + (seed >> 4) % 1000, 8, 0, kind.name);
+                return p;
+            });
+        };
+
+        for (auto p : live) {
+            memFree(p, kind.name);
+        }
+        memPageFree(kind.name);
+    }
+}
+
+TEST_CASE("bench memory scratch allocation by space kind", "[Allocator][!benchmark]") {
+    auto defaultSpace = L"benchscratch";
+    auto arenaSpace = L"benchscratcharena";
+    const uint32 scratchCount = 1000;
+
+    REQUIRE(memPageAdd(defaultSpace, memPageMinSize(false), false));
+    REQUIRE(memPageAdd(arenaSpace, memPageMinSize(false), false, MEMPAGE_KIND_ARENA));
+
+    // 한꺼번에 버려지는 임시 데이터, 크기는 캐시가 받지 않는 범위까지 섞음
+    std::vector<void*> scratch(scratchCount);
+
+    BENCHMARK("default, " + std::to_string(scratchCount) + " alloc then free each") {
+        uint32 seed = 12345;
+        for (auto& p : scratch) {
+            seed = seed * 1664525u + 1013904223u;
+            p = memAlloc(16 + (seed >> 8) % 2000, 8, 0, defaultSpace);
+        }
+        for (auto p : scratch) {
+            memFree(p, defaultSpace);
+        }
+        return scratch[0];
+    };
+
+    BENCHMARK("arena, " + std::to_string(scratchCount) + " alloc then reset") {
+        uint32 seed = 12345;
+        for (auto& p : scratch) {
+            seed = seed * 1664525u + 1013904223u;
+            p = memAlloc(16 + (seed >> 8) % 2000, 8, 0, arenaSpace);
+        }
+        memArenaReset(arenaSpace);
+        return scratch[0];
+    };
+
+    memPageFree(defaultSpace);
+    memPageFree(arenaSpace);
+}
+
+TEST_CASE("bench memory address space lookup", "[Allocator][!benchmark]") {
+    // 이름 비교가 가장 길어지도록 앞 슬롯을 채워둔 뒤 마지막에 등록
+    const int fillerCount = 12;
+    std::vector<std::wstring> fillers;
+    for (auto i = 0; i < fillerCount; i++) {
+        fillers.push_back(L"benchfiller" + std::to_wstring(i));
+        memPageAdd(fillers.back().c_str(), memPageMinSize(true), false);
+    }
+    auto addrspace0 = L"benchlookup";
+    auto space = memPageAdd(addrspace0, memPageMinSize(false), false, MEMPAGE_KIND_SLAB);
+    REQUIRE(space);
+
+    BENCHMARK("system, by name") {
+        auto p = memAlloc(64, 8, 0, SYSTEM_NAME);
+        memFree(p, SYSTEM_NAME);
+        return p;
+    };
+
+    BENCHMARK("system, by handle") {
+        auto p = memAllocH(64, 8, 0, MEMSPACE_SYSTEM);
+        memFreeH(p, MEMSPACE_SYSTEM);
+        return p;
+    };
+
+    BENCHMARK("slab space after " + std::to_string(fillerCount) + " spaces, by name") {
+        auto p = memAlloc(64, 8, 0, addrspace0);
+        memFree(p, addrspace0);
+        return p;
+    };
+
+    BENCHMARK("slab space after " + std::to_string(fillerCount) + " spaces, by handle") {
+        auto p = memAllocH(64, 8, 0, space);
+        memFreeH(p, space);
+        return p;
+    };
+
+    memPageFree(addrspace0);
+    for (auto& filler : fillers) {
+        memPageFree(filler.c_str());
+    }
+}
+
+TEST_CASE("bench memory page option", "[Allocator][!benchmark]") {
+    const std::pair<const char*, uint32> options[] = {
+        { "normal", 0 },
+        { "prefault", MEMPAGE_FLAG_PREFAULT },
+        { "huge", MEMPAGE_FLAG_HUGE },
+        { "huge+prefault", MEMPAGE_FLAG_HUGE | MEMPAGE_FLAG_PREFAULT },
+    };
+    auto addrspace0 = L"benchpage";
+    auto pageSize = memPageMinSize(false);
+    const size_t touchStep = 4096;
+
+    auto touch = [&](uint8* p) {
+        for (size_t i = 0; i < pageSize; i += touchStep) {
+            p[i] = (uint8)i;
+        }
+        return p[0];
+    };
+
+    for (auto& option : options) {
+        auto name = std::string(option.first);
+
+        // 블록마다 새 페이지, 미리 채우는 비용은 할당 쪽에 들어감
+        BENCHMARK_ADVANCED(name + ", alloc + first touch 16MB page")(Catch::Benchmark::Chronometer meter) {
+            auto space = memPageAdd(addrspace0, pageSize, false, MEMPAGE_KIND_DEFAULT, option.second);
+            std::vector<uint8*> blocks(meter.runs());
+            meter.measure([&](int i) {
+                blocks[i] = (uint8*)memAllocH(pageSize - 256, 64, 0, space);
+                return touch(blocks[i]);
+            });
+            memPageFree(addrspace0);
+        };
+
+        // TLB 에 다 들어가지 않는 작업 공간에서 임의 읽기
+        {
+            const int pageCount = 8;
+            auto space = memPageAdd(addrspace0, pageSize, false, MEMPAGE_KIND_DEFAULT, option.second);
+            std::vector<uint8*> blocks(pageCount);
+            for (auto& block : blocks) {
+                block = (uint8*)memAllocH(pageSize - 256, 64, 0, space);
+                touch(block);
+            }
+
+            BENCHMARK(name + ", 64k random reads over 128MB") {
+                uint32 seed = 12345;
+                uint32 sum = 0;
+                for (auto i = 0; i < 65536; i++) {
+                    seed = seed * 1664525u + 1013904223u;
+                    sum += blocks[seed % pageCount][(seed >> 4) % (pageSize - 256)];
+                }
+                return sum;
+            };
+
+            // 미리 채우는 비용이 할당과 첫 접근 중 어디로 가는지 한 번씩 측정
+            auto start = std::chrono::high_resolution_clock::now();
+#ifdef __linux__
+            auto faults = MinorFaults();
+#endif
+            auto block = (uint8*)memAllocH(pageSize - 256, 64, 0, space);
+            auto allocated = std::chrono::high_resolution_clock::now();
+            touch(block);
+            auto touched = std::chrono::high_resolution_clock::now();
+            auto allocMs = std::chrono::duration<double, std::milli>(allocated - start).count();
+            auto touchMs = std::chrono::duration<double, std::milli>(touched - allocated).count();
+            WARN(name << ": alloc " << allocMs << "ms, first touch " << touchMs << "ms");
+#ifdef __linux__
+            WARN(name << ": " << MinorFaults() - faults << " minor faults for alloc + first touch of a 16MB page");
+#endif
+            memPageFree(addrspace0);
+        }
+    }
+}
+
+TEST_CASE("bench memory page warm-up", "[Allocator][!benchmark]") {
+    // 장면을 불러온 직후 첫 프레임에서 64MB 를 처음 쓰는 상황
+    // 주소 공간을 만드는 쪽이 기다리는 시간과 첫 프레임이 기다리는 시간을 나눠서 잼
+    const std::pair<const char*, uint32> options[] = {
+        { "normal", 0 },
+        { "prefault", MEMPAGE_FLAG_PREFAULT },
+        { "warm", MEMPAGE_FLAG_WARM },
+    };
+    auto addrspace0 = L"benchwarm";
+    const size_t frameBytes = 64 * 1024 * 1024;
+    const size_t touchStep = 4096;
+
+    for (auto& option : options) {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto space = memPageAdd(addrspace0, frameBytes, false, MEMPAGE_KIND_DEFAULT, option.second);
+        REQUIRE(space);
+        if (option.second != MEMPAGE_FLAG_WARM) {
+            // 스레드 캐시를 거치지 않는 크기로 같은 범위 페이지를 미리 받아둠, normal 은 채우지 않음
+            auto p = memAllocH(4096, 16, 0, space);
+            memFreeH(p, space);
+        }
+        auto added = std::chrono::high_resolution_clock::now();
+
+        // 불러오는 동안 백그라운드 스레드가 채움
+        while (memPageWarmState(space) == MEMWARM_WARMING) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        auto loaded = std::chrono::high_resolution_clock::now();
+
+#ifdef __linux__
+        auto faults = MinorFaults();
+#endif
+        auto frameStart = std::chrono::high_resolution_clock::now();
+        auto block = (uint8*)memAllocH(frameBytes - 4096, 64, 0, space);
+        REQUIRE(block != nullptr);
+        for (size_t i = 0; i < frameBytes - 4096; i += touchStep) {
+            block[i] = (uint8)i;
+        }
+        auto frameEnd = std::chrono::high_resolution_clock::now();
+
+        auto addMs = std::chrono::duration<double, std::milli>(added - start).count();
+        auto loadMs = std::chrono::duration<double, std::milli>(loaded - added).count();
+        auto frameMs = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+        WARN(option.first << ": add " << addMs << "ms, background " << loadMs << "ms, first frame " << frameMs << "ms");
+#ifdef __linux__
+        WARN(option.first << ": " << MinorFaults() - faults << " minor faults in the first frame");
+#endif
+        REQUIRE(memFreeH(block, space));
+        REQUIRE(memPageFree(addrspace0));
+    }
+}
+
+TEST_CASE("bench memory stats sampling", "[Allocator][!benchmark]") {
+    auto addrspace0 = L"benchstats";
+    auto space = memPageAdd(addrspace0, memPageMinSize(false), false);
+    REQUIRE(space);
+
+    // 통계 카운터는 항상 켜져 있고 지연 시간 측정만 간격으로 조절
+    const uint32 intervals[] = { 0, 64, 1 };
+    for (auto interval : intervals) {
+        REQUIRE(memPageSetSampling(space, interval));
+        auto name = interval == 0? std::string("sampling off"): "sample every " + std::to_string(interval);
+
+        BENCHMARK(name + ", alloc/free 48 bytes") {
+            auto p = memAllocH(48, 8, 0, space);
+            memFreeH(p, space);
+            return p;
+        };
+
+        BENCHMARK(name + ", alloc/free 4000 bytes") {
+            auto p = memAllocH(4000, 8, 0, space);
+            memFreeH(p, space);
+            return p;
+        };
+    }
+
+    std::vector<void*> live(10000);
+    for (size_t i = 0; i < live.size(); i++) {
+        live[i] = memAllocH(16 + i % 3000, 8, 0, space);
+    }
+    for (size_t i = 0; i < live.size(); i += 2) {
+        memFreeH(live[i], space);
+    }
+
+    BENCHMARK("memPageStats, 5000 live / 5000 free ranges") {
+        MemPageStats stats;
+        memPageStats(space, &stats);
+        return stats.freeBytes;
+    };
+
+    memPageFree(addrspace0);
+}
+
+TEST_CASE("bench memory reallocate", "[Allocator][!benchmark]") {
+    auto addrspace0 = L"benchrealloc";
+    REQUIRE(memPageAdd(addrspace0, memPageMinSize(false), false));
+    const int32 pushCount = 1000000;
+
+    // 용량 1 에서 시작해서 두 배씩 늘어남
+    const wchar_t* spaces[] = { SYSTEM_NAME, addrspace0 };
+    for (auto addrspace : spaces) {
+        auto name = std::string(addrspace == addrspace0? "default": "system");
+
+        BENCHMARK(name + ", ArrayList push " + std::to_string(pushCount) + " uint64") {
+            ArrayList list;
+            list.Init(addrspace, sizeof(uint64), alignof(uint64), 1);
+            for (uint64 i = 0; i < (uint64)pushCount; i++) {
+                list.InsertLast(1, &i, nullptr);
+            }
+            auto count = list.Count();
+            list.Destroy();
+            return count;
+        };
+    }
+
+    // 늘릴 때마다 뒤에 다른 할당이 끼어들면 옮겨야 함
+    BENCHMARK("default, grow 64 -> 64KB by 64 bytes, memRealloc") {
+        auto p = memAlloc(64, 8, 0, addrspace0);
+        for (size_t size = 128; size <= 64 * 1024; size += 64) {
+            p = memRealloc(p, size, 8, 0, addrspace0);
+        }
+        return memFree(p, addrspace0);
+    };
+    BENCHMARK("default, grow 64 -> 64KB by 64 bytes, alloc + copy + free") {
+        auto p = memAlloc(64, 8, 0, addrspace0);
+        for (size_t size = 128; size <= 64 * 1024; size += 64) {
+            auto newPtr = memAlloc(size, 8, 0, addrspace0);
+            memcpy(newPtr, p, size - 64);
+            memFree(p, addrspace0);
+            p = newPtr;
+        }
+        return memFree(p, addrspace0);
+    };
+
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("bench buddy allocator", "[Allocator][!benchmark]") {
+    // GPU 힙처럼 256MB 를 64KB 블록 단위로 나누고 64KB~4MB 블록을 교체
+    const uint64 heapSize = (uint64)256 * 1024 * 1024;
+    const uint64 blockSize = 64 * 1024;
+    const uint32 liveCount = 64;
+
+    BuddyAllocator buddy;
+    REQUIRE(buddy.Init(nullptr, heapSize, blockSize));
+    auto addrspace0 = L"benchbuddyheap";
+    REQUIRE(memPageAdd(addrspace0, (size_t)heapSize, false));
+
+    uint32 seed = 12345;
+    auto nextSize = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return blockSize + (seed >> 8) % (4 * 1024 * 1024 - blockSize);
+    };
+
+    std::vector<uint64> offsets(liveCount);
+    std::vector<void*> pointers(liveCount);
+    for (uint32 i = 0; i < liveCount; i++) {
+        offsets[i] = buddy.Alloc(nextSize(), blockSize);
+        pointers[i] = memAlloc((size_t)nextSize(), (size_t)blockSize, 0, addrspace0);
+    }
+
+    BENCHMARK_ADVANCED("buddy offset, replace random live 64KB~4MB")(Catch::Benchmark::Chronometer meter) {
+        meter.measure([&](int i) {
+            auto& offset = offsets[(seed >> 4) % liveCount];
+            buddy.Free(offset);
+            offset = buddy.Alloc(nextSize(), blockSize);
+            return offset;
+        });
+    };
+
+    // 같은 요청을 기본 주소 공간의 범위 할당으로 처리, 페이지는 건드리지 않음
+    BENCHMARK_ADVANCED("default space, replace random live 64KB~4MB")(Catch::Benchmark::Chronometer meter) {
+        meter.measure([&](int i) {
+            auto& p = pointers[(seed >> 4) % liveCount];
+            memFree(p, addrspace0);
+            p = memAlloc((size_t)nextSize(), (size_t)blockSize, 0, addrspace0);
+            return p;
+        });
+    };
+
+    BENCHMARK("buddy offset, fragmentation report") {
+        BuddyStats stats;
+        buddy.Stats(&stats);
+        return stats.fragmentation;
+    };
+
+    BuddyStats stats;
+    buddy.Stats(&stats);
+    WARN("buddy used " << stats.usedBytes / (1024 * 1024) << " MB, requested " << stats.requestedBytes / (1024 * 1024) <<
+        " MB, fragmentation " << stats.fragmentation);
+
+    for (auto p : pointers) {
+        memFree(p, addrspace0);
+    }
+    REQUIRE(memPageFree(addrspace0));
+    REQUIRE(buddy.Destroy());
+}
+
+TEST_CASE("bench object pool", "[Allocator][!benchmark]") {
+    // 작업 기술자 크기의 블록, 스레드 캐시가 켜지는 기본 주소 공간과 비교
+    const int32 step = 64;
+    const int32 opCount = 100000;
+    auto addrspace0 = L"benchpoolspace";
+    REQUIRE(memPageAdd(addrspace0, memPageMinSize(false), false));
+
+    ObjectPool pool;
+    REQUIRE(pool.Init(nullptr, step, 16));
+
+    BENCHMARK("pool, alloc/free 64 bytes") {
+        auto p = pool.Alloc();
+        pool.Free(p);
+        return p;
+    };
+    BENCHMARK("memAlloc, alloc/free 64 bytes") {
+        auto p = memAlloc(step, 16, 0, addrspace0);
+        memFree(p, addrspace0);
+        return p;
+    };
+
+    void* blocks[256];
+    BENCHMARK("pool, bulk alloc/free 256 x 64 bytes") {
+        auto count = pool.AllocBulk(blocks, 256);
+        pool.FreeBulk(blocks, count);
+        return count;
+    };
+    BENCHMARK("memAlloc, alloc/free 256 x 64 bytes") {
+        for (auto i = 0; i < 256; i++) {
+            blocks[i] = memAlloc(step, 16, 0, addrspace0);
+        }
+        for (auto i = 0; i < 256; i++) {
+            memFree(blocks[i], addrspace0);
+        }
+        return blocks[0];
+    };
+
+    // 생산자가 할당한 블록을 소비자가 해제, 블록이 항상 다른 스레드로 넘어감
+    for (auto threadCount : { 2, 4, 8 }) {
+        auto handoff = [&](auto alloc, auto free) {
+            std::vector<std::atomic<void*>> slots(1024);
+            for (auto& slot : slots) {
+                slot.store(nullptr);
+            }
+
+            std::vector<std::thread> threads;
+            for (auto t = 0; t < threadCount; t++) {
+                threads.emplace_back([&, t]() {
+                    uint32 seed = 77u + t;
+                    for (auto i = 0; i < opCount / threadCount; i++) {
+                        seed = seed * 1664525u + 1013904223u;
+                        auto previous = slots[(seed >> 8) % slots.size()].exchange(alloc());
+                        if (previous) {
+                            free(previous);
+                        }
+                    }
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            for (auto& slot : slots) {
+                if (auto p = slot.exchange(nullptr)) {
+                    free(p);
+                }
+            }
+            return threadCount;
+        };
+
+        auto suffix = std::to_string(threadCount) + " threads, " + std::to_string(opCount) + " handoffs";
+        BENCHMARK("pool, " + suffix) {
+            return handoff([&]() { return pool.Alloc(); }, [&](void* p) { pool.Free(p); });
+        };
+        BENCHMARK("memAlloc, " + suffix) {
+            return handoff([&]() { return memAlloc(step, 16, 0, addrspace0); }, [&](void* p) { memFree(p, addrspace0); });
+        };
+    }
+
+    REQUIRE(pool.Destroy());
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("bench memory compaction", "[Allocator][!benchmark]") {
+    // 64MB 를 1~16KB 블록으로 채우고 3/4 를 해제한 뒤, 한 번에 옮길 양에 따른 멈춤 시간을 잼
+    const size_t liveBytes = 64 * 1024 * 1024;
+    const size_t budgets[] = { 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, ~(size_t)0 };
+
+    for (auto budget : budgets) {
+        auto addrspace0 = L"benchcompact";
+        auto space = memPageAdd(addrspace0, memPageMinSize(false), false);
+        REQUIRE(space);
+
+        uint32 seed = 4321;
+        std::vector<MemHandle> all, handles;
+        for (size_t total = 0; total < liveBytes;) {
+            seed = seed * 1664525u + 1013904223u;
+            auto size = (size_t)1024 + (seed >> 8) % (15 * 1024);
+            auto handle = memHandleAlloc(size, 16, space);
+            REQUIRE(handle);
+            memset(memHandlePin(handle), 0x5A, size);
+            memHandleUnpin(handle);
+            all.push_back(handle);
+            total += size;
+        }
+        for (auto handle : all) {
+            seed = seed * 1664525u + 1013904223u;
+            if ((seed >> 28) < 4) {
+                handles.push_back(handle);
+            } else {
+                REQUIRE(memHandleFree(handle));
+            }
+        }
+        auto pageSize = memPageSize(addrspace0);
+
+        // 옮길 블록이 없을 때까지 나눠서 호출
+        MemCompactStats stats;
+        uint64 passCount = 0, totalNs = 0, maxNs = 0;
+        size_t movedBytes = 0, releasedBytes = 0;
+        do {
+            REQUIRE(memCompact(space, budget, &stats));
+            passCount++;
+            totalNs += stats.pauseNs;
+            maxNs = stats.pauseNs > maxNs? stats.pauseNs: maxNs;
+            movedBytes += stats.movedBytes;
+            releasedBytes += stats.releasedBytes;
+        } while (stats.movedCount > 0);
+
+        auto name = budget == ~(size_t)0? std::string("unlimited"): std::to_string(budget / 1024) + " KB";
+        WARN("budget " << name << ": " << passCount << " passes, moved " << movedBytes / 1024 << " KB, released " <<
+            releasedBytes / 1024 << " / " << pageSize / 1024 << " KB, max pause " << maxNs / 1000 << " us, avg pause " <<
+            totalNs / passCount / 1000 << " us");
+
+        for (auto handle : handles) {
+            REQUIRE(memHandleFree(handle));
+        }
+        REQUIRE(memPageFree(addrspace0));
+    }
+}
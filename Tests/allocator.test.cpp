@@ -3,6 +3,39 @@
 #include "defined_type.h"
 #include "catch.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <stdio.h>
+#include <unistd.h>
+#endif
+
+// 프로세스의 상주 메모리 크기
+static size_t ResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.WorkingSetSize;
+#else
+    long pages = 0, residentPages = 0;
+    auto file = fopen("/proc/self/statm", "r");
+    if (file) {
+        if (fscanf(file, "%ld %ld", &pages, &residentPages) != 2) {
+            residentPages = 0;
+        }
+        fclose(file);
+    }
+    return (size_t)residentPages * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
 TEST_CASE("test memory allocate", "[Allocator]") {
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_CHECK_ALWAYS_DF | _CRTDBG_LEAK_CHECK_DF);
 
@@ -76,4 +109,953 @@ TEST_CASE("test memory allocate (page locked)", "[Allocator]") {
             sp[i][j] = (char)0;
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("test memory allocate (free range reuse)", "[Allocator]") {
+    auto addrspace0 = L"freerange";
+
+    const int count = 4096;
+    const size_t alignments[4] = { 8, 16, 64, 256 };
+    char* sp[count] = { 0, };
+    uint32 sa[count] = { 0, };
+    size_t total = 0;
+
+    uint32 seed = 12345;
+    auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+    for (auto round = 0; round < 4; round++) {
+        for (auto i = 0; i < count; i++) {
+            if (sp[i] != nullptr) {
+                continue;
+            }
+
+            auto alignment = alignments[next() % 4];
+            sa[i] = next() % 512;
+            sp[i] = (char*)memAlloc(sa[i], alignment, 0, addrspace0);
+
+            REQUIRE(sp[i] != nullptr);
+            REQUIRE(((size_t)sp[i] & (alignment - 1)) == 0);
+
+            memset(sp[i], i & 0xff, sa[i]);
+            total += sa[i];
+        }
+
+        REQUIRE(memAllocSize(addrspace0) == total);
+
+        for (auto i = 0; i < count; i++) {
+            bool intact = true;
+            for (uint32 j = 0; j < sa[i]; j++) {
+                intact &= sp[i][j] == (char)(i & 0xff);
+            }
+            REQUIRE(intact);
+
+            if (next() % 2) {
+                REQUIRE(memFree(sp[i], addrspace0));
+                total -= sa[i];
+                sp[i] = nullptr;
+            }
+        }
+
+        REQUIRE(memAllocSize(addrspace0) == total);
+    }
+
+    for (auto i = 0; i < count; i++) {
+        if (sp[i] != nullptr) {
+            REQUIRE(memFree(sp[i], addrspace0));
+            REQUIRE_FALSE(memFree(sp[i], addrspace0));
+        }
+    }
+    REQUIRE(memAllocSize(addrspace0) == 0);
+
+    // 모두 해제되면 빈 범위가 합쳐져 페이지 하나를 통째로 다시 쓸 수 있어야 함
+    auto pageSize = memPageSize(addrspace0);
+    auto whole = memAlloc(memPageMinSize(false) - 64, 8, 0, addrspace0);
+    REQUIRE(whole != nullptr);
+    REQUIRE(memPageSize(addrspace0) == pageSize);
+    REQUIRE(memFree(whole, addrspace0));
+
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("test memory free (chunk lookup)", "[Allocator]") {
+    auto addrspace0 = L"chunklookup";
+    auto pageSize = memPageMinSize(true);
+
+    REQUIRE(memPageAdd(addrspace0, pageSize, false));
+
+    const int count = 64;
+    char* sp[count] = { 0, };
+    size_t total = 0;
+
+    for (auto i = 0; i < count; i++) {
+        sp[i] = (char*)memAlloc(1000, 8, 0, addrspace0);
+        REQUIRE(sp[i] != nullptr);
+        total += 1000;
+    }
+    REQUIRE(memPageSize(addrspace0) > pageSize);
+
+    // 페이지 크기를 넘는 할당은 여러 정렬 윈도우에 걸친 청크가 됨
+    auto big = (char*)memAlloc(pageSize * 5 + 100, 8, 0, addrspace0);
+    REQUIRE(big != nullptr);
+    total += pageSize * 5 + 100;
+    REQUIRE(memAllocSize(addrspace0) == total);
+
+    REQUIRE_FALSE(memFree(big + pageSize * 3, addrspace0));
+    REQUIRE_FALSE(memFree(sp[0] + 8, addrspace0));
+    REQUIRE(memFree(big, addrspace0));
+    total -= pageSize * 5 + 100;
+
+    for (auto i = count - 1; i >= 0; i--) {
+        REQUIRE(memFree(sp[i], addrspace0));
+        total -= 1000;
+        REQUIRE(memAllocSize(addrspace0) == total);
+    }
+
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("test memory allocate (slab)", "[Allocator]") {
+    auto addrspace0 = L"slab";
+    auto pageSize = memPageMinSize(true);
+
+    REQUIRE(memPageAdd(addrspace0, pageSize, false, MEMPAGE_KIND_SLAB));
+    REQUIRE_FALSE(memPageAdd(L"slabkind", pageSize, false, 100));
+
+    const int count = 512;
+    char* sp[count] = { 0, };
+    size_t sa[count] = { 0, };
+    size_t total = 0;
+
+    uint32 seed = 4321;
+    for (auto i = 0; i < count; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        // 슬랩 크기를 넘는 요청과 큰 정렬도 섞어서 기본 경로로 가는지 확인
+        sa[i] = i % 16 == 0? 2000 + (seed >> 8) % 1000: (seed >> 8) % 1025;
+        auto alignment = i % 8 == 1? 64: 8;
+        sp[i] = (char*)memAlloc(sa[i], alignment, 0, addrspace0);
+        REQUIRE(sp[i] != nullptr);
+        REQUIRE((size_t)sp[i] % alignment == 0);
+        memset(sp[i], i, sa[i]);
+        total += sa[i];
+    }
+    REQUIRE(memAllocSize(addrspace0) == total);
+    REQUIRE(memPageSize(addrspace0) % pageSize == 0);
+
+    for (auto i = 0; i < count; i += 2) {
+        REQUIRE(memFree(sp[i], addrspace0));
+        REQUIRE_FALSE(memFree(sp[i], addrspace0));
+        total -= sa[i];
+        sp[i] = nullptr;
+    }
+    REQUIRE(memAllocSize(addrspace0) == total);
+
+    // 해제된 블록은 같은 클래스의 요청에 다시 쓰임
+    auto pageTotal = memPageSize(addrspace0);
+    for (auto i = 0; i < count; i += 2) {
+        sp[i] = (char*)memAlloc(sa[i], 8, 0, addrspace0);
+        REQUIRE(sp[i] != nullptr);
+        memset(sp[i], i, sa[i]);
+        total += sa[i];
+    }
+    REQUIRE(memAllocSize(addrspace0) == total);
+    REQUIRE(memPageSize(addrspace0) == pageTotal);
+
+    for (auto i = 0; i < count; i++) {
+        bool intact = true;
+        for (size_t j = 0; j < sa[i]; j++) {
+            intact &= sp[i][j] == (char)i;
+        }
+        REQUIRE(intact);
+        REQUIRE(memFree(sp[i], addrspace0));
+    }
+    REQUIRE(memAllocSize(addrspace0) == 0);
+
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("test memory allocate (arena)", "[Allocator]") {
+    auto addrspace0 = L"arena";
+    auto pageSize = memPageMinSize(true);
+
+    auto space = memPageAdd(addrspace0, pageSize, false, MEMPAGE_KIND_ARENA);
+    REQUIRE(space);
+    REQUIRE_FALSE(memArenaPush(L"notarena"));
+    REQUIRE_FALSE(memArenaPop(addrspace0));
+    REQUIRE_FALSE(memArenaPushH(MEMSPACE_SYSTEM));
+    REQUIRE_FALSE(memArenaPushH(MEMSPACE_INVALID));
+    REQUIRE(memPageSizeH(MEMSPACE_SYSTEM) == 0);
+
+    auto first = (char*)memAlloc(100, 8, 0, addrspace0);
+    REQUIRE(first != nullptr);
+    auto aligned = (char*)memAlloc(10, 256, 0, addrspace0);
+    REQUIRE((size_t)aligned % 256 == 0);
+    REQUIRE(aligned >= first + 100);
+    REQUIRE(memAllocSize(addrspace0) == 110);
+
+    // 개별 해제는 아무것도 하지 않음, 중간 주소나 두 번 해제도 true 라서 검증이 되지 않음
+    REQUIRE(memFree(first, addrspace0));
+    REQUIRE(memFree(first, addrspace0));
+    REQUIRE(memFree(first + 1, addrspace0));
+    REQUIRE(memAllocSize(addrspace0) == 110);
+
+    REQUIRE(memArenaPush(addrspace0));
+    auto scoped = (char*)memAlloc(64, 8, 0, addrspace0);
+    REQUIRE(scoped != nullptr);
+    {
+        MemArenaScope scope(addrspace0);
+        // 페이지보다 큰 요청은 새 청크로 넘어감
+        auto big = (char*)memAlloc(pageSize * 3, 16, 0, addrspace0);
+        REQUIRE(big != nullptr);
+        memset(big, 1, pageSize * 3);
+        REQUIRE(memAllocSize(addrspace0) == 110 + 64 + pageSize * 3);
+    }
+    REQUIRE(memAllocSize(addrspace0) == 110 + 64);
+    REQUIRE(memArenaPop(addrspace0));
+    REQUIRE(memAllocSize(addrspace0) == 110);
+    REQUIRE(memAlloc(64, 8, 0, addrspace0) == scoped);
+
+    // 핸들로 부르는 쪽도 같은 스택을 씀
+    {
+        MemArenaScope scope(space);
+        REQUIRE(scope.pushed);
+        REQUIRE(memAlloc(32, 8, 0, addrspace0) != nullptr);
+    }
+    REQUIRE(memAllocSize(addrspace0) == 110 + 64);
+    REQUIRE(memArenaPushH(space));
+    REQUIRE(memAlloc(32, 8, 0, addrspace0) != nullptr);
+    REQUIRE(memArenaPopH(space));
+    REQUIRE(memAllocSize(addrspace0) == 110 + 64);
+
+    auto pageTotal = memPageSize(addrspace0);
+    REQUIRE(pageTotal >= pageSize * 4);
+    REQUIRE(memPageSizeH(space) == pageTotal);
+
+    // 리셋 후에는 처음 위치부터 다시 쓰고 페이지는 유지
+    REQUIRE(memArenaReset(addrspace0));
+    REQUIRE(memAllocSize(addrspace0) == 0);
+    REQUIRE(memPageSize(addrspace0) == pageTotal);
+    REQUIRE(memAlloc(100, 8, 0, addrspace0) == first);
+
+    size_t total = 100;
+    for (auto i = 0; i < 256; i++) {
+        auto p = (char*)memAlloc(100, 8, 0, addrspace0);
+        REQUIRE(p != nullptr);
+        memset(p, i, 100);
+        total += 100;
+    }
+    REQUIRE(memAllocSize(addrspace0) == total);
+    REQUIRE(memPageSize(addrspace0) <= pageTotal + pageSize * 8);
+
+    REQUIRE(memArenaResetH(space));
+    REQUIRE(memAllocSize(addrspace0) == 0);
+
+    REQUIRE(memPageFree(addrspace0));
+    // 지운 뒤의 핸들은 세대가 달라서 아무 공간도 가리키지 않음
+    REQUIRE_FALSE(memArenaResetH(space));
+    REQUIRE(memPageSizeH(space) == 0);
+}
+
+TEST_CASE("test memory allocate (buddy)", "[Allocator]") {
+    auto addrspace0 = L"buddy";
+    auto pageSize = memPageMinSize(true);
+    auto space = memPageAdd(addrspace0, pageSize, false, MEMPAGE_KIND_BUDDY);
+    REQUIRE(space);
+
+    // 블록은 최소 블록 크기 이상의 2의 거듭제곱이고 페이지 시작에서 크기로 정렬됨
+    auto first = (char*)memAlloc(100, 8, 0, addrspace0);
+    REQUIRE(first != nullptr);
+    REQUIRE((size_t)first % MEMBUDDY_MIN_BLOCK_SIZE == 0);
+    auto second = (char*)memAlloc(1000, 8, 0, addrspace0);
+    REQUIRE((size_t)second % 1024 == 0);
+    auto shifted = (char*)memAlloc(64, 64, 16, addrspace0);
+    REQUIRE(((size_t)shifted - 16) % 64 == 0);
+    REQUIRE(memAlloc(64, 8, MEMBUDDY_MIN_BLOCK_SIZE, addrspace0) == nullptr);
+    REQUIRE(memAllocSize(addrspace0) == 1164);
+
+    // 블록 안에서는 제자리에서 크기만 바뀜
+    REQUIRE(memRealloc(second, 1024, 8, 0, addrspace0) == second);
+    REQUIRE(memAllocSize(addrspace0) == 1188);
+
+    // 페이지보다 큰 요청은 2의 거듭제곱 크기의 새 청크로 감
+    auto big = (char*)memAlloc(pageSize * 3, 16, 0, addrspace0);
+    REQUIRE(big != nullptr);
+    memset(big, 1, pageSize * 3);
+    REQUIRE(memPageSize(addrspace0) == pageSize + pageSize * 4);
+
+    MemPageStats stats;
+    REQUIRE(memPageStats(space, &stats));
+    REQUIRE(stats.liveCount == 4);
+    REQUIRE(stats.liveBytes == memAllocSize(addrspace0));
+    REQUIRE(stats.freeBytes == pageSize - 256 - 1024 - 256);
+    REQUIRE(stats.fragmentation > 0.0f);
+
+    REQUIRE(memFree(big, addrspace0));
+    REQUIRE(memFree(shifted, addrspace0));
+    REQUIRE_FALSE(memFree(second + 256, addrspace0));
+    REQUIRE(memFree(second, addrspace0));
+    REQUIRE(memFree(first, addrspace0));
+    REQUIRE(memAllocSize(addrspace0) == 0);
+
+    // 모두 해제하면 청크마다 빈 블록 하나로 합쳐짐
+    REQUIRE(memPageStats(space, &stats));
+    REQUIRE(stats.freeBytes == memPageSize(addrspace0));
+    REQUIRE(stats.largestFreeBytes == pageSize * 4);
+    REQUIRE(memAlloc(100, 8, 0, addrspace0) == first);
+
+    REQUIRE(memTrim(space) == pageSize * 4);
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("test memory allocate (handle)", "[Allocator]") {
+    auto addrspace0 = L"handle";
+
+    auto space = memPageAdd(addrspace0, memPageMinSize(false), false);
+    REQUIRE(space);
+    REQUIRE(memPageFind(addrspace0) == space);
+    REQUIRE_FALSE(memPageAdd(addrspace0, memPageMinSize(false), false));
+    REQUIRE_FALSE(memPageAdd(SYSTEM_NAME, memPageMinSize(false), false));
+    REQUIRE(memPageFind(SYSTEM_NAME) == MEMSPACE_SYSTEM);
+    REQUIRE(memPageFind(L"") == MEMSPACE_SYSTEM);
+    REQUIRE(memPageFind(nullptr) == MEMSPACE_SYSTEM);
+    REQUIRE_FALSE(memPageFind(L"handlenone"));
+
+    auto p0 = (char*)memAllocH(100, 8, 0, space);
+    auto p1 = (char*)memAllocH(3000, 64, 0, space);
+    REQUIRE(p0 != nullptr);
+    REQUIRE(p1 != nullptr);
+    REQUIRE((size_t)p1 % 64 == 0);
+    REQUIRE(memAllocSize(addrspace0) == 3100);
+
+    // 핸들과 이름은 같은 주소 공간을 가리킴
+    REQUIRE(memFree(p0, addrspace0));
+    REQUIRE(memFreeH(p1, space));
+    REQUIRE_FALSE(memFreeH(p1, space));
+    REQUIRE(memAllocSize(addrspace0) == 0);
+
+    auto sys = memAllocH(64, 16, 0, MEMSPACE_SYSTEM);
+    REQUIRE(sys != nullptr);
+    REQUIRE(memFreeH(sys, MEMSPACE_SYSTEM));
+
+    // 해제된 주소 공간의 핸들은 같은 이름으로 다시 등록해도 쓸 수 없음
+    REQUIRE(memPageFree(addrspace0));
+    REQUIRE(memAllocH(100, 8, 0, space) == nullptr);
+    REQUIRE_FALSE(memFreeH(p0, space));
+    REQUIRE(memAllocH(100, 8, 0, MEMSPACE_INVALID) == nullptr);
+
+    auto space2 = memPageAdd(addrspace0, memPageMinSize(false), false);
+    REQUIRE(space2);
+    REQUIRE(space2 != space);
+    REQUIRE(memAllocH(100, 8, 0, space) == nullptr);
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("test memory reallocate", "[Allocator]") {
+    auto addrspace0 = L"realloc";
+    auto space = memPageAdd(addrspace0, memPageMinSize(false), false);
+    REQUIRE(space);
+
+    SECTION("range") {
+        // 뒤쪽이 비어 있으면 주소를 유지하고 늘어남
+        auto p0 = (uint8*)memReallocH(nullptr, 1000, 64, 0, space);
+        REQUIRE(p0 != nullptr);
+        for (auto i = 0; i < 1000; i++) {
+            p0[i] = (uint8)i;
+        }
+        REQUIRE(memReallocH(p0, 4000, 64, 0, space) == p0);
+        REQUIRE(memAllocSize(addrspace0) == 4000);
+
+        // 줄이면 남는 뒤쪽을 다른 할당이 씀
+        REQUIRE(memReallocH(p0, 2000, 64, 0, space) == p0);
+        REQUIRE(memAllocSize(addrspace0) == 2000);
+        auto p1 = (uint8*)memAllocH(1000, 8, 0, space);
+        REQUIRE(p1 == p0 + 2000);
+
+        // 뒤가 막혀 있으면 옮기고 이전 블록은 해제
+        auto p2 = (uint8*)memReallocH(p0, 8000, 64, 0, space);
+        REQUIRE(p2 != nullptr);
+        REQUIRE(p2 != p0);
+        REQUIRE((size_t)p2 % 64 == 0);
+        for (auto i = 0; i < 1000; i++) {
+            REQUIRE(p2[i] == (uint8)i);
+        }
+        REQUIRE_FALSE(memFreeH(p0, space));
+        REQUIRE(memAllocSize(addrspace0) == 9000);
+
+        // 정렬이 맞지 않으면 제자리에서 늘리지 않음
+        auto p3 = (uint8*)memReallocH(p1, 1500, 4096, 0, space);
+        REQUIRE(p3 != nullptr);
+        REQUIRE((size_t)p3 % 4096 == 0);
+
+        REQUIRE(memReallocH(p1, 100, 8, 0, space) == nullptr);
+        REQUIRE(memFreeH(p2, space));
+        REQUIRE(memFreeH(p3, space));
+        REQUIRE(memAllocSize(addrspace0) == 0);
+    }
+
+    SECTION("cache") {
+        // 같은 크기 클래스 안에서는 그대로, 넘으면 범위 할당으로 옮김
+        auto p0 = (uint8*)memAllocH(40, 8, 0, space);
+        REQUIRE(p0 != nullptr);
+        memset(p0, 7, 40);
+        REQUIRE(memReallocH(p0, 48, 8, 0, space) == p0);
+        REQUIRE(memAllocSize(addrspace0) == 48);
+
+        auto p1 = (uint8*)memReallocH(p0, 3000, 8, 0, space);
+        REQUIRE(p1 != nullptr);
+        REQUIRE(p1 != p0);
+        for (auto i = 0; i < 40; i++) {
+            REQUIRE(p1[i] == 7);
+        }
+        REQUIRE(memAllocSize(addrspace0) == 3000);
+        REQUIRE(memFreeH(p1, space));
+        REQUIRE(memAllocSize(addrspace0) == 0);
+    }
+
+    SECTION("system") {
+        auto p0 = (uint8*)memRealloc(nullptr, 100, 64, 0);
+        REQUIRE(p0 != nullptr);
+        for (auto i = 0; i < 100; i++) {
+            p0[i] = (uint8)i;
+        }
+
+        // 여러 번 옮겨도 정렬과 내용이 유지됨
+        auto p1 = p0;
+        for (size_t size = 200; size < 4 * 1024 * 1024; size *= 2) {
+            p1 = (uint8*)memRealloc(p1, size, 64, 0);
+            REQUIRE(p1 != nullptr);
+            REQUIRE((size_t)p1 % 64 == 0);
+        }
+        for (auto i = 0; i < 100; i++) {
+            REQUIRE(p1[i] == (uint8)i);
+        }
+        REQUIRE(memFree(p1));
+    }
+
+    SECTION("arena") {
+        auto addrspace1 = L"reallocarena";
+        auto arena = memPageAdd(addrspace1, memPageMinSize(false), false, MEMPAGE_KIND_ARENA);
+        REQUIRE(arena);
+
+        auto p0 = (uint8*)memAllocH(64, 8, 0, arena);
+        memset(p0, 3, 64);
+        auto p1 = (uint8*)memReallocH(p0, 256, 8, 0, arena);
+        REQUIRE(p1 != nullptr);
+        for (auto i = 0; i < 64; i++) {
+            REQUIRE(p1[i] == 3);
+        }
+        REQUIRE(memPageFree(addrspace1));
+    }
+
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("test memory allocate (page options)", "[Allocator]") {
+    const uint32 options[] = { 0, MEMPAGE_FLAG_PREFAULT, MEMPAGE_FLAG_HUGE, MEMPAGE_FLAG_HUGE | MEMPAGE_FLAG_PREFAULT };
+
+    REQUIRE_FALSE(memPageAdd(L"pageoption", memPageMinSize(false), false, MEMPAGE_KIND_DEFAULT, 1 << 10));
+
+    for (auto option : options) {
+        auto addrspace0 = L"pageoption";
+        auto space = memPageAdd(addrspace0, memPageMinSize(false), false, MEMPAGE_KIND_DEFAULT, option);
+        REQUIRE(space);
+
+        // 페이지 크기를 넘는 할당과 작은 할당이 모두 정렬과 내용을 유지해야 함
+        auto big = (char*)memAllocH(memPageMinSize(false) * 2 + 100, 4096, 0, space);
+        auto small = (char*)memAllocH(48, 16, 0, space);
+        REQUIRE(big != nullptr);
+        REQUIRE(small != nullptr);
+        REQUIRE((size_t)big % 4096 == 0);
+        memset(big, 0x5A, memPageMinSize(false) * 2 + 100);
+        memset(small, 0x33, 48);
+        REQUIRE(big[memPageMinSize(false) * 2 + 99] == 0x5A);
+        REQUIRE(memPageSize(addrspace0) >= memPageMinSize(false) * 3);
+
+        REQUIRE(memFreeH(big, space));
+        REQUIRE(memFreeH(small, space));
+        REQUIRE(memPageFree(addrspace0));
+    }
+
+    // 잠긴 작은 페이지
+    auto locked = memPageAdd(L"pageoptionlocked", memPageMinSize(true), true, MEMPAGE_KIND_DEFAULT, MEMPAGE_FLAG_PREFAULT);
+    REQUIRE(locked);
+    auto p = memAllocH(1000, 8, 0, locked);
+    REQUIRE(p != nullptr);
+    REQUIRE(memFreeH(p, locked));
+    REQUIRE(memPageFree(L"pageoptionlocked"));
+
+    // system 주소 공간의 offset 정렬
+    auto sys = (char*)memAlloc(100, 64, 8);
+    REQUIRE(sys != nullptr);
+    REQUIRE((size_t)(sys + 8) % 64 == 0);
+    REQUIRE(memFree(sys));
+}
+
+TEST_CASE("test memory allocate (warm)", "[Allocator]") {
+    const size_t warmBytes = 64 * 1024 * 1024;
+
+    // 백그라운드 스레드가 끝낼 때까지 기다림
+    auto waitWarm = [](MemSpace space) {
+        for (auto i = 0; i < 10000 && memPageWarmState(space) == MEMWARM_WARMING; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return memPageWarmState(space);
+    };
+
+    REQUIRE_FALSE(memPageWarm(MEMSPACE_INVALID));
+    REQUIRE(memPageWarmState(MEMSPACE_INVALID) == MEMWARM_COLD);
+
+    SECTION("on demand") {
+        auto addrspace0 = L"warm";
+        auto space = memPageAdd(addrspace0, memPageMinSize(false), false);
+        REQUIRE(space);
+        REQUIRE(memPageWarmState(space) == MEMWARM_COLD);
+
+        // 이미 쓰고 있는 내용은 채우는 동안 바뀌지 않음
+        auto p = (uint8*)memAllocH(1000, 16, 0, space);
+        REQUIRE(p != nullptr);
+        memset(p, 0x6B, 1000);
+        REQUIRE(memPageWarmState(space) == MEMWARM_COLD);
+
+        auto resident = ResidentBytes();
+        REQUIRE(memPageWarm(space, warmBytes));
+        REQUIRE(memPageSize(addrspace0) >= warmBytes);
+        REQUIRE(waitWarm(space) == MEMWARM_WARM);
+        REQUIRE(ResidentBytes() > resident + warmBytes / 2);
+        for (auto i = 0; i < 1000; i++) {
+            REQUIRE(p[i] == 0x6B);
+        }
+
+        // 이미 받은 만큼은 더 받지 않음
+        auto pageSize = memPageSize(addrspace0);
+        REQUIRE(memPageWarm(space, warmBytes));
+        REQUIRE(memPageSize(addrspace0) == pageSize);
+        REQUIRE(memPageWarmState(space) == MEMWARM_WARM);
+
+        // 돌려줬다가 다시 받은 청크는 다시 차가움
+        REQUIRE(memFreeH(p, space));
+        REQUIRE(memTrim(space) > 0);
+        p = (uint8*)memAllocH(1000, 16, 0, space);
+        REQUIRE(memPageWarmState(space) == MEMWARM_COLD);
+        REQUIRE(memFreeH(p, space));
+        REQUIRE(memPageFree(addrspace0));
+    }
+
+    SECTION("page flag") {
+        auto addrspace0 = L"warmflag";
+        auto space = memPageAdd(addrspace0, warmBytes, false, MEMPAGE_KIND_DEFAULT, MEMPAGE_FLAG_WARM);
+        REQUIRE(space);
+        REQUIRE(memPageSize(addrspace0) == warmBytes);
+
+        // 채우는 중에도 할당할 수 있음
+        auto p = (uint8*)memAllocH(4 * 1024 * 1024, 64, 0, space);
+        REQUIRE(p != nullptr);
+        memset(p, 0x21, 4 * 1024 * 1024);
+        REQUIRE(memPageWarmState(space) != MEMWARM_COLD);
+        REQUIRE(waitWarm(space) == MEMWARM_WARM);
+        REQUIRE(p[4 * 1024 * 1024 - 1] == 0x21);
+
+        // 새로 받는 청크도 채움
+        auto big = memAllocH(warmBytes, 64, 0, space);
+        REQUIRE(big != nullptr);
+        REQUIRE(waitWarm(space) == MEMWARM_WARM);
+        REQUIRE(memFreeH(big, space));
+        REQUIRE(memFreeH(p, space));
+        REQUIRE(memPageFree(addrspace0));
+
+        // 채우는 중에 해제해도 됨
+        for (auto i = 0; i < 8; i++) {
+            REQUIRE(memPageAdd(addrspace0, warmBytes, false, MEMPAGE_KIND_ARENA, MEMPAGE_FLAG_WARM));
+            REQUIRE(memPageFree(addrspace0));
+        }
+
+        // 채우는 중인 청크는 비어 있어도 돌려주지 않고, 나머지는 돌려줘도 상태가 맞음
+        for (auto i = 0; i < 8; i++) {
+            space = memPageAdd(addrspace0, warmBytes, false, MEMPAGE_KIND_DEFAULT, MEMPAGE_FLAG_WARM);
+            REQUIRE(space);
+            auto q = memAllocH(1000, 16, 0, space);
+            REQUIRE(q != nullptr);
+            REQUIRE(memFreeH(q, space));
+            memTrim(space);
+            auto state = waitWarm(space);
+            REQUIRE(state != MEMWARM_WARMING);
+            REQUIRE((state == MEMWARM_WARM) == (memPageSize(addrspace0) > 0));
+            REQUIRE(memPageFree(addrspace0));
+        }
+    }
+
+    SECTION("prefault") {
+        auto addrspace0 = L"warmprefault";
+        auto space = memPageAdd(addrspace0, memPageMinSize(false), false, MEMPAGE_KIND_BUDDY, MEMPAGE_FLAG_PREFAULT);
+        REQUIRE(space);
+        REQUIRE(memPageWarm(space, memPageMinSize(false)));
+        REQUIRE(memPageWarmState(space) == MEMWARM_WARM);
+        REQUIRE(memPageFree(addrspace0));
+    }
+}
+
+TEST_CASE("test memory allocate (trim)", "[Allocator]") {
+    const int count = 32;
+    const size_t blockSize = 4 * 1024 * 1024;
+    const size_t liveBytes = count * blockSize;
+    std::vector<char*> blocks(count);
+
+    auto fill = [&](MemSpace space) {
+        for (auto& block : blocks) {
+            block = (char*)memAllocH(blockSize, 64, 0, space);
+            REQUIRE(block != nullptr);
+            memset(block, 0x7F, blockSize);
+        }
+    };
+    auto release = [&](MemSpace space) {
+        for (auto block : blocks) {
+            REQUIRE(memFreeH(block, space));
+        }
+    };
+
+    SECTION("trim on demand") {
+        auto addrspace0 = L"trim";
+        auto space = memPageAdd(addrspace0, memPageMinSize(false), false);
+        REQUIRE(space);
+
+        fill(space);
+        auto pageSize = memPageSize(addrspace0);
+        auto peak = ResidentBytes();
+
+        // 기본 정책은 빈 페이지를 모두 보관
+        release(space);
+        REQUIRE(memPageSize(addrspace0) == pageSize);
+        REQUIRE(ResidentBytes() + liveBytes / 2 > peak);
+
+        REQUIRE(memTrim(space) == pageSize);
+        REQUIRE(memPageSize(addrspace0) == 0);
+        REQUIRE(ResidentBytes() + liveBytes / 2 < peak);
+        REQUIRE(memTrim(space) == 0);
+
+        // 돌려준 청크 자리를 다시 씀
+        fill(space);
+        REQUIRE(memPageSize(addrspace0) == pageSize);
+        release(space);
+        REQUIRE(memPageFree(addrspace0));
+    }
+
+    SECTION("retain policy") {
+        auto addrspace0 = L"trimretain";
+        auto space = memPageAdd(addrspace0, memPageMinSize(false), false);
+        REQUIRE(space);
+        REQUIRE(memPageSetTrim(space, 1, MEMTRIM_DECOMMIT));
+        REQUIRE_FALSE(memPageSetTrim(space, 1, 7));
+        REQUIRE_FALSE(memPageSetTrim(MEMSPACE_INVALID, 1));
+
+        fill(space);
+        auto pageSize = memPageSize(addrspace0);
+        auto peak = ResidentBytes();
+
+        // 비워지는 즉시 한 페이지만 남기고 돌려줌, 주소 범위는 남음
+        release(space);
+        REQUIRE(memPageSize(addrspace0) == pageSize);
+        REQUIRE(ResidentBytes() + liveBytes / 2 < peak);
+        REQUIRE(memTrim(space) == memPageMinSize(false));
+
+        fill(space);
+        REQUIRE(memPageSize(addrspace0) == pageSize);
+        REQUIRE(blocks[count - 1][blockSize - 1] == 0x7F);
+        release(space);
+        REQUIRE(memPageFree(addrspace0));
+    }
+
+    SECTION("arena") {
+        auto addrspace0 = L"trimarena";
+        auto space = memPageAdd(addrspace0, memPageMinSize(false), false, MEMPAGE_KIND_ARENA);
+        REQUIRE(space);
+
+        fill(space);
+        auto pageSize = memPageSize(addrspace0);
+
+        // 리셋 이후 첫 청크만 남김
+        REQUIRE(memArenaReset(addrspace0));
+        REQUIRE(memTrim(space) + memPageMinSize(false) == pageSize);
+        REQUIRE(memPageSize(addrspace0) == memPageMinSize(false));
+
+        fill(space);
+        REQUIRE(memPageSize(addrspace0) == pageSize);
+        REQUIRE(memPageFree(addrspace0));
+    }
+}
+
+TEST_CASE("test memory allocate (relocatable)", "[Allocator]") {
+    auto addrspace0 = L"relocatable";
+    auto space = memPageAdd(addrspace0, memPageMinSize(false), false);
+    REQUIRE(space);
+
+    const size_t blockSize = 1000;
+    const int32 count = (int32)(memPageMinSize(false) / blockSize) * 4;
+
+    REQUIRE_FALSE(memHandleAlloc(100, 16, MEMSPACE_SYSTEM));
+    REQUIRE_FALSE(memHandleAlloc(0, 16, space));
+    REQUIRE_FALSE(memHandleAlloc(100, 24, space));
+    REQUIRE(memHandlePin(MEMHANDLE_NULL) == nullptr);
+
+    std::vector<MemHandle> handles(count);
+    for (auto i = 0; i < count; i++) {
+        handles[i] = memHandleAlloc(blockSize, 16, space);
+        REQUIRE(handles[i]);
+        auto p = (int32*)memHandlePin(handles[i]);
+        REQUIRE(p != nullptr);
+        REQUIRE((size_t)p % 16 == 0);
+        p[0] = i;
+        p[blockSize / sizeof(int32) - 1] = ~i;
+        REQUIRE(memHandleUnpin(handles[i]));
+    }
+    REQUIRE(memHandleSize(handles[0]) == blockSize);
+    REQUIRE_FALSE(memHandleUnpin(handles[0]));
+    auto pageSize = memPageSize(addrspace0);
+
+    // 넷 중 하나만 남겨서 모든 청크에 구멍을 냄
+    std::vector<int32> kept;
+    for (auto i = 0; i < count; i++) {
+        if (i % 4 == 0) {
+            kept.push_back(i);
+        } else {
+            REQUIRE(memHandleFree(handles[i]));
+        }
+    }
+    REQUIRE_FALSE(memHandleFree(handles[1]));
+    REQUIRE(memHandlePin(handles[1]) == nullptr);
+    REQUIRE(memHandleSize(handles[1]) == 0);
+    REQUIRE(memAllocSize(addrspace0) == kept.size() * blockSize);
+
+    // 고정된 블록은 해제하거나 옮기지 않음
+    auto pinned = handles[kept.back()];
+    auto pinnedPtr = memHandlePin(pinned);
+    REQUIRE_FALSE(memHandleFree(pinned));
+
+    // 옮길 양을 제한하면 조금씩 나눠서 진행
+    MemCompactStats stats;
+    REQUIRE_FALSE(memCompact(MEMSPACE_INVALID, 0, &stats));
+    REQUIRE(memCompact(space, 1, &stats));
+    REQUIRE(stats.movedCount == 1);
+    REQUIRE(stats.movedBytes == blockSize);
+
+    REQUIRE(memCompact(space, ~(size_t)0, &stats));
+    REQUIRE(stats.movedCount > 0);
+    REQUIRE(stats.pinnedCount == 1);
+    REQUIRE(stats.releasedBytes > 0);
+    REQUIRE(memPageSize(addrspace0) + stats.releasedBytes == pageSize);
+    REQUIRE(memAllocSize(addrspace0) == kept.size() * blockSize);
+
+    REQUIRE(memHandlePin(pinned) == pinnedPtr);
+    REQUIRE(memHandleUnpin(pinned));
+    REQUIRE(memHandleUnpin(pinned));
+
+    for (auto i : kept) {
+        auto p = (int32*)memHandlePin(handles[i]);
+        REQUIRE((size_t)p % 16 == 0);
+        REQUIRE(p[0] == i);
+        REQUIRE(p[blockSize / sizeof(int32) - 1] == ~i);
+        REQUIRE(memHandleUnpin(handles[i]));
+    }
+
+    // 고정을 풀면 마지막 블록도 앞으로 옮기고 청크를 돌려줌
+    auto compactedSize = memPageSize(addrspace0);
+    REQUIRE(memCompact(space, ~(size_t)0, &stats));
+    REQUIRE(stats.pinnedCount == 0);
+    REQUIRE(memPageSize(addrspace0) < compactedSize);
+    REQUIRE(memHandlePin(pinned) != pinnedPtr);
+    REQUIRE(memHandleUnpin(pinned));
+
+    for (auto i : kept) {
+        REQUIRE(memHandleFree(handles[i]));
+    }
+    REQUIRE(memAllocSize(addrspace0) == 0);
+
+    // 압축 전부터 비어 있던 청크는 RETAIN_ALL 이면 남겨둠
+    auto emptySize = memPageSize(addrspace0);
+    REQUIRE(emptySize > 0);
+    REQUIRE(memCompact(space, ~(size_t)0, &stats));
+    REQUIRE(stats.movedCount == 0);
+    REQUIRE(stats.releasedBytes == 0);
+    REQUIRE(memPageSize(addrspace0) == emptySize);
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("test memory allocate (stats)", "[Allocator]") {
+    auto addrspace0 = L"stats";
+    auto space = memPageAdd(addrspace0, memPageMinSize(false), false);
+    REQUIRE(space);
+    REQUIRE(memPageSetSampling(space, 1));
+
+    MemPageStats stats;
+    REQUIRE_FALSE(memPageStats(MEMSPACE_SYSTEM, &stats));
+    REQUIRE(memPageStats(space, &stats));
+    REQUIRE(stats.allocCount == 0);
+    REQUIRE(stats.liveBytes == 0);
+
+    // 스레드 캐시로 가는 작은 크기와 범위로 가는 큰 크기를 섞음
+    const int count = 64;
+    const size_t sizes[] = { 24, 200, 4000, 100000 };
+    std::vector<void*> blocks;
+    size_t liveBytes = 0;
+    for (auto i = 0; i < count; i++) {
+        auto size = sizes[i % 4];
+        blocks.push_back(memAllocH(size, 8, 0, space));
+        REQUIRE(blocks.back() != nullptr);
+        liveBytes += size;
+    }
+
+    REQUIRE(memPageStats(space, &stats));
+    REQUIRE(stats.liveBytes == liveBytes);
+    REQUIRE(stats.liveBytes == memAllocSize(addrspace0));
+    REQUIRE(stats.peakBytes >= liveBytes);
+    REQUIRE(stats.allocCount == count);
+    REQUIRE(stats.liveCount == count);
+    REQUIRE(stats.sizeHistogram[MemStatSizeBucket(24)] == count / 4);
+    REQUIRE(stats.sizeHistogram[MemStatSizeBucket(200)] == count / 4);
+    REQUIRE(stats.sizeHistogram[MemStatSizeBucket(4000)] == count / 4);
+    REQUIRE(stats.sizeHistogram[MemStatSizeBucket(100000)] == count / 4);
+    REQUIRE(stats.pageBytes == memPageSize(addrspace0));
+    REQUIRE(stats.chunkCount >= 1);
+    REQUIRE(stats.latencySampleCount == count);
+    REQUIRE(stats.latencyP50Ns <= stats.latencyP99Ns);
+
+    // 큰 블록을 하나 건너 하나씩 해제하면 빈 공간이 흩어짐
+    auto fragmentedBefore = stats.fragmentation;
+    for (auto i = 3; i < count; i += 8) {
+        REQUIRE(memFreeH(blocks[i], space));
+        liveBytes -= sizes[3];
+        blocks[i] = nullptr;
+    }
+    REQUIRE(memPageStats(space, &stats));
+    REQUIRE(stats.liveBytes == liveBytes);
+    REQUIRE(stats.liveCount == count - count / 8);
+    REQUIRE(stats.peakBytes > liveBytes);
+    REQUIRE(stats.freeBytes > stats.largestFreeBytes);
+    REQUIRE(stats.fragmentation > fragmentedBefore);
+
+    wchar_t dump[1024];
+    auto length = memPageDump(space, dump, 1024);
+    REQUIRE(length > 0);
+    REQUIRE(length < 1024);
+    REQUIRE(wcslen(dump) == length);
+    REQUIRE(wcsstr(dump, L"[stats]") != nullptr);
+    REQUIRE(wcsstr(dump, L"p99") != nullptr);
+
+    // 잘려도 필요한 길이를 돌려줌
+    wchar_t small[16];
+    REQUIRE(memPageDump(space, small, 16) == length);
+    REQUIRE(wcslen(small) == 15);
+
+    for (auto p : blocks) {
+        if (p) {
+            REQUIRE(memFreeH(p, space));
+        }
+    }
+    REQUIRE(memPageStats(space, &stats));
+    REQUIRE(stats.liveBytes == 0);
+    REQUIRE(stats.liveCount == 0);
+    REQUIRE(memPageFree(addrspace0));
+
+    // 아레나는 되돌릴 때 개수도 되돌림
+    auto arena = memPageAdd(L"statsarena", memPageMinSize(false), false, MEMPAGE_KIND_ARENA);
+    REQUIRE(memAllocH(100, 8, 0, arena) != nullptr);
+    REQUIRE(memArenaPush(L"statsarena"));
+    REQUIRE(memAllocH(100, 8, 0, arena) != nullptr);
+    REQUIRE(memAllocH(100, 8, 0, arena) != nullptr);
+    REQUIRE(memArenaPop(L"statsarena"));
+    REQUIRE(memPageStats(arena, &stats));
+    REQUIRE(stats.allocCount == 3);
+    REQUIRE(stats.liveCount == 1);
+    REQUIRE(stats.freeBytes == memPageMinSize(false) - 100);
+    REQUIRE(stats.fragmentation == 0.0f);
+    REQUIRE(memPageFree(L"statsarena"));
+}
+
+TEST_CASE("test memory allocate (multi thread)", "[Allocator]") {
+    auto addrspace0 = L"multithread";
+    const int threadCount = 8;
+    const int liveCount = 2048;
+
+    std::vector<std::vector<char*>> live(threadCount, std::vector<char*>(liveCount));
+    std::vector<std::vector<uint32>> sizes(threadCount, std::vector<uint32>(liveCount));
+    std::atomic<int> failed(0);
+
+    auto fill = [](char* p, uint32 size, int tag) {
+        for (uint32 j = 0; j < size; j++) {
+            p[j] = (char)(tag + j);
+        }
+    };
+    auto check = [](char* p, uint32 size, int tag) {
+        for (uint32 j = 0; j < size; j++) {
+            if (p[j] != (char)(tag + j)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // 스레드마다 작은/큰 할당을 섞어 반복하고 절반은 살려둠
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t]() {
+            uint32 seed = 777 + t;
+            for (int i = 0; i < liveCount * 4; i++) {
+                seed = seed * 1664525u + 1013904223u;
+                auto slot = (seed >> 8) % liveCount;
+                if (live[t][slot]) {
+                    if (!check(live[t][slot], sizes[t][slot], t) || !memFree(live[t][slot], addrspace0)) {
+                        failed++;
+                    }
+                    live[t][slot] = nullptr;
+                } else {
+                    auto size = (seed >> 4) % 16 == 0? 300 + (seed >> 12) % 2000: (seed >> 12) % 257;
+                    auto alignment = (seed >> 20) % 8 == 0? 64: 8;
+                    auto p = (char*)memAlloc(size, alignment, 0, addrspace0);
+                    if (p == nullptr || (size_t)p % alignment != 0) {
+                        failed++;
+                        continue;
+                    }
+                    fill(p, size, t);
+                    live[t][slot] = p;
+                    sizes[t][slot] = size;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(failed == 0);
+
+    // 다른 스레드가 할당한 블록 해제
+    threads.clear();
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t]() {
+            auto owner = (t + 1) % threadCount;
+            for (int i = 0; i < liveCount; i++) {
+                auto p = live[owner][i];
+                if (p && (!check(p, sizes[owner][i], owner) || !memFree(p, addrspace0))) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(failed == 0);
+
+    // 끝난 스레드의 캐시는 주소 공간으로 돌아가 있어야 함
+    REQUIRE(memAllocSize(addrspace0) == 0);
+    MemPageStats stats;
+    REQUIRE(memPageStats(memPageFind(addrspace0), &stats));
+    REQUIRE(stats.liveCount == 0);
+    REQUIRE(stats.allocCount > 0);
+    REQUIRE(stats.peakBytes > 0);
+    for (int i = 0; i < liveCount; i++) {
+        if (live[0][i]) {
+            REQUIRE_FALSE(memFree(live[0][i], addrspace0));
+            break;
+        }
+    }
+
+    REQUIRE(memPageFree(addrspace0));
+}
@@ -1,6 +1,9 @@
 #include "common.h"
+#include "typedarraylist.h"
 #include "catch.hpp"
 
+#include <string>
+
 struct TestData {
     uint64 d0;
     uint64 d1;
@@ -104,3 +107,233 @@ TEST_CASE("test ArrayList", "[Container.ArrayList]") {
 
     REQUIRE(list.Destroy());
 }
+
+TEST_CASE("test ArrayList growth", "[Container.ArrayList]") {
+    auto addrspace = L"arraylistgrowth";
+    REQUIRE(memPageAdd(addrspace, memPageMinSize(false), false));
+
+    ArrayList list;
+    REQUIRE(list.Init(addrspace, sizeof(TestData), ArrayList::s_DefaultAlignment, 1));
+
+    // 커질 때 이전 블록을 해제하므로 주소 공간에는 현재 용량만 남음
+    auto moveCount = 0;
+    auto start = list.Start();
+    for (uint64 i = 0; i < 10000; i++) {
+        TestData data = { i, i + 1, i + 2, i + 3 };
+        REQUIRE(list.InsertLast(1, &data, nullptr));
+        REQUIRE(memAllocSize(addrspace) == list.Capacity() * sizeof(TestData));
+
+        if (list.Start() != start) {
+            start = list.Start();
+            moveCount++;
+        }
+    }
+    for (uint64 i = 0; i < 10000; i++) {
+        REQUIRE(((TestData*)list[i])->d0 == i);
+    }
+
+    // 다른 할당이 없으면 뒤쪽 빈 공간으로 늘어남
+    REQUIRE(moveCount <= 1);
+
+    REQUIRE(list.Destroy());
+    REQUIRE(memAllocSize(addrspace) == 0);
+    REQUIRE(memPageFree(addrspace));
+}
+
+TEST_CASE("test ArrayList insert before last", "[Container.ArrayList]") {
+    ArrayList list;
+    REQUIRE(list.Init(nullptr, sizeof(uint64), alignof(uint64), 4));
+
+    // 마지막 원소 앞에 넣어도 마지막 원소가 뒤로 밀림
+    uint64 values[] = { 0, 2, 1 };
+    REQUIRE(list.InsertLast(2, values, nullptr));
+    REQUIRE(list.Insert(1, 1, values + 2, nullptr));
+    REQUIRE(list.Count() == 3);
+    for (uint64 i = 0; i < 3; i++) {
+        REQUIRE(*(uint64*)list[i] == i);
+    }
+    REQUIRE(list.Destroy());
+}
+
+// 생성/소멸 횟수를 세는 복사 불가능하지 않은 타입
+struct TrackedValue
+{
+    static int32 s_LiveCount;
+    static int32 s_MoveCount;
+
+    std::string name;
+
+    TrackedValue(const char* name) : name(name) { s_LiveCount++; }
+    TrackedValue(const TrackedValue& o) : name(o.name) { s_LiveCount++; }
+    TrackedValue(TrackedValue&& o) noexcept : name(std::move(o.name)) { s_LiveCount++; s_MoveCount++; }
+    TrackedValue& operator=(const TrackedValue& o) = default;
+    TrackedValue& operator=(TrackedValue&& o) noexcept { name = std::move(o.name); s_MoveCount++; return *this; }
+    ~TrackedValue() { s_LiveCount--; }
+};
+int32 TrackedValue::s_LiveCount = 0;
+int32 TrackedValue::s_MoveCount = 0;
+
+TEST_CASE("test TypedArrayList", "[Container.ArrayList]") {
+    static_assert(sizeof(TypedArrayList<TestData>) == sizeof(ArrayList), "same layout as ArrayList");
+
+    SECTION("trivially copyable") {
+        auto addrspace = L"typedarraylist";
+        REQUIRE(memPageAdd(addrspace, memPageMinSize(false), false));
+
+        TypedArrayList<TestData> list;
+        REQUIRE(list.Init(addrspace, 1));
+        for (uint64 i = 0; i < 100; i++) {
+            REQUIRE(list.InsertLast({ i, i, i, i }));
+        }
+        REQUIRE(list.Count() == 100);
+        REQUIRE(list.Capacity() >= 100);
+        REQUIRE(list[99].d0 == 99);
+        REQUIRE(((TestData*)list.Raw()[42])->d3 == 42);
+
+        // 한 번에 여러 개를 끼워넣음
+        TestData inserted[3] = { { 1000, 0, 0, 0 }, { 1001, 0, 0, 0 }, { 1002, 0, 0, 0 } };
+        REQUIRE(list.InsertRange(99, inserted, 3));
+        REQUIRE_FALSE(list.InsertRange(200, inserted, 3));
+        REQUIRE(list.Count() == 103);
+        REQUIRE(list[98].d0 == 98);
+        REQUIRE(list[99].d0 == 1000);
+        REQUIRE(list[101].d0 == 1002);
+        REQUIRE(list[102].d0 == 99);
+
+        // 순서를 유지하면서 조건에 맞는 원소를 지움
+        REQUIRE(list.EraseIf([](const TestData& data) { return data.d0 % 2 == 1; }) == 51);
+        REQUIRE(list.Count() == 52);
+        for (auto i = 0; i < 49; i++) {
+            REQUIRE(list[i].d0 == (uint64)i * 2);
+        }
+        REQUIRE(list[50].d0 == 1000);
+        REQUIRE(list[51].d0 == 1002);
+
+        REQUIRE(list.RemoveSwap(0));
+        REQUIRE(list[0].d0 == 1002);
+        REQUIRE(list.Count() == 51);
+        REQUIRE_FALSE(list.RemoveSwap(51));
+        REQUIRE(list.Remove(0, 2));
+        REQUIRE(list[0].d0 == 4);
+
+        REQUIRE(list.Reserve(1000));
+        REQUIRE(list.Capacity() == 1000);
+        REQUIRE(list.ShrinkToFit());
+        REQUIRE(list.Capacity() == 49);
+        REQUIRE(memAllocSize(addrspace) == 49 * sizeof(TestData));
+        REQUIRE(list[48].d0 == 1000);
+
+        REQUIRE(list.Destroy());
+        REQUIRE(memAllocSize(addrspace) == 0);
+        REQUIRE(memPageFree(addrspace));
+    }
+
+    SECTION("move only on growth") {
+        TrackedValue::s_LiveCount = 0;
+        TrackedValue::s_MoveCount = 0;
+
+        TypedArrayList<TrackedValue> list;
+        REQUIRE(list.Init(nullptr, 1));
+        const char* names[] = { "a", "b", "c", "d", "e", "f", "g", "h" };
+        for (auto name : names) {
+            REQUIRE(list.EmplaceLast(name) != nullptr);
+        }
+        REQUIRE(TrackedValue::s_LiveCount == 8);
+        // 1 -> 2 -> 4 -> 8 로 늘면서 이전 원소를 이동 생성
+        REQUIRE(TrackedValue::s_MoveCount == 1 + 2 + 4);
+
+        TrackedValue inserted[] = { "x", "y" };
+        REQUIRE(list.InsertRange(1, inserted, 2));
+        REQUIRE(list.Count() == 10);
+        REQUIRE(list[0].name == "a");
+        REQUIRE(list[1].name == "x");
+        REQUIRE(list[2].name == "y");
+        REQUIRE(list[3].name == "b");
+        REQUIRE(list.Last().name == "h");
+
+        REQUIRE(list.RemoveSwap(0));
+        REQUIRE(list[0].name == "h");
+        REQUIRE(list.Remove(1, 2));
+        REQUIRE(list[1].name == "b");
+        REQUIRE(list.EraseIf([](const TrackedValue& value) { return value.name < "d"; }) == 2);
+        REQUIRE(list.Count() == 5);
+        REQUIRE(list[0].name == "h");
+        REQUIRE(list[1].name == "d");
+        REQUIRE(list.Last().name == "g");
+        REQUIRE(TrackedValue::s_LiveCount == 5 + 2);
+
+        REQUIRE(list.ShrinkToFit());
+        REQUIRE(list.Capacity() == 5);
+        REQUIRE(list[4].name == "g");
+
+        REQUIRE(list.Destroy());
+        REQUIRE(TrackedValue::s_LiveCount == 2);
+    }
+
+    SECTION("insert own element on growth") {
+        // 가득 찬 목록에 자기 원소를 넣으면 늘리면서 이전 블록을 풀기 전에 읽어야 함
+        TypedArrayList<TestData> trivial;
+        REQUIRE(trivial.Init(nullptr, 1));
+        REQUIRE(trivial.InsertLast({ 7, 8, 9, 10 }));
+        // 1 -> 2 -> 4 -> 8 로 늘 때마다 마지막 원소를 넣음
+        for (auto i = 0; i < 6; i++) {
+            REQUIRE(trivial.InsertLast(trivial.Last()));
+        }
+        REQUIRE(trivial.Count() == 7);
+        REQUIRE(trivial.Capacity() == 8);
+        for (auto i = 0; i < 7; i++) {
+            REQUIRE(trivial[i].d0 == 7);
+            REQUIRE(trivial[i].d3 == 10);
+        }
+        REQUIRE(trivial.Destroy());
+
+        TypedArrayList<TrackedValue> list;
+        REQUIRE(list.Init(nullptr, 1));
+        REQUIRE(list.EmplaceLast("first") != nullptr);
+        REQUIRE(list.InsertLast(list[0]));
+        REQUIRE(list.EmplaceLast(list.Last()) != nullptr);
+        REQUIRE(list.Count() == 3);
+        REQUIRE(list.Capacity() == 4);
+        REQUIRE(list.InsertLast(list[1]));
+        REQUIRE(list.EmplaceLast(list[2].name.c_str()) != nullptr);
+        REQUIRE(list.Capacity() == 8);
+        for (auto i = 0; i < 5; i++) {
+            REQUIRE(list[i].name == "first");
+        }
+        REQUIRE(list.Destroy());
+    }
+
+    SECTION("insert own element in the middle on growth") {
+        // 가득 찬 목록의 중간에 자기 원소나 자기 범위를 끼워넣음
+        TypedArrayList<TestData> trivial;
+        REQUIRE(trivial.Init(nullptr, 2));
+        REQUIRE(trivial.InsertLast({ 1, 1, 1, 1 }));
+        REQUIRE(trivial.InsertLast({ 2, 2, 2, 2 }));
+        REQUIRE(trivial.Count() == trivial.Capacity());
+        REQUIRE(trivial.Insert(0, trivial[1]));
+        REQUIRE(trivial.Count() == trivial.Capacity() - 1);
+        REQUIRE(trivial.Insert(1, trivial[2]));
+        REQUIRE(trivial.Count() == trivial.Capacity());
+        REQUIRE(trivial.InsertRange(1, &trivial[0], 4));
+        uint64 expected[] = { 2, 2, 2, 1, 2, 2, 1, 2 };
+        REQUIRE(trivial.Count() == 8);
+        for (auto i = 0; i < 8; i++) {
+            REQUIRE(trivial[i].d0 == expected[i]);
+            REQUIRE(trivial[i].d3 == expected[i]);
+        }
+        REQUIRE(trivial.Destroy());
+
+        TypedArrayList<std::string> list;
+        REQUIRE(list.Init(nullptr, 1));
+        REQUIRE(list.EmplaceLast("a long string that does not fit in the small buffer") != nullptr);
+        REQUIRE(list.Count() == list.Capacity());
+        REQUIRE(list.Insert(0, list[0]));
+        REQUIRE(list.Count() == list.Capacity());
+        REQUIRE(list.InsertRange(1, &list[0], 2));
+        REQUIRE(list.Count() == 4);
+        for (auto i = 0; i < 4; i++) {
+            REQUIRE(list[i] == "a long string that does not fit in the small buffer");
+        }
+        REQUIRE(list.Destroy());
+    }
+}
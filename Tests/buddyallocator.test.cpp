@@ -0,0 +1,166 @@
+#include "allocators.h"
+#include "buddyallocator.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <map>
+#include <vector>
+
+TEST_CASE("test buddy allocator", "[Allocator.Buddy]") {
+    BuddyAllocator buddy;
+
+    REQUIRE_FALSE(buddy.Init(nullptr, 1000, 16));
+    REQUIRE_FALSE(buddy.Init(nullptr, 1024, 24));
+    REQUIRE_FALSE(buddy.Init(nullptr, 64, 128));
+    REQUIRE(buddy.Alloc(16) == BUDDY_INVALID_OFFSET);
+
+    REQUIRE(buddy.Init(nullptr, 1024, 64));
+    REQUIRE(buddy.HeapSize() == 1024);
+    REQUIRE(buddy.MinBlockSize() == 64);
+
+    BuddyStats stats;
+    buddy.Stats(&stats);
+    REQUIRE(stats.orderCount == 5);
+    REQUIRE(stats.freeBytes == 1024);
+    REQUIRE(stats.largestFreeBytes == 1024);
+    REQUIRE(stats.freeBlockCounts[4] == 1);
+    REQUIRE(stats.fragmentation == 0.0f);
+
+    // 첫 할당은 힙을 반씩 잘라서 앞쪽 최소 블록을 씀
+    auto a = buddy.Alloc(10);
+    REQUIRE(a == 0);
+    buddy.Stats(&stats);
+    REQUIRE(stats.usedBytes == 64);
+    REQUIRE(stats.requestedBytes == 10);
+    REQUIRE(stats.freeBlockCounts[0] == 1);
+    REQUIRE(stats.freeBlockCounts[1] == 1);
+    REQUIRE(stats.freeBlockCounts[2] == 1);
+    REQUIRE(stats.freeBlockCounts[3] == 1);
+    REQUIRE(stats.largestFreeBytes == 512);
+
+    // 크기는 2의 거듭제곱으로 올리고 블록은 크기로 정렬됨
+    auto b = buddy.Alloc(100);
+    REQUIRE(b == 128);
+    auto c = buddy.Alloc(64);
+    REQUIRE(c == 64);
+    auto d = buddy.Alloc(16, 256);
+    REQUIRE(d == 256);
+    REQUIRE(d % 256 == 0);
+
+    uint64 blockSize, requested;
+    REQUIRE(buddy.Query(b, &blockSize, &requested));
+    REQUIRE(blockSize == 128);
+    REQUIRE(requested == 100);
+    REQUIRE_FALSE(buddy.Query(b + 64, &blockSize, &requested));
+    REQUIRE(buddy.Resize(b, 128));
+    REQUIRE_FALSE(buddy.Resize(b, 129));
+    REQUIRE(buddy.Query(b, &blockSize, &requested));
+    REQUIRE(requested == 128);
+
+    // 남은 512 보다 큰 블록은 없음
+    REQUIRE(buddy.Alloc(513) == BUDDY_INVALID_OFFSET);
+    REQUIRE(buddy.Alloc(2048) == BUDDY_INVALID_OFFSET);
+    REQUIRE(buddy.Alloc(0) == BUDDY_INVALID_OFFSET);
+    REQUIRE(buddy.Alloc(16, 48) == BUDDY_INVALID_OFFSET);
+
+    // 블록 시작이 아니거나 이미 해제한 오프셋은 실패
+    REQUIRE_FALSE(buddy.Free(b + 64));
+    REQUIRE_FALSE(buddy.Free(b + 1));
+    REQUIRE_FALSE(buddy.Free(4096));
+    REQUIRE(buddy.Free(a));
+    REQUIRE_FALSE(buddy.Free(a));
+
+    // 짝이 아직 사용중이라 합쳐지지 않아서 조각남
+    buddy.Stats(&stats);
+    REQUIRE(stats.allocCount == 3);
+    REQUIRE(stats.freeBytes == 1024 - 64 - 128 - 256);
+    REQUIRE(stats.largestFreeBytes == 512);
+    REQUIRE(stats.freeBlockCounts[0] == 1);
+    REQUIRE(stats.fragmentation > 0.0f);
+
+    // 해제 순서와 상관 없이 모두 해제하면 하나의 블록으로 합쳐짐
+    REQUIRE(buddy.Free(d));
+    REQUIRE(buddy.Free(c));
+    REQUIRE(buddy.Free(b));
+    buddy.Stats(&stats);
+    REQUIRE(stats.allocCount == 0);
+    REQUIRE(stats.usedBytes == 0);
+    REQUIRE(stats.requestedBytes == 0);
+    REQUIRE(stats.freeBlockCounts[4] == 1);
+    for (auto i = 0; i < 4; i++) {
+        REQUIRE(stats.freeBlockCounts[i] == 0);
+    }
+    REQUIRE(buddy.Alloc(1024) == 0);
+
+    REQUIRE(buddy.Destroy());
+    buddy.Stats(&stats);
+    REQUIRE(stats.heapSize == 0);
+}
+
+TEST_CASE("test buddy allocator (random)", "[Allocator.Buddy]") {
+    // GPU 힙처럼 256MB 를 4KB 블록으로 나눔
+    const uint64 heapSize = (uint64)256 * 1024 * 1024;
+    BuddyAllocator buddy;
+    REQUIRE(buddy.Init(nullptr, heapSize, 4096));
+
+    std::map<uint64, uint64> live;
+    uint32 seed = 777;
+    uint64 used = 0;
+    for (auto i = 0; i < 20000; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        if (live.empty() || (seed >> 28) < 9) {
+            auto size = (uint64)1 + (seed >> 8) % (4 * 1024 * 1024);
+            auto alignment = (uint64)1 << ((seed >> 4) % 17);
+            auto offset = buddy.Alloc(size, alignment);
+            if (offset == BUDDY_INVALID_OFFSET) {
+                continue;
+            }
+            REQUIRE(offset % alignment == 0);
+            REQUIRE(offset + size <= heapSize);
+
+            // 이웃 블록과 겹치지 않음
+            auto next = live.lower_bound(offset);
+            if (next != live.end()) {
+                REQUIRE(offset + size <= next->first);
+            }
+            if (next != live.begin()) {
+                auto prev = std::prev(next);
+                REQUIRE(prev->first + prev->second <= offset);
+            }
+            live[offset] = size;
+
+            uint64 blockSize, requested;
+            REQUIRE(buddy.Query(offset, &blockSize, &requested));
+            REQUIRE(requested == size);
+            used += blockSize;
+        } else {
+            auto it = live.begin();
+            std::advance(it, (seed >> 8) % live.size());
+            uint64 blockSize, requested;
+            REQUIRE(buddy.Query(it->first, &blockSize, &requested));
+            used -= blockSize;
+            REQUIRE(buddy.Free(it->first));
+            live.erase(it);
+        }
+        REQUIRE(buddy.UsedBytes() == used);
+    }
+
+    BuddyStats stats;
+    buddy.Stats(&stats);
+    REQUIRE(stats.allocCount == live.size());
+    REQUIRE(stats.freeBytes + stats.usedBytes == heapSize);
+    uint64 freeBytes = 0;
+    for (auto i = 0; i < stats.orderCount; i++) {
+        freeBytes += (uint64)stats.freeBlockCounts[i] * (stats.minBlockSize << i);
+    }
+    REQUIRE(freeBytes == stats.freeBytes);
+
+    for (auto& block : live) {
+        REQUIRE(buddy.Free(block.first));
+    }
+    buddy.Stats(&stats);
+    REQUIRE(stats.largestFreeBytes == heapSize);
+    REQUIRE(stats.freeBlockCounts[stats.orderCount - 1] == 1);
+
+    REQUIRE(buddy.Destroy());
+}
@@ -0,0 +1,281 @@
+#include "geometry.h"
+#include "catch.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// 저장소에는 sponza.obj 가 없고 char_max 는 FBX SDK 없이 읽을 수 없으므로, OBJ 로 내보낸 파일이 있으면 그것을 쓰고
+// 없으면 비슷한 크기의 장면을 만들어서 씀
+static const char* g_SponzaPaths[] = {
+    "resources/models/sponza/sponza.obj", "../resources/models/sponza/sponza.obj", "../../resources/models/sponza/sponza.obj",
+};
+static const char* g_CharMaxPaths[] = {
+    "resources/models/max_skinned/char_max.obj", "../resources/models/max_skinned/char_max.obj",
+    "../../resources/models/max_skinned/char_max.obj",
+};
+
+// v 와 f 만 읽는 최소한의 OBJ 로더, 다각형은 부채꼴로 나눔
+static bool LoadObjPositions(const char* path, std::vector<Vector3f>& positions, std::vector<uint32>& indices)
+{
+    auto file = fopen(path, "r");
+    if (file == nullptr) {
+        return false;
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        if (line[0] == 'v' && line[1] == ' ') {
+            Vector3f p;
+            if (sscanf(line + 2, "%f %f %f", &p.x, &p.y, &p.z) == 3) {
+                positions.push_back(p);
+            }
+        } else if (line[0] == 'f' && line[1] == ' ') {
+            std::vector<uint32> face;
+            auto cursor = line + 2;
+            for (;;) {
+                char* end;
+                auto index = strtol(cursor, &end, 10);
+                if (end == cursor) {
+                    break;
+                }
+                face.push_back(index < 0? (uint32)(positions.size() + index): (uint32)(index - 1));
+                // v/vt/vn 에서 위치 인덱스만 씀
+                while (*end != '\0' && *end != ' ' && *end != '\t' && *end != '\n' && *end != '\r') {
+                    end++;
+                }
+                cursor = end;
+            }
+            for (size_t i = 2; i < face.size(); i++) {
+                indices.push_back(face[0]);
+                indices.push_back(face[i - 1]);
+                indices.push_back(face[i]);
+            }
+        }
+    }
+    fclose(file);
+    return !indices.empty();
+}
+
+static float BenchRandom(uint64& seed)
+{
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    return (float)(seed >> 40) / (float)(1ull << 24);
+}
+
+static void AddQuad(std::vector<Vector3f>& positions, std::vector<uint32>& indices, Vector3f origin, Vector3f u, Vector3f v, uint32 steps)
+{
+    auto base = (uint32)positions.size();
+    for (uint32 j = 0; j <= steps; j++) {
+        for (uint32 i = 0; i <= steps; i++) {
+            positions.push_back(origin + u * ((float)i / steps) + v * ((float)j / steps));
+        }
+    }
+    for (uint32 j = 0; j < steps; j++) {
+        for (uint32 i = 0; i < steps; i++) {
+            auto a = base + j * (steps + 1) + i;
+            indices.insert(indices.end(), { a, a + 1, a + steps + 1, a + 1, a + steps + 2, a + steps + 1 });
+        }
+    }
+}
+
+// sponza 와 비슷한 실내 장면, 긴 방에 기둥과 잘게 나뉜 벽, 흩어진 작은 물체로 약 26 만 삼각형
+static void MakeAtrium(std::vector<Vector3f>& positions, std::vector<uint32>& indices)
+{
+    AddQuad(positions, indices, Vector3f(-30, 0, -15), Vector3f(60, 0, 0), Vector3f(0, 0, 30), 100);
+    AddQuad(positions, indices, Vector3f(-30, 20, -15), Vector3f(0, 0, 30), Vector3f(60, 0, 0), 60);
+    AddQuad(positions, indices, Vector3f(-30, 0, -15), Vector3f(0, 20, 0), Vector3f(60, 0, 0), 80);
+    AddQuad(positions, indices, Vector3f(-30, 0, 15), Vector3f(60, 0, 0), Vector3f(0, 20, 0), 80);
+    for (auto column = 0; column < 24; column++) {
+        auto x = -27.5f + (column % 12) * 5.f, z = column < 12? -8.f: 8.f;
+        // 원기둥
+        auto base = (uint32)positions.size();
+        const uint32 sides = 48, rings = 40;
+        for (uint32 r = 0; r <= rings; r++) {
+            for (uint32 s = 0; s < sides; s++) {
+                auto angle = 6.2831853f * s / sides;
+                positions.push_back(Vector3f(x + cosf(angle) * 0.8f, 20.f * r / rings, z + sinf(angle) * 0.8f));
+            }
+        }
+        for (uint32 r = 0; r < rings; r++) {
+            for (uint32 s = 0; s < sides; s++) {
+                auto a = base + r * sides + s, b = base + r * sides + (s + 1) % sides;
+                indices.insert(indices.end(), { a, b, a + sides, b, b + sides, a + sides });
+            }
+        }
+    }
+    uint64 seed = 11;
+    while (indices.size() / 3 < 262000) {
+        Vector3f center(BenchRandom(seed) * 56 - 28, BenchRandom(seed) * 18 + 1, BenchRandom(seed) * 28 - 14);
+        auto base = (uint32)positions.size();
+        for (auto k = 0; k < 3; k++) {
+            positions.push_back(center + Vector3f(BenchRandom(seed), BenchRandom(seed), BenchRandom(seed)) * 0.3f);
+        }
+        indices.insert(indices.end(), { base, base + 1, base + 2 });
+    }
+}
+
+// char_max 크기의 (약 2 만 삼각형) 캐릭터 대신 울퉁불퉁한 구
+static void MakeCharacter(std::vector<Vector3f>& positions, std::vector<uint32>& indices)
+{
+    const uint32 rings = 100, sides = 100;
+    for (uint32 r = 0; r <= rings; r++) {
+        auto phi = 3.14159265f * r / rings;
+        for (uint32 s = 0; s <= sides; s++) {
+            auto theta = 6.2831853f * s / sides;
+            auto radius = 1.f + 0.2f * sinf(phi * 7) * cosf(theta * 5);
+            positions.push_back(Vector3f(radius * sinf(phi) * cosf(theta), radius * cosf(phi) * 2.f, radius * sinf(phi) * sinf(theta)));
+        }
+    }
+    for (uint32 r = 0; r < rings; r++) {
+        for (uint32 s = 0; s < sides; s++) {
+            auto a = r * (sides + 1) + s;
+            indices.insert(indices.end(), { a, a + 1, a + sides + 1, a + 1, a + sides + 2, a + sides + 1 });
+        }
+    }
+}
+
+static void LoadMesh(const char* const* paths, uint32 pathCount, void (*fallback)(std::vector<Vector3f>&, std::vector<uint32>&),
+    std::vector<Vector3f>& positions, std::vector<uint32>& indices, std::string& label)
+{
+    for (uint32 i = 0; i < pathCount; i++) {
+        if (LoadObjPositions(paths[i], positions, indices)) {
+            label = paths[i];
+            return;
+        }
+        positions.clear();
+        indices.clear();
+    }
+    fallback(positions, indices);
+    label += " (synthetic)";
+}
+
+static void BenchMesh(std::string label, const std::vector<Vector3f>& positions, const std::vector<uint32>& indices, const Ray& center)
+{
+    auto vertexCount = (uint32)positions.size(), indexCount = (uint32)indices.size();
+    WARN(label << ", " << indexCount / 3 << " triangles");
+
+    BVHBuildOption serial;
+    serial.threadCount = 1;
+    BENCHMARK(label + ", build 1 thread") {
+        BVH bvh;
+        bvh.Build(positions.data(), vertexCount, indices.data(), indexCount, &serial);
+        return bvh.NodeCount();
+    };
+    BENCHMARK(label + ", build all threads") {
+        BVH bvh;
+        bvh.Build(positions.data(), vertexCount, indices.data(), indexCount);
+        return bvh.NodeCount();
+    };
+
+    BVH bvh;
+    bvh.Build(positions.data(), vertexCount, indices.data(), indexCount);
+    WARN(label << ", " << bvh.NodeCount() << " nodes, depth " << bvh.Depth());
+
+    // 장면 가운데에서 모든 방향으로 쏘는 광선
+    const uint32 rayCount = 100000;
+    std::vector<Ray> rays(rayCount);
+    uint64 seed = 17;
+    for (auto& ray : rays) {
+        Vector3f dir(BenchRandom(seed) * 2 - 1, BenchRandom(seed) * 2 - 1, BenchRandom(seed) * 2 - 1);
+        ray.origin = center.origin;
+        ray.direction = dir.normalized();
+    }
+    BENCHMARK(label + ", 100k closest hit") {
+        uint32 hits = 0;
+        BVHHit hit;
+        for (auto& ray : rays) {
+            hits += bvh.Intersect(ray, 1e30f, hit);
+        }
+        return hits;
+    };
+    BENCHMARK(label + ", 100k any hit") {
+        uint32 hits = 0;
+        for (auto& ray : rays) {
+            hits += bvh.IntersectAny(ray, 1e30f);
+        }
+        return hits;
+    };
+}
+
+TEST_CASE("bench BVH", "[Geometry.BVH][!benchmark]") {
+    std::vector<Vector3f> positions;
+    std::vector<uint32> indices;
+    std::string label = "sponza";
+    LoadMesh(g_SponzaPaths, sizeof(g_SponzaPaths) / sizeof(g_SponzaPaths[0]), MakeAtrium, positions, indices, label);
+    BVH bvh;
+    REQUIRE(bvh.Build(positions.data(), (uint32)positions.size(), indices.data(), (uint32)indices.size()));
+    Ray center;
+    center.origin = bvh.GetBounds().center;
+    BenchMesh(label, positions, indices, center);
+
+    positions.clear();
+    indices.clear();
+    label = "char_max";
+    LoadMesh(g_CharMaxPaths, sizeof(g_CharMaxPaths) / sizeof(g_CharMaxPaths[0]), MakeCharacter, positions, indices, label);
+    REQUIRE(bvh.Build(positions.data(), (uint32)positions.size(), indices.data(), (uint32)indices.size()));
+    center.origin = bvh.GetBounds().center;
+    BenchMesh(label, positions, indices, center);
+}
+
+// 한 번 쏘는 데 걸린 시간 중 가장 짧은 것으로 Mrays/s 를 셈
+static double MeasureMrays(const BVH& bvh, const std::vector<Ray>& rays, std::vector<BVHHit>& hits, uint32 width)
+{
+    double best = 1e30;
+    for (auto run = 0; run < 5; run++) {
+        auto begin = std::chrono::steady_clock::now();
+        bvh.IntersectRays(rays.data(), (uint32)rays.size(), 1e30f, hits.data(), width);
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+    }
+    return rays.size() / best / 1e6;
+}
+
+TEST_CASE("bench BVH packets", "[Geometry.BVH][!benchmark]") {
+    std::vector<Vector3f> positions;
+    std::vector<uint32> indices;
+    std::string label = "sponza";
+    LoadMesh(g_SponzaPaths, sizeof(g_SponzaPaths) / sizeof(g_SponzaPaths[0]), MakeAtrium, positions, indices, label);
+    BVH bvh;
+    REQUIRE(bvh.Build(positions.data(), (uint32)positions.size(), indices.data(), (uint32)indices.size()));
+    auto bounds = bvh.GetBounds();
+
+    // 512x512 카메라 광선을 4x2 타일 순서로 늘어놓아서 packet 하나가 화면의 이웃 픽셀을 맡음
+    const uint32 size = 512;
+    std::vector<Ray> camera;
+    for (uint32 tileY = 0; tileY < size; tileY += 2) {
+        for (uint32 tileX = 0; tileX < size; tileX += 4) {
+            for (uint32 y = tileY; y < tileY + 2; y++) {
+                for (uint32 x = tileX; x < tileX + 4; x++) {
+                    Ray ray;
+                    ray.origin = bounds.center - Vector3f(bounds.extents.x * 0.8f, 0, 0);
+                    ray.direction = Vector3f(1.f, (y + 0.5f) / size - 0.5f, (x + 0.5f) / size - 0.5f).normalized();
+                    camera.push_back(ray);
+                }
+            }
+        }
+    }
+    // 같은 점에서 아무 방향으로나 쏘는 광선, packet 이 흩어지는 최악의 경우
+    std::vector<Ray> scattered(camera.size());
+    uint64 seed = 23;
+    for (auto& ray : scattered) {
+        ray.origin = bounds.center;
+        ray.direction = Vector3f(BenchRandom(seed) * 2 - 1, BenchRandom(seed) * 2 - 1, BenchRandom(seed) * 2 - 1).normalized();
+    }
+
+    std::vector<BVHHit> hits(camera.size());
+    std::vector<uint32> widths = { 1, 4 };
+    if (BVH::MaxPacketWidth() >= 8) {
+        widths.push_back(8);
+    }
+    for (auto width : widths) {
+        auto name = label + ", " + std::to_string(width) + "-wide";
+        WARN(name << ", camera " << MeasureMrays(bvh, camera, hits, width) << " Mrays/s, scattered "
+            << MeasureMrays(bvh, scattered, hits, width) << " Mrays/s");
+        BENCHMARK(name + ", 262k camera rays") {
+            return bvh.IntersectRays(camera.data(), (uint32)camera.size(), 1e30f, hits.data(), width);
+        };
+    }
+}
@@ -0,0 +1,288 @@
+#include "geometry.h"
+#include "catch.hpp"
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+static float BVHRandom(uint64& seed)
+{
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    return (float)(seed >> 40) / (float)(1ull << 24);
+}
+
+static void BVHRandomTriangles(uint64 seed, uint32 count, std::vector<Vector3f>& positions)
+{
+    for (uint32 i = 0; i < count; i++) {
+        Vector3f center(BVHRandom(seed) * 20 - 10, BVHRandom(seed) * 20 - 10, BVHRandom(seed) * 20 - 10);
+        for (auto k = 0; k < 3; k++) {
+            positions.push_back(Vector3f(
+                center.x + BVHRandom(seed) - 0.5f, center.y + BVHRandom(seed) - 0.5f, center.z + BVHRandom(seed) - 0.5f
+            ));
+        }
+    }
+}
+
+static Ray BVHRandomRay(uint64& seed)
+{
+    Vector3f origin(BVHRandom(seed) * 30 - 15, BVHRandom(seed) * 30 - 15, BVHRandom(seed) * 30 - 15);
+    Vector3f target(BVHRandom(seed) * 20 - 10, BVHRandom(seed) * 20 - 10, BVHRandom(seed) * 20 - 10);
+    Ray ray;
+    ray.origin = origin;
+    ray.direction = (target - origin).normalized();
+    return ray;
+}
+
+static bool BruteForceTriangle(const std::vector<Vector3f>& positions, const Ray& ray, float tMax, float& closest, uint32& primitive)
+{
+    auto found = false;
+    closest = tMax;
+    for (uint32 i = 0; i < positions.size() / 3; i++) {
+        auto e1 = positions[i * 3 + 1] - positions[i * 3];
+        auto e2 = positions[i * 3 + 2] - positions[i * 3];
+        auto p = Cross(ray.direction, e2);
+        auto det = Dot(e1, p);
+        if (fabsf(det) < 1e-12f) {
+            continue;
+        }
+        auto s = ray.origin - positions[i * 3];
+        auto u = Dot(s, p) / det;
+        auto q = Cross(s, e1);
+        auto v = Dot(ray.direction, q) / det;
+        auto t = Dot(e2, q) / det;
+        if (u >= 0 && v >= 0 && u + v <= 1 && t >= 0 && t <= closest) {
+            found = true;
+            closest = t;
+            primitive = i;
+        }
+    }
+    return found;
+}
+
+static void CheckTree(const BVH& bvh)
+{
+    // 모든 primitive 가 정확히 한 leaf 에 들어 있고 자식 상자는 부모 안에 있음
+    auto nodes = bvh.Nodes();
+    std::vector<uint32> visited(bvh.PrimitiveCount(), 0);
+    for (uint32 i = 0; i < bvh.NodeCount(); i++) {
+        auto& node = nodes[i];
+        if (node.primitiveCount > 0) {
+            for (uint32 p = node.offset; p < node.offset + node.primitiveCount; p++) {
+                REQUIRE(p < bvh.PrimitiveCount());
+                visited[bvh.PrimitiveIndices()[p]]++;
+            }
+            continue;
+        }
+        REQUIRE(node.offset > i + 1);
+        REQUIRE(node.offset < bvh.NodeCount());
+        for (auto child : { i + 1, node.offset }) {
+            for (auto k = 0; k < 3; k++) {
+                REQUIRE(nodes[child].min[k] >= node.min[k]);
+                REQUIRE(nodes[child].max[k] <= node.max[k]);
+            }
+        }
+    }
+    for (auto count : visited) {
+        REQUIRE(count == 1);
+    }
+    REQUIRE(bvh.Depth() <= BVH_MAX_DEPTH);
+}
+
+TEST_CASE("test BVH triangles", "[Geometry.BVH]") {
+    REQUIRE(sizeof(BVHNode) == 32);
+
+    BVH bvh;
+    std::vector<Vector3f> positions;
+    REQUIRE_FALSE(bvh.Build(positions.data(), 0, nullptr, 0));
+    REQUIRE(bvh.PrimitiveType() == BVHPrimitiveType::None);
+
+    BVHRandomTriangles(1, 5000, positions);
+    uint32 bad[3] = { 0, 1, (uint32)positions.size() };
+    REQUIRE_FALSE(bvh.Build(positions.data(), (uint32)positions.size(), bad, 3));
+
+    // 한 스레드와 여러 스레드로 만든 트리가 같은 결과를 냄
+    BVHBuildOption serialOption;
+    serialOption.threadCount = 1;
+    BVHBuildOption parallelOption;
+    parallelOption.threadCount = 4;
+    parallelOption.parallelThreshold = 256;
+
+    BVH parallel;
+    REQUIRE(bvh.Build(positions.data(), (uint32)positions.size(), nullptr, (uint32)positions.size(), &serialOption));
+    REQUIRE(parallel.Build(positions.data(), (uint32)positions.size(), nullptr, (uint32)positions.size(), &parallelOption));
+    REQUIRE(bvh.PrimitiveType() == BVHPrimitiveType::Triangle);
+    REQUIRE(bvh.PrimitiveCount() == 5000);
+    CheckTree(bvh);
+    CheckTree(parallel);
+
+    auto bounds = bvh.GetBounds();
+    for (auto& p : positions) {
+        for (auto k = 0; k < 3; k++) {
+            REQUIRE(p[k] >= bounds.center[k] - bounds.extents[k] - 1e-4f);
+            REQUIRE(p[k] <= bounds.center[k] + bounds.extents[k] + 1e-4f);
+        }
+    }
+
+    uint64 seed = 99;
+    auto hitCount = 0;
+    for (auto i = 0; i < 500; i++) {
+        auto ray = BVHRandomRay(seed);
+        auto tMax = i % 5 == 0? 10.f: 100.f;
+        float expectedT;
+        uint32 expectedPrimitive = 0;
+        auto expected = BruteForceTriangle(positions, ray, tMax, expectedT, expectedPrimitive);
+
+        BVHHit hit;
+        REQUIRE(bvh.Intersect(ray, tMax, hit) == expected);
+        REQUIRE(bvh.IntersectAny(ray, tMax) == expected);
+        BVHHit parallelHit;
+        REQUIRE(parallel.Intersect(ray, tMax, parallelHit) == expected);
+        if (expected) {
+            hitCount++;
+            REQUIRE(hit.t == Approx(expectedT).margin(1e-4));
+            REQUIRE(parallelHit.t == Approx(expectedT).margin(1e-4));
+            REQUIRE(hit.u >= 0);
+            REQUIRE(hit.v >= 0);
+            REQUIRE(hit.u + hit.v <= 1.0001f);
+            // 같은 거리에 겹친 삼각형이 없으면 같은 primitive
+            if (hit.primitive != expectedPrimitive) {
+                REQUIRE(hit.t == Approx(expectedT).margin(1e-6));
+            }
+        }
+    }
+    REQUIRE(hitCount > 0);
+
+    // 인덱스 버퍼로 만든 트리는 primitive 번호가 삼각형 순서를 따름
+    std::vector<uint32> indices;
+    for (uint32 i = 0; i < positions.size() / 3; i++) {
+        indices.push_back(i * 3 + 2);
+        indices.push_back(i * 3 + 1);
+        indices.push_back(i * 3);
+    }
+    BVH indexed;
+    REQUIRE(indexed.Build(positions.data(), (uint32)positions.size(), indices.data(), (uint32)indices.size()));
+    seed = 5;
+    for (auto i = 0; i < 100; i++) {
+        auto ray = BVHRandomRay(seed);
+        BVHHit a, b;
+        REQUIRE(indexed.Intersect(ray, 100.f, a) == bvh.Intersect(ray, 100.f, b));
+        if (bvh.Intersect(ray, 100.f, b)) {
+            REQUIRE(a.t == Approx(b.t).margin(1e-4));
+        }
+    }
+
+    // packet 으로 쏴도 한 광선씩 쏜 것과 같고, 개수가 폭의 배수가 아니어도 됨
+    std::vector<Ray> rays;
+    for (auto i = 0; i < 203; i++) {
+        rays.push_back(BVHRandomRay(seed));
+    }
+    // 한 점에서 퍼지는 광선은 packet 안에서 방향이 비슷함
+    for (auto i = 0; i < 64; i++) {
+        Ray ray;
+        ray.origin = Vector3f(0, 0, -20);
+        ray.direction = Vector3f((i % 8) * 0.02f - 0.07f, (i / 8) * 0.02f - 0.07f, 1).normalized();
+        rays.push_back(ray);
+    }
+    REQUIRE((BVH::MaxPacketWidth() == 4 || BVH::MaxPacketWidth() == 8));
+    for (auto width : { 0u, 1u, 4u, 8u }) {
+        std::vector<BVHHit> hits(rays.size());
+        uint32 expectedCount = 0;
+        auto count = bvh.IntersectRays(rays.data(), (uint32)rays.size(), 50.f, hits.data(), width);
+        for (size_t i = 0; i < rays.size(); i++) {
+            BVHHit expected;
+            if (bvh.Intersect(rays[i], 50.f, expected)) {
+                expectedCount++;
+                REQUIRE(hits[i].primitive != BVH_INVALID_PRIMITIVE);
+                REQUIRE(hits[i].t == Approx(expected.t).margin(1e-4));
+                REQUIRE(hits[i].u >= 0);
+                REQUIRE(hits[i].v >= 0);
+                REQUIRE(hits[i].u + hits[i].v <= 1.0001f);
+            } else {
+                REQUIRE(hits[i].primitive == BVH_INVALID_PRIMITIVE);
+                REQUIRE(hits[i].t == 50.f);
+            }
+        }
+        REQUIRE(count == expectedCount);
+    }
+
+    bvh.Clear();
+    BVHHit hit;
+    REQUIRE(bvh.NodeCount() == 0);
+    REQUIRE_FALSE(bvh.Intersect(BVHRandomRay(seed), 100.f, hit));
+}
+
+TEST_CASE("test BVH bounds", "[Geometry.BVH]") {
+    uint64 seed = 3;
+    std::vector<Bounds> boxes;
+    for (auto i = 0; i < 3000; i++) {
+        Vector3f center(BVHRandom(seed) * 40 - 20, BVHRandom(seed) * 40 - 20, BVHRandom(seed) * 40 - 20);
+        Vector3f extents(BVHRandom(seed) * 0.5f + 0.01f, BVHRandom(seed) * 0.5f + 0.01f, BVHRandom(seed) * 0.5f + 0.01f);
+        boxes.push_back(Bounds(center, extents));
+    }
+    // 같은 자리에 몰린 primitive 도 나눌 수 있음
+    for (auto i = 0; i < 100; i++) {
+        boxes.push_back(Bounds(Vector3f(1, 2, 3), Vector3f(0.1f)));
+    }
+
+    BVH bvh;
+    REQUIRE(bvh.Build(boxes.data(), (uint32)boxes.size()));
+    REQUIRE(bvh.PrimitiveType() == BVHPrimitiveType::Bounds);
+    CheckTree(bvh);
+
+    std::vector<uint32> result(boxes.size());
+    for (auto i = 0; i < 200; i++) {
+        Bounds query(
+            Vector3f(BVHRandom(seed) * 40 - 20, BVHRandom(seed) * 40 - 20, BVHRandom(seed) * 40 - 20),
+            Vector3f(BVHRandom(seed) * 4)
+        );
+        std::vector<uint32> expected;
+        for (uint32 b = 0; b < boxes.size(); b++) {
+            auto overlap = true;
+            for (auto k = 0; k < 3; k++) {
+                overlap &= fabsf(boxes[b].center[k] - query.center[k]) <= boxes[b].extents[k] + query.extents[k];
+            }
+            if (overlap) {
+                expected.push_back(b);
+            }
+        }
+
+        auto count = bvh.Overlap(query, result.data(), (uint32)result.size());
+        REQUIRE(count == expected.size());
+        std::vector<uint32> found(result.begin(), result.begin() + count);
+        std::sort(found.begin(), found.end());
+        REQUIRE(found == expected);
+        // 용량이 모자라도 전체 개수는 돌려줌
+        REQUIRE(bvh.Overlap(query, nullptr, 0) == count);
+    }
+
+    auto hits = 0;
+    for (auto i = 0; i < 300; i++) {
+        auto ray = BVHRandomRay(seed);
+        auto expected = false;
+        auto expectedT = 100.f;
+        for (auto& box : boxes) {
+            auto t0 = 0.f, t1 = expectedT;
+            for (auto k = 0; k < 3; k++) {
+                auto ta = (box.center[k] - box.extents[k] - ray.origin[k]) / ray.direction[k];
+                auto tb = (box.center[k] + box.extents[k] - ray.origin[k]) / ray.direction[k];
+                t0 = std::max(t0, std::min(ta, tb));
+                t1 = std::min(t1, std::max(ta, tb));
+            }
+            if (t0 <= t1) {
+                expected = true;
+                expectedT = t0;
+            }
+        }
+
+        BVHHit hit, packetHit[3];
+        Ray packet[3] = { ray, ray, ray };
+        REQUIRE(bvh.Intersect(ray, 100.f, hit) == expected);
+        REQUIRE(bvh.IntersectRays(packet, 3, 100.f, packetHit) == (expected? 3: 0));
+        if (expected) {
+            hits++;
+            REQUIRE(hit.t == Approx(expectedT).margin(1e-4));
+            REQUIRE(packetHit[2].t == Approx(expectedT).margin(1e-4));
+        }
+    }
+    REQUIRE(hits > 0);
+}
@@ -0,0 +1,191 @@
+#include "allocators.h"
+#include "container.h"
+#include "typedarraylist.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+// EASTL 은 build_libraries.bat 으로 받아서 빌드했을 때만 비교
+#if __has_include(<EASTL/vector.h>)
+#include <EASTL/vector.h>
+#define BENCH_EASTL 1
+
+// EASTL 기본 할당자가 부르는 new[], 해제는 기본 delete[] 로 하므로 기본 new[] 로 받음
+// bench 원소는 기본 정렬이라 정렬 요청은 무시해도 됨
+void* operator new[](size_t size, const char* pName, int flags, unsigned debugFlags, const char* file, int line)
+{
+    return ::operator new[](size);
+}
+void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, const char* pName, int flags, unsigned debugFlags, const char* file, int line)
+{
+    return ::operator new[](size);
+}
+#endif
+
+struct BenchParticle
+{
+    float position[3];
+    float velocity[3];
+    uint32 id;
+    uint32 flags;
+};
+
+TEST_CASE("bench TypedArrayList", "[Container.ArrayList][!benchmark]") {
+    const int32 count = 100000;
+
+    auto particle = [](int32 i) {
+        BenchParticle p = { { (float)i, 0, 0 }, { 0, 1, 0 }, (uint32)i, (uint32)i % 3 };
+        return p;
+    };
+
+    BENCHMARK("TypedArrayList, push 100k particles") {
+        TypedArrayList<BenchParticle> list;
+        list.Init(nullptr, 1);
+        for (auto i = 0; i < count; i++) {
+            list.InsertLast(particle(i));
+        }
+        auto n = list.Count();
+        list.Destroy();
+        return n;
+    };
+    BENCHMARK("ArrayList, push 100k particles") {
+        ArrayList list;
+        list.Init(nullptr, sizeof(BenchParticle), ArrayList::s_DefaultAlignment, 1);
+        for (auto i = 0; i < count; i++) {
+            auto p = particle(i);
+            list.InsertLast(1, &p, nullptr);
+        }
+        auto n = list.Count();
+        list.Destroy();
+        return n;
+    };
+    BENCHMARK("std::vector, push 100k particles") {
+        std::vector<BenchParticle> list;
+        for (auto i = 0; i < count; i++) {
+            list.push_back(particle(i));
+        }
+        return list.size();
+    };
+#ifdef BENCH_EASTL
+    BENCHMARK("eastl::vector, push 100k particles") {
+        eastl::vector<BenchParticle> list;
+        for (auto i = 0; i < count; i++) {
+            list.push_back(particle(i));
+        }
+        return list.size();
+    };
+#endif
+
+    // 죽은 입자를 지우는 프레임, 1/3 을 지우고 순서 유지
+    // 측정마다 목록을 새로 만들어야 해서 크기를 줄임
+    const int32 eraseCount = 10000;
+    TypedArrayList<BenchParticle> typed;
+    typed.Init(nullptr, eraseCount);
+    std::vector<BenchParticle> stdList;
+    for (auto i = 0; i < eraseCount; i++) {
+        typed.InsertLast(particle(i));
+        stdList.push_back(particle(i));
+    }
+
+    BENCHMARK_ADVANCED("TypedArrayList, EraseIf 1/3 of 10k")(Catch::Benchmark::Chronometer meter) {
+        std::vector<TypedArrayList<BenchParticle>> lists(meter.runs());
+        for (auto& list : lists) {
+            list.Init(nullptr, eraseCount);
+            list.InsertRange(0, typed.Data(), typed.Count());
+        }
+        meter.measure([&](int i) {
+            return lists[i].EraseIf([](const BenchParticle& p) { return p.flags == 0; });
+        });
+        for (auto& list : lists) {
+            list.Destroy();
+        }
+    };
+    BENCHMARK_ADVANCED("std::vector, erase(remove_if) 1/3 of 10k")(Catch::Benchmark::Chronometer meter) {
+        std::vector<std::vector<BenchParticle>> lists(meter.runs(), stdList);
+        meter.measure([&](int i) {
+            auto& list = lists[i];
+            auto it = std::remove_if(list.begin(), list.end(), [](const BenchParticle& p) { return p.flags == 0; });
+            auto removed = list.end() - it;
+            list.erase(it, list.end());
+            return removed;
+        });
+    };
+#ifdef BENCH_EASTL
+    BENCHMARK_ADVANCED("eastl::vector, erase(remove_if) 1/3 of 10k")(Catch::Benchmark::Chronometer meter) {
+        std::vector<eastl::vector<BenchParticle>> lists(meter.runs(), eastl::vector<BenchParticle>(stdList.begin(), stdList.end()));
+        meter.measure([&](int i) {
+            auto& list = lists[i];
+            auto it = eastl::remove_if(list.begin(), list.end(), [](const BenchParticle& p) { return p.flags == 0; });
+            auto removed = list.end() - it;
+            list.erase(it, list.end());
+            return removed;
+        });
+    };
+#endif
+
+    // 순서가 필요 없으면 지울 때마다 마지막 원소로 채움
+    BENCHMARK_ADVANCED("TypedArrayList, RemoveSwap 1k from front")(Catch::Benchmark::Chronometer meter) {
+        std::vector<TypedArrayList<BenchParticle>> lists(meter.runs());
+        for (auto& list : lists) {
+            list.Init(nullptr, eraseCount);
+            list.InsertRange(0, typed.Data(), typed.Count());
+        }
+        meter.measure([&](int i) {
+            for (auto j = 0; j < 1000; j++) {
+                lists[i].RemoveSwap(j);
+            }
+            return lists[i].Count();
+        });
+        for (auto& list : lists) {
+            list.Destroy();
+        }
+    };
+    BENCHMARK_ADVANCED("TypedArrayList, Remove 1k from front")(Catch::Benchmark::Chronometer meter) {
+        std::vector<TypedArrayList<BenchParticle>> lists(meter.runs());
+        for (auto& list : lists) {
+            list.Init(nullptr, eraseCount);
+            list.InsertRange(0, typed.Data(), typed.Count());
+        }
+        meter.measure([&](int i) {
+            for (auto j = 0; j < 1000; j++) {
+                lists[i].Remove(0);
+            }
+            return lists[i].Count();
+        });
+        for (auto& list : lists) {
+            list.Destroy();
+        }
+    };
+
+    // 이동 생성이 필요한 원소
+    BENCHMARK("TypedArrayList, push 100k std::string") {
+        TypedArrayList<std::string> list;
+        list.Init(nullptr, 1);
+        for (auto i = 0; i < count; i++) {
+            list.EmplaceLast("particle name that does not fit in sso");
+        }
+        auto n = list.Count();
+        list.Destroy();
+        return n;
+    };
+    BENCHMARK("std::vector, push 100k std::string") {
+        std::vector<std::string> list;
+        for (auto i = 0; i < count; i++) {
+            list.emplace_back("particle name that does not fit in sso");
+        }
+        return list.size();
+    };
+#ifdef BENCH_EASTL
+    BENCHMARK("eastl::vector, push 100k std::string") {
+        eastl::vector<std::string> list;
+        for (auto i = 0; i < count; i++) {
+            list.emplace_back("particle name that does not fit in sso");
+        }
+        return list.size();
+    };
+#endif
+
+    typed.Destroy();
+}
@@ -0,0 +1,145 @@
+#include "allocators.h"
+#include "frameallocator.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+TEST_CASE("test frame arena", "[Allocator.FrameArena]") {
+    MemEpochCounter epoch;
+    FrameArena frames;
+
+    REQUIRE_FALSE(frames.Init(L"frame", 0, memPageMinSize(true), epoch.Source()));
+    REQUIRE(frames.Init(L"frame", 2, memPageMinSize(true), epoch.Source()));
+    REQUIRE(frames.Alloc(16, 8) == nullptr);
+
+    REQUIRE(frames.BeginFrame(1, false));
+    auto first = (char*)frames.Alloc(100, 16);
+    REQUIRE(first != nullptr);
+    REQUIRE((size_t)first % 16 == 0);
+    REQUIRE(memAllocSize(frames.AddrSpace()) == 100);
+
+    REQUIRE(frames.BeginFrame(2, false));
+    auto second = (char*)frames.Alloc(100, 16);
+    REQUIRE(second != nullptr);
+    REQUIRE(second != first);
+
+    // 프레임 1 이 끝나기 전에는 같은 arena 를 다시 쓸 수 없음
+    REQUIRE_FALSE(frames.BeginFrame(3, false));
+    REQUIRE(frames.Frame() == 2);
+    REQUIRE_FALSE(frames.BeginFrame(2, false));
+
+    epoch.Retire(1);
+    epoch.Retire(0);
+    REQUIRE(frames.IsRetired(1));
+    REQUIRE_FALSE(frames.IsRetired(2));
+    REQUIRE(frames.BeginFrame(3, false));
+    REQUIRE(memAllocSize(frames.AddrSpace()) == 0);
+    REQUIRE(frames.Alloc(100, 16) == first);
+
+    // 건너뛴 프레임도 이전 프레임이 모두 끝났는지로 판단
+    REQUIRE_FALSE(frames.BeginFrame(6, false));
+    epoch.Retire(4);
+    REQUIRE(frames.BeginFrame(6, false));
+
+    REQUIRE(frames.Destroy());
+    REQUIRE_FALSE(frames.BeginFrame(7, false));
+}
+
+TEST_CASE("test frame arena (early reuse stress)", "[Allocator.FrameArena]") {
+    const int32 bufferCounts[] = { 2, 3 };
+    const uint64 frameCount = 300;
+
+    for (auto bufferCount : bufferCounts) {
+        MemEpochCounter epoch;
+        FrameArena frames;
+        REQUIRE(frames.Init(L"framestress", bufferCount, memPageMinSize(true), epoch.Source()));
+
+        struct Block { uint8* p; size_t size; };
+        struct Submit { uint64 frame; std::vector<Block> blocks; };
+        std::deque<Submit> queue;
+        std::mutex queueLock;
+        std::atomic<bool> done(false);
+        std::atomic<int> failed(0);
+
+        // GPU 대신 제출된 프레임을 늦게 확인하고 끝냄
+        // 그 사이 다른 프레임이 같은 메모리를 덮어썼다면 내용이 달라짐
+        std::thread gpu([&]() {
+            uint32 seed = 99;
+            for (;;) {
+                Submit submit;
+                {
+                    std::lock_guard<std::mutex> guard(queueLock);
+                    if (queue.empty()) {
+                        if (done) {
+                            break;
+                        }
+                        submit.frame = 0;
+                    } else {
+                        submit = std::move(queue.front());
+                        queue.pop_front();
+                    }
+                }
+                if (submit.frame == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                seed = seed * 1664525u + 1013904223u;
+                std::this_thread::sleep_for(std::chrono::microseconds((seed >> 8) % 200));
+
+                for (auto& block : submit.blocks) {
+                    for (size_t i = 0; i < block.size; i++) {
+                        if (block.p[i] != (uint8)submit.frame) {
+                            failed++;
+                            break;
+                        }
+                    }
+                }
+                epoch.Retire(submit.frame);
+            }
+        });
+
+        uint32 seed = 1234;
+        for (uint64 frame = 1; frame <= frameCount; frame++) {
+            if (!frames.BeginFrame(frame)) {
+                failed++;
+                break;
+            }
+            if (frame > (uint64)bufferCount && epoch.retired.load() < frame - bufferCount) {
+                failed++;
+            }
+
+            Submit submit;
+            submit.frame = frame;
+            seed = seed * 1664525u + 1013904223u;
+            auto blockCount = 1 + (seed >> 8) % 32;
+            for (uint32 i = 0; i < blockCount; i++) {
+                seed = seed * 1664525u + 1013904223u;
+                Block block;
+                block.size = 1 + (seed >> 8) % 3000;
+                block.p = (uint8*)frames.Alloc(block.size, 16);
+                if (block.p == nullptr) {
+                    failed++;
+                    continue;
+                }
+                memset(block.p, (uint8)frame, block.size);
+                submit.blocks.push_back(block);
+            }
+
+            std::lock_guard<std::mutex> guard(queueLock);
+            queue.push_back(std::move(submit));
+        }
+        done = true;
+        gpu.join();
+
+        REQUIRE(failed == 0);
+        REQUIRE(epoch.retired.load() == frameCount);
+        REQUIRE(frames.Destroy());
+    }
+}
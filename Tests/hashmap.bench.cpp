@@ -0,0 +1,109 @@
+#include "allocators.h"
+#include "hashmap.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ImportScene/char_max.FBX 의 노드 이름, 스킨 클러스터마다 이 목록에서 본을 찾음
+static const char* g_CharMaxNodes[] = {
+    "Char_Max", "Face", "Bip001", "Bip001 Footsteps", "Bip001 Pelvis", "Bip001 Spine", "Bip001 Spine1", "Bip001 Neck",
+    "Bip001 L Clavicle", "Bip001 L UpperArm", "Bip001 L Forearm", "Bip001 L Hand", "Bip001 L Finger0", "Bip001 L Finger0Nub",
+    "Bip001 R Clavicle", "Bip001 R UpperArm", "Bip001 R Forearm", "Bip001 R Hand", "Bip001 R Finger0", "Bip001 R Finger0Nub",
+    "Bip001 Head", "Bip001 HeadNub", "Bip001 L Thigh", "Bip001 L Calf", "Bip001 L Foot", "Bip001 L Toe0", "Bip001 L Toe0Nub",
+    "Bip001 R Thigh", "Bip001 R Calf", "Bip001 R Foot", "Bip001 R Toe0", "Bip001 R Toe0Nub", "Tail", "Tail_End",
+};
+
+// 클러스터 이름은 FBX SDK 가 따로 들고 있으므로 같은 내용의 다른 포인터로 찾음
+static void BenchBoneLookup(const char* label, const std::vector<std::string>& nodes)
+{
+    std::vector<std::string> clusters(nodes.begin(), nodes.end());
+    auto nodeCount = (int32)nodes.size();
+
+    BENCHMARK(std::string(label) + ", strcmp scan") {
+        int64 sum = 0;
+        for (auto& cluster : clusters) {
+            for (auto i = 0; i < nodeCount; i++) {
+                if (strcmp(nodes[i].c_str(), cluster.c_str()) == 0) {
+                    sum += i;
+                    break;
+                }
+            }
+        }
+        return sum;
+    };
+    BENCHMARK(std::string(label) + ", HashMap build + lookup") {
+        HashMap map;
+        map.Init(nullptr, sizeof(const char*), sizeof(int32), hashMapStringHash, hashMapStringEqual, nullptr, nodeCount);
+        for (auto i = 0; i < nodeCount; i++) {
+            auto name = nodes[i].c_str();
+            map.Insert(&name, &i);
+        }
+        int64 sum = 0;
+        for (auto& cluster : clusters) {
+            auto name = cluster.c_str();
+            sum += *(int32*)map.Find(&name);
+        }
+        map.Destroy();
+        return sum;
+    };
+    BENCHMARK(std::string(label) + ", std::unordered_map build + lookup") {
+        std::unordered_map<std::string, int32> map;
+        map.reserve(nodeCount);
+        for (auto i = 0; i < nodeCount; i++) {
+            map.emplace(nodes[i], i);
+        }
+        int64 sum = 0;
+        for (auto& cluster : clusters) {
+            sum += map.find(cluster)->second;
+        }
+        return sum;
+    };
+}
+
+TEST_CASE("bench HashMap", "[Container.HashMap][!benchmark]") {
+    BenchBoneLookup("char_max 34 nodes", std::vector<std::string>(std::begin(g_CharMaxNodes), std::end(g_CharMaxNodes)));
+
+    // 이름이 앞부분을 공유하는 큰 계층
+    std::vector<std::string> nodes;
+    for (auto i = 0; i < 10000; i++) {
+        nodes.push_back("Bip001 Node" + std::to_string(i));
+    }
+    BenchBoneLookup("synthetic 10k nodes", nodes);
+
+    // 정수 키를 찾기만 반복, 넣은 순서와 다른 순서로 찾음
+    std::vector<uint64> keys(100000);
+    uint64 seed = 1;
+    for (auto& key : keys) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        key = seed ^ (seed >> 29);
+    }
+    HashMap map;
+    map.Init(nullptr, sizeof(uint64), sizeof(uint64));
+    std::unordered_map<uint64, uint64> stdMap;
+    for (uint64 i = 0; i < keys.size(); i++) {
+        map.Insert(&keys[i], &i);
+        stdMap.emplace(keys[i], i);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+    BENCHMARK("HashMap, find 100k uint64") {
+        uint64 sum = 0;
+        for (auto& key : keys) {
+            sum += *(uint64*)map.Find(&key);
+        }
+        return sum;
+    };
+    BENCHMARK("std::unordered_map, find 100k uint64") {
+        uint64 sum = 0;
+        for (auto key : keys) {
+            sum += stdMap.find(key)->second;
+        }
+        return sum;
+    };
+    map.Destroy();
+}
@@ -0,0 +1,129 @@
+#include "allocators.h"
+#include "hashmap.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+TEST_CASE("test HashMap", "[Container.HashMap]") {
+    HashMap map;
+
+    REQUIRE_FALSE(map.Init(nullptr, 0, 4));
+    REQUIRE(map.Find("") == nullptr);
+
+    REQUIRE(map.Init(nullptr, sizeof(uint64), sizeof(int32)));
+    REQUIRE(map.Count() == 0);
+
+    // 기존 키는 덮어쓰고, FindOrInsert 는 그대로 둠
+    uint64 key = 7;
+    int32 value = 70;
+    REQUIRE(*(int32*)map.Insert(&key, &value) == 70);
+    value = 71;
+    REQUIRE(*(int32*)map.Insert(&key, &value) == 71);
+    bool inserted = true;
+    value = 72;
+    REQUIRE(*(int32*)map.FindOrInsert(&key, &value, &inserted) == 71);
+    REQUIRE_FALSE(inserted);
+    REQUIRE(map.Count() == 1);
+
+    key = 8;
+    REQUIRE(*(int32*)map.FindOrInsert(&key, nullptr, &inserted) == 0);
+    REQUIRE(inserted);
+    REQUIRE(map.Remove(&key));
+    REQUIRE_FALSE(map.Remove(&key));
+    REQUIRE(map.Find(&key) == nullptr);
+
+    // 무작위로 넣고 지우면서 std::unordered_map 과 비교
+    std::unordered_map<uint64, int32> expected;
+    uint64 seed = 12345;
+    for (auto i = 0; i < 20000; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        key = (seed >> 33) % 3000;
+        if ((seed >> 20) % 3 == 0) {
+            REQUIRE(map.Remove(&key) == (expected.erase(key) > 0));
+        } else {
+            value = i;
+            map.Insert(&key, &value);
+            expected[key] = i;
+        }
+    }
+    REQUIRE(map.Count() == expected.size());
+    for (auto& pair : expected) {
+        auto p = (int32*)map.Find(&pair.first);
+        REQUIRE(p != nullptr);
+        REQUIRE(*p == pair.second);
+    }
+    for (uint64 k = 3000; k < 3100; k++) {
+        REQUIRE(map.Find(&k) == nullptr);
+    }
+
+    // 슬롯 순회는 모든 원소를 한 번씩 봄
+    uint64 visited = 0;
+    for (auto i = map.Next(0); i >= 0; i = map.Next(i + 1)) {
+        auto k = *(const uint64*)map.KeyAt(i);
+        REQUIRE(expected.at(k) == *(int32*)map.ValueAt(i));
+        visited++;
+    }
+    REQUIRE(visited == expected.size());
+
+    auto capacity = map.Capacity();
+    REQUIRE(map.RemoveAll());
+    REQUIRE(map.Count() == 0);
+    REQUIRE(map.Next(0) == -1);
+    REQUIRE(map.Capacity() == capacity);
+    REQUIRE(map.Destroy());
+}
+
+TEST_CASE("test HashMap (string key)", "[Container.HashMap]") {
+    auto addrspace0 = L"hashmap";
+    REQUIRE(memPageAdd(addrspace0, memPageMinSize(false), false));
+
+    std::vector<std::string> names;
+    for (auto i = 0; i < 1000; i++) {
+        names.push_back("Bip001 Node" + std::to_string(i));
+    }
+
+    HashMap map;
+    REQUIRE(map.Init(addrspace0, sizeof(const char*), sizeof(int32), hashMapStringHash, hashMapStringEqual, nullptr, names.size()));
+    auto capacity = map.Capacity();
+    for (auto i = 0; i < (int32)names.size(); i++) {
+        auto name = names[i].c_str();
+        REQUIRE(map.Insert(&name, &i) != nullptr);
+    }
+    // 미리 잡은 용량으로 충분함
+    REQUIRE(map.Capacity() == capacity);
+
+    // 다른 포인터라도 내용이 같으면 같은 키
+    for (auto i = 0; i < (int32)names.size(); i++) {
+        auto copy = names[i];
+        auto name = copy.c_str();
+        auto p = (int32*)map.Find(&name);
+        REQUIRE(p != nullptr);
+        REQUIRE(*p == i);
+    }
+    auto missing = "Bip001 Node1000";
+    REQUIRE(map.Find(&missing) == nullptr);
+
+    REQUIRE(memAllocSize(addrspace0) > 0);
+    REQUIRE(map.Destroy());
+    REQUIRE(memAllocSize(addrspace0) == 0);
+    REQUIRE(memPageFree(addrspace0));
+
+    // 넓은 문자열 키
+    const wchar_t* files[] = { L"skinning.hlsl", L"object.hlsl", L"dq.hlsl" };
+    REQUIRE(map.Init(nullptr, sizeof(const wchar_t*), 0, hashMapWStringHash, hashMapWStringEqual));
+    for (auto file : files) {
+        REQUIRE(map.Insert(&file, nullptr) != nullptr);
+    }
+    std::wstring object = L"object.hlsl";
+    auto objectName = object.c_str();
+    REQUIRE(map.Find(&objectName) != nullptr);
+    REQUIRE(map.Count() == 3);
+    REQUIRE(map.Destroy());
+
+    REQUIRE(hashString("Bip001") == hashBytes("Bip001", 6));
+    REQUIRE(hashString("Bip001") != hashString("Bip002"));
+    REQUIRE(hashString("Bip001", 1) != hashString("Bip001"));
+}
@@ -0,0 +1,88 @@
+#include "geometry.h"
+#include "catch.hpp"
+
+#include <math.h>
+#include <string>
+#include <vector>
+
+static float KDTreeBenchRandom(uint64& seed)
+{
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    return (float)(seed >> 40) / (float)(1ull << 24);
+}
+
+// brute force 는 점 수에 비례하므로 큰 집합에서는 질의 수를 줄여서 잼
+static void BenchPointCount(uint32 pointCount, uint32 queryCount, uint32 bruteForceQueryCount)
+{
+    const uint32 k = 8;
+    uint64 seed = pointCount;
+    std::vector<Vector3f> points(pointCount);
+    for (auto& p : points) {
+        p.x = KDTreeBenchRandom(seed);
+        p.y = KDTreeBenchRandom(seed);
+        p.z = KDTreeBenchRandom(seed);
+    }
+    std::vector<Vector3f> queries(queryCount);
+    for (auto& q : queries) {
+        q.x = KDTreeBenchRandom(seed);
+        q.y = KDTreeBenchRandom(seed);
+        q.z = KDTreeBenchRandom(seed);
+    }
+    std::vector<KDTreeNeighbor> neighbors((size_t)queryCount * k);
+    std::vector<uint32> found(queryCount);
+    // 질의마다 평균 8 개쯤 들어오는 반지름
+    auto radius = powf(8.f / pointCount * 3 / (4 * 3.14159265f), 1.f / 3);
+
+    auto label = std::to_string(pointCount) + " points";
+    BENCHMARK(label + ", build") {
+        KDTree tree;
+        tree.Build(points.data(), pointCount);
+        return tree.Count();
+    };
+
+    KDTree tree;
+    tree.Build(points.data(), pointCount);
+    BENCHMARK(label + ", " + std::to_string(queryCount) + " x 8-NN") {
+        uint32 sum = 0;
+        for (uint32 i = 0; i < queryCount; i++) {
+            sum += tree.Nearest(queries[i], k, neighbors.data() + i * k);
+        }
+        return sum;
+    };
+    BENCHMARK(label + ", " + std::to_string(queryCount) + " x 8-NN batch") {
+        return tree.NearestBatch(queries.data(), queryCount, k, neighbors.data(), found.data());
+    };
+    BENCHMARK(label + ", " + std::to_string(queryCount) + " x radius batch") {
+        return tree.RadiusBatch(queries.data(), queryCount, radius, neighbors.data(), k, found.data());
+    };
+    BENCHMARK(label + ", " + std::to_string(bruteForceQueryCount) + " x 8-NN brute force") {
+        float sum = 0;
+        for (uint32 i = 0; i < bruteForceQueryCount; i++) {
+            float best[k];
+            for (auto& b : best) {
+                b = FLT_MAX;
+            }
+            auto& q = queries[i];
+            for (auto& p : points) {
+                auto dx = p.x - q.x, dy = p.y - q.y, dz = p.z - q.z;
+                auto d = dx * dx + dy * dy + dz * dz;
+                if (d < best[k - 1]) {
+                    auto n = k - 1;
+                    for (; n > 0 && best[n - 1] > d; n--) {
+                        best[n] = best[n - 1];
+                    }
+                    best[n] = d;
+                }
+            }
+            sum += best[k - 1];
+        }
+        return sum;
+    };
+}
+
+TEST_CASE("bench KDTree", "[Geometry.KDTree][!benchmark]") {
+    BenchPointCount(10000, 10000, 1000);
+    BenchPointCount(100000, 10000, 100);
+    BenchPointCount(1000000, 10000, 10);
+    BenchPointCount(10000000, 10000, 1);
+}
@@ -0,0 +1,126 @@
+#include "geometry.h"
+#include "catch.hpp"
+
+#include <algorithm>
+#include <vector>
+
+static float KDTreeRandom(uint64& seed)
+{
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    return (float)(seed >> 40) / (float)(1ull << 24);
+}
+
+static float SqrDistance(const Vector3f& a, const Vector3f& b)
+{
+    auto dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+static std::vector<float> BruteForceNearest(const std::vector<Vector3f>& points, const Vector3f& query, uint32 k, float maxDistance)
+{
+    std::vector<float> distances;
+    for (auto& p : points) {
+        auto d = SqrDistance(p, query);
+        if (d <= maxDistance * maxDistance) {
+            distances.push_back(d);
+        }
+    }
+    std::sort(distances.begin(), distances.end());
+    distances.resize(std::min((size_t)k, distances.size()));
+    return distances;
+}
+
+TEST_CASE("test KDTree", "[Geometry.KDTree]") {
+    KDTree tree;
+    std::vector<Vector3f> points;
+    KDTreeNeighbor neighbor;
+    REQUIRE_FALSE(tree.Build(nullptr, 0));
+    REQUIRE(tree.Nearest(Vector3f(0.f), 1, &neighbor) == 0);
+
+    uint64 seed = 1;
+    for (auto i = 0; i < 20000; i++) {
+        points.push_back(Vector3f(KDTreeRandom(seed) * 10, KDTreeRandom(seed) * 10, KDTreeRandom(seed)));
+    }
+    // 겹친 점과 한 평면에 몰린 점도 섞음
+    for (auto i = 0; i < 500; i++) {
+        points.push_back(Vector3f(5.f, 5.f, 0.5f));
+        points.push_back(Vector3f(KDTreeRandom(seed) * 10, 2.f, 0.25f));
+    }
+    REQUIRE(tree.Build(points.data(), (uint32)points.size(), 4));
+    REQUIRE(tree.Count() == points.size());
+
+    // 모든 점이 한 번씩 들어 있음
+    std::vector<uint32> visited(points.size(), 0);
+    for (uint32 i = 0; i < tree.Count(); i++) {
+        auto index = tree.Indices()[i];
+        visited[index]++;
+        REQUIRE(tree.Points()[i] == points[index]);
+    }
+    for (auto v : visited) {
+        REQUIRE(v == 1);
+    }
+
+    // brute force 와 같은 거리의 이웃을 같은 순서로 찾음
+    std::vector<KDTreeNeighbor> neighbors(64);
+    for (auto i = 0; i < 300; i++) {
+        Vector3f query(KDTreeRandom(seed) * 12 - 1, KDTreeRandom(seed) * 12 - 1, KDTreeRandom(seed) * 2 - 0.5f);
+        if (i % 10 == 0) {
+            query = Vector3f(5.f, 5.f, 0.5f);
+        }
+        auto k = 1 + i % 40;
+        auto maxDistance = i % 3 == 0? 0.3f: FLT_MAX;
+        auto expected = BruteForceNearest(points, query, k, maxDistance);
+        auto found = tree.Nearest(query, k, neighbors.data(), maxDistance);
+        REQUIRE(found == expected.size());
+        for (uint32 n = 0; n < found; n++) {
+            REQUIRE(neighbors[n].sqrDistance == expected[n]);
+            REQUIRE(SqrDistance(points[neighbors[n].index], query) == neighbors[n].sqrDistance);
+        }
+
+        auto radius = KDTreeRandom(seed) * 0.5f;
+        uint32 expectedCount = 0;
+        for (auto& p : points) {
+            expectedCount += SqrDistance(p, query) <= radius * radius;
+        }
+        auto total = tree.Radius(query, radius, neighbors.data(), (uint32)neighbors.size());
+        REQUIRE(total == expectedCount);
+        for (uint32 n = 0; n < std::min(total, (uint32)neighbors.size()); n++) {
+            REQUIRE(neighbors[n].sqrDistance <= radius * radius);
+            REQUIRE(SqrDistance(points[neighbors[n].index], query) == neighbors[n].sqrDistance);
+        }
+        REQUIRE(tree.Radius(query, radius, nullptr, 0) == total);
+    }
+
+    // k 가 점 개수보다 많으면 모든 점을 돌려줌
+    KDTree small;
+    REQUIRE(small.Build(points.data(), 7, 1));
+    REQUIRE(small.Nearest(Vector3f(0.f), 64, neighbors.data()) == 7);
+    for (auto n = 1; n < 7; n++) {
+        REQUIRE(neighbors[n - 1].sqrDistance <= neighbors[n].sqrDistance);
+    }
+
+    // batch 질의는 하나씩 부른 것과 같음
+    const uint32 queryCount = 3000, k = 8, capacity = 16;
+    std::vector<Vector3f> queries;
+    for (uint32 i = 0; i < queryCount; i++) {
+        queries.push_back(Vector3f(KDTreeRandom(seed) * 10, KDTreeRandom(seed) * 10, KDTreeRandom(seed)));
+    }
+    std::vector<KDTreeNeighbor> batch(queryCount * capacity);
+    std::vector<uint32> found(queryCount);
+    REQUIRE(tree.NearestBatch(queries.data(), queryCount, k, batch.data(), found.data(), FLT_MAX, 4));
+    for (uint32 i = 0; i < queryCount; i++) {
+        REQUIRE(found[i] == k);
+        REQUIRE(tree.Nearest(queries[i], k, neighbors.data()) == k);
+        for (uint32 n = 0; n < k; n++) {
+            REQUIRE(batch[i * k + n].sqrDistance == neighbors[n].sqrDistance);
+        }
+    }
+    REQUIRE(tree.RadiusBatch(queries.data(), queryCount, 0.2f, batch.data(), capacity, found.data(), 4));
+    for (uint32 i = 0; i < queryCount; i++) {
+        REQUIRE(found[i] == tree.Radius(queries[i], 0.2f, nullptr, 0));
+    }
+
+    tree.Clear();
+    REQUIRE(tree.Count() == 0);
+    REQUIRE(tree.Radius(Vector3f(0.f), 1.f, nullptr, 0) == 0);
+}
@@ -0,0 +1,173 @@
+#include "allocators.h"
+#include "container.h"
+#include "memtrace.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <stdio.h>
+#include <set>
+#include <thread>
+
+TEST_CASE("test memory trace", "[Allocator.Trace]") {
+    const char* path = "memtrace.test.bin";
+
+    REQUIRE(memTraceBegin(path));
+    REQUIRE_FALSE(memTraceBegin(path));
+
+    auto space = memPageAdd(L"trace", memPageMinSize(false), false, MEMPAGE_KIND_DEFAULT, 0);
+    REQUIRE(space);
+
+    void* named[100];
+    for (auto i = 0; i < 100; i++) {
+        named[i] = memAllocH(16 + i, 64, 0, space);
+        REQUIRE(named[i] != nullptr);
+    }
+    for (auto i = 0; i < 100; i += 2) {
+        REQUIRE(memFreeH(named[i], space));
+    }
+
+    // 버퍼가 넘치도록 다른 스레드에서 system 할당
+    std::thread worker([]() {
+        for (auto i = 0; i < 5000; i++) {
+            auto p = memAlloc(32, 16, 0, SYSTEM_NAME);
+            memFree(p, SYSTEM_NAME);
+        }
+    });
+    worker.join();
+
+    REQUIRE(memPageFree(L"trace"));
+    REQUIRE(memTraceEnd());
+    REQUIRE_FALSE(memTraceEnd());
+
+    // 기록이 끝난 뒤의 할당은 남지 않음
+    auto after = memAlloc(32, 16, 0, SYSTEM_NAME);
+    memFree(after, SYSTEM_NAME);
+
+    ArrayList records, names;
+    REQUIRE(memTraceLoad(path, &records, &names));
+    remove(path);
+
+    REQUIRE(names.Count() == 1);
+    auto name = (MemTraceName*)names[0];
+    REQUIRE(wcscmp(name->name, L"trace") == 0);
+    REQUIRE(name->space != MEMTRACE_SYSTEM_SPACE);
+
+    // system 공간은 Common 내부 목록도 쓰므로 기록 전에 받은 주소가 해제될 수 있음
+    int32 spaceCount = 0, spaceFreeCount = 0, allocCount = 0, freeCount = 0, workerCount = 0;
+    std::set<uint64> live;
+    std::set<uint16> threads;
+    auto first = (MemTraceRecord*)records.Start();
+    for (auto i = 0; i < records.Count(); i++) {
+        auto& record = first[i];
+        REQUIRE(record.op <= MEMTRACE_OP_SPACE_FREE);
+        threads.insert(record.thread);
+
+        if (i > 0) {
+            REQUIRE(first[i - 1].time <= record.time);
+        }
+
+        auto named = record.space == name->space;
+        if (!named) {
+            REQUIRE(record.space == MEMTRACE_SYSTEM_SPACE);
+        }
+
+        switch (record.op) {
+        case MEMTRACE_OP_SPACE:
+            REQUIRE(named);
+            REQUIRE(record.pointer == MEMPAGE_KIND_DEFAULT);
+            REQUIRE(record.size == memPageMinSize(false));
+            spaceCount++;
+            break;
+        case MEMTRACE_OP_ALLOC:
+            REQUIRE(live.insert(record.pointer).second);
+            if (named) {
+                REQUIRE(record.alignShift == 6);
+                REQUIRE(record.size >= 16);
+                REQUIRE(record.size < 116);
+                allocCount++;
+            } else if (record.size == 32 && record.alignShift == 4) {
+                workerCount++;
+            }
+            break;
+        case MEMTRACE_OP_FREE:
+            if (named) {
+                REQUIRE(live.erase(record.pointer) == 1);
+                freeCount++;
+            } else {
+                live.erase(record.pointer);
+            }
+            break;
+        case MEMTRACE_OP_SPACE_FREE:
+            REQUIRE(named);
+            spaceFreeCount++;
+            break;
+        }
+    }
+
+    REQUIRE(spaceCount == 1);
+    REQUIRE(spaceFreeCount == 1);
+    REQUIRE(allocCount == 100);
+    REQUIRE(freeCount == 50);
+    REQUIRE(workerCount == 5000);
+    REQUIRE(threads.size() >= 2);
+
+    records.Destroy();
+    names.Destroy();
+}
+
+TEST_CASE("test memory trace (realloc and free failure)", "[Allocator.Trace]") {
+    const char* path = "memtrace.realloc.test.bin";
+
+    auto space = memPageAdd(L"trace.realloc", memPageMinSize(false), false, MEMPAGE_KIND_DEFAULT, 0);
+    REQUIRE(space);
+    auto stale = memPageAdd(L"trace.stale", memPageMinSize(false), false, MEMPAGE_KIND_DEFAULT, 0);
+    REQUIRE(stale);
+    REQUIRE(memPageFree(L"trace.stale"));
+
+    REQUIRE(memTraceBegin(path));
+    auto p = memAllocH(64, 16, 0, space);
+    REQUIRE(p != nullptr);
+    // 늘릴 수 없는 크기와 지워진 공간, 둘 다 실패하고 p 는 그대로 살아 있어야 함
+    REQUIRE(memReallocH(p, (size_t)1 << 60, 16, 0, space) == nullptr);
+    REQUIRE(memReallocH(p, 128, 16, 0, stale) == nullptr);
+    auto q = memReallocH(p, 4096, 16, 0, space);
+    REQUIRE(q != nullptr);
+    // 실패한 해제도 기록에 남지 않아야 재생할 때 살아 있는 블록을 풀지 않음
+    int local = 0;
+    REQUIRE_FALSE(memFreeH(q, stale));
+    REQUIRE_FALSE(memFreeH(&local, space));
+    REQUIRE(memFreeH(q, space));
+    REQUIRE(memTraceEnd());
+    REQUIRE(memPageFree(L"trace.realloc"));
+
+    ArrayList records, names;
+    REQUIRE(memTraceLoad(path, &records, &names));
+    remove(path);
+
+    REQUIRE(names.Count() == 1);
+    auto named = ((MemTraceName*)names[0])->space;
+
+    // p 의 해제는 성공한 realloc 에서 한 번만, 그 뒤에 q 의 할당과 해제
+    int32 allocCount = 0, freeCount = 0;
+    std::set<uint64> live;
+    auto first = (MemTraceRecord*)records.Start();
+    for (auto i = 0; i < records.Count(); i++) {
+        auto& record = first[i];
+        if (record.space != named) {
+            continue;
+        }
+        if (record.op == MEMTRACE_OP_ALLOC) {
+            REQUIRE(live.insert(record.pointer).second);
+            allocCount++;
+        } else if (record.op == MEMTRACE_OP_FREE) {
+            REQUIRE(live.erase(record.pointer) == 1);
+            freeCount++;
+        }
+    }
+    REQUIRE(allocCount == 2);
+    REQUIRE(freeCount == 2);
+    REQUIRE(live.empty());
+
+    records.Destroy();
+    names.Destroy();
+}
@@ -0,0 +1,192 @@
+#include "allocators.h"
+#include "objectpool.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST_CASE("test object pool", "[Container.ObjectPool]") {
+    ObjectPool pool;
+
+    REQUIRE_FALSE(pool.Init(nullptr, 0));
+    REQUIRE_FALSE(pool.Init(nullptr, 48, 24));
+    REQUIRE(pool.Alloc() == nullptr);
+
+    REQUIRE(pool.Init(nullptr, 48, 16, 16, 64));
+    REQUIRE(pool.Step() == 48);
+    REQUIRE(pool.Alignment() == 16);
+    REQUIRE(pool.Capacity() == 0);
+
+    std::set<void*> blocks;
+    for (auto i = 0; i < 64; i++) {
+        auto p = (uint8*)pool.Alloc();
+        REQUIRE(p != nullptr);
+        REQUIRE((size_t)p % 16 == 0);
+        memset(p, i, 48);
+        REQUIRE(blocks.insert(p).second);
+    }
+    REQUIRE(pool.Capacity() == 64);
+    REQUIRE(pool.LiveCount() == 64);
+
+    // maxCount 를 넘으면 실패
+    REQUIRE(pool.Alloc() == nullptr);
+
+    int local = 0;
+    REQUIRE_FALSE(pool.Free(nullptr));
+    REQUIRE_FALSE(pool.Free((uint8*)*blocks.begin() + 8));
+    // 풀 밖의 주소는 페이지 첫 부분을 읽지 않고 거름
+    REQUIRE_FALSE(pool.Free(&local));
+
+    // 해제한 블록은 스레드 캐시에 남아서 아직 사용중으로 셈
+    for (auto p : blocks) {
+        REQUIRE(pool.Free(p));
+    }
+    REQUIRE(pool.LiveCount() <= (uint64)OBJECTPOOL_MAGAZINE_SIZE);
+
+    // 해제한 블록을 다시 씀
+    void* bulk[64];
+    REQUIRE(pool.AllocBulk(bulk, 64) == 64);
+    REQUIRE(pool.AllocBulk(bulk, 1) == 0);
+    for (auto i = 0; i < 64; i++) {
+        REQUIRE(blocks.count(bulk[i]) == 1);
+    }
+    std::set<void*> unique(bulk, bulk + 64);
+    REQUIRE(unique.size() == 64);
+
+    // 하나라도 다른 블록이면 아무것도 해제하지 않음
+    auto other = bulk[63];
+    bulk[63] = &local;
+    REQUIRE_FALSE(pool.FreeBulk(bulk, 64));
+    bulk[63] = other;
+    REQUIRE(pool.FreeBulk(bulk, 64));
+    REQUIRE(pool.LiveCount() <= (uint64)OBJECTPOOL_MAGAZINE_SIZE);
+    REQUIRE(pool.Capacity() == 64);
+
+    REQUIRE(pool.Destroy());
+    REQUIRE_FALSE(pool.Destroy());
+    REQUIRE(pool.Alloc() == nullptr);
+
+    // 다시 만든 풀은 이전 풀이 스레드 캐시에 남긴 블록을 쓰지 않음
+    auto addrspace0 = L"objectpool";
+    REQUIRE(memPageAdd(addrspace0, memPageMinSize(false), false));
+    REQUIRE(pool.Init(addrspace0, 8));
+    auto p = pool.Alloc();
+    REQUIRE(p != nullptr);
+    REQUIRE(blocks.count(p) == 0);
+    REQUIRE(pool.Free(p));
+    REQUIRE(pool.Destroy());
+    REQUIRE(memAllocSize(addrspace0) == 0);
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("test object pool (multi thread)", "[Container.ObjectPool]") {
+    // 블록을 다른 스레드에 넘겨서 해제하게 하고 같은 블록이 두 번 나가지 않는지 확인
+    // 빈 블록은 첫 4바이트에 목록 연결을 적으므로 owner 는 뒤에 둠
+    struct Packet
+    {
+        uint64 sequence;
+        int32 thread;
+        std::atomic<int32> owner;
+    };
+
+    const int32 threadCount = 8;
+    const int32 iterationCount = 20000;
+    const int32 slotCount = 256;
+    const int32 maxCount = 4096;
+
+    ObjectPool pool;
+    REQUIRE(pool.Init(nullptr, sizeof(Packet), alignof(Packet), 64, maxCount));
+
+    // 모든 블록을 미리 만들어서 owner 를 비워둠
+    std::vector<void*> warm(maxCount);
+    REQUIRE(pool.AllocBulk(warm.data(), maxCount) == maxCount);
+    for (auto p : warm) {
+        ((Packet*)p)->owner.store(-1);
+    }
+    REQUIRE(pool.FreeBulk(warm.data(), maxCount));
+
+    std::vector<std::atomic<Packet*>> slots(slotCount);
+    for (auto& slot : slots) {
+        slot.store(nullptr);
+    }
+    std::atomic<int32> duplicateCount(0), corruptCount(0), failCount(0);
+
+    auto release = [&](Packet* packet) {
+        if (packet->owner.exchange(-1) < 0) {
+            duplicateCount++;
+        }
+        if (!pool.Free(packet)) {
+            failCount++;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t]() {
+            uint32 seed = 1234u + t;
+            Packet* bulk[16];
+            for (auto i = 0; i < iterationCount; i++) {
+                seed = seed * 1664525u + 1013904223u;
+
+                if ((seed >> 28) == 0) {
+                    // 가끔 여러 개를 한 번에 받고 한 번에 돌려줌
+                    auto count = pool.AllocBulk((void**)bulk, 16);
+                    for (auto j = 0; j < count; j++) {
+                        if (bulk[j]->owner.exchange(t) >= 0) {
+                            duplicateCount++;
+                        }
+                    }
+                    for (auto j = 0; j < count; j++) {
+                        bulk[j]->owner.store(-1);
+                    }
+                    if (count != 16 || !pool.FreeBulk((void**)bulk, count)) {
+                        failCount++;
+                    }
+                    continue;
+                }
+
+                auto packet = (Packet*)pool.Alloc();
+                if (packet == nullptr) {
+                    failCount++;
+                    continue;
+                }
+                if (packet->owner.exchange(t) >= 0) {
+                    duplicateCount++;
+                }
+                packet->thread = t;
+                packet->sequence = i;
+
+                // 다른 스레드가 넣어둔 블록과 바꾸고 그 블록을 해제
+                auto previous = slots[(seed >> 8) % slotCount].exchange(packet);
+                if (previous != nullptr) {
+                    if (previous->owner.load() != previous->thread) {
+                        corruptCount++;
+                    }
+                    release(previous);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (auto& slot : slots) {
+        auto packet = slot.exchange(nullptr);
+        if (packet != nullptr) {
+            release(packet);
+        }
+    }
+
+    REQUIRE(duplicateCount == 0);
+    REQUIRE(corruptCount == 0);
+    REQUIRE(failCount == 0);
+
+    // 끝난 스레드의 캐시는 풀로 돌아옴
+    REQUIRE(pool.LiveCount() <= (uint64)OBJECTPOOL_MAGAZINE_SIZE);
+    REQUIRE(pool.Capacity() == maxCount);
+    REQUIRE(pool.Destroy());
+}
@@ -0,0 +1,192 @@
+#include "allocators.h"
+#include "ringbuffer.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 스레드 사이에 명령 count 개를 넘기는 시간
+static const int32 g_RingItemCount = 200000;
+
+// 비교용, 락 하나로 감싼 큐
+struct LockedQueue {
+    std::mutex lock;
+    std::condition_variable cv;
+    std::deque<uint64> items;
+    bool closed = false;
+
+    void Push(uint64 value)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            items.push_back(value);
+        }
+        cv.notify_one();
+    }
+    bool Pop(uint64* value)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        cv.wait(guard, [this]() { return !items.empty() || closed; });
+        if (items.empty()) {
+            return false;
+        }
+        *value = items.front();
+        items.pop_front();
+        return true;
+    }
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closed = true;
+        }
+        cv.notify_all();
+    }
+};
+
+template <typename Ring>
+static uint64 RunRing(Ring& ring, int32 producerCount, int32 consumerCount, int32 batch)
+{
+    std::vector<std::thread> producers, consumers;
+    std::vector<uint64> sums(consumerCount);
+    for (auto c = 0; c < consumerCount; c++) {
+        consumers.emplace_back([&ring, &sums, c, batch]() {
+            uint64 values[64], sum = 0;
+            for (;;) {
+                auto n = batch > 1? ring.PopBulk(values, batch): 0;
+                if (n == 0) {
+                    if (!ring.PopWait(values)) {
+                        break;
+                    }
+                    n = 1;
+                }
+                for (auto i = 0; i < n; i++) {
+                    sum += values[i];
+                }
+            }
+            sums[c] = sum;
+        });
+    }
+    for (auto p = 0; p < producerCount; p++) {
+        producers.emplace_back([&ring, producerCount, batch]() {
+            uint64 values[64];
+            auto perProducer = g_RingItemCount / producerCount;
+            for (auto i = 0; i < perProducer;) {
+                auto n = perProducer - i < batch? perProducer - i: batch;
+                for (auto j = 0; j < n; j++) {
+                    values[j] = (uint64)(i + j);
+                }
+                auto pushed = batch > 1? ring.PushBulk(values, n): 0;
+                if (pushed == 0) {
+                    ring.PushWait(values);
+                    pushed = 1;
+                }
+                i += pushed;
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    ring.Close();
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    uint64 sum = 0;
+    for (auto s : sums) {
+        sum += s;
+    }
+    return sum;
+}
+
+static uint64 RunSPSC(int32 batch)
+{
+    SPSCRingBuffer ring;
+    ring.Init(nullptr, sizeof(uint64), 1024, true);
+    auto sum = RunRing(ring, 1, 1, batch);
+    ring.Destroy();
+    return sum;
+}
+
+static uint64 RunMPMC(int32 producerCount, int32 consumerCount, int32 batch)
+{
+    MPMCRingBuffer ring;
+    ring.Init(nullptr, sizeof(uint64), 1024, true);
+    auto sum = RunRing(ring, producerCount, consumerCount, batch);
+    ring.Destroy();
+    return sum;
+}
+
+TEST_CASE("bench RingBuffer throughput", "[Container.RingBuffer][!benchmark]") {
+    BENCHMARK("SPSCRingBuffer, 200k items") {
+        return RunSPSC(1);
+    };
+    BENCHMARK("SPSCRingBuffer, 200k items, bulk 32") {
+        return RunSPSC(32);
+    };
+    BENCHMARK("MPMCRingBuffer 1:1, 200k items") {
+        return RunMPMC(1, 1, 1);
+    };
+    BENCHMARK("MPMCRingBuffer 2:2, 200k items") {
+        return RunMPMC(2, 2, 1);
+    };
+    BENCHMARK("MPMCRingBuffer 2:2, 200k items, bulk 32") {
+        return RunMPMC(2, 2, 32);
+    };
+    BENCHMARK("mutex + deque 1:1, 200k items") {
+        LockedQueue queue;
+        std::thread consumer([&queue]() {
+            uint64 value;
+            while (queue.Pop(&value)) {
+            }
+        });
+        for (auto i = 0; i < g_RingItemCount; i++) {
+            queue.Push((uint64)i);
+        }
+        queue.Close();
+        consumer.join();
+        return queue.items.size();
+    };
+}
+
+// 두 링으로 주고받는 왕복 시간, 상대가 잠들어 있으면 깨우는 비용이 들어감
+static uint64 PingPong(bool waitable, int32 roundTrips)
+{
+    SPSCRingBuffer ping, pong;
+    ping.Init(nullptr, sizeof(uint64), 16, waitable);
+    pong.Init(nullptr, sizeof(uint64), 16, waitable);
+
+    std::thread echo([&ping, &pong]() {
+        uint64 value;
+        while (ping.PopWait(&value)) {
+            pong.PushWait(&value);
+        }
+    });
+    uint64 sum = 0;
+    for (uint64 i = 0; i < (uint64)roundTrips; i++) {
+        uint64 value;
+        ping.PushWait(&i);
+        pong.PopWait(&value);
+        sum += value;
+    }
+    ping.Close();
+    echo.join();
+
+    ping.Destroy();
+    pong.Destroy();
+    return sum;
+}
+
+TEST_CASE("bench RingBuffer latency", "[Container.RingBuffer][!benchmark]") {
+    BENCHMARK("SPSCRingBuffer ping-pong x1000, waitable") {
+        return PingPong(true, 1000);
+    };
+    BENCHMARK("SPSCRingBuffer ping-pong x1000, yield") {
+        return PingPong(false, 1000);
+    };
+}
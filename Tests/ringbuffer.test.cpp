@@ -0,0 +1,188 @@
+#include "allocators.h"
+#include "ringbuffer.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+struct RingCommand {
+    uint32 producer;
+    uint32 sequence;
+    uint64 payload;
+};
+
+TEST_CASE("test SPSCRingBuffer", "[Container.RingBuffer]") {
+    SPSCRingBuffer ring;
+
+    REQUIRE_FALSE(ring.Init(nullptr, 0, 16));
+    REQUIRE_FALSE(ring.Init(nullptr, 8, 0));
+    uint64 value = 0;
+    REQUIRE_FALSE(ring.Push(&value));
+
+    REQUIRE(ring.Init(nullptr, sizeof(uint64), 5));
+    REQUIRE(ring.Capacity() == 8);
+    REQUIRE(ring.Step() == sizeof(uint64));
+    REQUIRE_FALSE(ring.Pop(&value));
+
+    for (uint64 i = 0; i < 8; i++) {
+        REQUIRE(ring.Push(&i));
+    }
+    REQUIRE_FALSE(ring.Push(&value));
+    REQUIRE(ring.Count() == 8);
+    for (uint64 i = 0; i < 5; i++) {
+        REQUIRE(ring.Pop(&value));
+        REQUIRE(value == i);
+    }
+
+    // 끝을 넘어가는 묶음도 순서대로
+    uint64 values[8] = { 100, 101, 102, 103, 104, 105, 106, 107 };
+    REQUIRE(ring.PushBulk(values, 8) == 5);
+    uint64 popped[8] = {};
+    REQUIRE(ring.PopBulk(popped, 8) == 8);
+    REQUIRE(popped[0] == 5);
+    REQUIRE(popped[2] == 7);
+    REQUIRE(popped[3] == 100);
+    REQUIRE(popped[7] == 104);
+    REQUIRE(ring.PopBulk(popped, 8) == 0);
+
+    // 닫힌 뒤에는 넣을 수 없지만 남은 원소는 꺼냄
+    REQUIRE(ring.Push(&values[0]));
+    ring.Close();
+    REQUIRE(ring.IsClosed());
+    REQUIRE_FALSE(ring.Push(&values[1]));
+    REQUIRE(ring.PopWait(&value));
+    REQUIRE(value == 100);
+    REQUIRE_FALSE(ring.PopWait(&value));
+    REQUIRE(ring.Destroy());
+
+    // 다른 스레드로 순서를 지켜서 넘김
+    auto addrspace0 = L"ringbuffer";
+    REQUIRE(memPageAdd(addrspace0, memPageMinSize(false), false));
+    REQUIRE(ring.Init(addrspace0, sizeof(RingCommand), 64, true));
+    const uint32 count = 100000;
+    std::thread producer([&ring]() {
+        RingCommand batch[7];
+        uint32 sent = 0;
+        while (sent < count) {
+            if (sent % 3 == 0) {
+                RingCommand command = { 0, sent, (uint64)sent * 3 };
+                ring.PushWait(&command);
+                sent++;
+                continue;
+            }
+            auto n = count - sent < 7? count - sent: 7;
+            for (uint32 i = 0; i < n; i++) {
+                batch[i] = { 0, sent + i, (uint64)(sent + i) * 3 };
+            }
+            // 가득 차면 하나씩 기다리면서 넣음
+            auto pushed = 0;
+            while (pushed < (int32)n) {
+                auto bulk = ring.PushBulk(batch + pushed, n - pushed);
+                pushed += bulk > 0? bulk: ring.PushWait(batch + pushed)? 1: 0;
+            }
+            sent += n;
+        }
+        ring.Close();
+    });
+
+    uint32 expected = 0;
+    auto ordered = true;
+    RingCommand command;
+    while (ring.PopWait(&command)) {
+        ordered &= command.sequence == expected && command.payload == (uint64)expected * 3;
+        expected++;
+    }
+    producer.join();
+    REQUIRE(ordered);
+    REQUIRE(expected == count);
+    REQUIRE(ring.Destroy());
+    REQUIRE(memAllocSize(addrspace0) == 0);
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("test MPMCRingBuffer", "[Container.RingBuffer]") {
+    MPMCRingBuffer ring;
+
+    REQUIRE_FALSE(ring.Init(nullptr, 0, 16));
+    REQUIRE(ring.Init(nullptr, sizeof(uint32), 4));
+    REQUIRE(ring.Capacity() == 4);
+
+    uint32 values[6] = { 1, 2, 3, 4, 5, 6 };
+    REQUIRE(ring.PushBulk(values, 6) == 4);
+    REQUIRE_FALSE(ring.Push(&values[4]));
+    REQUIRE(ring.Count() == 4);
+    uint32 value = 0;
+    REQUIRE(ring.Pop(&value));
+    REQUIRE(value == 1);
+    REQUIRE(ring.Push(&values[4]));
+    uint32 popped[6] = {};
+    REQUIRE(ring.PopBulk(popped, 6) == 4);
+    REQUIRE(popped[0] == 2);
+    REQUIRE(popped[3] == 5);
+    REQUIRE_FALSE(ring.Pop(nullptr));
+    REQUIRE(ring.Destroy());
+
+    // 생산자와 소비자 여럿, 모든 명령을 정확히 한 번씩 받고 생산자마다 순서는 유지
+    const uint32 producerCount = 3, consumerCount = 3, perProducer = 30000;
+    REQUIRE(ring.Init(nullptr, sizeof(RingCommand), 128, true));
+
+    std::vector<std::atomic<uint32>> received(producerCount * perProducer);
+    for (auto& r : received) {
+        r.store(0);
+    }
+    std::atomic<bool> ordered(true);
+    std::vector<std::thread> consumers;
+    for (uint32 c = 0; c < consumerCount; c++) {
+        consumers.emplace_back([&]() {
+            uint32 last[producerCount] = {};
+            bool seen[producerCount] = {};
+            RingCommand batch[4];
+            for (;;) {
+                auto n = ring.PopBulk(batch, 4);
+                if (n == 0) {
+                    if (!ring.PopWait(&batch[0])) {
+                        break;
+                    }
+                    n = 1;
+                }
+                for (auto i = 0; i < n; i++) {
+                    auto& command = batch[i];
+                    if (seen[command.producer] && command.sequence <= last[command.producer]) {
+                        ordered = false;
+                    }
+                    seen[command.producer] = true;
+                    last[command.producer] = command.sequence;
+                    received[command.producer * perProducer + command.sequence].fetch_add(1);
+                }
+            }
+        });
+    }
+
+    std::vector<std::thread> producers;
+    for (uint32 p = 0; p < producerCount; p++) {
+        producers.emplace_back([&ring, p]() {
+            for (uint32 i = 0; i < perProducer; i++) {
+                RingCommand command = { p, i, 0 };
+                ring.PushWait(&command);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    ring.Close();
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    auto once = true;
+    for (auto& r : received) {
+        once &= r.load() == 1;
+    }
+    REQUIRE(once);
+    REQUIRE(ordered);
+    REQUIRE(ring.Count() == 0);
+    REQUIRE(ring.Destroy());
+}
@@ -0,0 +1,145 @@
+#include "allocators.h"
+#include "segmentedlist.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <vector>
+
+struct SegmentedData {
+    uint64 id;
+    uint64 value[3];
+};
+
+TEST_CASE("test SegmentedList", "[Container.SegmentedList]") {
+    SegmentedList list;
+
+    REQUIRE_FALSE(list.Init(nullptr, 0));
+    REQUIRE_FALSE(list.Init(nullptr, 8, 24));
+    REQUIRE(list.InsertLast(nullptr) == nullptr);
+
+    REQUIRE(list.Init(nullptr, sizeof(SegmentedData), 32, 5));
+    REQUIRE(list.BlockCapacity() == 8);
+
+    // 블록이 늘어나도 앞에서 받은 주소는 그대로
+    std::vector<SegmentedData*> ptrs;
+    for (uint64 i = 0; i < 100; i++) {
+        SegmentedData data = { i, { i, i * 2, i * 3 } };
+        auto p = (SegmentedData*)list.InsertLast(&data);
+        REQUIRE(p != nullptr);
+        REQUIRE((size_t)p % 32 == 0);
+        ptrs.push_back(p);
+    }
+    REQUIRE(list.Count() == 100);
+    REQUIRE(list.End() == 100);
+    REQUIRE(list.BlockCount() == 13);
+    for (auto i = 0; i < 100; i++) {
+        REQUIRE(list[i] == ptrs[i]);
+        REQUIRE(ptrs[i]->id == (uint64)i);
+        REQUIRE(ptrs[i]->value[2] == (uint64)i * 3);
+        REQUIRE(list.IndexOf(ptrs[i]) == i);
+    }
+    REQUIRE(list[100] == nullptr);
+    REQUIRE(list.IndexOf((uint8*)ptrs[3] + 1) == -1);
+
+    // 블록 단위 순회, 마지막 블록은 쓰는 자리만 셈
+    int32 visited = 0, slotCount = 0;
+    for (auto b = 0; b < list.BlockCount(); b++) {
+        auto block = (SegmentedData*)list.Block(b, &slotCount);
+        for (auto i = 0; i < slotCount; i++) {
+            REQUIRE(block[i].id == (uint64)visited);
+            visited++;
+        }
+    }
+    REQUIRE(visited == 100);
+
+    // 빈 자리 비트맵이 없으면 가운데는 못 지움
+    REQUIRE_FALSE(list.Remove(10));
+    REQUIRE(list.RemoveLast());
+    REQUIRE(list.Count() == 99);
+
+    SegmentedList copy;
+    REQUIRE(copy.Init(nullptr, 8));
+    REQUIRE(copy.CopyFrom(list));
+    REQUIRE(copy.Count() == 99);
+    REQUIRE(copy.Step() == (int32)sizeof(SegmentedData));
+    REQUIRE(((SegmentedData*)copy[98])->id == 98);
+    REQUIRE(copy[98] != list[98]);
+    REQUIRE(copy.Destroy());
+
+    REQUIRE(list.RemoveAll());
+    REQUIRE(list.Count() == 0);
+    REQUIRE(list.InsertLast(nullptr) == ptrs[0]);
+    REQUIRE(ptrs[0]->id == 0);
+    REQUIRE(list.Destroy());
+
+    // 주소 공간에서 받은 블록은 Destroy 에서 모두 돌려줌
+    auto addrspace0 = L"segmentedlist";
+    REQUIRE(memPageAdd(addrspace0, memPageMinSize(false), false));
+    REQUIRE(list.Init(addrspace0, 24, 8, 16));
+    for (auto i = 0; i < 1000; i++) {
+        REQUIRE(list.InsertLast(nullptr) != nullptr);
+    }
+    REQUIRE(memAllocSize(addrspace0) > 0);
+    REQUIRE(list.Destroy());
+    REQUIRE(memAllocSize(addrspace0) == 0);
+    REQUIRE(memPageFree(addrspace0));
+}
+
+TEST_CASE("test SegmentedList (free slots)", "[Container.SegmentedList]") {
+    SegmentedList list;
+    REQUIRE(list.Init(nullptr, sizeof(uint32), 4, 1, true));
+    REQUIRE(list.BlockCapacity() == 64);
+
+    std::vector<uint32*> ptrs;
+    for (uint32 i = 0; i < 200; i++) {
+        ptrs.push_back((uint32*)list.InsertLast(&i));
+    }
+
+    // 3의 배수를 지워도 나머지 주소와 인덱스는 그대로
+    for (auto i = 0; i < 200; i += 3) {
+        REQUIRE(list.Remove(i));
+    }
+    REQUIRE_FALSE(list.Remove(0));
+    REQUIRE_FALSE(list.Remove(200));
+    REQUIRE(list.Count() == 133);
+    REQUIRE(list.End() == 200);
+
+    auto alive = 0;
+    for (auto i = list.Next(0); i >= 0; i = list.Next(i + 1)) {
+        REQUIRE(i % 3 != 0);
+        REQUIRE(*(uint32*)list[i] == (uint32)i);
+        REQUIRE(list[i] == ptrs[i]);
+        alive++;
+    }
+    REQUIRE(alive == 133);
+
+    // 빈 자리는 앞에서부터 다시 씀
+    int32 index = -1;
+    uint32 value = 1000;
+    REQUIRE(list.Add(&value, &index) == ptrs[0]);
+    REQUIRE(index == 0);
+    REQUIRE(list.Add(&value, &index) == ptrs[3]);
+    REQUIRE(index == 3);
+    REQUIRE(list.IsAlive(3));
+    REQUIRE(list.Count() == 135);
+
+    // 뒤쪽이 비면 End() 가 당겨짐, 150 은 이미 지웠으므로 149 까지 남음
+    for (auto i = 151; i < 200; i++) {
+        list.Remove(i);
+    }
+    REQUIRE(list.End() == 150);
+    REQUIRE(list.Next(150) == -1);
+
+    // 빈 자리를 모두 채우면 뒤에 붙음
+    while (list.Count() < list.End()) {
+        REQUIRE(list.Add(&value, nullptr) != nullptr);
+    }
+    REQUIRE(list.Add(&value, &index) != nullptr);
+    REQUIRE(index == 150);
+    REQUIRE(list.Count() == 151);
+
+    REQUIRE(list.RemoveAll());
+    REQUIRE(list.Next(0) == -1);
+    REQUIRE_FALSE(list.IsAlive(0));
+    REQUIRE(list.Destroy());
+}
@@ -0,0 +1,105 @@
+#include "allocators.h"
+#include "slotmap.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+struct SlotResource {
+    uint64 id;
+    float extent[3];
+};
+
+TEST_CASE("test SlotMap", "[Container.SlotMap]") {
+    SlotMap map;
+
+    REQUIRE_FALSE(map.Init(nullptr, 0));
+    REQUIRE_FALSE(map.Init(nullptr, 8, 12));
+    REQUIRE(map.Insert(nullptr) == SLOTMAP_INVALID_HANDLE);
+
+    REQUIRE(map.Init(nullptr, sizeof(SlotResource), 16, 2));
+    REQUIRE(map.Find(SLOTMAP_INVALID_HANDLE) == nullptr);
+
+    SlotResource resource = { 10, { 1.f, 2.f, 3.f } };
+    auto h0 = map.Insert(&resource);
+    resource.id = 11;
+    auto h1 = map.Insert(&resource);
+    resource.id = 12;
+    auto h2 = map.Insert(&resource);
+    REQUIRE(h0 != SLOTMAP_INVALID_HANDLE);
+    REQUIRE(map.Count() == 3);
+    REQUIRE(map.Capacity() >= 3);
+    REQUIRE((size_t)map.Data() % 16 == 0);
+    REQUIRE(((SlotResource*)map.Find(h1))->id == 11);
+
+    // 가운데를 지우면 마지막 원소가 옮겨오고 핸들은 그대로 씀
+    REQUIRE(map.Erase(h0));
+    REQUIRE_FALSE(map.Erase(h0));
+    REQUIRE(map.Find(h0) == nullptr);
+    REQUIRE(map.Count() == 2);
+    REQUIRE(((SlotResource*)map[0])->id == 12);
+    REQUIRE(map.HandleAt(0) == h2);
+    REQUIRE(((SlotResource*)map.Find(h2))->id == 12);
+    REQUIRE(map[2] == nullptr);
+
+    // 같은 슬롯을 다시 써도 이전 핸들로는 찾을 수 없음
+    auto h3 = map.Insert(nullptr);
+    REQUIRE((uint32)h3 == (uint32)h0);
+    REQUIRE(h3 != h0);
+    REQUIRE_FALSE(map.IsAlive(h0));
+    REQUIRE(map.IsAlive(h3));
+    REQUIRE(((SlotResource*)map.Find(h3))->id == 0);
+
+    // 무작위로 넣고 지우면서 비교
+    std::unordered_map<SlotHandle, uint64> expected;
+    std::vector<SlotHandle> erased;
+    REQUIRE(map.RemoveAll());
+    REQUIRE(map.Count() == 0);
+    REQUIRE_FALSE(map.IsAlive(h1));
+    uint64 seed = 7;
+    for (uint64 i = 0; i < 20000; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        if ((seed >> 40) % 3 == 0 && !expected.empty()) {
+            auto it = expected.begin();
+            std::advance(it, (seed >> 20) % expected.size());
+            REQUIRE(map.Erase(it->first));
+            erased.push_back(it->first);
+            expected.erase(it);
+        } else {
+            resource.id = i;
+            auto handle = map.Insert(&resource);
+            REQUIRE(handle != SLOTMAP_INVALID_HANDLE);
+            REQUIRE(expected.emplace(handle, i).second);
+        }
+    }
+    REQUIRE(map.Count() == (int32)expected.size());
+    for (auto& pair : expected) {
+        auto p = (SlotResource*)map.Find(pair.first);
+        REQUIRE(p != nullptr);
+        REQUIRE(p->id == pair.second);
+    }
+    for (auto handle : erased) {
+        REQUIRE(map.Find(handle) == nullptr);
+    }
+
+    // dense 배열은 빈틈 없이 모든 원소를 한 번씩 담음
+    for (auto i = 0; i < map.Count(); i++) {
+        auto handle = map.HandleAt(i);
+        REQUIRE(expected.at(handle) == ((SlotResource*)map[i])->id);
+        REQUIRE(map.Find(handle) == (uint8*)map.Data() + i * sizeof(SlotResource));
+    }
+    REQUIRE(map.Destroy());
+
+    auto addrspace0 = L"slotmap";
+    REQUIRE(memPageAdd(addrspace0, memPageMinSize(false), false));
+    REQUIRE(map.Init(addrspace0, sizeof(uint32)));
+    for (uint32 i = 0; i < 1000; i++) {
+        REQUIRE(map.Insert(&i) != SLOTMAP_INVALID_HANDLE);
+    }
+    REQUIRE(memAllocSize(addrspace0) > 0);
+    REQUIRE(map.Destroy());
+    REQUIRE(memAllocSize(addrspace0) == 0);
+    REQUIRE(memPageFree(addrspace0));
+}
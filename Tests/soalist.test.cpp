@@ -0,0 +1,97 @@
+#include "allocators.h"
+#include "soalist.h"
+#include "defined_type.h"
+#include "catch.hpp"
+
+struct SoAVector3 {
+    float x, y, z;
+};
+
+TEST_CASE("test SoAList", "[Container.SoAList]") {
+    SoAList list;
+
+    int32 badSteps[] = { 12, 0 };
+    REQUIRE_FALSE(list.Init(nullptr, 2, badSteps));
+    REQUIRE_FALSE(list.Init(nullptr, 0, badSteps));
+    REQUIRE(list.InsertLast(nullptr) == -1);
+
+    // 정점, 법선, 본 인덱스 열
+    enum { POSITION, NORMAL, BONE, COLUMN_COUNT };
+    int32 steps[] = { sizeof(SoAVector3), sizeof(SoAVector3), sizeof(uint8) * 4 };
+    REQUIRE(list.Init(nullptr, COLUMN_COUNT, steps, 3));
+    REQUIRE(list.ColumnCount() == COLUMN_COUNT);
+    REQUIRE(list.ColumnStep(BONE) == 4);
+    REQUIRE(list.ColumnStep(COLUMN_COUNT) == 0);
+    REQUIRE(list.Capacity() == 3);
+
+    for (auto i = 0; i < 1000; i++) {
+        SoAVector3 position = { (float)i, (float)i * 2, (float)i * 3 };
+        uint8 bone[4] = { (uint8)i, 0, 0, 0 };
+        const void* values[] = { &position, nullptr, bone };
+        REQUIRE(list.InsertLast(values) == i);
+    }
+    REQUIRE(list.Count() == 1000);
+    REQUIRE(list.Capacity() >= 1000);
+
+    // 모든 열은 64바이트 정렬이고 서로 겹치지 않음
+    for (auto c = 0; c < COLUMN_COUNT; c++) {
+        REQUIRE((size_t)list.Column(c) % SoAList::s_ColumnAlignment == 0);
+    }
+    REQUIRE((uint8*)list.Column(POSITION) + sizeof(SoAVector3) * list.Capacity() <= (uint8*)list.Column(NORMAL));
+    REQUIRE((uint8*)list.Column(NORMAL) + sizeof(SoAVector3) * list.Capacity() <= (uint8*)list.Column(BONE));
+
+    // 열 포인터로 바로 씀
+    auto positions = (SoAVector3*)list.Column(POSITION);
+    auto normals = (SoAVector3*)list.Column(NORMAL);
+    for (auto i = 0; i < list.Count(); i++) {
+        REQUIRE(normals[i].x == 0.f);
+        normals[i] = { 0.f, 1.f, 0.f };
+        REQUIRE(positions[i].y == (float)i * 2);
+    }
+    REQUIRE(list.At(BONE, 999) == (uint8*)list.Column(BONE) + 999 * 4);
+    REQUIRE(list.At(BONE, 1000) == nullptr);
+    REQUIRE(list.At(COLUMN_COUNT, 0) == nullptr);
+
+    // 마지막 행이 지운 자리로 옮겨옴
+    REQUIRE(list.RemoveSwap(10));
+    REQUIRE(list.Count() == 999);
+    REQUIRE(((SoAVector3*)list.At(POSITION, 10))->x == 999.f);
+    REQUIRE(*(uint8*)list.At(BONE, 10) == (uint8)999);
+    REQUIRE_FALSE(list.RemoveSwap(999));
+    REQUIRE(list.RemoveLast());
+
+    // 늘어난 행은 0, 줄여도 용량은 그대로
+    REQUIRE(list.Resize(2000));
+    REQUIRE(list.Count() == 2000);
+    REQUIRE(((SoAVector3*)list.At(NORMAL, 1500))->y == 0.f);
+    REQUIRE(((SoAVector3*)list.At(NORMAL, 500))->y == 1.f);
+    auto capacity = list.Capacity();
+    REQUIRE(list.Resize(100));
+    REQUIRE(list.Capacity() == capacity);
+    REQUIRE_FALSE(list.ResizeMem(99));
+    REQUIRE(list.ResizeMem(100));
+    REQUIRE(((SoAVector3*)list.At(POSITION, 99))->z == 99.f * 3);
+
+    SoAList copy;
+    REQUIRE(copy.Init(nullptr, 1, steps));
+    REQUIRE(copy.CopyFrom(list));
+    REQUIRE(copy.ColumnCount() == COLUMN_COUNT);
+    REQUIRE(copy.Count() == 100);
+    REQUIRE(((SoAVector3*)copy.At(POSITION, 50))->y == 100.f);
+    REQUIRE(copy.Column(POSITION) != list.Column(POSITION));
+    REQUIRE(copy.Destroy());
+
+    REQUIRE(list.RemoveAll());
+    REQUIRE(list.Count() == 0);
+    REQUIRE(list.Destroy());
+
+    // 모든 열을 한 번에 받고 한 번에 돌려줌
+    auto addrspace0 = L"soalist";
+    REQUIRE(memPageAdd(addrspace0, memPageMinSize(false), false));
+    REQUIRE(list.Init(addrspace0, COLUMN_COUNT, steps));
+    REQUIRE(list.Resize(4096));
+    REQUIRE(memAllocSize(addrspace0) >= 4096 * (sizeof(SoAVector3) * 2 + 4));
+    REQUIRE(list.Destroy());
+    REQUIRE(memAllocSize(addrspace0) == 0);
+    REQUIRE(memPageFree(addrspace0));
+}